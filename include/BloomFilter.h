@@ -0,0 +1,138 @@
+/*
+ * Metodología de la Programación: Kmer5
+ * Curso 2023/2024
+ */
+
+/**
+ * @file BloomFilter.h
+ */
+
+#ifndef BLOOM_FILTER_H
+#define BLOOM_FILTER_H
+
+#include <atomic>
+
+/**
+ * @class BloomFilter
+ * @brief A set of keys of 64 bits (for example, the codes of the kmers of a
+ * KmerCoder) that answers whether a key has been inserted with some false
+ * positives but without false negatives, using a few bits for each key.
+ *
+ * The filter is blocked: it is divided in blocks of a cache line (512
+ * bits), and all the bits of a key are in the same word of 64 bits of a
+ * block, so a key only reads or writes one cache line, and it is inserted
+ * with a single atomic operation that sets its bits and returns the
+ * previous ones. Several threads can insert keys at the same time.
+ */
+class BloomFilter {
+public:
+    /**
+     * Number of bits of a block (a cache line of 64 bytes)
+     */
+    static const int BLOCK_BITS = 512;
+
+    /**
+     * Default number of bits of the filter for each key
+     */
+    static const int DEFAULT_BITS_PER_KEY = 12;
+
+    /**
+     * Maximum number of bits of a key
+     */
+    static const int MAX_HASHES = 7;
+
+    /**
+     * @brief Constructor of the class. The filter is empty.
+     * @param numKeys The expected number of keys. Input parameter
+     * @param bitsPerKey The number of bits of the filter for each expected
+     * key. The number of bits of a key is the one that minimizes the false
+     * positives, up to MAX_HASHES. Input parameter
+     * @throw std::invalid_argument Throws an std::invalid_argument exception
+     * if @p numKeys or @p bitsPerKey are not positive
+     */
+    BloomFilter(long long numKeys, int bitsPerKey = DEFAULT_BITS_PER_KEY);
+
+    /**
+     * @brief Destructor
+     */
+    ~BloomFilter();
+
+    /**
+     * @brief Returns the number of bits of the filter
+     * Query method
+     * @return The number of bits
+     */
+    long long getNumBits() const;
+
+    /**
+     * @brief Returns the number of bits of each key
+     * Query method
+     * @return The number of hash functions
+     */
+    int getNumHashes() const;
+
+    /**
+     * @brief Returns the number of keys inserted that were not found in the
+     * filter, that is, an estimation of the number of different keys
+     * Query method
+     * @return The number of new keys inserted
+     */
+    long long getNumKeys() const;
+
+    /**
+     * @brief Returns the memory of the filter
+     * Query method
+     * @return The number of bytes
+     */
+    long long getMemory() const;
+
+    /**
+     * @brief Returns the probability that a key that has not been inserted
+     * is found, with the current number of keys (see getNumKeys()). The
+     * keys of each block follow a Poisson distribution, so the rate is a
+     * bit larger than the one of a filter that is not blocked
+     * Query method
+     * @return The false positive rate
+     */
+    double getFalsePositiveRate() const;
+
+    /**
+     * @brief Checks whether a key has been inserted
+     * Query method
+     * @param key A key. Input parameter
+     * @return true if all the bits of @p key are set, which can be a false
+     * positive
+     */
+    bool contains(unsigned long long key) const;
+
+    /**
+     * @brief Inserts a key. Several threads can insert keys at the same time,
+     * and if they insert the same new key, only one of them finds it new.
+     * Modifier method
+     * @param key A key. Input parameter
+     * @return true if all the bits of @p key were already set, that is, if
+     * @p key was found in the filter (see contains())
+     */
+    bool insert(unsigned long long key);
+
+private:
+    unsigned long long* _memory; ///< The allocated words, with room for the alignment
+    unsigned long long* _words; ///< The words of the blocks, aligned to a cache line
+    long long _numBlocks; ///< Number of blocks
+    int _numHashes; ///< Number of bits of each key
+    std::atomic<long long> _numKeys; ///< Number of new keys inserted
+
+    /**
+     * @brief Obtains the word of a key and the bits of the key in the word
+     * Query method
+     * @param key A key. Input parameter
+     * @param mask The bits of the key in the word. Output parameter
+     * @return The position of the word
+     */
+    long long locate(unsigned long long key, unsigned long long& mask) const;
+
+    BloomFilter(const BloomFilter& orig); ///< Not copyable
+    BloomFilter& operator=(const BloomFilter& orig); ///< Not copyable
+};
+
+#endif /* BLOOM_FILTER_H */
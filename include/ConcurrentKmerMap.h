@@ -0,0 +1,200 @@
+/*
+ * Metodología de la Programación: Kmer5
+ * Curso 2023/2024
+ */
+
+/**
+ * @file ConcurrentKmerMap.h
+ */
+
+#ifndef CONCURRENT_KMER_MAP_H
+#define CONCURRENT_KMER_MAP_H
+
+#include <atomic>
+#include <string>
+
+#include "BloomFilter.h"
+#include "KmerCoder.h"
+#include "Profile.h"
+
+/**
+ * @class ConcurrentKmerMap
+ * @brief Counts the kmers of sequences in a hash table shared by several
+ * threads, for the values of k whose matrix of KmerCounter would be too
+ * large but whose different kmers fit in memory. The kmers are the same as
+ * the ones of a KmerCounter with the same parameters, including the kmers
+ * with missing nucleotides unless only the valid kmers are counted.
+ *
+ * Each kmer is a code with the positions of its nucleotides packed in a 64
+ * bits integer (see KmerCoder). The
+ * table uses open addressing with linear probing and it is lock-free: a
+ * thread inserts a new kmer in an empty slot with a compare-and-swap of its
+ * key, and the frequencies are increased with relaxed atomic increments.
+ * The table is not resized, so its capacity should be enough for the
+ * different kmers of the sequences, and its memory does not depend on the
+ * number of threads.
+ *
+ * The kmers that appear only once (for example, the ones with sequencing
+ * errors) can be dropped before they take a slot (see filterSingletons()):
+ * the first occurrence of each kmer is only inserted in a BloomFilter, so
+ * the table only needs room for the repeated kmers.
+ */
+class ConcurrentKmerMap {
+public:
+    /**
+     * Maximum proportion of used slots of the table. Linear probing is slow
+     * in a table that is almost full
+     */
+    static const double MAX_LOAD;
+
+    /**
+     * @brief Constructor of the class. The table is empty.
+     * @param k The number of nucleotides in each kmer. Input parameter
+     * @param validNucleotides The set of valid nucleotides. Input parameter
+     * @param capacity The number of different kmers that can be counted.
+     * The table has the next power of 2 of @p capacity / MAX_LOAD slots.
+     * Input parameter
+     * @param canonical Whether canonical kmers are counted (see class
+     * KmerCounter). Input parameter
+     * @param onlyValidKmers Whether only the kmers without missing
+     * nucleotides are counted (see class KmerCounter). Input parameter
+     * @throw std::invalid_argument Throws an std::invalid_argument exception
+     * if @p k or @p capacity are not positive, if the nucleotides of a kmer
+     * cannot be packed in 64 bits, or if @p canonical is true and the
+     * complementary nucleotides of @p validNucleotides cannot be obtained
+     * (see KmerCounter::GetComplementaryNucleotides())
+     */
+    ConcurrentKmerMap(int k, const std::string& validNucleotides,
+        long long capacity, bool canonical = false,
+        bool onlyValidKmers = false);
+
+    /**
+     * @brief Destructor
+     */
+    ~ConcurrentKmerMap();
+
+    /**
+     * @brief Returns the number of nucleotides in each kmer
+     * Query method
+     * @return The value of k
+     */
+    int getK() const;
+
+    /**
+     * @brief Returns the number of slots of the table
+     * Query method
+     * @return The number of slots
+     */
+    long long getNumSlots() const;
+
+    /**
+     * @brief Returns the number of different kmers counted
+     * Query method
+     * @return The number of used slots of the table
+     */
+    long long getSize() const;
+
+    /**
+     * @brief Returns the size of the table in bytes
+     * Query method
+     * @return The number of bytes of the keys and the frequencies, plus the
+     * ones of the filter of singletons, if any
+     */
+    long long getMemory() const;
+
+    /**
+     * @brief Returns the false positive rate of the filter of singletons,
+     * that is, the proportion of the kmers that appear only once that are
+     * counted anyway (with a frequency of 2)
+     * Query method
+     * @return The false positive rate (see
+     * BloomFilter::getFalsePositiveRate()), or 0 if the singletons are not
+     * filtered
+     */
+    double getFalsePositiveRate() const;
+
+    /**
+     * @brief Drops the kmers that appear only once in the sequences counted
+     * from now on. The first occurrence of each kmer is inserted in a
+     * BloomFilter instead of the table, and the frequencies of
+     * toProfile() are corrected with that occurrence. Some singletons are
+     * counted because of the false positives of the filter (see
+     * getFalsePositiveRate()). It should be called before counting.
+     * Modifier method
+     * @param numKmers The expected number of different kmers, including the
+     * singletons. Input parameter
+     * @param bitsPerKmer The number of bits of the filter for each kmer.
+     * Input parameter
+     * @throw std::invalid_argument Throws an std::invalid_argument exception
+     * if @p numKmers or @p bitsPerKmer are not positive
+     */
+    void filterSingletons(long long numKmers,
+        int bitsPerKmer = BloomFilter::DEFAULT_BITS_PER_KEY);
+
+    /**
+     * @brief Checks whether the kmers of k nucleotides of a set of valid
+     * nucleotides can be counted in a ConcurrentKmerMap
+     * @param k The number of nucleotides in each kmer. Input parameter
+     * @param validNucleotides The set of valid nucleotides. Input parameter
+     * @param onlyValidKmers Whether only the kmers without missing
+     * nucleotides are counted. Input parameter
+     * @return true if the nucleotides of a kmer can be packed in 64 bits
+     * (see KmerCoder::CanPack())
+     */
+    static bool CanPack(int k, const std::string& validNucleotides,
+        bool onlyValidKmers);
+
+    /**
+     * @brief Adds to the current frequencies the ones of the kmers of the
+     * given sequence, as in KmerCounter::addSequenceFrequencies(). Several
+     * threads can call this method at the same time, and the sequence can
+     * also be divided in pieces that are counted by several threads (see
+     * KmerCounter::ForEachPiece()).
+     * Modifier method
+     * @param sequence A sequence of nucleotides. Input parameter
+     * @param numThreads The number of threads. Input parameter
+     * @throw std::length_error Throws a std::length_error exception if the
+     * table is full. Some kmers of the sequence can be already counted
+     */
+    void addSequenceFrequencies(const std::string& sequence,
+        int numThreads = 1);
+
+    /**
+     * @brief Builds a Profile object with the kmers of the table and their
+     * frequencies, as KmerCounter::toProfile(), adding the first occurrence
+     * of each kmer if the singletons are filtered. It should not be called
+     * while the kmers are counted.
+     * Query method
+     * @return A Profile object, which is not sorted
+     */
+    Profile toProfile() const;
+
+private:
+    KmerCoder _coder; ///< Codes of the kmers of the sequences
+    long long _numSlots; ///< Number of slots of the table (a power of 2)
+    long long _maxSize; ///< Maximum number of used slots
+
+    /**
+     * Key of each slot: the code of its kmer plus 1, or 0 if it is empty
+     */
+    std::atomic<unsigned long long>* _keys;
+    std::atomic<long long>* _frequencies; ///< Frequency of the kmer of each slot
+    std::atomic<long long> _size; ///< Number of used slots
+    BloomFilter* _filter; ///< Filter of the singletons, or nullptr if they are counted
+
+    /**
+     * @brief Adds a value to the frequency of a kmer, inserting it in the
+     * table if it is not found
+     * Modifier method
+     * @param code The code of the kmer. Input parameter
+     * @param value The value to add. Input parameter
+     * @throw std::length_error Throws a std::length_error exception if the
+     * kmer is new and the table is full
+     */
+    void increase(unsigned long long code, int value);
+
+    ConcurrentKmerMap(const ConcurrentKmerMap& orig); ///< Not copyable
+    ConcurrentKmerMap& operator=(const ConcurrentKmerMap& orig); ///< Not copyable
+};
+
+#endif /* CONCURRENT_KMER_MAP_H */
@@ -0,0 +1,190 @@
+/*
+ * Metodología de la Programación: Kmer5
+ * Curso 2023/2024
+ */
+
+/**
+ * @file CountMinSketch.h
+ */
+
+#ifndef COUNT_MIN_SKETCH_H
+#define COUNT_MIN_SKETCH_H
+
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "CounterTable.h"
+#include "KmerCoder.h"
+#include "Profile.h"
+
+/**
+ * @class CountMinSketch
+ * @brief Counts approximately the kmers of sequences in a fixed amount of
+ * memory, and keeps the most frequent ones (the heavy hitters), for the
+ * sets of reads whose different kmers do not fit in memory. The kmers are
+ * the same as the ones of a KmerCounter with the same parameters, and
+ * their nucleotides are packed in codes of 64 bits (see KmerCoder).
+ *
+ * The sketch is a matrix of counters with depth rows of width columns.
+ * Each row has its own hash function, which maps a kmer to a column, and
+ * the estimation of the frequency of a kmer is the minimum of its counters.
+ * The counters are increased with conservative update: only the counters
+ * that are equal to the minimum are increased. So an estimation is never
+ * smaller than the frequency of the kmer, and with probability
+ * \f$1-e^{-depth}\f$ it exceeds the frequency at most in
+ * \f$\frac{e}{width}N\f$, where N is the number of kmers counted (see
+ * getErrorBound()).
+ *
+ * The heavy hitters are the kmers with the largest estimations: after each
+ * increment, the kmer is kept if its estimation is larger than the smallest
+ * one of the heavy hitters. The memory of the counters and the heavy
+ * hitters depends only on width, depth and the number of heavy hitters, not
+ * on k or on the length of the sequences.
+ */
+class CountMinSketch {
+public:
+    /**
+     * Default number of counters of each row
+     */
+    static const int DEFAULT_WIDTH = 1 << 22;
+
+    /**
+     * Default number of rows
+     */
+    static const int DEFAULT_DEPTH = 4;
+
+    /**
+     * Maximum number of rows. The probability of an error larger than
+     * getErrorBound() is already negligible with far fewer rows
+     */
+    static const int MAX_DEPTH = 32;
+
+    /**
+     * @brief Constructor of the class. All the counters are 0 and there are
+     * no heavy hitters.
+     * @param k The number of nucleotides in each kmer. Input parameter
+     * @param validNucleotides The set of valid nucleotides. Input parameter
+     * @param numHeavyHitters The number of kmers with the largest
+     * estimations that are kept. Input parameter
+     * @param width The number of counters of each row. Input parameter
+     * @param depth The number of rows. Input parameter
+     * @param canonical Whether canonical kmers are counted (see class
+     * KmerCounter). Input parameter
+     * @param onlyValidKmers Whether only the kmers without missing
+     * nucleotides are counted (see class KmerCounter). Input parameter
+     * @throw std::invalid_argument Throws an std::invalid_argument exception
+     * if @p k, @p numHeavyHitters, @p width or @p depth are not positive,
+     * if @p depth is larger than MAX_DEPTH, if there are more than INT_MAX
+     * counters, if the nucleotides of a kmer cannot be packed in 64 bits
+     * (see KmerCoder::CanPack()), or if @p canonical is true and
+     * the complementary nucleotides of @p validNucleotides cannot be
+     * obtained (see KmerCounter::GetComplementaryNucleotides())
+     */
+    CountMinSketch(int k, const std::string& validNucleotides,
+        int numHeavyHitters, int width = DEFAULT_WIDTH,
+        int depth = DEFAULT_DEPTH, bool canonical = false,
+        bool onlyValidKmers = false);
+
+    /**
+     * @brief Returns the number of nucleotides in each kmer
+     * Query method
+     * @return The value of k
+     */
+    int getK() const;
+
+    /**
+     * @brief Returns the number of counters of each row
+     * Query method
+     * @return The width of the sketch
+     */
+    int getWidth() const;
+
+    /**
+     * @brief Returns the number of rows
+     * Query method
+     * @return The depth of the sketch
+     */
+    int getDepth() const;
+
+    /**
+     * @brief Returns the number of kmers counted, that is, the sum of the
+     * frequencies of all the kmers
+     * Query method
+     * @return The number of kmers counted
+     */
+    long long getNumKmers() const;
+
+    /**
+     * @brief Returns the maximum error of an estimation,
+     * \f$\lceil\frac{e}{width}N\rceil\f$, where N is the number of kmers
+     * counted. An estimation is never smaller than the frequency of its
+     * kmer, and it exceeds it at most in this value with the probability
+     * given by getConfidence()
+     * Query method
+     * @return The maximum error of an estimation
+     */
+    long long getErrorBound() const;
+
+    /**
+     * @brief Returns the probability that an estimation does not exceed the
+     * frequency of its kmer in more than getErrorBound()
+     * Query method
+     * @return \f$1-e^{-depth}\f$
+     */
+    double getConfidence() const;
+
+    /**
+     * @brief Returns the memory used by the counters and the heavy hitters
+     * Query method
+     * @return The number of bytes
+     */
+    long long getMemory() const;
+
+    /**
+     * @brief Adds to the current estimations the kmers of the given
+     * sequence, in the same way as KmerCounter::addSequenceFrequencies()
+     * Modifier method
+     * @param sequence A sequence of nucleotides. Input parameter
+     */
+    void addSequenceFrequencies(const std::string& sequence);
+
+    /**
+     * @brief Builds a Profile object with the heavy hitters and their
+     * estimations as frequencies
+     * Query method
+     * @return A sorted Profile object (see Profile::sort())
+     */
+    Profile toProfile() const;
+
+private:
+    KmerCoder _coder; ///< Codes of the kmers of the sequences
+    int _width; ///< Number of counters of each row
+    int _depth; ///< Number of rows
+    CounterTable _counters; ///< The counters, row after row
+    long long _numKmers; ///< Number of kmers counted
+
+    int _numHeavyHitters; ///< Maximum number of heavy hitters
+    std::unordered_map<unsigned long long, long long> _heavyHitters; ///< Estimation of each heavy hitter
+    std::set<std::pair<long long, unsigned long long> > _ranking; ///< The heavy hitters by increasing estimation
+
+    /**
+     * @brief Adds a value to the estimation of a kmer with conservative
+     * update, and updates the heavy hitters
+     * Modifier method
+     * @param code The code of the kmer. Input parameter
+     * @param value The value to add. Input parameter
+     */
+    void increase(unsigned long long code, long long value);
+
+    /**
+     * @brief Updates the heavy hitters with the new estimation of a kmer
+     * Modifier method
+     * @param code The code of the kmer. Input parameter
+     * @param estimation The estimation of the kmer. Input parameter
+     */
+    void updateHeavyHitters(unsigned long long code, long long estimation);
+};
+
+#endif /* COUNT_MIN_SKETCH_H */
@@ -0,0 +1,222 @@
+/*
+ * Metodología de la Programación: Kmer5
+ * Curso 2023/2024
+ */
+
+/**
+ * @file CounterTable.h
+ */
+
+#ifndef COUNTER_TABLE_H
+#define COUNTER_TABLE_H
+
+#include <functional>
+#include <unordered_map>
+
+/**
+ * @class CounterTable
+ * @brief A table of counters (the frequencies of the kmers of a
+ * KmerCounter) stored in cells of 8, 16 or 32 bits, so a table of sparse
+ * frequencies takes 2 or 4 times less memory than a table of int.
+ *
+ * The cells are unsigned and saturating: when a cell reaches its maximum
+ * value (\f$2^{bits}-1\f$), it is promoted to an overflow map with a 64 bits
+ * integer, which keeps the rest of its count. So the value of a counter is
+ * its cell plus its entry in the overflow map, and the counts are exact up
+ * to \f$2^{63}-1\f$ for any size of the cells. The overflow map only has
+ * the saturated cells, which are few for the default 32 bits cells.
+ *
+ * The counters can also be increased by several threads at the same time
+ * (see increase() and add()): the cells are updated with relaxed atomic
+ * operations, and the overflow map with a lock.
+ */
+class CounterTable {
+public:
+    /**
+     * Default number of bits of a cell
+     */
+    static const int DEFAULT_CELL_BITS = 32;
+
+    /**
+     * @brief Constructor of the class. All the counters are 0.
+     * @param numCells The number of counters. Input parameter
+     * @param cellBits The number of bits of each cell: 8, 16 or 32. Input
+     * parameter
+     * @throw std::invalid_argument Throws an std::invalid_argument exception
+     * if @p numCells is negative or @p cellBits is not valid
+     */
+    CounterTable(int numCells = 0, int cellBits = DEFAULT_CELL_BITS);
+
+    /**
+     * @brief Copy constructor
+     * @param orig the CounterTable object used as source for the copy.
+     * Input parameter
+     */
+    CounterTable(const CounterTable& orig);
+
+    /**
+     * @brief Destructor
+     */
+    ~CounterTable();
+
+    /**
+     * @brief Overloading of the assignment operator.
+     * Modifier method
+     * @param orig the CounterTable object used as source for the
+     * assignment. Input parameter
+     * @return A reference to this object
+     */
+    CounterTable& operator=(const CounterTable& orig);
+
+    /**
+     * @brief Discards the counters and allocates a new table, whose counters
+     * are 0
+     * Modifier method
+     * @param numCells The number of counters. Input parameter
+     * @param cellBits The number of bits of each cell: 8, 16 or 32. Input
+     * parameter
+     * @throw std::invalid_argument Throws an std::invalid_argument exception
+     * if @p numCells is negative or @p cellBits is not valid
+     */
+    void reset(int numCells, int cellBits);
+
+    /**
+     * @brief Returns the number of counters of the table
+     * Query method
+     * @return The number of counters
+     */
+    int getNumCells() const;
+
+    /**
+     * @brief Returns the number of bits of each cell
+     * Query method
+     * @return 8, 16 or 32
+     */
+    int getCellBits() const;
+
+    /**
+     * @brief Changes the number of bits of each cell, keeping the values of
+     * the counters: the cells that do not fit in the new size are promoted
+     * to the overflow map, and the overflows that fit are moved back to
+     * their cells.
+     * Modifier method
+     * @param cellBits The number of bits of each cell: 8, 16 or 32. Input
+     * parameter
+     * @throw std::invalid_argument Throws an std::invalid_argument exception
+     * if @p cellBits is not valid
+     */
+    void setCellBits(int cellBits);
+
+    /**
+     * @brief Returns the number of saturated cells, whose counters are
+     * promoted to the overflow map
+     * Query method
+     * @return The number of entries of the overflow map
+     */
+    int getNumOverflows() const;
+
+    /**
+     * @brief Returns the memory used by the counters: the bytes of the
+     * cells and an estimation of the bytes of the overflow map
+     * Query method
+     * @return The number of bytes
+     */
+    long long getMemory() const;
+
+    /**
+     * @brief Returns the value of a counter
+     * Query method
+     * @param cell The position of the counter. Input parameter
+     * @return The value of the counter
+     */
+    long long get(int cell) const;
+
+    /**
+     * @brief Returns the number of counters that are not 0
+     * Query method
+     * @return The number of counters greater than 0
+     */
+    int getNumNonZero() const;
+
+    /**
+     * @brief Calls a function with each counter that is not 0, in the order
+     * of the positions
+     * Query method
+     * @param visit The function, which receives the position of the counter
+     * and its value. Input parameter
+     */
+    void forEachNonZero(
+        const std::function<void(int, long long)>& visit) const;
+
+    /**
+     * @brief Adds a value to a counter
+     * Modifier method
+     * @param cell The position of the counter. Input parameter
+     * @param value The value to add. Input parameter
+     * @param shared Whether other threads can increase the counters at the
+     * same time. Input parameter
+     * @throw std::out_of_range Throws a std::out_of_range exception if
+     * @p value is negative or the counter would exceed \f$2^{63}-1\f$
+     */
+    void add(int cell, long long value, bool shared = false);
+
+    /**
+     * @brief Increases by 1 each one of the given counters. The counter
+     * @p prefetchDistance positions ahead is prefetched before each
+     * increment (see KmerCounter::setPrefetchDistance()).
+     * Modifier method
+     * @param cells The positions of the counters. A position can appear
+     * several times. Input parameter
+     * @param numCells The number of positions. Input parameter
+     * @param prefetchDistance The prefetch distance, or 0. Input parameter
+     * @param shared Whether other threads can increase the counters at the
+     * same time. Input parameter
+     */
+    void increase(const int cells[], int numCells, int prefetchDistance,
+        bool shared = false);
+
+    /**
+     * @brief Sets all the counters to 0
+     * Modifier method
+     */
+    void clear();
+
+    /**
+     * @brief Overloading of the operator +=. It adds to each counter the
+     * counter at the same position of the given table
+     * Modifier method
+     * @param table A CounterTable. Input parameter
+     * @throw std::invalid_argument Throws an std::invalid_argument exception
+     * if @p table has a different number of counters
+     * @throw std::out_of_range Throws a std::out_of_range exception if a
+     * counter would exceed \f$2^{63}-1\f$. The counters can be partially
+     * added
+     * @return A reference to this object
+     */
+    CounterTable& operator+=(const CounterTable& table);
+
+private:
+    unsigned char* _cells; ///< The cells, of _cellBits bits each one
+    int _numCells; ///< Number of counters
+    int _cellBits; ///< Number of bits of each cell
+
+    /**
+     * Value of each saturated cell beyond the maximum value of a cell
+     */
+    std::unordered_map<int, long long> _overflow;
+
+    /**
+     * @brief Returns the maximum value of a cell
+     * Query method
+     * @return \f$2^{bits}-1\f$
+     */
+    long long getMaxCell() const;
+
+    /**
+     * @brief Allocates the cells, set to 0
+     * Modifier method
+     */
+    void allocate();
+};
+
+#endif /* COUNTER_TABLE_H */
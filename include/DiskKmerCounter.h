@@ -0,0 +1,235 @@
+/*
+ * Metodología de la Programación: Kmer5
+ * Curso 2023/2024
+ */
+
+/**
+ * @file DiskKmerCounter.h
+ */
+
+#ifndef DISK_KMER_COUNTER_H
+#define DISK_KMER_COUNTER_H
+
+#include <fstream>
+#include <string>
+
+#include "NucleotideTable.h"
+#include "Profile.h"
+
+/**
+ * @class DiskKmerCounter
+ * @brief Counts the kmers of a set of DNA files whose table of kmers does
+ * not fit in memory (for example, k=31), using temporary files. Only the
+ * kmers without missing nucleotides are counted, as in a KmerCounter that
+ * counts only valid kmers, and they can also be canonical kmers.
+ *
+ * The kmers are counted in two passes:
+ * - The input files are read by blocks, and the code of each kmer (its
+ * nucleotides packed in a 64 bits integer) is appended to one of a set of
+ * bucket files, selected with a hash of the code, so all the copies of a
+ * kmer are in the same bucket.
+ * - Each bucket is counted independently in memory, by several threads:
+ * its codes are sorted, and the frequency of each kmer is the length of its
+ * run. The kmers of a bucket are saved as a partial Profile, sorted as in
+ * Profile::sort(), in another temporary file, and the partial Profiles are
+ * merged in the final Profile, which is already sorted.
+ *
+ * The number of buckets is chosen so that a bucket of each thread fits in
+ * the memory limit, given the size of the input files. The space of the
+ * temporary files can also be limited.
+ */
+class DiskKmerCounter {
+public:
+    /**
+     * Default limit of the memory used to count the kmers, in bytes
+     */
+    static const long long DEFAULT_MEMORY_LIMIT = 1LL << 30;
+
+    /**
+     * Minimum limit of the memory used to count the kmers, in bytes
+     */
+    static const long long MIN_MEMORY_LIMIT = 1LL << 24;
+
+    /**
+     * Maximum number of bucket files
+     */
+    static const int MAX_BUCKETS = 1024;
+
+    /**
+     * @brief Constructor of the class. The temporary files are created in
+     * the current directory, with DEFAULT_MEMORY_LIMIT bytes of memory,
+     * without limit of disk space and with a thread.
+     * @param k The number of nucleotides in each kmer. Input parameter
+     * @param validNucleotides The set of valid nucleotides. Input parameter
+     * @param canonical Whether canonical kmers are counted (see class
+     * KmerCounter). Input parameter
+     * @throw std::invalid_argument Throws an std::invalid_argument exception
+     * if @p k is not positive, if the nucleotides of a kmer cannot be packed
+     * in 64 bits, or if @p canonical is true and the complementary
+     * nucleotides of @p validNucleotides cannot be obtained (see
+     * KmerCounter::GetComplementaryNucleotides())
+     */
+    DiskKmerCounter(int k, const std::string& validNucleotides,
+        bool canonical = false);
+
+    /**
+     * @brief Destructor. It removes the temporary files that still exist.
+     */
+    ~DiskKmerCounter();
+
+    /**
+     * @brief Sets the directory where the temporary files are created
+     * Modifier method
+     * @param directory The name of the directory. Input parameter
+     */
+    void setTemporaryDirectory(const std::string& directory);
+
+    /**
+     * @brief Sets the limit of the memory used to count the kmers. The
+     * memory of the final Profile is not included
+     * Modifier method
+     * @param bytes The limit, in bytes. Input parameter
+     * @throw std::invalid_argument Throws an std::invalid_argument exception
+     * if @p bytes is less than MIN_MEMORY_LIMIT
+     */
+    void setMemoryLimit(long long bytes);
+
+    /**
+     * @brief Sets the limit of the space of the temporary files
+     * Modifier method
+     * @param bytes The limit, in bytes, or 0 for no limit. Input parameter
+     * @throw std::invalid_argument Throws an std::invalid_argument exception
+     * if @p bytes is negative
+     */
+    void setDiskLimit(long long bytes);
+
+    /**
+     * @brief Sets the number of threads that count the buckets
+     * Modifier method
+     * @param numThreads The number of threads. Input parameter
+     * @throw std::invalid_argument Throws an std::invalid_argument exception
+     * if @p numThreads is not positive
+     */
+    void setNumThreads(int numThreads);
+
+    /**
+     * @brief Returns the number of buckets of the last count
+     * Query method
+     * @return The number of buckets, or 0 if nothing has been counted
+     */
+    int getNumBuckets() const;
+
+    /**
+     * @brief Returns the space of the bucket files of the last count
+     * Query method
+     * @return The number of bytes written in the bucket files
+     */
+    long long getDiskUsage() const;
+
+    /**
+     * @brief Counts the kmers of a set of DNA files. As in
+     * KmerCounter::calculateFrequencies(), the sequence of a file is its
+     * first word, and the lowercase nucleotides are counted as the
+     * uppercase ones. The temporary files are removed before returning.
+     * Modifier method
+     * @param fileNames The names of the DNA files. Input parameter
+     * @param numFiles The number of DNA files. Input parameter
+     * @return The Profile of the kmers of all the files, sorted as in
+     * Profile::sort()
+     * @throw std::ios_base::failure Throws a std::ios_base::failure exception
+     * if an input file cannot be read, if a temporary file cannot be
+     * written or read, or if the temporary files exceed the disk limit
+     */
+    Profile count(char* const fileNames[], int numFiles);
+
+private:
+    int _k; ///< Number of nucleotides in each kmer
+    std::string _validNucleotides; ///< Set of valid nucleotides
+    bool _canonical; ///< Whether canonical kmers are counted
+    NucleotideTable _table; ///< Code of each character (0 for the invalid ones)
+    int _bits; ///< Number of bits of a nucleotide in the code of a kmer
+
+    /**
+     * Position in the sorted set of valid nucleotides of the nucleotide at
+     * each position of _validNucleotides, used to sort the codes as the kmers
+     */
+    int _ranks[256];
+    std::string _sortedNucleotides; ///< Valid nucleotides in alphabetical order
+
+    /**
+     * Position in _validNucleotides of the complementary nucleotide of the
+     * nucleotide at each position, if canonical kmers are counted
+     */
+    int _complements[256];
+
+    std::string _directory; ///< Directory of the temporary files
+    long long _memoryLimit; ///< Limit of the memory, in bytes
+    long long _diskLimit; ///< Limit of the temporary files, in bytes (0 without limit)
+    int _numThreads; ///< Number of threads that count the buckets
+    int _numBuckets; ///< Number of buckets of the last count
+    long long _diskUsage; ///< Bytes written in the bucket files of the last count
+    std::string _prefix; ///< Beginning of the names of the temporary files
+
+    /**
+     * @brief Returns the name of a temporary file
+     * Query method
+     * @param bucket The bucket of the file. Input parameter
+     * @param partial Whether it is the file of the partial Profile of the
+     * bucket, instead of its codes. Input parameter
+     * @return The name of the file
+     */
+    std::string getFileName(int bucket, bool partial) const;
+
+    /**
+     * @brief Appends the codes of the kmers of a DNA file to the bucket
+     * files (first pass)
+     * Modifier method
+     * @param fileName The name of the DNA file. Input parameter
+     * @param outputs The bucket files. Input/Output parameter
+     * @param buffers The codes of each bucket that are not written yet.
+     * Input/Output parameter
+     * @param sizes The number of codes of each buffer. Input/Output parameter
+     * @param capacity The capacity of each buffer. Input parameter
+     */
+    void spill(const char* fileName, std::ofstream outputs[],
+        unsigned long long buffers[], int sizes[], int capacity);
+
+    /**
+     * @brief Writes the codes of a buffer in its bucket file
+     * Modifier method
+     * @param output The bucket file. Input/Output parameter
+     * @param buffer The codes. Input parameter
+     * @param size The number of codes. Input parameter
+     */
+    void write(std::ofstream& output, const unsigned long long buffer[],
+        int size);
+
+    /**
+     * @brief Counts the kmers of a bucket and saves them in its partial
+     * Profile file (second pass)
+     * Query method
+     * @param bucket The bucket. Input parameter
+     * @return The number of different kmers of the bucket
+     */
+    long long countBucket(int bucket) const;
+
+    /**
+     * @brief Returns the kmer of a sort key (see countBucket())
+     * Query method
+     * @param key The code of the kmer with the positions of its nucleotides
+     * in _sortedNucleotides. Input parameter
+     * @return The kmer
+     */
+    std::string getKmer(unsigned long long key) const;
+
+    /**
+     * @brief Removes the temporary files of the last count
+     * Modifier method
+     */
+    void removeFiles();
+
+    DiskKmerCounter(const DiskKmerCounter& orig); ///< Not copyable
+    DiskKmerCounter& operator=(const DiskKmerCounter& orig); ///< Not copyable
+};
+
+#endif /* DISK_KMER_COUNTER_H */
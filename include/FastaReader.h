@@ -0,0 +1,91 @@
+/*
+ * Metodología de la Programación: Kmer5
+ * Curso 2023/2024
+ */
+
+/**
+ * @file FastaReader.h
+ */
+
+#ifndef FASTA_READER_H
+#define FASTA_READER_H
+
+#include <fstream>
+#include <string>
+
+/**
+ * @class FastaReader
+ * @brief Reads the records of a (multi-)FASTA file one by one. A record is
+ * a line with its name, which begins with '>', followed by the lines of its
+ * sequence. The lines of the sequence are joined, without the whitespace
+ * characters.
+ *
+ * The lines before the first name (for example, all the lines of a .dna
+ * file without names) form a record whose name is the name of the file.
+ */
+class FastaReader {
+public:
+    /**
+     * @brief Base constructor. It builds a closed FastaReader object.
+     */
+    FastaReader();
+
+    /**
+     * @brief Destructor. It closes the file if it was open.
+     */
+    ~FastaReader();
+
+    /**
+     * @brief Opens the given FASTA file. If this object was already open,
+     * it is closed first.
+     * Modifier method
+     * @param fileName A c-string with the name of the file. Input parameter
+     * @throw std::ios_base::failure Throws a std::ios_base::failure exception
+     * if the given file cannot be opened
+     */
+    void open(const char fileName[]);
+
+    /**
+     * @brief Closes the file.
+     * Modifier method
+     */
+    void close();
+
+    /**
+     * @brief Reads the next record of the file.
+     * Modifier method
+     * @param name The name of the record, without the '>'. Output parameter
+     * @param sequence The sequence of the record. Output parameter
+     * @return true if a record has been read; false at the end of the file
+     */
+    bool next(std::string& name, std::string& sequence);
+
+    /**
+     * @brief Reads the next records of the file, until @p maxRecords
+     * records have been read or their sequences have at least
+     * @p maxNucleotides nucleotides.
+     * Modifier method
+     * @param names The names of the records. It should have space for
+     * @p maxRecords elements. Output parameter
+     * @param sequences The sequences of the records. It should have space
+     * for @p maxRecords elements. Output parameter
+     * @param maxRecords The maximum number of records to read. Input
+     * parameter
+     * @param maxNucleotides The number of nucleotides after which no more
+     * records are read. Input parameter
+     * @return The number of records read (0 at the end of the file)
+     */
+    int next(std::string names[], std::string sequences[], int maxRecords,
+        long long maxNucleotides);
+
+private:
+    std::ifstream _input; ///< The FASTA file
+    std::string _fileName; ///< The name of the FASTA file
+    std::string _line; ///< The name line of the next record, if it has been read
+    bool _first; ///< Whether no record has been read yet
+
+    FastaReader(const FastaReader& orig); ///< Not copyable
+    FastaReader& operator=(const FastaReader& orig); ///< Not copyable
+};
+
+#endif /* FASTA_READER_H */
@@ -16,6 +16,8 @@
 #include <iostream>
 #include <string>
 
+class NucleotideTable;
+
 /**
  * @class Kmer
  * @brief It represents a list of k consecutive nucleotides of a DNA or RNA
@@ -117,6 +119,17 @@ public:
      * (nucleotides) that should be considered as valid. Input parameter
      */
     void normalize(const std::string& validNucleotides);
+
+    /**
+     * @brief Normalizes this Kmer as normalize(const std::string&), with the
+     * table of a set of valid nucleotides, which classifies and converts to
+     * uppercase each character in a single access. It is faster when many 
+     * kmers are normalized with the same set of nucleotides.
+     * Modifier method
+     * @param table The NucleotideTable of the valid nucleotides. Input 
+     * parameter
+     */
+    void normalize(const NucleotideTable& table);
     
     /**
      * @brief Returns the complementary of this Kmer. For example, given the Kmer
@@ -0,0 +1,156 @@
+/*
+ * Metodología de la Programación: Kmer5
+ * Curso 2023/2024
+ */
+
+/**
+ * @file KmerCoder.h
+ */
+
+#ifndef KMER_CODER_H
+#define KMER_CODER_H
+
+#include <algorithm>
+#include <string>
+
+#include "NucleotideTable.h"
+
+/**
+ * @class KmerCoder
+ * @brief Obtains the kmers of sequences as codes of 64 bits, for the
+ * counters that store the kmers instead of a matrix with all of them (see
+ * ConcurrentKmerMap, CountMinSketch and SpaceSaving). The kmers are the
+ * same as the ones of a KmerCounter with the same parameters, including the
+ * kmers with missing nucleotides unless only the valid kmers are counted.
+ *
+ * The code of a kmer has the positions of its nucleotides in
+ * _allNucleotides (as the position of the kmer in the matrix of
+ * KmerCounter), packed with the bits needed for a position, and the code of
+ * each kmer of a sequence is obtained from the previous one with a shift.
+ */
+class KmerCoder {
+public:
+    /**
+     * @brief Constructor of the class
+     * @param k The number of nucleotides in each kmer. Input parameter
+     * @param validNucleotides The set of valid nucleotides. Input parameter
+     * @param canonical Whether canonical kmers are coded (see class
+     * KmerCounter). Input parameter
+     * @param onlyValidKmers Whether only the kmers without missing
+     * nucleotides are coded (see class KmerCounter). Input parameter
+     * @throw std::invalid_argument Throws an std::invalid_argument exception
+     * if the nucleotides of a kmer cannot be packed in 64 bits (see
+     * CanPack()), or if @p canonical is true and the complementary
+     * nucleotides of @p validNucleotides cannot be obtained (see
+     * KmerCounter::GetComplementaryNucleotides())
+     */
+    KmerCoder(int k, const std::string& validNucleotides,
+        bool canonical = false, bool onlyValidKmers = false);
+
+    /**
+     * @brief Returns the number of nucleotides in each kmer
+     * Query method
+     * @return The value of k
+     */
+    int getK() const;
+
+    /**
+     * @brief Checks whether the kmers of k nucleotides of a set of valid
+     * nucleotides can be packed in codes of 64 bits
+     * @param k The number of nucleotides in each kmer. Input parameter
+     * @param validNucleotides The set of valid nucleotides. Input parameter
+     * @param onlyValidKmers Whether only the kmers without missing
+     * nucleotides are coded. Input parameter
+     * @return true if k is positive and the nucleotides of a kmer fit in
+     * less than 64 bits
+     */
+    static bool CanPack(int k, const std::string& validNucleotides,
+        bool onlyValidKmers);
+
+    /**
+     * @brief Calls a function with the code of each kmer of a piece of a
+     * sequence, in order. A run of kmers with only missing nucleotides (the
+     * code 0) is given in a single call with its number of kmers.
+     * Query method
+     * @param text The nucleotides of the piece. Input parameter
+     * @param length The number of nucleotides. Input parameter
+     * @param visit The function, which receives the code of a kmer and its
+     * number of consecutive occurrences. Input parameter
+     */
+    template <class Visit>
+    void forEachCode(const char text[], int length, Visit visit) const;
+
+    /**
+     * @brief Returns the nucleotides of a code
+     * Query method
+     * @param code The code of a kmer. Input parameter
+     * @return The k nucleotides of @p code
+     */
+    std::string decode(unsigned long long code) const;
+
+private:
+    /**
+     * Number of nucleotides of a sequence that are translated at once to
+     * their positions in the set of nucleotides
+     */
+    static const int TRANSLATION_BLOCK = 4096;
+
+    int _k; ///< Number of nucleotides in each kmer
+    std::string _allNucleotides; ///< Nucleotides of the positions of the codes
+    bool _canonical; ///< Whether canonical kmers are coded
+    bool _onlyValidKmers; ///< Whether only the kmers without missing nucleotides are coded
+    NucleotideTable _table; ///< Code of each character (0 for the invalid ones)
+    int _bits; ///< Number of bits of a nucleotide in a code
+
+    /**
+     * Position in _allNucleotides of the complementary nucleotide of each
+     * position, if canonical kmers are coded
+     */
+    int _complements[256];
+};
+
+template <class Visit>
+void KmerCoder::forEachCode(const char text[], int length,
+        Visit visit) const {
+    unsigned char values[TRANSLATION_BLOCK];
+    unsigned long long mask = (1ULL << (_k * _bits)) - 1;
+    int shift = (_k - 1) * _bits;
+    unsigned long long code = 0;
+    unsigned long long reverse = 0;
+    int run = 0; // Number of nucleotides at the end of the window
+    for (int start = 0; start < length; start += TRANSLATION_BLOCK) {
+        int size = std::min(TRANSLATION_BLOCK, length - start);
+        _table.translate(text + start, size, values);
+        for (int i = 0; i < size; i++) {
+            int value = values[i];
+            if (_onlyValidKmers) {
+                if (value == 0) {
+                    run = 0;
+                    i = NucleotideTable::FindValid(values, i + 1, size) - 1;
+                    continue;
+                }
+                value--;
+            }
+            code = ((code << _bits) | value) & mask;
+            if (_canonical) {
+                reverse = (reverse >> _bits) |
+                        ((unsigned long long) _complements[value] << shift);
+            }
+            if (run < _k - 1) {
+                run++;
+                continue;
+            }
+
+            if (code == 0 && !_onlyValidKmers) {
+                // Only missing nucleotides, until the next valid one
+                int next = NucleotideTable::FindValid(values, i + 1, size);
+                visit(0ULL, next - i);
+                i = next - 1;
+                continue;
+            }
+            visit(_canonical && reverse < code ? reverse : code, 1);
+        }
+    }
+}
+
+#endif /* KMER_CODER_H */
@@ -15,16 +15,26 @@
 
 #include <string>
 #include <cmath>
+#include <functional>
 
+#include "CounterTable.h"
+#include "NucleotideTable.h"
 #include "Profile.h"
 
+class PartitionedCounters;
+class SequenceFilter;
+
 /**
  * @class KmerCounter
  * @brief It is a helper class used to calculate the frequency of each kmer in
  * a text file. 
- * It consists of a matrix of integers. Each element in the matrix contains
+ * It consists of a matrix of counters. Each element in the matrix contains
  * the frequency of the kmer that is defined by its row and column: the kmer formed 
  * taking the nucleotides defined by the row and column of that element. 
+ * The counters are stored in a CounterTable, whose cells have 32 bits by 
+ * default, or 8 or 16 bits to save memory (see setCellBits()): the 
+ * frequencies that do not fit in a cell are kept in an overflow map, so 
+ * they are exact in any case.
  * 
  * This class has a private data member string _validNucleotides to contain the set of
  * possible nucleotides in a kmer and a private data member
@@ -47,7 +57,31 @@
  *  
  * When searching for kmers in a text file, if we find a character that 
  * does not belong to the set of valid nucleotides, it will be replaced by the 
- * character Kmer::MISSING_NUCLEOTIDE in the corresponding kmer
+ * character Kmer::MISSING_NUCLEOTIDE in the corresponding kmer. The
+ * characters are classified with a NucleotideTable, built once for each 
+ * KmerCounter, which also converts the lowercase (soft-masked) nucleotides
+ * to uppercase ones.
+ * 
+ * A KmerCounter can also count only the kmers without missing nucleotides: 
+ * the window of the kmer restarts after each invalid character, and 
+ * _allNucleotides only contains the valid nucleotides, so the matrix is 
+ * much smaller (\f$4^k\f$ instead of \f$5^k\f$ kmers for "ACGT", where 
+ * the positions in the matrix are obtained with shifts and masks). The 
+ * Profile is the one of the default mode after Profile::zip(true).
+ * 
+ * A KmerCounter can also count canonical kmers, so that a sequence and its
+ * reverse complement have the same frequencies: each kmer is counted as the
+ * smaller one of itself and its reverse complement, in the order of the 
+ * nucleotides of _allNucleotides (the alphabetical order for kmers of "ACGT"
+ * or "ACGU" without missing nucleotides). The reverse complement of each
+ * kmer of a sequence is obtained from the one of the previous kmer, as its
+ * position in the matrix. For an odd k, a kmer and its reverse complement
+ * have complementary middle nucleotides, so only one nucleotide of each 
+ * complementary pair (and the missing nucleotide) is needed in the middle 
+ * position, and the matrix only has those rows.
+ * 
+ * A KmerCounter can also count spaced kmers, whose nucleotides are selected
+ * by a seed in a longer window of the sequence (see setSeed()).
  */
 class KmerCounter {
 public:
@@ -60,6 +94,25 @@ public:
      * to the field _validNucleotides
      */
     static const char* const DEFAULT_VALID_NUCLEOTIDES;
+    
+    /**
+     * Default number of kmers between the prefetch of the counter of a kmer
+     * and its increment, for the matrices that do not fit in the cache (see
+     * setPrefetchDistance())
+     */
+    static const int DEFAULT_PREFETCH_DISTANCE = 16;
+    
+    /**
+     * Maximum number of kmers between the prefetch of the counter of a kmer
+     * and its increment
+     */
+    static const int MAX_PREFETCH_DISTANCE = 1024;
+    
+    /**
+     * Name of the parameter of the profiles whose kmers are counted with a
+     * spaced seed (see setSeed() and Profile::getParameters())
+     */
+    static const std::string SEED;
 
     /**
      * @brief Constructor of the class. This object uses a matrix of 
@@ -71,9 +124,23 @@ public:
      * @param k The number of nucleotides in each kmer. Input parameter
      * @param validNucleotides The set of nucleotides (characters) that are 
      * considered as part of a kmer. Input parameter
+     * @param canonical Whether canonical kmers are counted (see the 
+     * description of this class). Input parameter
+     * @param onlyValidKmers Whether only the kmers without missing 
+     * nucleotides are counted (see the description of this class). In that
+     * case, _allNucleotides is initialized with @p validNucleotides. Input 
+     * parameter
+     * @param cellBits The number of bits of each cell of the matrix (see
+     * setCellBits()). Input parameter
+     * @throw std::invalid_argument Throws an std::invalid_argument exception
+     * if @p canonical is true and the complementary nucleotides of 
+     * @p validNucleotides cannot be obtained (see 
+     * GetComplementaryNucleotides()), or if @p cellBits is not valid
      */
     KmerCounter(int k=5, 
-       const std::string& validNucleotides = DEFAULT_VALID_NUCLEOTIDES);
+       const std::string& validNucleotides = DEFAULT_VALID_NUCLEOTIDES,
+       bool canonical = false, bool onlyValidKmers = false,
+       int cellBits = CounterTable::DEFAULT_CELL_BITS);
 
     /**
      * @brief Copy constructor
@@ -106,7 +173,8 @@ public:
     
     /**
      * @brief Returns the number of different kmers that can be built using
-     * @p _k nucleotides (including the missing nucleotide)
+     * @p _k nucleotides (including the missing nucleotide, unless only the
+     * kmers without missing nucleotides are counted)
      * Query method
      * @return The number of different kmers that can be built using
      * @p _k nucleotides 
@@ -121,6 +189,169 @@ public:
      */
     int getNumberActiveKmers() const;
     
+    /**
+     * @brief Checks whether this object counts canonical kmers.
+     * Query method
+     * @return true if each kmer is counted as the smaller one of itself and
+     * its reverse complement; false otherwise
+     */
+    bool isCanonical() const;
+    
+    /**
+     * @brief Checks whether this object counts only the kmers without 
+     * missing nucleotides.
+     * Query method
+     * @return true if the kmers with invalid nucleotides are skipped; false
+     * if they are counted with Kmer::MISSING_NUCLEOTIDE
+     */
+    bool countsOnlyValidKmers() const;
+    
+    /**
+     * @brief Returns the number of kmers between the prefetch of the counter
+     * of a kmer and its increment (see setPrefetchDistance()).
+     * Query method
+     * @return The prefetch distance, or 0 if the counters are not prefetched
+     */
+    int getPrefetchDistance() const;
+    
+    /**
+     * @brief Sets the number of kmers between the prefetch of the counter of
+     * a kmer and its increment. The kmers of a sequence are counted in 
+     * batches: their positions in the matrix are obtained first, and then
+     * each counter is increased after asking the processor to bring to the
+     * cache the counter of the kmer @p prefetchDistance positions ahead, so
+     * the cache misses of a large matrix are not waited one by one. The 
+     * frequencies are the same for any distance. By default, the distance 
+     * is DEFAULT_PREFETCH_DISTANCE for the matrices of at least 1 MB and 0
+     * for the smaller ones.
+     * Modifier method
+     * @param prefetchDistance The number of kmers, or 0 to increase the 
+     * counters without prefetching them. Input parameter
+     * @throw std::invalid_argument Throws an std::invalid_argument exception
+     * if @p prefetchDistance is negative or greater than 
+     * MAX_PREFETCH_DISTANCE
+     */
+    void setPrefetchDistance(int prefetchDistance);
+    
+    /**
+     * @brief Returns whether the kmers are counted by partitions of the 
+     * matrix (see setPartitioned()).
+     * Query method
+     * @return true if the counters are increased by partitions; false if 
+     * they are increased in the order of the kmers
+     */
+    bool isPartitioned() const;
+    
+    /**
+     * @brief Selects how the counters of the kmers of a sequence are 
+     * increased. By default, each counter is increased in the order of the
+     * kmers of the sequence, prefetching the next ones (see 
+     * setPrefetchDistance()). When the matrix is partitioned, each 
+     * increment is first kept in a buffer of the slice of the matrix of its
+     * counter (see PartitionedCounters), and the increments of a slice are
+     * done together, when its buffer is full or at the end of the sequence.
+     * It is useful for the matrices that are too large for the cache and 
+     * too dense for a sparse counter (for example, k between 9 and 14 for 
+     * "ACGT"), but whether it is faster than prefetching depends on the
+     * machine (see BENCHCOUNT), so it is not selected by default. The 
+     * frequencies are the same with both engines.
+     * Modifier method
+     * @param partitioned Whether the counters are increased by partitions.
+     * Input parameter
+     */
+    void setPartitioned(bool partitioned);
+    
+    /**
+     * @brief Returns the number of bits of each cell of the matrix of 
+     * frequencies (see setCellBits()).
+     * Query method
+     * @return 8, 16 or 32
+     */
+    int getCellBits() const;
+    
+    /**
+     * @brief Sets the number of bits of each cell of the matrix of 
+     * frequencies, keeping the current frequencies. With 8 or 16 bits, the 
+     * matrix takes 4 or 2 times less memory than with the default 32 bits, 
+     * and the few kmers whose frequencies do not fit in their cells are 
+     * promoted to the overflow map of the CounterTable, so the frequencies
+     * are the same with any size of the cells. The smaller cells are useful
+     * for a large and sparse matrix, whose most kmers have small 
+     * frequencies.
+     * Modifier method
+     * @param cellBits The number of bits: 8, 16 or 32. Input parameter
+     * @throw std::invalid_argument Throws an std::invalid_argument exception
+     * if @p cellBits is not valid
+     */
+    void setCellBits(int cellBits);
+    
+    /**
+     * @brief Returns the spaced seed of the kmers (see setSeed()).
+     * Query method
+     * @return The seed, or an empty string if the nucleotides of the kmers
+     * are consecutive
+     */
+    const std::string& getSeed() const;
+    
+    /**
+     * @brief Returns the number of nucleotides of a sequence that form a 
+     * kmer: k, or the length of the seed (see setSeed()).
+     * Query method
+     * @return The number of nucleotides of the window of a kmer
+     */
+    int getSpan() const;
+    
+    /**
+     * @brief Sets a spaced seed for the kmers, so their nucleotides are not
+     * consecutive in the sequences. The seed is a string of 1 and 0 with k 
+     * 1, which begins and ends with 1 (for example, "1101011" for k=5): 
+     * each kmer has the nucleotides at the positions of the 1 of a window
+     * of seed.length() nucleotides, and the ones at the positions of the 0
+     * are ignored. A substitution at those positions does not change the 
+     * kmer, so the spaced kmers of two diverged sequences (for example, two
+     * strains with SNPs) share more kmers than the contiguous ones of the 
+     * same size. The matrix has the same size as without seed, and the 
+     * Profile keeps the seed as its parameters (see toProfile()).
+     * 
+     * The positions in _allNucleotides of the nucleotides of a window are 
+     * packed in a code of 64 bits, and the ones of the kmer are extracted
+     * with the PEXT instruction when it is available (compiling with BMI2,
+     * for example with -mbmi2 or -march=native), or with a shift and a mask
+     * for each run of 1 of the seed otherwise. The frequencies are set to 0.
+     * Modifier method
+     * @param seed The seed, or an empty string for consecutive nucleotides.
+     * Input parameter
+     * @throw std::invalid_argument Throws an std::invalid_argument exception
+     * if @p seed is not valid, if the nucleotides of a window do not fit in
+     * 64 bits, or if canonical kmers are counted and @p seed is not 
+     * symmetric (the reverse complement of a spaced kmer is only a kmer of
+     * the same seed if the seed is its own reverse)
+     */
+    void setSeed(const std::string& seed);
+    
+    /**
+     * @brief Returns the memory used by the matrix of frequencies (see 
+     * CounterTable::getMemory()).
+     * Query method
+     * @return The number of bytes
+     */
+    long long getMemory() const;
+    
+    /**
+     * @brief Obtains the complementary nucleotide of each nucleotide of the
+     * given set: A and T (or U in RNA) are complementary, and so are C and G.
+     * For example, the complementary nucleotides of "ACGT" are "TGCA", and 
+     * the ones of "ACGU" are "UGCA".
+     * @param validNucleotides A set of nucleotides. Input parameter
+     * @throw std::invalid_argument Throws an std::invalid_argument exception
+     * if the complementary nucleotide of some nucleotide of 
+     * @p validNucleotides is not in that set, or it is not unique
+     * @return A string with the complementary nucleotide of each nucleotide
+     * of @p validNucleotides
+     */
+    static std::string GetComplementaryNucleotides(
+        const std::string& validNucleotides);
+    
     /**
      * @brief Obtains a string with the following content:
      * - In the first line, the content of the private data _allNucleotides and
@@ -141,12 +372,15 @@ public:
      * @throw std::invalid_argument This method throws an 
      * std::invalid_argument exception if the given kmer contains any
      * invalid nucleotide.
+     * @throw std::out_of_range This method throws an std::out_of_range 
+     * exception if @p frequency is negative or the frequency of the kmer 
+     * would exceed \f$2^{63}-1\f$
      * @param kmer The kmer in which the frequency will be modified. 
      * Input parameter
      * @param frequency The quantity that will be added to the current 
      * frequency. Input parameter
      */
-    void increaseFrequency(const Kmer& kmer, int frequency = 1);
+    void increaseFrequency(const Kmer& kmer, long long frequency = 1);
 
     /**
      * @brief Overloading of the assignment operator.
@@ -166,7 +400,10 @@ public:
      * @throw std::invalid_argument This method throws an 
      * std::invalid_argument exception if the given argument @p kc has a different
      * set of nucleotides or a different K (number of nucleotides in
-     * kmers).
+     * kmers), or only one of them counts canonical kmers or only the kmers
+     * without missing nucleotides, or their seeds are different.
+     * @throw std::out_of_range Throws a std::out_of_range exception if a 
+     * frequency would exceed \f$2^{63}-1\f$
      * @return A reference to this object
      */
     KmerCounter& operator+=(const KmerCounter& kc);
@@ -186,6 +423,74 @@ public:
      */
     void calculateFrequencies(const char* fileName);
 
+    /**
+     * @brief Reads the DNA of the given text file in the same way as 
+     * calculateFrequencies(const char*), its first word, and applies the 
+     * given filter to it (see SequenceFilter). So the frequencies of the 
+     * filtered DNA are the ones calculated by 
+     * calculateSequenceFrequencies() with the returned sequence.
+     * @param fileName The name of the file to process. Input parameter
+     * @param filter The filter applied to the DNA. Input parameter
+     * @throw std::ios_base::failure Throws a std::ios_base::failure if the
+     * given file cannot be opened
+     * @return The filtered DNA of the file
+     */
+    static std::string ReadSequence(const char* fileName, 
+            const SequenceFilter& filter);
+
+    /**
+     * @brief Calculates the frequencies of each kmer in the given sequence of
+     * nucleotides, in the same way as calculateFrequencies(const char*):
+     * each kmer is normalized (see Kmer::normalize()) and the frequency of
+     * each kmer is set to zero before starting. The kmers are not built as
+     * Kmer objects: the position of each kmer in the matrix is obtained from
+     * the position of the previous one.
+     * Modifier method
+     * @param sequence A sequence of nucleotides. Input parameter
+     */
+    void calculateSequenceFrequencies(const std::string& sequence);
+
+    /**
+     * @brief Adds to the current frequencies the ones of the kmers of the
+     * given sequence of nucleotides, which are calculated as in
+     * calculateSequenceFrequencies(), but without setting the frequencies
+     * to zero before. A long sequence can be counted in consecutive pieces
+     * if each piece begins with the last getSpan()-1 nucleotides of the 
+     * previous one.
+     * 
+     * With several threads, the sequence is divided in pieces (see 
+     * ForEachPiece()) that are counted at the same time in the matrix of
+     * this object, whose counters are increased with relaxed atomic 
+     * increments. So the memory does not depend on the number of threads,
+     * and the frequencies are the same as with a thread. The partitioned
+     * engine (see setPartitioned()) is only used with a thread.
+     * Modifier method
+     * @param sequence A sequence of nucleotides. Input parameter
+     * @param numThreads The number of threads. Input parameter
+     */
+    void addSequenceFrequencies(const std::string& sequence, 
+        int numThreads = 1);
+    
+    /**
+     * @brief Divides a sequence in pieces whose kmers are counted by 
+     * several threads: each piece has the nucleotides of a range of 
+     * consecutive kmers, so it overlaps the next piece in k-1 nucleotides,
+     * and each thread counts the next piece that is not counted yet. The 
+     * counter of the kmers should be shared by the threads.
+     * @param length The number of nucleotides of the sequence. Input 
+     * parameter
+     * @param k The number of nucleotides of a kmer. Input parameter
+     * @param numThreads The number of threads. Input parameter
+     * @param countPiece The function that counts the kmers of a piece, 
+     * given the position of its first nucleotide and the position after its
+     * last nucleotide. Input parameter
+     * @throw std::exception Throws the first exception thrown by 
+     * @p countPiece, once all the threads have finished. The pieces that 
+     * were not counted yet are skipped
+     */
+    static void ForEachPiece(int length, int k, int numThreads,
+        const std::function<void(int, int)>& countPiece);
+
     /**
      * @brief Builds a Profile object from this KmerCounter object. The 
      * Profile will contain the kmers and frequencies for those one with 
@@ -198,6 +503,9 @@ public:
      * vector of kmers. If you need an ordered vector of kmers, you must sort
      * (using Profile::sort() method) the returned Profile after calling to 
      * this method.
+     * If the kmers are counted with a spaced seed, the parameters of the
+     * Profile are SEED=seed (for example, "seed=1101011"), so it is only 
+     * compared with the profiles of the same seed.
      * Query method
      * 
      * @return A Profile object from this KmerCounter object
@@ -205,7 +513,12 @@ public:
     Profile toProfile() const;
 
 private:
-    int** _frequency; ///< 2D matrix with the frequency of each kmer
+    /**
+     * 2D matrix with the frequency of each kmer. The rows are consecutive 
+     * in a single CounterTable: the counter of the row i and the column j is
+     * at the position i * getNumCols() + j
+     */
+    CounterTable _frequency;
     
     int _k; ///< Value of K (number of nucleotides in each kmer)
 
@@ -216,12 +529,40 @@ private:
      */
     std::string _validNucleotides;
     
+    /**
+     * Whether only the kmers without missing nucleotides are counted
+     */
+    bool _onlyValidKmers;
+    
     /**
      * Set with the character representing a missing (unknown) nucleotide
-     * (Kmer::MISSING_NUCLEOTIDE) and the set of valid nucleotides.
+     * (Kmer::MISSING_NUCLEOTIDE) and the set of valid nucleotides, or only 
+     * the set of valid nucleotides if only the kmers without missing 
+     * nucleotides are counted.
      */
     std::string _allNucleotides;
     
+    bool _canonical; ///< Whether canonical kmers are counted
+    
+    /**
+     * Complementary nucleotide of each nucleotide of _allNucleotides (the
+     * missing nucleotide is its own complementary), if canonical kmers are
+     * counted
+     */
+    std::string _complementaryNucleotides;
+    
+    /**
+     * Position in _allNucleotides of each character of a sequence, once 
+     * converted to uppercase (0 for the invalid ones)
+     */
+    NucleotideTable _table;
+    
+    int _prefetchDistance; ///< Number of kmers between a prefetch and its increment
+    
+    bool _partitioned; ///< Whether the counters are increased by partitions of the matrix
+    
+    std::string _seed; ///< Spaced seed of the kmers, or empty for consecutive nucleotides
+    
     /**
      * @brief Returns the numbers of rows of the matrix in this object.
      * Query method
@@ -277,6 +618,40 @@ private:
      */
     void getRowColumn(const Kmer& kmer, int& row, int& column) const;
 
+    /**
+     * @brief Checks whether the rows of the matrix only have one nucleotide
+     * of each complementary pair in the middle position, that is, whether
+     * canonical kmers are counted and k is odd
+     * Query method
+     * @return true if the rows only contain the canonical middle nucleotides
+     */
+    bool hasCanonicalRows() const;
+    
+    /**
+     * @brief Obtains the value in _allNucleotides of the nucleotide in the 
+     * middle of the kmers of each row position, for a matrix with canonical
+     * rows (see hasCanonicalRows()), and the row position of each value 
+     * (-1 for the nucleotides that cannot be in the middle).
+     * Query method
+     * @param middleValues The value of each middle position: the missing
+     * nucleotide and the first nucleotide of each complementary pair. It 
+     * should have space for getNumNucleotides() elements. Output parameter
+     * @param middlePositions The middle position of each value. It should 
+     * have space for getNumNucleotides() elements. Output parameter
+     * @return The number of middle positions
+     */
+    int getMiddles(int middleValues[], int middlePositions[]) const;
+    
+    /**
+     * @brief Returns the smaller one of the given kmer and its reverse 
+     * complement, in the order of _allNucleotides.
+     * Query method
+     * @param kmer A string with nucleotides of _allNucleotides. 
+     * Input parameter
+     * @return The canonical kmer of @p kmer
+     */
+    std::string getCanonicalKmer(const std::string& kmer) const;
+
     /**
      * @brief Returns the Kmer that is defined by the provided row and column 
      * Query method
@@ -291,6 +666,99 @@ private:
      */
     Kmer getKmer(int row, int column) const;
     
+    /**
+     * @brief Adds to the current frequencies the ones of the kmers of the
+     * given sequence (see addSequenceFrequencies())
+     * Modifier method
+     * @param text The nucleotides of the sequence. Input parameter
+     * @param length The number of nucleotides, at least k. Input parameter
+     * @param partitions The partitions of the matrix, or nullptr if the 
+     * counters are increased directly. Input/Output parameter
+     * @param shared Whether other threads are increasing the counters at 
+     * the same time. Input parameter
+     */
+    void countKmers(const char text[], int length, 
+        PartitionedCounters* partitions, bool shared);
+    
+    /**
+     * @brief Adds to the current frequencies the ones of all the kmers of 
+     * the given sequence, when the kmers with missing nucleotides are also
+     * counted (see countKmers())
+     * Modifier method
+     * @param text The nucleotides of the sequence. Input parameter
+     * @param length The number of nucleotides, at least k. Input parameter
+     * @param partitions The partitions of the matrix, or nullptr. 
+     * Input/Output parameter
+     * @param shared Whether the counters are shared. Input parameter
+     */
+    void countAllKmers(const char text[], int length, 
+        PartitionedCounters* partitions, bool shared);
+    
+    /**
+     * @brief Adds to the current frequencies the ones of the kmers without
+     * missing nucleotides of the given sequence, when only those kmers are 
+     * counted (see countKmers())
+     * Modifier method
+     * @param text The nucleotides of the sequence. Input parameter
+     * @param length The number of nucleotides. Input parameter
+     * @param partitions The partitions of the matrix, or nullptr. 
+     * Input/Output parameter
+     * @param shared Whether the counters are shared. Input parameter
+     */
+    void countValidKmers(const char text[], int length, 
+        PartitionedCounters* partitions, bool shared);
+    
+    /**
+     * @brief Adds to the current frequencies the ones of the spaced kmers of
+     * the given sequence, when the kmers are counted with a seed (see 
+     * countKmers() and setSeed())
+     * Modifier method
+     * @param text The nucleotides of the sequence. Input parameter
+     * @param length The number of nucleotides. Input parameter
+     * @param partitions The partitions of the matrix, or nullptr. 
+     * Input/Output parameter
+     * @param shared Whether the counters are shared. Input parameter
+     */
+    void countSpacedKmers(const char text[], int length, 
+        PartitionedCounters* partitions, bool shared);
+    
+    /**
+     * @brief Increases by 1 the counters of the kmers of a block of a 
+     * sequence, with the engine selected with setPartitioned(), or with 
+     * relaxed atomic increments if the counters are shared
+     * Modifier method
+     * @param cells The positions of the counters in _frequency. Input 
+     * parameter
+     * @param numCells The number of positions. Input parameter
+     * @param partitions The partitions of the matrix, or nullptr if the 
+     * counters are increased directly. Input/Output parameter
+     * @param shared Whether other threads are increasing the counters at 
+     * the same time. Input parameter
+     */
+    void increaseCells(const int cells[], int numCells, 
+        PartitionedCounters* partitions, bool shared);
+    
+    /**
+     * @brief Returns the position of the counter of a canonical kmer in 
+     * _frequency, given the positions of a kmer and its reverse complement
+     * as if the matrix had all the rows
+     * Query method
+     * @param index The position of the kmer. Input parameter
+     * @param reverse The position of the reverse complement of the kmer. 
+     * Input parameter
+     * @param numCols The number of columns of the matrix. Input parameter
+     * @param complements The value of the complementary nucleotide of each
+     * value. Input parameter
+     * @param numMiddles The number of middle positions (see getMiddles()),
+     * or 0 if the matrix has all the rows. Input parameter
+     * @param middlePositions The middle position of each value, if 
+     * @p numMiddles is not 0. Input parameter
+     * @return The position of the counter of the canonical kmer
+     */
+    int getCanonicalCell(int index, int reverse, int numCols, 
+        const int complements[], int numMiddles, 
+        const int middlePositions[]) const;
+    
     /**
      * @brief Sets the frequency of each kmer to 0, that is, it fills with 0 the 
      * matrix of frequencies
@@ -304,21 +772,9 @@ private:
      * Query method
      * @param row Row of the element. Input parameter
      * @param column Column of the element. Input parameter
-     * @return A const reference to the element at the given position
+     * @return The frequency of the element at the given position
      */
-    const int& operator()(int row, int column) const;
-
-    /**
-     * @brief Overloading of the () operator to access to the element at a 
-     * given position.
-     * Query and modifier method
-     * @param row Row of the element. Input parameter
-     * @param column Column of the element. Input parameter
-     * @return A reference to the element at the given position
-     */
-    int& operator()(int row, int column);
-    
-    void deallocate();
+    long long operator()(int row, int column) const;
 };
 
 #endif /* KMER_COUNTER_H */
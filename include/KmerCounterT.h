@@ -0,0 +1,426 @@
+/*
+ * Metodología de la Programación: Kmer5
+ * Curso 2023/2024
+ */
+
+/**
+ * @file KmerCounterT.h
+ */
+
+#ifndef KMER_COUNTER_T_H
+#define KMER_COUNTER_T_H
+
+#include <algorithm>
+#include <climits>
+#include <fstream>
+#include <string>
+#include <stdexcept>
+
+#include "CounterTable.h"
+#include "KmerCounter.h"
+#include "NucleotideTable.h"
+#include "PartitionedCounters.h"
+#include "PackedKmer.h"
+
+/**
+ * @class KmerCounterT
+ * @brief A KmerCounter for kmers of K nucleotides, with K fixed at compile
+ * time. It counts the kmers of a sequence in the same way as KmerCounter
+ * (without canonical kmers): the characters that are not valid nucleotides
+ * are taken as Kmer::MISSING_NUCLEOTIDE, lowercase nucleotides as uppercase
+ * ones, and each kmer is identified by its position in a table of
+ * \f$(|validNucleotides|+1)^K\f$ kmers.
+ *
+ * The Profile is built from PackedKmer objects instead of strings: the
+ * nucleotides of each kmer are packed in an integer whose order is the
+ * alphabetical order of the kmers, so the kmers are sorted by frequency with
+ * integer comparisons, and each string is only built once, when the Profile
+ * is filled. The loops over the K nucleotides are unrolled. At most
+ * PackedKmer<K>::MAX_SYMBOLS - 1 valid nucleotides are allowed. The 
+ * frequencies are kept in a CounterTable, as in KmerCounter, and the large
+ * tables can also be increased by partitions (see setPartitioned()).
+ */
+template <int K>
+class KmerCounterT {
+public:
+    /**
+     * @brief Constructor of the class. All the frequencies are 0.
+     * @param validNucleotides The set of nucleotides (characters) that are
+     * considered as part of a kmer. Input parameter
+     * @param cellBits The number of bits of each cell of the table of 
+     * frequencies (see KmerCounter::setCellBits()). Input parameter
+     * @throw std::invalid_argument Throws an std::invalid_argument exception
+     * if there are too many valid nucleotides, the table of kmers is too
+     * large or @p cellBits is not valid
+     */
+    KmerCounterT(const std::string& validNucleotides =
+            KmerCounter::DEFAULT_VALID_NUCLEOTIDES, 
+            int cellBits = CounterTable::DEFAULT_CELL_BITS): 
+            _table(validNucleotides) {
+        _allNucleotides = Kmer::MISSING_NUCLEOTIDE + validNucleotides;
+        int base = _allNucleotides.size();
+        if (base > PackedKmer<K>::MAX_SYMBOLS)
+            throw std::invalid_argument(std::string("KmerCounterT<K>::"
+                    "KmerCounterT(const std::string& validNucleotides): too "
+                    "many nucleotides in ") + validNucleotides);
+
+        long long numKmers = 1;
+        for (int i = 0; i < K; i++) {
+            numKmers *= base;
+            if (numKmers > INT_MAX)
+                throw std::invalid_argument(std::string("KmerCounterT<K>::"
+                        "KmerCounterT(const std::string& validNucleotides): "
+                        "the table of kmers is too large"));
+        }
+        _numKmers = numKmers;
+        _highPower = _numKmers / base;
+
+        // Rank of each value in the sorted set of nucleotides, used as the
+        //    symbols of the PackedKmers
+        _symbols = _allNucleotides;
+        std::sort(_symbols.begin(), _symbols.end());
+        for (int v = 0; v < base; v++) {
+            _ranks[v] = _symbols.find(_allNucleotides[v]);
+        }
+
+        _frequency.reset(_numKmers, cellBits);
+        _prefetchDistance = _numKmers >= PREFETCH_MIN_KMERS ?
+                KmerCounter::DEFAULT_PREFETCH_DISTANCE : 0;
+        _partitioned = false;
+    }
+
+    /**
+     * @brief Copy constructor
+     * @param orig the KmerCounterT object used as source for the copy.
+     * Input parameter
+     */
+    KmerCounterT(const KmerCounterT& orig): _frequency(orig._frequency),
+            _table(orig._table) {
+        copy(orig);
+    }
+
+    /**
+     * @brief Overloading of the assignment operator.
+     * Modifier method
+     * @param orig the KmerCounterT object used as source for the
+     * assignment. Input parameter
+     * @return A reference to this object
+     */
+    KmerCounterT& operator=(const KmerCounterT& orig) {
+        if (this != &orig) {
+            _frequency = orig._frequency;
+            _table = orig._table;
+            copy(orig);
+        }
+
+        return *this;
+    }
+
+    /**
+     * @brief Returns the number of nucleotides in each kmer
+     * Query method
+     * @return K
+     */
+    static int getK() {
+        return K;
+    }
+
+    /**
+     * @brief Returns the number of different kmers that can be built using
+     * K nucleotides (including the missing nucleotide)
+     * Query method
+     * @return The number of kmers of the table
+     */
+    int getNumKmers() const {
+        return _numKmers;
+    }
+
+    /**
+     * @brief Returns the number of kmers between the prefetch of the counter
+     * of a kmer and its increment (see KmerCounter::setPrefetchDistance()).
+     * Query method
+     * @return The prefetch distance, or 0 if the counters are not prefetched
+     */
+    int getPrefetchDistance() const {
+        return _prefetchDistance;
+    }
+
+    /**
+     * @brief Sets the number of kmers between the prefetch of the counter of
+     * a kmer and its increment, as KmerCounter::setPrefetchDistance().
+     * Modifier method
+     * @param prefetchDistance The number of kmers, or 0 to increase the
+     * counters without prefetching them. Input parameter
+     * @throw std::invalid_argument Throws an std::invalid_argument exception
+     * if @p prefetchDistance is negative or greater than
+     * KmerCounter::MAX_PREFETCH_DISTANCE
+     */
+    void setPrefetchDistance(int prefetchDistance) {
+        if (prefetchDistance < 0 ||
+                prefetchDistance > KmerCounter::MAX_PREFETCH_DISTANCE)
+            throw std::invalid_argument(std::string("void KmerCounterT<K>::"
+                    "setPrefetchDistance(int prefetchDistance): invalid "
+                    "distance ") + std::to_string(prefetchDistance));
+        _prefetchDistance = prefetchDistance;
+    }
+
+    /**
+     * @brief Returns whether the kmers are counted by partitions of the 
+     * table (see setPartitioned()).
+     * Query method
+     * @return true if the counters are increased by partitions; false if 
+     * they are increased in the order of the kmers
+     */
+    bool isPartitioned() const {
+        return _partitioned;
+    }
+
+    /**
+     * @brief Selects how the counters of the kmers of a sequence are 
+     * increased, as KmerCounter::setPartitioned(). By default, they are
+     * increased in the order of the kmers.
+     * Modifier method
+     * @param partitioned Whether the counters are increased by partitions.
+     * Input parameter
+     */
+    void setPartitioned(bool partitioned) {
+        _partitioned = partitioned;
+    }
+
+    /**
+     * @brief Gets the number of kmers with a frequency greater than 0
+     * Query method
+     * @return the number of kmers with a frequency greater than 0
+     */
+    int getNumberActiveKmers() const {
+        return _frequency.getNumNonZero();
+    }
+
+    /**
+     * @brief Reads the first word of the given text file and calculates the
+     * frequencies of its kmers, as KmerCounter::calculateFrequencies().
+     * Modifier method
+     * @param fileName The name of the file to process. Input parameter
+     * @throw std::ios_base::failure Throws a std::ios_base::failure if the
+     * given file cannot be opened
+     */
+    void calculateFrequencies(const char* fileName) {
+        std::ifstream input(fileName);
+        if (!input)
+            throw std::ios_base::failure(std::string("void KmerCounterT<K>::"
+                    "calculateFrequencies(const char* fileName): the given "
+                    "file cannot be opened\n"));
+
+        std::string sequence;
+        input >> sequence;
+        calculateSequenceFrequencies(sequence);
+    }
+
+    /**
+     * @brief Calculates the frequencies of the kmers of the given sequence
+     * of nucleotides, setting the frequencies to zero before.
+     * Modifier method
+     * @param sequence A sequence of nucleotides. Input parameter
+     */
+    void calculateSequenceFrequencies(const std::string& sequence) {
+        _frequency.clear();
+        addSequenceFrequencies(sequence);
+    }
+
+    /**
+     * @brief Adds to the current frequencies the ones of the kmers of the
+     * given sequence of nucleotides.
+     * Modifier method
+     * @param sequence A sequence of nucleotides. Input parameter
+     */
+    void addSequenceFrequencies(const std::string& sequence) {
+        int length = sequence.size();
+        if (length - K + 1 <= 0)
+            return;
+
+        // The sequence is translated by blocks, and the first block has at
+        //    least the K-1 nucleotides that begin the first kmer. The 
+        //    counters of a block are increased with prefetches, or by 
+        //    partitions, as in KmerCounter
+        PartitionedCounters* partitions = nullptr;
+        if (_partitioned) {
+            partitions = new PartitionedCounters(_frequency);
+        }
+        int base = _allNucleotides.size();
+        const char* text = sequence.data();
+        unsigned char values[TRANSLATION_BLOCK];
+        int cells[TRANSLATION_BLOCK];
+        int index = 0;
+        for (int start = 0; start < length; start += TRANSLATION_BLOCK) {
+            int size = length - start < TRANSLATION_BLOCK ?
+                    length - start : TRANSLATION_BLOCK;
+            _table.translate(text + start, size, values);
+            int i = 0;
+            int numCells = 0;
+            if (start == 0) {
+                auto first = [&](int j) {
+                    index = index * base + values[j];
+                };
+                PackedLoop<K - 1>::Run(first);
+                i = K - 1;
+            }
+            for (; i < size; i++) {
+                index = (index % _highPower) * base + values[i];
+                if (index == 0) {
+                    // Only missing nucleotides: the same kmer until the
+                    //    next valid nucleotide
+                    int next = NucleotideTable::FindValid(values, i + 1, size);
+                    _frequency.add(0, next - i);
+                    i = next - 1;
+                    continue;
+                }
+                cells[numCells++] = index;
+            }
+            if (partitions != nullptr)
+                partitions->increase(cells, numCells);
+            else
+                _frequency.increase(cells, numCells, _prefetchDistance);
+        }
+        if (partitions != nullptr) {
+            partitions->flush();
+            delete partitions;
+        }
+    }
+
+    /**
+     * @brief Increases the current frequencies of the kmers of this object
+     * with the frequencies of the kmers of the given object.
+     * Modifier method
+     * @param kc a KmerCounterT object. Input parameter
+     * @throw std::invalid_argument This method throws an
+     * std::invalid_argument exception if the sets of nucleotides are not
+     * the same
+     * @return A reference to this object
+     */
+    KmerCounterT& operator+=(const KmerCounterT& kc) {
+        if (_allNucleotides != kc._allNucleotides)
+            throw std::invalid_argument(std::string("KmerCounterT<K>& "
+                    "KmerCounterT<K>::operator+=(const KmerCounterT<K>& kc): "
+                    "the nucleotides are different in each KmerCounterT"));
+
+        _frequency += kc._frequency;
+
+        return *this;
+    }
+
+    /**
+     * @brief Builds a Profile with the kmers with a frequency greater than
+     * 0, sorted as Profile::sort() does: in decreasing order of frequency,
+     * and in alphabetical order the kmers with the same frequency. So the
+     * returned Profile is the one of KmerCounter::toProfile() after
+     * Profile::zip() and Profile::sort().
+     * Query method
+     * @return A sorted Profile with the kmers of this object
+     */
+    Profile toProfile() const {
+        int base = _allNucleotides.size();
+        int numActive = getNumberActiveKmers();
+        Entry* entries = new Entry[numActive];
+        int pos = 0;
+        _frequency.forEachNonZero([&](int index, long long frequency) {
+            uint64_t code = 0;
+            int rest = index;
+            auto digit = [&](int i) {
+                code |= (uint64_t) _ranks[rest % base] <<
+                        (PackedKmer<K>::BITS * i);
+                rest /= base;
+            };
+            PackedLoop<K>::Run(digit);
+            entries[pos].frequency = frequency;
+            entries[pos].code = code;
+            pos++;
+        });
+
+        std::sort(entries, entries + numActive,
+                [](const Entry& a, const Entry& b) {
+                    return a.frequency > b.frequency ||
+                            (a.frequency == b.frequency && a.code < b.code);
+                });
+
+        Profile profile(numActive);
+        std::string text(K, Kmer::MISSING_NUCLEOTIDE);
+        for (int i = 0; i < numActive; i++) {
+            PackedKmer<K>(entries[i].code).decode(_symbols, text);
+            profile.at(i).setKmer(Kmer(text));
+            profile.at(i).setFrequency(entries[i].frequency);
+        }
+        delete[] entries;
+
+        return profile;
+    }
+
+private:
+    /**
+     * Number of nucleotides of a sequence that are translated at once by
+     * the NucleotideTable
+     */
+    static const int TRANSLATION_BLOCK = 4096;
+
+    /**
+     * Number of kmers of the table from which the counters are prefetched by
+     * default (a table of 1 MB)
+     */
+    static const int PREFETCH_MIN_KMERS = 1 << 18;
+
+    /**
+     * A kmer of the table and its frequency
+     */
+    struct Entry {
+        long long frequency; ///< Frequency of the kmer
+        uint64_t code; ///< Code of the PackedKmer of the kmer
+    };
+
+    std::string _allNucleotides; ///< Kmer::MISSING_NUCLEOTIDE followed by the valid nucleotides
+    std::string _symbols; ///< The characters of _allNucleotides, sorted
+    int _numKmers; ///< Number of kmers in the table
+    int _highPower; ///< Number of nucleotides (with the missing one) to the power K-1
+    int _prefetchDistance; ///< Number of kmers between a prefetch and its increment
+    bool _partitioned; ///< Whether the counters are increased by partitions of the table
+    CounterTable _frequency; ///< Frequency of each kmer
+    NucleotideTable _table; ///< Position in _allNucleotides of each character
+    int _ranks[PackedKmer<K>::MAX_SYMBOLS]; ///< Position in _symbols of each value
+
+    void copy(const KmerCounterT& orig) {
+        _allNucleotides = orig._allNucleotides;
+        _symbols = orig._symbols;
+        _numKmers = orig._numKmers;
+        _highPower = orig._highPower;
+        _prefetchDistance = orig._prefetchDistance;
+        _partitioned = orig._partitioned;
+        for (int v = 0; v < PackedKmer<K>::MAX_SYMBOLS; v++) {
+            _ranks[v] = orig._ranks[v];
+        }
+    }
+};
+
+/**
+ * @brief Learns the sorted Profile of a set of DNA files with a KmerCounterT
+ * specialized for the given value of k (from 1 to 12). The kmers of each file are counted
+ * as in KmerCounter::calculateFrequencies(), and the Profile is the one of
+ * KmerCounter::toProfile() after Profile::zip() and Profile::sort().
+ * @param k The number of nucleotides of a kmer. Input parameter
+ * @param validNucleotides The set of valid nucleotides. Input parameter
+ * @param fileNames The names of the DNA files. Input parameter
+ * @param numFiles The number of DNA files. Input parameter
+ * @param profile The learned Profile. Output parameter
+ * @param cellBits The number of bits of each cell of the table of 
+ * frequencies: 8, 16 or 32. Input parameter
+ * @param partitioned Whether the counters are increased by partitions of
+ * the table (see KmerCounterT::setPartitioned()). Input parameter
+ * @throw std::ios_base::failure Throws a std::ios_base::failure if some file
+ * cannot be opened
+ * @return true if the Profile has been learned; false if there is not a
+ * specialization for @p k and @p validNucleotides, or its table of kmers
+ * is too large (then @p profile is not modified)
+ */
+bool LearnSortedProfile(int k, const std::string& validNucleotides,
+        char* const fileNames[], int numFiles, Profile& profile,
+        int cellBits = CounterTable::DEFAULT_CELL_BITS, 
+        bool partitioned = false);
+
+#endif /* KMER_COUNTER_T_H */
@@ -18,7 +18,7 @@
 
 /**
  * @class KmerFreq
- * @brief A pair formed by a Kmer object and a frequency (an int), 
+ * @brief A pair formed by a Kmer object and a frequency (a long long), 
  * that gives the frequency of a Kmer (times it appears) in a genoma.
  */
 class KmerFreq {
@@ -42,7 +42,7 @@ public:
      * Query method
      * @return The frequency of this KmerFreq object
      */
-    int getFrequency() const;
+    long long getFrequency() const;
 
     /**
      * @brief Sets the Kmer of this KmerFreq object.
@@ -58,7 +58,7 @@ public:
      * @param frequency the new frequency value for this KmerFreq object. 
      * Input parameter
      */
-    void setFrequency(const int frequency);
+    void setFrequency(const long long frequency);
     
     /**
      * @brief Obtains a string with the string and frequency of the kmer
@@ -72,7 +72,7 @@ public:
     /**
      * @brief Writes this object to the given output stream. It first writes
      * the kmer of this object (using method Kmer::write(ostream&)) 
-     * and them the bytes of the frequency (an int value) in binary format 
+     * and them the bytes of the frequency (a long long value) in binary format 
      * (using method ostream::write(const char* s, streamsize n))
      * Query method
      * @param outputStream An output stream where this object will be written
@@ -82,7 +82,7 @@ public:
     /**
      * @brief Reads this object from the given input stream. It first reads
      * the Kmer of this object (using method Kmer::read(std::istream&) and 
-     * then the bytes of the frequency (an int value) in binary format (using 
+     * then the bytes of the frequency (a long long value) in binary format (using 
      * method istream::read(char* s, streamsize n))
      * Modifier method
      * @param inputStream An input stream from which this object will be read
@@ -91,7 +91,7 @@ public:
     
 private:
     Kmer _kmer; ///< the Kmer object
-    int _frequency; ///< the frequency
+    long long _frequency; ///< the frequency
 }; // end class KmerFreq
 
 /**
@@ -0,0 +1,207 @@
+/*
+ * Metodología de la Programación: Kmer5
+ * Curso 2023/2024
+ */
+
+/**
+ * @file KmerIndex.h
+ */
+
+#ifndef KMER_INDEX_H
+#define KMER_INDEX_H
+
+#include <iostream>
+#include <string>
+
+#include "Profile.h"
+
+/**
+ * @class KmerIndex
+ * @brief A hash table that maps each kmer of a set of reference Profiles to
+ * the reference that contains it. It is used to classify each read of a
+ * sequencing file (see CLASSIFYREADS) instead of the whole file.
+ *
+ * A kmer that appears in several references is mapped to AMBIGUOUS, which
+ * is the lowest common ancestor of those references when no taxonomy is
+ * available. The references are identified by an integer (for example,
+ * their position in a ProfileDatabase).
+ *
+ * The kmers are stored as integer codes: the kmer is read as a number in
+ * base the number of valid nucleotides, where the value of each nucleotide
+ * is its position in the set of valid nucleotides. Kmers with other
+ * characters are not stored. The table uses open addressing with linear
+ * probing, and it is saved in a binary file as it is in memory, so loading
+ * it does not need to insert the kmers again.
+ */
+class KmerIndex {
+public:
+    /**
+     * Reference of a kmer that appears in several references, or of a
+     * read whose votes are tied
+     */
+    static const int AMBIGUOUS = -1;
+
+    /**
+     * Reference of a kmer that is not in the table, or of a read without
+     * enough kmers in the table
+     */
+    static const int NOT_FOUND = -2;
+
+    /**
+     * @brief Base constructor. It builds an empty index for kmers of @p k
+     * nucleotides from the set @p validNucleotides.
+     * @throw std::invalid_argument Throws an std::invalid_argument exception
+     * if @p k is less or equal than zero, or if the codes of the kmers do
+     * not fit in 64 bits
+     * @param k The number of nucleotides of a kmer. Input parameter
+     * @param validNucleotides The set of valid nucleotides. Input parameter
+     */
+    KmerIndex(int k = 5, const std::string& validNucleotides = "ACGT");
+
+    /**
+     * @brief Destructor
+     */
+    ~KmerIndex();
+
+    /**
+     * @brief Returns the number of nucleotides of the kmers of this index.
+     * Query method
+     * @return The number of nucleotides of the kmers
+     */
+    int getK() const;
+
+    /**
+     * @brief Returns the set of valid nucleotides of this index.
+     * Query method
+     * @return A const reference to the set of valid nucleotides
+     */
+    const std::string& getValidNucleotides() const;
+
+    /**
+     * @brief Returns the number of references of this index, that is, the
+     * greatest identifier of a reference plus one.
+     * Query method
+     * @return The number of references
+     */
+    int getNumReferences() const;
+
+    /**
+     * @brief Returns the number of distinct kmers in this index.
+     * Query method
+     * @return The number of kmers
+     */
+    long long getSize() const;
+
+    /**
+     * @brief Adds the kmers of the given Profile as kmers of the given
+     * reference. Kmers with characters that are not valid nucleotides, or
+     * with a different length, are skipped.
+     * Modifier method
+     * @param profile A Profile object. Input parameter
+     * @param reference The identifier of the reference (greater or equal
+     * than 0). Input parameter
+     * @throw std::invalid_argument Throws an std::invalid_argument exception
+     * if @p reference is negative
+     */
+    void addProfile(const Profile& profile, int reference);
+
+    /**
+     * @brief Returns the reference of the given kmer.
+     * Query method
+     * @param kmer A Kmer object. Input parameter
+     * @return The reference of the kmer, AMBIGUOUS or NOT_FOUND
+     */
+    int find(const Kmer& kmer) const;
+
+    /**
+     * @brief Classifies a sequence (for example, a read) by majority vote:
+     * each of its kmers votes for its reference, and the reference with
+     * most votes is returned. Lowercase nucleotides are taken as uppercase
+     * ones, and kmers with invalid characters are skipped.
+     * This method only reads the table, so it can be called by several
+     * threads at the same time, each one with its own auxiliary arrays.
+     * Query method
+     * @param sequence The characters of the sequence. Input parameter
+     * @param length The number of characters of the sequence. Input parameter
+     * @param minVotes The minimum number of votes of the winner reference.
+     * Input parameter
+     * @param votes Auxiliary array with getNumReferences() elements, all of
+     * them equal to 0. They are also equal to 0 when this method returns.
+     * Input/Output parameter
+     * @param voted Auxiliary array with space for @p length elements.
+     * Output parameter
+     * @return The reference with most votes, AMBIGUOUS if there is a tie or
+     * NOT_FOUND if no reference has @p minVotes votes
+     */
+    int classify(const char sequence[], int length, int minVotes,
+        int votes[], int voted[]) const;
+
+    /**
+     * @brief Saves this index in the given file.
+     * Query method
+     * @param fileName A c-string with the name of the file. Input parameter
+     * @throw std::ios_base::failure Throws a std::ios_base::failure exception
+     * if the given file cannot be opened or if an error occurs while writing
+     * to the file
+     */
+    void save(const char fileName[]) const;
+
+    /**
+     * @brief Loads this index from the given file.
+     * Modifier method
+     * @param fileName A c-string with the name of the file. Input parameter
+     * @throw std::ios_base::failure Throws a std::ios_base::failure exception
+     * if the given file cannot be opened, if an error occurs while reading
+     * from the file or if the header or the references of the kmers found in
+     * the file are not valid
+     * @throw std::invalid_argument Throws a std::invalid_argument exception if
+     * an invalid magic string is found in the given file
+     */
+    void load(const char fileName[]);
+
+private:
+    int _k; ///< Number of nucleotides of a kmer
+    std::string _validNucleotides; ///< Set of valid nucleotides
+    int _numReferences; ///< Greatest identifier of a reference plus one
+    unsigned long long* _keys; ///< Code of the kmer of each slot plus one (0 in an empty slot)
+    int* _references; ///< Reference of the kmer of each slot
+    long long _capacity; ///< Number of slots (a power of 2)
+    long long _size; ///< Number of used slots
+    unsigned long long _highPower; ///< Number of valid nucleotides to the power k-1
+    signed char _values[256]; ///< Value of each character as a nucleotide, or -1
+
+    static const std::string MAGIC_STRING; ///< A const string with the magic string for index files
+    static const long long INITIAL_CAPACITY = 1024; ///< Initial number of slots
+
+    void allocate(long long capacity);
+    void deallocate();
+
+    /**
+     * @brief Builds the table _values and _highPower from _k and
+     * _validNucleotides
+     * @throw std::invalid_argument Throws an std::invalid_argument exception
+     * if the codes of the kmers do not fit in 64 bits
+     */
+    void initValues();
+
+    /**
+     * @brief Returns the slot of a code: the one that contains it, or the
+     * empty slot where it should be inserted
+     * @param key The code of a kmer plus one. Input parameter
+     * @return The position of the slot
+     */
+    long long findSlot(unsigned long long key) const;
+
+    /**
+     * @brief Inserts a kmer code of a reference. If the kmer is already in
+     * the table with another reference, its reference becomes AMBIGUOUS
+     * @param code The code of the kmer. Input parameter
+     * @param reference The identifier of the reference. Input parameter
+     */
+    void insert(unsigned long long code, int reference);
+
+    KmerIndex(const KmerIndex& orig); ///< Not copyable
+    KmerIndex& operator=(const KmerIndex& orig); ///< Not copyable
+};
+
+#endif /* KMER_INDEX_H */
@@ -0,0 +1,101 @@
+/*
+ * Metodología de la Programación: Kmer5
+ * Curso 2023/2024
+ */
+
+/**
+ * @file NucleotideTable.h
+ */
+
+#ifndef NUCLEOTIDE_TABLE_H
+#define NUCLEOTIDE_TABLE_H
+
+#include <string>
+
+/**
+ * @class NucleotideTable
+ * @brief A lookup table that classifies the 256 possible characters of a
+ * sequence for a given set of valid nucleotides. Each character is mapped in
+ * a single access to its code: its position in Kmer::MISSING_NUCLEOTIDE
+ * followed by the valid nucleotides, after converting it to uppercase, or 0
+ * (the missing nucleotide) if it is not a valid nucleotide. So lowercase
+ * (soft-masked) nucleotides have the same code as the uppercase ones, and
+ * the codes are the values used by KmerCounter and Kmer::normalize().
+ *
+ * Whole blocks of characters can also be translated to codes before the
+ * kmers are counted. When SSE2 is available, 16 characters are translated
+ * at once, comparing them with each valid nucleotide.
+ */
+class NucleotideTable {
+public:
+    /**
+     * Maximum number of valid nucleotides that are translated with SIMD
+     * instructions. Larger sets are translated with the table
+     */
+    static const int MAX_SIMD_NUCLEOTIDES = 16;
+
+    /**
+     * @brief Constructor of the class
+     * @param validNucleotides The set of valid nucleotides. Input parameter
+     */
+    NucleotideTable(const std::string& validNucleotides);
+
+    /**
+     * @brief Returns the code of the given character
+     * Query method
+     * @param c A character. Input parameter
+     * @return The position of the uppercase @p c in Kmer::MISSING_NUCLEOTIDE
+     * followed by the valid nucleotides, or 0 if it is not a valid nucleotide
+     */
+    int getCode(char c) const {
+        return _codes[(unsigned char)c];
+    }
+
+    /**
+     * @brief Returns the given character normalized, as in Kmer::normalize()
+     * Query method
+     * @param c A character. Input parameter
+     * @return The uppercase @p c if it is a valid nucleotide, or
+     * Kmer::MISSING_NUCLEOTIDE otherwise
+     */
+    char getNucleotide(char c) const {
+        return _nucleotides[(unsigned char)c];
+    }
+
+    /**
+     * @brief Translates a block of characters to their codes (see getCode())
+     * Query method
+     * @param text The characters. Input parameter
+     * @param length The number of characters of @p text. Input parameter
+     * @param codes The code of each character. It should have space for
+     * @p length elements. Output parameter
+     */
+    void translate(const char text[], int length, unsigned char codes[]) const;
+
+    /**
+     * @brief Finds the next valid nucleotide in a block of codes, skipping a
+     * run of invalid characters (code 0), like the long runs of N of the
+     * gaps of an assembly. When SSE2 is available, 16 codes are checked at
+     * once.
+     * @param codes The codes of a block of characters. Input parameter
+     * @param from The first position to check. Input parameter
+     * @param length The number of codes of the block. Input parameter
+     * @return The first position from @p from with a code greater than 0,
+     * or @p length if there is none
+     */
+    static int FindValid(const unsigned char codes[], int from, int length);
+
+private:
+    unsigned char _codes[256]; ///< Code of each character
+    char _nucleotides[256]; ///< Normalized nucleotide of each character
+
+    /**
+     * Number of characters compared with the uppercase characters of a
+     * block in translate(), or 0 if the table is used
+     */
+    int _numSimdNucleotides;
+    char _simdNucleotides[MAX_SIMD_NUCLEOTIDES]; ///< Characters with a code greater than 0
+    unsigned char _simdCodes[MAX_SIMD_NUCLEOTIDES]; ///< Code of each one of _simdNucleotides
+};
+
+#endif /* NUCLEOTIDE_TABLE_H */
@@ -0,0 +1,254 @@
+/*
+ * Metodología de la Programación: Kmer5
+ * Curso 2023/2024
+ */
+
+/**
+ * @file PackedKmer.h
+ */
+
+#ifndef PACKED_KMER_H
+#define PACKED_KMER_H
+
+#include <cstdint>
+#include <string>
+#include <stdexcept>
+
+#include "Kmer.h"
+
+/**
+ * @brief Calls a function for the positions 0, 1, ..., N-1. The calls are
+ * generated at compile time, so the loop is unrolled.
+ */
+template <int N>
+struct PackedLoop {
+    /**
+     * @brief Calls @p f(i) for each position i from 0 to N-1
+     * @param f A function object. Input/Output parameter
+     */
+    template <class F>
+    static void Run(F& f) {
+        PackedLoop<N - 1>::Run(f);
+        f(N - 1);
+    }
+};
+
+/**
+ * @brief End of the recursion of PackedLoop
+ */
+template <>
+struct PackedLoop<0> {
+    template <class F>
+    static void Run(F&) {}
+};
+
+/**
+ * @class PackedKmer
+ * @brief A Kmer of K nucleotides packed in an integer, with 3 bits for each
+ * nucleotide, so up to 21 nucleotides fit in 64 bits.
+ *
+ * Each nucleotide is stored as its position in a set of at most 8 symbols,
+ * which usually contains Kmer::MISSING_NUCLEOTIDE and the valid nucleotides.
+ * The first nucleotide is stored in the most significant bits, so if the
+ * symbols are sorted, the order of the codes is the alphabetical order of
+ * the kmers and two kmers are compared with a single integer comparison.
+ *
+ * The value of K is fixed at compile time, so the loops over the nucleotides
+ * are unrolled. The conversions from and to strings and Kmer objects are
+ * only needed to read and write kmers.
+ */
+template <int K>
+class PackedKmer {
+    static_assert(K > 0 && K <= 21, "PackedKmer: K must be in [1, 21]");
+
+public:
+    /**
+     * Number of bits of each nucleotide
+     */
+    static const int BITS = 3;
+
+    /**
+     * Maximum number of symbols
+     */
+    static const int MAX_SYMBOLS = 1 << BITS;
+
+    /**
+     * Mask with the bits of the K nucleotides
+     */
+    static const uint64_t MASK = ((uint64_t)1 << (K * BITS)) - 1;
+
+    /**
+     * @brief Base constructor. It builds the kmer whose nucleotides are
+     * all the first symbol.
+     */
+    PackedKmer(): _code(0) {}
+
+    /**
+     * @brief It builds a PackedKmer from its code.
+     * @param code The packed nucleotides. Only the bits of K nucleotides
+     * are used. Input parameter
+     */
+    explicit PackedKmer(uint64_t code): _code(code & MASK) {}
+
+    /**
+     * @brief It builds a PackedKmer from a string with K nucleotides.
+     * @param text A string with K characters of @p symbols. Input parameter
+     * @param symbols The set of symbols. Input parameter
+     * @throw std::invalid_argument Throws an std::invalid_argument exception
+     * if the length of @p text is not K, if some character is not in
+     * @p symbols or if there are more than MAX_SYMBOLS symbols
+     */
+    PackedKmer(const std::string& text, const std::string& symbols) {
+        if ((int) text.size() != K || (int) symbols.size() > MAX_SYMBOLS)
+            throw std::invalid_argument(std::string("PackedKmer<K>::"
+                    "PackedKmer(const std::string& text, const std::string& "
+                    "symbols): invalid length of ") + text);
+
+        _code = 0;
+        for (int i = 0; i < K; i++) {
+            size_t value = symbols.find(text[i]);
+            if (value == std::string::npos)
+                throw std::invalid_argument(std::string("PackedKmer<K>::"
+                        "PackedKmer(const std::string& text, const "
+                        "std::string& symbols): invalid nucleotide in ") +
+                        text);
+            _code = (_code << BITS) | value;
+        }
+    }
+
+    /**
+     * @brief Returns the number of nucleotides of this kmer.
+     * Query method
+     * @return K
+     */
+    static int getK() {
+        return K;
+    }
+
+    /**
+     * @brief Returns the packed nucleotides of this kmer.
+     * Query method
+     * @return The code of this kmer
+     */
+    uint64_t getCode() const {
+        return _code;
+    }
+
+    /**
+     * @brief Returns the position in the set of symbols of the nucleotide
+     * at the given position.
+     * Query method
+     * @param index A position from 0 to K-1. Input parameter
+     * @return The value of the nucleotide at position @p index
+     */
+    int at(int index) const {
+        return (_code >> ((K - 1 - index) * BITS)) & (MAX_SYMBOLS - 1);
+    }
+
+    /**
+     * @brief Removes the first nucleotide of this kmer and appends a
+     * nucleotide at its end, as when a window of K nucleotides moves over a
+     * sequence.
+     * Modifier method
+     * @param value The position in the set of symbols of the new nucleotide.
+     * Input parameter
+     */
+    void push(int value) {
+        _code = ((_code << BITS) | value) & MASK;
+    }
+
+    /**
+     * @brief Returns the reverse complement of this kmer.
+     * Query method
+     * @param complements The value of the complementary symbol of each
+     * symbol. Input parameter
+     * @return The reverse complement of this kmer
+     */
+    PackedKmer reverseComplement(const int complements[]) const {
+        uint64_t code = _code;
+        uint64_t reverse = 0;
+        auto step = [&](int) {
+            reverse = (reverse << BITS) |
+                    complements[code & (MAX_SYMBOLS - 1)];
+            code >>= BITS;
+        };
+        PackedLoop<K>::Run(step);
+
+        return PackedKmer(reverse);
+    }
+
+    /**
+     * @brief Writes the nucleotides of this kmer in a string.
+     * Query method
+     * @param symbols The set of symbols. Input parameter
+     * @param text A string with at least K characters, where the
+     * nucleotides are written. Output parameter
+     */
+    void decode(const std::string& symbols, std::string& text) const {
+        uint64_t code = _code;
+        auto step = [&](int i) {
+            text[K - 1 - i] = symbols[code & (MAX_SYMBOLS - 1)];
+            code >>= BITS;
+        };
+        PackedLoop<K>::Run(step);
+    }
+
+    /**
+     * @brief Returns a string with the nucleotides of this kmer.
+     * Query method
+     * @param symbols The set of symbols. Input parameter
+     * @return A string with K nucleotides
+     */
+    std::string toString(const std::string& symbols) const {
+        std::string text(K, Kmer::MISSING_NUCLEOTIDE);
+        decode(symbols, text);
+
+        return text;
+    }
+
+    /**
+     * @brief Returns a Kmer object with the nucleotides of this kmer.
+     * Query method
+     * @param symbols The set of symbols. Input parameter
+     * @return A Kmer with K nucleotides
+     */
+    Kmer toKmer(const std::string& symbols) const {
+        return Kmer(toString(symbols));
+    }
+
+    /**
+     * @brief Checks whether two kmers are equal.
+     * Query method
+     * @param other A PackedKmer. Input parameter
+     * @return true if both kmers have the same nucleotides
+     */
+    bool operator==(const PackedKmer& other) const {
+        return _code == other._code;
+    }
+
+    /**
+     * @brief Checks whether two kmers are different.
+     * Query method
+     * @param other A PackedKmer. Input parameter
+     * @return true if the kmers have different nucleotides
+     */
+    bool operator!=(const PackedKmer& other) const {
+        return _code != other._code;
+    }
+
+    /**
+     * @brief Compares two kmers in the order of their codes, which is the
+     * alphabetical order if the set of symbols is sorted.
+     * Query method
+     * @param other A PackedKmer. Input parameter
+     * @return true if this kmer is before @p other
+     */
+    bool operator<(const PackedKmer& other) const {
+        return _code < other._code;
+    }
+
+private:
+    uint64_t _code; ///< The packed nucleotides, the first one in the highest bits
+};
+
+#endif /* PACKED_KMER_H */
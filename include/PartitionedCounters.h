@@ -0,0 +1,97 @@
+/*
+ * Metodología de la Programación: Kmer5
+ * Curso 2023/2024
+ */
+
+/**
+ * @file PartitionedCounters.h
+ */
+
+#ifndef PARTITIONED_COUNTERS_H
+#define PARTITIONED_COUNTERS_H
+
+#include "CounterTable.h"
+
+/**
+ * @class PartitionedCounters
+ * @brief Increases the counters of a large table by partitions, instead of
+ * in the order in which the kmers are found. The table is divided in
+ * partitions of PARTITION_SIZE consecutive counters (a slice that fits in
+ * the L2 cache), and each increment is first appended to the buffer of its
+ * partition, selected with the high bits of the position of the counter.
+ * When the buffer of a partition is full, all its increments are done at
+ * once, so they only touch the slice of the table of that partition, which
+ * is already in the cache after the first ones.
+ *
+ * The increments that are still in the buffers are not in the table until
+ * flush() is called.
+ */
+class PartitionedCounters {
+public:
+    /**
+     * Number of bits of the position of a counter inside its partition
+     */
+    static const int PARTITION_BITS = 16;
+
+    /**
+     * Number of counters of a partition (256 KB of 32 bits cells)
+     */
+    static const int PARTITION_SIZE = 1 << PARTITION_BITS;
+
+    /**
+     * @brief Constructor of the class. The buffers of the partitions have
+     * space for about BUFFERED_INCREMENTS increments in total, and for at
+     * least MIN_PARTITION_BUFFER increments each one.
+     * @param counters The table of counters. It is not copied, so it should
+     * exist while this object is used. Input/Output parameter
+     */
+    PartitionedCounters(CounterTable& counters);
+
+    /**
+     * @brief Destructor. The increments that are still in the buffers are
+     * discarded (see flush()).
+     */
+    ~PartitionedCounters();
+
+    /**
+     * @brief Returns the number of partitions of the table
+     * Query method
+     * @return The number of partitions
+     */
+    int getNumPartitions() const;
+
+    /**
+     * @brief Increases by 1 each one of the given counters of the table. The
+     * increments are appended to the buffers of their partitions, and the
+     * ones of a full buffer are done.
+     * Modifier method
+     * @param cells The positions of the counters in the table. A position
+     * can appear several times. Input parameter
+     * @param numCells The number of positions. Input parameter
+     */
+    void increase(const int cells[], int numCells);
+
+    /**
+     * @brief Does the increments of all the buffers, partition by partition.
+     * Modifier method
+     */
+    void flush();
+
+private:
+    CounterTable& _counters; ///< The table of counters (not owned)
+    int _numPartitions; ///< Number of partitions of _counters
+    int _capacity; ///< Number of increments of the buffer of each partition
+    int* _offsets; ///< Buffers of the partitions: the positions of the counters to increase
+    int* _sizes; ///< Number of increments in the buffer of each partition
+
+    /**
+     * @brief Does the increments of the buffer of a partition
+     * @param partition The partition. Input parameter
+     */
+    void flush(int partition);
+
+    PartitionedCounters(const PartitionedCounters& orig); ///< Not copyable
+    PartitionedCounters& operator=(const PartitionedCounters& orig); ///< Not copyable
+};
+
+#endif /* PARTITIONED_COUNTERS_H */
@@ -82,6 +82,24 @@ public:
      */
     void setProfileId(const std::string& id);
 
+    /**
+     * @brief Returns the parameters of the counting of the kmers of this
+     * profile object that make it comparable only with the profiles counted
+     * in the same way, for example its sampling (see SampledKmerCounter).
+     * It is an empty string for a profile with all the kmers.
+     * Query method
+     * @return A const reference to the parameters of this profile object
+     */
+    const std::string& getParameters() const;
+
+    /**
+     * @brief Sets the parameters of the counting of the kmers of this
+     * profile object (see getParameters()).
+     * Modifier method
+     * @param parameters The new parameters, in a single line. Input parameter
+     */
+    void setParameters(const std::string& parameters);
+
 
     /**
      * @brief Gets a const reference to the KmerFreq at the given position 
@@ -151,6 +169,31 @@ public:
      */
     double getDistance(const Profile& otherProfile) const;
     
+    /**
+     * @brief Gets the distance between this Profile object and the given 
+     * argument object @p otherProfile (see getDistance(const Profile&)), 
+     * but stops as soon as it is known that the distance is greater than
+     * @p cutoff. As every term \f$| rank_{kmer_i(P_1)}^{P_1} - 
+     * rank_{kmer_i(P_1)}^{P_2} |\f$ is non-negative, the calculation stops 
+     * when the partial sum of the terms is greater than
+     * \f$cutoff * size(P_1) * size(P_2)\f$.
+     * This method is useful when searching the closest Profile to a given 
+     * one: the distance to the best Profile found so far can be used as 
+     * @p cutoff.
+     * Query method
+     * @param otherProfile A Profile object. Input parameter
+     * @param cutoff The maximum distance of interest. Input parameter
+     * @pre The list of kmers of this and otherProfile should be ordered in 
+     * decreasing order of frequency. This is not checked in this method.
+     * @throw Throws a std::invalid_argument exception if the implicit object
+     * (*this) or the argument Profile object are empty, that is, they do not 
+     * have any kmer.
+     * @return The distance between this Profile object and @p otherProfile
+     * if it is less or equals to @p cutoff. Otherwise, a value greater than
+     * @p cutoff (a lower bound of the distance).
+     */
+    double getDistanceBounded(const Profile& otherProfile, double cutoff) const;
+    
     /**
      * @brief Searchs the given kmer in the list of kmers in this
      * Profile, but only in positions from initialPos to finalPos 
@@ -200,7 +243,10 @@ public:
     void sort();
 
     /**
-     * @brief Saves this Profile object in the given file. 
+     * @brief Saves this Profile object in the given file. If the profile
+     * has parameters (see getParameters()), the magic string is the one of
+     * the version 1.1 of the format and it is followed by a line with the
+     * parameters.
      * Query method
      * @param fileName A c-string with the name of the file where this Profile 
      * object will be saved. Input parameter
@@ -230,6 +276,20 @@ public:
      * an invalid magic string is found in the given file
      */
     void load(const char fileName[]);
+
+    /**
+     * @brief Reads only the parameters (see getParameters()) of the Profile
+     * object stored in the given file, so they can be checked without
+     * loading its kmers.
+     * @param fileName A c-string with the name of the file where the Profile 
+     * is stored. Input parameter
+     * @throw std::ios_base::failure Throws a std::ios_base::failure exception 
+     * if the given file cannot be opened
+     * @throw throw std::invalid_argument Throws a std::invalid_argument if
+     * an invalid magic string is found in the given file
+     * @return The parameters of the Profile stored in the file
+     */
+    static std::string LoadParameters(const char fileName[]);
      
     /**
      * @brief Appends a copy of the given KmerFreq to this Profile object.
@@ -366,6 +426,7 @@ _G 5
     
 private:
     std::string _profileId; ///< Profile identifier
+    std::string _parameters; ///< Parameters of the counting of the kmers, or "" if all of them are counted
     KmerFreq* _vectorKmerFreq; ///< Dynamic array of KmerFreq
     int _size; ///< Number of used elements in the dynamic array _vectorKmerFreq
     int _capacity; ///< Number of reserved elements in the dynamic array _vectorKmerFreq
@@ -375,6 +436,8 @@ private:
 
     static const std::string MAGIC_STRING_T; ///< A const string with the magic string for text files
     static const std::string MAGIC_STRING_B; ///< A const string with the magic string for binary files
+    static const std::string MAGIC_STRING_TP; ///< A const string with the magic string for text files with parameters
+    static const std::string MAGIC_STRING_BP; ///< A const string with the magic string for binary files with parameters
     
     void allocate(int size);
     void deallocate();
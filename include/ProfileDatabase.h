@@ -0,0 +1,245 @@
+/*
+ * Metodología de la Programación: Kmer5
+ * Curso 2023/2024
+ */
+
+/**
+ * @file ProfileDatabase.h
+ */
+
+#ifndef PROFILE_DATABASE_H
+#define PROFILE_DATABASE_H
+
+#include <fstream>
+#include <string>
+
+#include "Profile.h"
+
+/**
+ * @class ProfileDatabase
+ * @brief A single binary file that contains a set of reference Profile
+ * objects. It is used to avoid passing thousands of .prf files to CLASSIFY.
+ *
+ * The layout of a database file is the following one:
+ * - A header: the magic string MAGIC_STRING followed by a '\\n', the number
+ * of profiles (a 32 bits int) and the position in the file of the offset
+ * table (a 64 bits int).
+ * - The payloads of the profiles, one after another. The payload of a
+ * profile with n kmers of k nucleotides is a packed block of n records of
+ * k characters (the kmer, without any separator) followed by the frequency
+ * (a 64 bits int in binary format, as the frequencies of a Profile).
+ * - The offset table, with an entry for each profile: the profile
+ * identifier, the value of k, the set of valid nucleotides, the number of
+ * kmers and the position of its payload in the file.
+ *
+ * Opening a database only reads the header and the offset table, so its
+ * cost depends on the number of profiles and not on their sizes. The kmers
+ * of a profile are only read from the file when the method getProfile() is
+ * called for it.
+ *
+ * A new database is written with create(), append() for each profile and
+ * close(), so the profiles do not need to be in memory at the same time.
+ * The header is only completed by close(): if the writing fails, the file
+ * is removed with discard().
+ */
+class ProfileDatabase {
+public:
+    /**
+     * @brief Base constructor. It builds a closed ProfileDatabase object,
+     * without any profile.
+     */
+    ProfileDatabase();
+
+    /**
+     * @brief Destructor. It closes the database file if it was open. A
+     * database written with create() that has not been closed with close()
+     * is discarded (see discard()), so an error while it is written does not
+     * leave a database that looks valid.
+     */
+    ~ProfileDatabase();
+
+    /**
+     * @brief Opens the given database file and reads its header and its
+     * offset table. The kmers of the profiles are not read.
+     * If this object was already open, it is closed first.
+     * Modifier method
+     * @param fileName A c-string with the name of the database file.
+     * Input parameter
+     * @throw std::ios_base::failure Throws a std::ios_base::failure exception
+     * if the given file cannot be opened, if an error occurs while reading
+     * from the file, or if the number of profiles, the offset table or the
+     * payloads do not fit in the size of the file (a truncated or corrupt
+     * database)
+     * @throw std::invalid_argument Throws a std::invalid_argument exception if
+     * an invalid magic string is found in the given file
+     */
+    void open(const char fileName[]);
+
+    /**
+     * @brief Creates a new empty database file where profiles can be
+     * written with append(). If this object was already open, it is closed
+     * first.
+     * Modifier method
+     * @param fileName A c-string with the name of the database file.
+     * Input parameter
+     * @throw std::ios_base::failure Throws a std::ios_base::failure exception
+     * if the given file cannot be opened
+     */
+    void create(const char fileName[]);
+
+    /**
+     * @brief Writes a profile at the end of a database opened with create().
+     * The value of k of the profile is obtained from the length of its first
+     * kmer.
+     * Modifier method
+     * @param profile The profile to write. Input parameter
+     * @param validNucleotides The set of valid nucleotides used to learn the
+     * profile. Input parameter
+     * @throw std::ios_base::failure Throws a std::ios_base::failure exception
+     * if the database has not been opened with create()
+     * @throw std::invalid_argument Throws a std::invalid_argument exception if
+     * the profile is empty or if it has parameters (see
+     * Profile::getParameters()), since the database only stores the profiles
+     * with all the kmers
+     */
+    void append(const Profile& profile, const std::string& validNucleotides);
+
+    /**
+     * @brief Closes the database file and removes the offset table of this
+     * object. If the database was opened with create(), the offset table is
+     * written before closing the file.
+     * Modifier method
+     * @throw std::ios_base::failure Throws a std::ios_base::failure exception
+     * if an error occurs while writing the file
+     */
+    void close();
+
+    /**
+     * @brief Closes a database opened with create() without writing its
+     * offset table, and removes its file. A database opened with open() is
+     * just closed, as with close().
+     * Modifier method
+     */
+    void discard();
+
+    /**
+     * @brief Returns the number of profiles in this database.
+     * Query method
+     * @return The number of profiles in this database
+     */
+    int getSize() const;
+
+    /**
+     * @brief Returns the identifier of the profile at the given position.
+     * Query method
+     * @param index The position of the profile. Input parameter
+     * @throw std::out_of_range Throws an std::out_of_range exception if the
+     * given index is not valid
+     * @return A const reference to the identifier of the profile
+     */
+    const std::string& getProfileId(int index) const;
+
+    /**
+     * @brief Returns the number of nucleotides of the kmers of the profile
+     * at the given position.
+     * Query method
+     * @param index The position of the profile. Input parameter
+     * @throw std::out_of_range Throws an std::out_of_range exception if the
+     * given index is not valid
+     * @return The number of nucleotides of the kmers of the profile
+     */
+    int getK(int index) const;
+
+    /**
+     * @brief Returns the set of valid nucleotides used to learn the profile
+     * at the given position.
+     * Query method
+     * @param index The position of the profile. Input parameter
+     * @throw std::out_of_range Throws an std::out_of_range exception if the
+     * given index is not valid
+     * @return A const reference to the set of valid nucleotides
+     */
+    const std::string& getValidNucleotides(int index) const;
+
+    /**
+     * @brief Returns the number of kmers of the profile at the given position.
+     * Query method
+     * @param index The position of the profile. Input parameter
+     * @throw std::out_of_range Throws an std::out_of_range exception if the
+     * given index is not valid
+     * @return The number of kmers of the profile
+     */
+    int getNumKmers(int index) const;
+
+    /**
+     * @brief Reads from the database file the profile at the given position.
+     * Only the payload of that profile is read from the file.
+     * Query method
+     * @param index The position of the profile. Input parameter
+     * @throw std::out_of_range Throws an std::out_of_range exception if the
+     * given index is not valid
+     * @throw std::ios_base::failure Throws a std::ios_base::failure exception
+     * if this object is not open or if an error occurs while reading
+     * from the file
+     * @return The profile at the given position
+     */
+    Profile getProfile(int index) const;
+
+    /**
+     * @brief Builds a database file with the profiles stored in the given
+     * .prf files (text or binary). The .prf files are loaded and written
+     * one by one, so only one of them is in memory at any time. The value
+     * of k of each profile is obtained from the length of its first kmer.
+     * @param fileName A c-string with the name of the database file to build.
+     * Input parameter
+     * @param profileFiles An array with the names of the .prf files.
+     * Input parameter
+     * @param numFiles The number of elements in @p profileFiles.
+     * Input parameter
+     * @param validNucleotides The set of valid nucleotides used to learn the
+     * profiles. Input parameter
+     * @throw std::ios_base::failure Throws a std::ios_base::failure exception
+     * if a file cannot be opened or if an error occurs while reading or
+     * writing a file
+     * @throw std::invalid_argument Throws a std::invalid_argument exception if
+     * some of the profiles is empty
+     * In case of an exception, the database file is removed.
+     */
+    static void build(const char fileName[], const std::string profileFiles[],
+        int numFiles, const std::string& validNucleotides);
+
+private:
+    /**
+     * @brief An entry of the offset table of the database
+     */
+    struct Entry {
+        std::string profileId; ///< Profile identifier
+        int k; ///< Number of nucleotides in each kmer
+        std::string validNucleotides; ///< Set of valid nucleotides
+        int numKmers; ///< Number of kmers in the profile
+        long long offset; ///< Position of the payload in the file
+    };
+
+    mutable std::ifstream _input; ///< The open database file
+    std::ofstream _output; ///< The database file opened with create()
+    std::string _fileName; ///< Name of the database file opened with create()
+    Entry* _entries; ///< Dynamic array with the offset table
+    int _size; ///< Number of entries in the offset table
+    int _capacity; ///< Capacity of the dynamic array _entries
+
+    static const std::string MAGIC_STRING; ///< A const string with the magic string for database files
+
+    /**
+     * @brief Checks that the given index is a valid position of the offset
+     * table.
+     * @param index The position to check. Input parameter
+     * @throw std::out_of_range Throws an std::out_of_range exception if the
+     * given index is not valid
+     */
+    void checkIndex(int index) const;
+
+    ProfileDatabase(const ProfileDatabase& orig); ///< Not copyable
+    ProfileDatabase& operator=(const ProfileDatabase& orig); ///< Not copyable
+};
+
+#endif /* PROFILE_DATABASE_H */
@@ -0,0 +1,177 @@
+/*
+ * Metodología de la Programación: Kmer5
+ * Curso 2023/2024
+ */
+
+/**
+ * @file RankVector.h
+ */
+
+#ifndef RANK_VECTOR_H
+#define RANK_VECTOR_H
+
+#include <iostream>
+
+#include "Profile.h"
+
+/**
+ * @class RankVector
+ * @brief A compact representation of the ranking of the kmers of a sorted
+ * Profile, used to compare Profiles with a true metric.
+ *
+ * The distance of Profile::getDistance() is not a metric: it is not
+ * symmetric and it only considers the kmers of the first Profile. The
+ * metric used by a RankVector is defined as follows. Given a depth
+ * \f$D\f$, each Profile \f$P\f$ is represented by the (infinite) vector
+ * \f$v_P\f$ indexed by all the possible kmers, with
+ * \f$v_P(kmer) = min(rank_{kmer}^{P}, D)\f$, where the rank of a kmer that
+ * does not appear in \f$P\f$ is \f$D\f$. The distance between two Profiles
+ * is the L1 distance between their vectors, scaled by a constant:
+ *
+ * \f$d(P_1, P_2) = \frac{\sum_{kmer} | v_{P_1}(kmer) - v_{P_2}(kmer) |}
+ * {D * D}\f$
+ *
+ * Only the kmers in the first \f$D\f$ positions of any of the two Profiles
+ * contribute to the sum. As an L1 distance between vectors, it is
+ * symmetric and it satisfies the triangle inequality, so it can be used by
+ * a metric tree (see class VPTree).
+ *
+ * A RankVector stores the hash values (see Sketch::Hash()) of the first
+ * \f$D\f$ kmers of the Profile, sorted in increasing order, together with
+ * their ranks, so the distance is calculated in O(D) by merging both lists.
+ *
+ * If the depth is not less than the number of kmers of the Profile, the
+ * RankVector is complete, and it can also be used to calculate the distance
+ * of Profile::getDistance() in linear time (see getProfileDistance()).
+ */
+class RankVector {
+public:
+    /**
+     * Default depth (number of ranked kmers)
+     */
+    static const int DEFAULT_DEPTH = 500;
+
+    /**
+     * @brief Base constructor. It builds an empty RankVector with the given
+     * depth.
+     * @throw std::invalid_argument Throws an std::invalid_argument exception
+     * if @p depth is less or equal than zero
+     * @param depth The number of ranked kmers. Input parameter
+     */
+    RankVector(int depth = DEFAULT_DEPTH);
+
+    /**
+     * @brief Copy constructor
+     * @param orig the RankVector object used as source for the copy. Input
+     * parameter
+     */
+    RankVector(const RankVector& orig);
+
+    /**
+     * @brief Destructor
+     */
+    ~RankVector();
+
+    /**
+     * @brief Overloading of the assignment operator for RankVector class.
+     * Modifier method
+     * @param orig the RankVector object used as source for the assignment.
+     * Input parameter
+     * @return A reference to this object
+     */
+    RankVector& operator=(const RankVector& orig);
+
+    /**
+     * @brief Returns the depth of this RankVector.
+     * Query method
+     * @return The depth of this RankVector
+     */
+    int getDepth() const;
+
+    /**
+     * @brief Returns the number of ranked kmers in this RankVector. It is
+     * less than the depth if the Profile had less kmers than that.
+     * Query method
+     * @return The number of ranked kmers
+     */
+    int getSize() const;
+
+    /**
+     * @brief Returns the number of kmers of the Profile used to build this
+     * RankVector.
+     * Query method
+     * @return The number of kmers of the Profile
+     */
+    int getProfileSize() const;
+
+    /**
+     * @brief Checks whether this RankVector contains all the kmers of its
+     * Profile.
+     * Query method
+     * @return true if the depth was not less than the size of the Profile;
+     * false otherwise
+     */
+    bool isComplete() const;
+
+    /**
+     * @brief Builds this RankVector with the first kmers of the given
+     * Profile.
+     * Modifier method
+     * @param profile A Profile object. Input parameter
+     * @pre The list of kmers of @p profile should be ordered in decreasing
+     * order of frequency. This is not checked in this method.
+     */
+    void build(const Profile& profile);
+
+    /**
+     * @brief Gets the metric distance between this RankVector and the given
+     * one (see the description of this class).
+     * Query method
+     * @param other A RankVector object. Input parameter
+     * @throw std::invalid_argument Throws an std::invalid_argument exception
+     * if the depths of both RankVectors are not the same
+     * @return The distance between both RankVectors
+     */
+    double getDistance(const RankVector& other) const;
+
+    /**
+     * @brief Gets the distance of Profile::getDistance() from the Profile of
+     * this RankVector (\f$P_1\f$) to the Profile of @p other (\f$P_2\f$).
+     * Instead of searching each kmer of \f$P_1\f$ in \f$P_2\f$, both
+     * lists of hash values are merged, so the cost is linear in the sizes of
+     * the Profiles. Both RankVectors should be complete (see isComplete()).
+     * Query method
+     * @param other A RankVector object. Input parameter
+     * @throw std::invalid_argument Throws an std::invalid_argument exception
+     * if any of the RankVectors is empty or it is not complete
+     * @return The distance from the Profile of this RankVector to the one
+     * of @p other
+     */
+    double getProfileDistance(const RankVector& other) const;
+
+    /**
+     * @brief Writes this object to the given output stream in binary format.
+     * Query method
+     * @param outputStream An output stream where this object will be written
+     */
+    void write(std::ostream& outputStream) const;
+
+    /**
+     * @brief Reads this object from the given input stream in binary format.
+     * Modifier method
+     * @param inputStream An input stream from which this object will be read
+     */
+    void read(std::istream& inputStream);
+
+private:
+    unsigned long long* _hashes; ///< Hash values of the ranked kmers, in increasing order
+    int* _ranks; ///< Rank of the kmer of each hash value
+    int _size; ///< Number of ranked kmers
+    int _profileSize; ///< Number of kmers of the Profile
+    int _depth; ///< Depth (capacity of the dynamic arrays)
+
+    void allocate(int depth);
+    void deallocate();
+};
+
+#endif /* RANK_VECTOR_H */
@@ -0,0 +1,158 @@
+/*
+ * Metodología de la Programación: Kmer5
+ * Curso 2023/2024
+ */
+
+/**
+ * @file SampledKmerCounter.h
+ */
+
+#ifndef SAMPLED_KMER_COUNTER_H
+#define SAMPLED_KMER_COUNTER_H
+
+#include <string>
+#include <unordered_map>
+
+#include "KmerCoder.h"
+#include "Profile.h"
+
+/**
+ * @class SampledKmerCounter
+ * @brief Counts only a sample of the kmers of sequences, so their Profile is
+ * much smaller and faster to build and to compare than the one with all the
+ * kmers, for example to classify genomes with a large k. The kmers are the
+ * same as the ones of a KmerCounter with the same parameters (see
+ * KmerCoder), and the sample depends only on them, so two sequences share
+ * the sampled kmers that they have in common. The sampling is one of these:
+ * - "fracminhash=S" (FracMinHash): the kmers whose hash value (see Hash())
+ * is in the smallest fraction 1/S of the hash values are counted, so about
+ * 1 of each S different kmers is in the Profile, with its frequency.
+ * - "minimizer=W" (window minimizers): in each window of W consecutive
+ * kmers, the one with the smallest hash value is selected, and each
+ * selected position is counted once, so about 2 of each W + 1 positions of
+ * a sequence are counted. When several kmers of a window have the smallest
+ * hash value, the one selected by the previous window is kept if it is
+ * still in the window, so a run of a repeated kmer selects one of each W
+ * positions (robust winnowing).
+ *
+ * The sampled kmers are counted in a hash table, and the Profile keeps the
+ * sampling as its parameters (see Profile::getParameters()), so it is only
+ * compared with the profiles sampled in the same way.
+ */
+class SampledKmerCounter {
+public:
+    /**
+     * Name of the FracMinHash sampling
+     */
+    static const std::string FRAC_MIN_HASH;
+
+    /**
+     * Name of the sampling of window minimizers
+     */
+    static const std::string MINIMIZER;
+
+    /**
+     * @brief Constructor of the class. No kmer is counted.
+     * @param k The number of nucleotides in each kmer. Input parameter
+     * @param validNucleotides The set of valid nucleotides. Input parameter
+     * @param sampling The sampling: "fracminhash=S" or "minimizer=W", with
+     * a positive integer S or W. Input parameter
+     * @param canonical Whether canonical kmers are counted (see class
+     * KmerCounter). Input parameter
+     * @param onlyValidKmers Whether only the kmers without missing
+     * nucleotides are counted (see class KmerCounter). Input parameter
+     * @throw std::invalid_argument Throws an std::invalid_argument exception
+     * if @p sampling is not valid, if the nucleotides of a kmer cannot be
+     * packed in 64 bits (see KmerCoder::CanPack()), or if @p canonical is
+     * true and the complementary nucleotides of @p validNucleotides cannot
+     * be obtained (see KmerCounter::GetComplementaryNucleotides())
+     */
+    SampledKmerCounter(int k, const std::string& validNucleotides,
+        const std::string& sampling, bool canonical = false,
+        bool onlyValidKmers = false);
+
+    /**
+     * @brief Returns the number of nucleotides in each kmer
+     * Query method
+     * @return The value of k
+     */
+    int getK() const;
+
+    /**
+     * @brief Returns the sampling, written as in the constructor (without
+     * leading zeros or signs)
+     * Query method
+     * @return A const reference to the sampling
+     */
+    const std::string& getSampling() const;
+
+    /**
+     * @brief Returns the number of kmers read, sampled or not
+     * Query method
+     * @return The number of kmers read
+     */
+    long long getNumKmers() const;
+
+    /**
+     * @brief Returns the number of different kmers counted
+     * Query method
+     * @return The number of sampled kmers
+     */
+    int getSize() const;
+
+    /**
+     * @brief Counts the sampled kmers of the DNA of the given file, as
+     * KmerCounter::calculateFrequencies(): its first word. The previous
+     * frequencies are removed.
+     * Modifier method
+     * @param fileName The name of the file. Input parameter
+     * @throw std::ios_base::failure Throws a std::ios_base::failure exception
+     * if the given file cannot be opened
+     */
+    void calculateFrequencies(const char* fileName);
+
+    /**
+     * @brief Adds the sampled kmers of the given sequence to the current
+     * frequencies. The windows of the minimizers do not span two sequences.
+     * Modifier method
+     * @param sequence A sequence of nucleotides. Input parameter
+     */
+    void addSequenceFrequencies(const std::string& sequence);
+
+    /**
+     * @brief Builds a Profile object with the sampled kmers and their
+     * frequencies, as KmerCounter::toProfile(), whose parameters are the
+     * sampling (see getSampling()).
+     * Query method
+     * @return A Profile object, which is not sorted
+     */
+    Profile toProfile() const;
+
+    /**
+     * @brief Returns the hash value of the code of a kmer used to sample
+     * it. It should not change, since the sampled profiles saved in files
+     * depend on it.
+     * @param code The code of a kmer (see KmerCoder). Input parameter
+     * @return The hash value of @p code
+     */
+    static unsigned long long Hash(unsigned long long code);
+
+private:
+    KmerCoder _coder; ///< Codes of the kmers of the sequences
+    std::string _sampling; ///< The sampling
+    bool _minimizers; ///< Whether the window minimizers are sampled, or FracMinHash
+    unsigned long long _threshold; ///< Largest hash value sampled by FracMinHash
+    int _window; ///< Number of kmers of a window of the minimizers
+    long long _numKmers; ///< Number of kmers read
+    std::unordered_map<unsigned long long, long long> _frequencies; ///< Frequency of each sampled kmer
+
+    /**
+     * @brief Adds a value to the frequency of a kmer
+     * Modifier method
+     * @param code The code of the kmer. Input parameter
+     * @param value The value to add. Input parameter
+     */
+    void increase(unsigned long long code, long long value);
+};
+
+#endif /* SAMPLED_KMER_COUNTER_H */
@@ -0,0 +1,150 @@
+/*
+ * Metodología de la Programación: Kmer5
+ * Curso 2023/2024
+ */
+
+/**
+ * @file SequenceFilter.h
+ */
+
+#ifndef SEQUENCE_FILTER_H
+#define SEQUENCE_FILTER_H
+
+#include <string>
+
+/**
+ * @class SequenceFilter
+ * @brief Masks the nucleotides of a sequence that should not give kmers
+ * before they are counted, replacing them in place with
+ * Kmer::MISSING_NUCLEOTIDE, so the kmers that contain them are counted as
+ * kmers with missing nucleotides, or skipped when only the kmers without
+ * missing nucleotides are counted (see class KmerCounter). Two filters can
+ * be enabled:
+ * - Quality: the nucleotides of a read whose Phred quality (encoded as
+ * Phred+33, as in the FASTQ files) is smaller than a minimum are masked.
+ * When SSE2 is available, 16 qualities are compared at once.
+ * - Low complexity (DUST): the windows of DUST_WINDOW nucleotides with a
+ * low complexity, like the runs of poly-A or the microsatellites, are
+ * masked. The score of a window is \f$\sum_t c_t (c_t - 1) / 2 / (l - 1)\f$,
+ * where \f$c_t\f$ is the number of occurrences of the triplet t among the
+ * \f$l = DUST\_WINDOW - 2\f$ triplets of the window, and the whole window
+ * is masked if its score is greater than the DUST level (the symmetric
+ * DUST of dustmasker, without searching the best interval of a window).
+ * The score is updated incrementally when the window moves one nucleotide,
+ * so the cost is constant for each nucleotide. Only the triplets of the
+ * nucleotides A, C, G and T (or U, in uppercase or lowercase) are counted.
+ *
+ * A SequenceFilter does not change after its construction and does not
+ * allocate memory while filtering, so a single object can be shared by
+ * several threads.
+ */
+class SequenceFilter {
+public:
+    /**
+     * Number of nucleotides of the windows of the low complexity filter
+     */
+    static const int DUST_WINDOW = 64;
+
+    /**
+     * Usual DUST level: the score of a window of a homopolymer is about 31,
+     * and the one of a random sequence is about 0.5
+     */
+    static const int DEFAULT_DUST_LEVEL = 20;
+
+    /**
+     * Value of the character of the quality 0 in a FASTQ file (Phred+33)
+     */
+    static const int PHRED_OFFSET = 33;
+
+    /**
+     * Largest quality that can be encoded with a printable character
+     */
+    static const int MAX_QUALITY = 126 - PHRED_OFFSET;
+
+    /**
+     * @brief Constructor of the class. The default filter does not mask
+     * any nucleotide.
+     * @param minQuality The minimum Phred quality of a nucleotide that is
+     * not masked, between 0 (the quality filter is disabled) and
+     * MAX_QUALITY. Input parameter
+     * @param dustLevel The DUST level of the low complexity filter: the
+     * windows with a greater score are masked. 0 disables the filter.
+     * Input parameter
+     * @throw std::invalid_argument Throws an std::invalid_argument exception
+     * if @p minQuality or @p dustLevel is out of range
+     */
+    SequenceFilter(int minQuality = 0, int dustLevel = 0);
+
+    /**
+     * @brief Returns the minimum quality of a nucleotide that is not masked
+     * Query method
+     * @return The minimum quality (0 if the quality filter is disabled)
+     */
+    int getMinQuality() const;
+
+    /**
+     * @brief Returns the DUST level of the low complexity filter
+     * Query method
+     * @return The DUST level (0 if the low complexity filter is disabled)
+     */
+    int getDustLevel() const;
+
+    /**
+     * @brief Checks whether any filter is enabled
+     * Query method
+     * @return true if filter() can mask some nucleotide; false otherwise
+     */
+    bool isEnabled() const;
+
+    /**
+     * @brief Masks the nucleotides of a sequence with Kmer::MISSING_NUCLEOTIDE:
+     * first the ones with a low quality, if the qualities are given, and
+     * then the windows with a low complexity. The nucleotides masked by
+     * the quality filter break the triplets of the low complexity filter.
+     * Query method
+     * @param sequence The nucleotides of the sequence. Input/Output parameter
+     * @param length The number of nucleotides of @p sequence. Input parameter
+     * @param qualities The quality of each nucleotide of @p sequence
+     * (Phred+33), or nullptr if it is unknown. It should have at least
+     * @p length characters. Input parameter
+     * @return The number of nucleotides masked (the ones that already were
+     * Kmer::MISSING_NUCLEOTIDE are not included)
+     */
+    long long filter(char sequence[], long long length,
+        const char qualities[] = nullptr) const;
+
+    /**
+     * @brief Masks the nucleotides of a sequence, as
+     * filter(char[], long long, const char[]) const
+     * Query method
+     * @param sequence The sequence. Input/Output parameter
+     * @return The number of nucleotides masked
+     */
+    long long filter(std::string& sequence) const;
+
+private:
+    int _minQuality; ///< Minimum quality of a nucleotide that is not masked, or 0
+    int _dustLevel; ///< DUST level of the low complexity filter, or 0
+
+    /**
+     * @brief Masks the nucleotides whose quality is smaller than _minQuality
+     * Query method
+     * @param sequence The nucleotides of the sequence. Input/Output parameter
+     * @param length The number of nucleotides of @p sequence. Input parameter
+     * @param qualities The quality of each nucleotide. Input parameter
+     * @return The number of nucleotides masked
+     */
+    long long maskQualities(char sequence[], long long length,
+        const char qualities[]) const;
+
+    /**
+     * @brief Masks the windows whose DUST score is greater than _dustLevel
+     * Query method
+     * @param sequence The nucleotides of the sequence. Input/Output parameter
+     * @param length The number of nucleotides of @p sequence. Input parameter
+     * @return The number of nucleotides masked
+     */
+    long long maskLowComplexity(char sequence[], long long length) const;
+};
+
+#endif /* SEQUENCE_FILTER_H */
@@ -0,0 +1,183 @@
+/*
+ * Metodología de la Programación: Kmer5
+ * Curso 2023/2024
+ */
+
+/**
+ * @file Sketch.h
+ */
+
+#ifndef SKETCH_H
+#define SKETCH_H
+
+#include <iostream>
+#include <string>
+
+#include "Profile.h"
+
+/**
+ * @class Sketch
+ * @brief A bottom-s MinHash sketch of the set of kmers of a Profile. It
+ * contains the @p s smallest hash values of the kmers of the Profile,
+ * sorted in increasing order, and the identifier of the Profile.
+ *
+ * The Jaccard similarity of the sets of kmers of two Profiles can be
+ * estimated from their sketches in O(s), without using the Profiles. It is
+ * used by CLASSIFY to select a few candidate Profiles among a very large
+ * set of references, before calculating the exact distances with
+ * Profile::getDistance().
+ */
+class Sketch {
+public:
+    /**
+     * Default number of hash values in a sketch
+     */
+    static const int DEFAULT_SIZE = 1000;
+
+    /**
+     * @brief Base constructor. It builds an empty Sketch object with
+     * "unknown" as identifier and space for @p size hash values.
+     * @throw std::invalid_argument Throws an std::invalid_argument exception
+     * if @p size is less or equal than zero
+     * @param size The maximum number of hash values in this Sketch.
+     * Input parameter
+     */
+    Sketch(int size = DEFAULT_SIZE);
+
+    /**
+     * @brief Copy constructor
+     * @param orig the Sketch object used as source for the copy. Input
+     * parameter
+     */
+    Sketch(const Sketch& orig);
+
+    /**
+     * @brief Destructor
+     */
+    ~Sketch();
+
+    /**
+     * @brief Overloading of the assignment operator for Sketch class.
+     * Modifier method
+     * @param orig the Sketch object used as source for the assignment. Input
+     * parameter
+     * @return A reference to this object
+     */
+    Sketch& operator=(const Sketch& orig);
+
+    /**
+     * @brief Returns the identifier of the Profile of this sketch.
+     * Query method
+     * @return A const reference to the identifier
+     */
+    const std::string& getProfileId() const;
+
+    /**
+     * @brief Returns the maximum number of hash values in this sketch.
+     * Query method
+     * @return The maximum number of hash values in this sketch
+     */
+    int getCapacity() const;
+
+    /**
+     * @brief Returns the number of hash values in this sketch. It is less
+     * than getCapacity() if the Profile had less kmers than that.
+     * Query method
+     * @return The number of hash values in this sketch
+     */
+    int getSize() const;
+
+    /**
+     * @brief Returns the hash value at the given position (hash values are
+     * sorted in increasing order).
+     * Query method
+     * @param index The position to consider. Input parameter
+     * @throw std::out_of_range Throws an std::out_of_range exception if the
+     * given index is not valid
+     * @return The hash value at the given position
+     */
+    unsigned long long at(int index) const;
+
+    /**
+     * @brief Builds this sketch with the kmers of the given Profile. Kmers
+     * with any missing nucleotide are not considered. The identifier of this
+     * sketch is set to the one of the Profile.
+     * Modifier method
+     * @param profile A Profile object. Input parameter
+     */
+    void build(const Profile& profile);
+
+    /**
+     * @brief Estimates the Jaccard similarity between the sets of kmers of
+     * the Profiles of this sketch and @p other. The estimation uses the
+     * s smallest hash values of the union of both sketches, where s is the
+     * minimum of the capacities of both sketches, and returns the fraction
+     * of them that belong to both sketches.
+     * Both sorted lists of hash values are merged with a branch free loop.
+     * Query method
+     * @param other A Sketch object. Input parameter
+     * @return The estimated Jaccard similarity (a value from 0 to 1)
+     */
+    double getJaccard(const Sketch& other) const;
+
+    /**
+     * @brief Writes this object to the given output stream in binary format:
+     * the identifier (a line of text), the capacity and the size (ints) and
+     * the hash values.
+     * Query method
+     * @param outputStream An output stream where this object will be written
+     */
+    void write(std::ostream& outputStream) const;
+
+    /**
+     * @brief Reads this object from the given input stream (see
+     * write(std::ostream&)).
+     * Modifier method
+     * @param inputStream An input stream from which this object will be read
+     */
+    void read(std::istream& inputStream);
+
+    /**
+     * @brief Saves the given sketches in a sketch file.
+     * @param fileName A c-string with the name of the file. Input parameter
+     * @param sketches An array of sketches. Input parameter
+     * @param numSketches The number of elements of @p sketches.
+     * Input parameter
+     * @throw std::ios_base::failure Throws a std::ios_base::failure exception
+     * if the given file cannot be opened or if an error occurs while writing
+     * to the file
+     */
+    static void Save(const char fileName[], const Sketch sketches[],
+        int numSketches);
+
+    /**
+     * @brief Loads the sketches stored in a sketch file.
+     * @param fileName A c-string with the name of the file. Input parameter
+     * @param numSketches The number of sketches loaded. Output parameter
+     * @throw std::ios_base::failure Throws a std::ios_base::failure exception
+     * if the given file cannot be opened or if an error occurs while reading
+     * from the file
+     * @throw std::invalid_argument Throws a std::invalid_argument exception if
+     * an invalid magic string is found in the given file
+     * @return A dynamic array with the loaded sketches. It should be released
+     * with delete[]
+     */
+    static Sketch* Load(const char fileName[], int& numSketches);
+
+    /**
+     * @brief Returns the hash value of the given kmer.
+     * @param kmer A Kmer object. Input parameter
+     * @return The hash value of the given kmer
+     */
+    static unsigned long long Hash(const Kmer& kmer);
+
+private:
+    std::string _profileId; ///< Profile identifier
+    unsigned long long* _hashes; ///< Dynamic array with the sorted hash values
+    int _size; ///< Number of used elements in the dynamic array _hashes
+    int _capacity; ///< Number of reserved elements in the dynamic array _hashes
+
+    static const std::string MAGIC_STRING; ///< A const string with the magic string for sketch files
+};
+
+#endif /* SKETCH_H */
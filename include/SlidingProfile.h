@@ -0,0 +1,262 @@
+/*
+ * Metodología de la Programación: Kmer5
+ * Curso 2023/2024
+ */
+
+/**
+ * @file SlidingProfile.h
+ */
+
+#ifndef SLIDING_PROFILE_H
+#define SLIDING_PROFILE_H
+
+#include <string>
+
+#include "Profile.h"
+
+/**
+ * @class SlidingProfile
+ * @brief The sorted Profile of a window of a sequence, updated when kmers
+ * enter or leave the window, together with its distances (see
+ * Profile::getDistance()) to a set of reference Profiles.
+ *
+ * The kmers of the window are kept in an array sorted as in
+ * Profile::sort(): in decreasing order of frequency and alphabetically
+ * within the same frequency, where the position of a kmer is its rank. The
+ * kmers with the same frequency form a bucket of consecutive positions,
+ * and the positions of the kmers in the table follow the alphabetical
+ * order. Adding or removing a kmer only updates its frequency and the
+ * sizes of the buckets, in O(1). After adding or removing a range of kmers,
+ * the kmers whose frequency has changed are sorted and merged with the
+ * ones that stay in each changed bucket, which are still sorted, so the
+ * window is not sorted again.
+ *
+ * For each reference, the sum of the differences between the rank of each
+ * kmer in the window and in the reference is updated only for the kmers
+ * whose rank has changed, so the distance to a reference is obtained in
+ * O(1). The distances are the ones of Profile::getDistance() for the
+ * Profile of the window returned by toProfile(), which is the one learned
+ * from the window and sorted with Profile::sort().
+ *
+ * As in KmerCounter, the characters that are not valid nucleotides are
+ * taken as Kmer::MISSING_NUCLEOTIDE, lowercase nucleotides are taken as
+ * uppercase ones, and each kmer is identified by its position in a table of
+ * \f$(|validNucleotides|+1)^k\f$ kmers.
+ */
+class SlidingProfile {
+public:
+    /**
+     * @brief Base constructor. It builds an empty window for kmers of @p k
+     * nucleotides from the set @p validNucleotides, without references.
+     * @throw std::invalid_argument Throws an std::invalid_argument exception
+     * if @p k is less or equal than zero or if the table of kmers is too
+     * large
+     * @param k The number of nucleotides of a kmer. Input parameter
+     * @param validNucleotides The set of valid nucleotides. Input parameter
+     */
+    SlidingProfile(int k = 5, const std::string& validNucleotides = "ACGT");
+
+    /**
+     * @brief Copy constructor
+     * @param orig the SlidingProfile object used as source for the copy.
+     * Input parameter
+     */
+    SlidingProfile(const SlidingProfile& orig);
+
+    /**
+     * @brief Destructor
+     */
+    ~SlidingProfile();
+
+    /**
+     * @brief Overloading of the assignment operator for SlidingProfile
+     * class.
+     * Modifier method
+     * @param orig the SlidingProfile object used as source for the
+     * assignment. Input parameter
+     * @return A reference to this object
+     */
+    SlidingProfile& operator=(const SlidingProfile& orig);
+
+    /**
+     * @brief Returns the number of nucleotides of the kmers.
+     * Query method
+     * @return The number of nucleotides of the kmers
+     */
+    int getK() const;
+
+    /**
+     * @brief Returns the number of distinct kmers in the window.
+     * Query method
+     * @return The number of distinct kmers in the window
+     */
+    int getSize() const;
+
+    /**
+     * @brief Returns the number of references.
+     * Query method
+     * @return The number of references
+     */
+    int getNumReferences() const;
+
+    /**
+     * @brief Adds a reference Profile. Its kmers with a different length
+     * are skipped.
+     * Modifier method
+     * @param reference A Profile sorted in decreasing order of frequency.
+     * Input parameter
+     * @throw std::invalid_argument Throws an std::invalid_argument exception
+     * if @p reference is empty
+     */
+    void addReference(const Profile& reference);
+
+    /**
+     * @brief Adds to the window the kmers of @p sequence that begin in the
+     * positions [first, last).
+     * Modifier method
+     * @param sequence A sequence of nucleotides. Input parameter
+     * @param first The first position of a kmer to add. Input parameter
+     * @param last The position after the last one of a kmer to add. The
+     * kmers should be inside @p sequence. Input parameter
+     */
+    void addKmers(const std::string& sequence, int first, int last);
+
+    /**
+     * @brief Removes from the window the kmers of @p sequence that begin in
+     * the positions [first, last). They should have been added before.
+     * Modifier method
+     * @param sequence A sequence of nucleotides. Input parameter
+     * @param first The first position of a kmer to remove. Input parameter
+     * @param last The position after the last one of a kmer to remove. The
+     * kmers should be inside @p sequence. Input parameter
+     */
+    void removeKmers(const std::string& sequence, int first, int last);
+
+    /**
+     * @brief Moves the window from the kmers of @p sequence that begin in
+     * the positions [first, last) to the ones that begin in [nextFirst,
+     * nextLast): the kmers that leave the window are removed and the ones
+     * that enter it are added, and the window is sorted only once.
+     * Modifier method
+     * @param sequence A sequence of nucleotides. Input parameter
+     * @param first The first position of a kmer of the window. Input
+     * parameter
+     * @param last The position after the last one of a kmer of the window.
+     * Input parameter
+     * @param nextFirst The first position of a kmer of the new window.
+     * Input parameter
+     * @param nextLast The position after the last one of a kmer of the new
+     * window. The kmers should be inside @p sequence. Input parameter
+     */
+    void slide(const std::string& sequence, int first, int last,
+        int nextFirst, int nextLast);
+
+    /**
+     * @brief Gets the distance from the Profile of the window to a
+     * reference (see the description of this class).
+     * Query method
+     * @param reference The position of the reference, in the order in
+     * which they were added. Input parameter
+     * @throw std::out_of_range Throws an std::out_of_range exception if
+     * @p reference is not a valid position
+     * @throw std::invalid_argument Throws an std::invalid_argument exception
+     * if the window is empty
+     * @return The distance from the window to the reference
+     */
+    double getDistance(int reference) const;
+
+    /**
+     * @brief Builds the Profile of the window, with the kmers in the order
+     * of their ranks.
+     * Query method
+     * @return The Profile of the window
+     */
+    Profile toProfile() const;
+
+private:
+    int _k; ///< Number of nucleotides of a kmer
+    std::string _allNucleotides; ///< Kmer::MISSING_NUCLEOTIDE and the valid nucleotides, in alphabetical order
+    int _numCodes; ///< Number of kmers in the table
+    int _highPower; ///< Number of nucleotides (with the missing one) to the power k-1
+    int* _frequencies; ///< Frequency of each kmer in the window
+    int* _positions; ///< Rank of each kmer in the window (-1 if its frequency is 0)
+    int* _order; ///< Kmers of the window in the order of their ranks
+    int _size; ///< Number of distinct kmers in the window
+    bool* _touched; ///< Whether the frequency of each kmer has changed since the window was sorted
+    int* _touchedKmers; ///< Kmers whose frequency has changed since the window was sorted
+    int _numTouched; ///< Number of elements of _touchedKmers
+    int* _ends; ///< Number of kmers with a frequency greater or equal than each frequency
+    int* _sortedEnds; ///< The elements of _ends when the window was sorted
+    bool* _changed; ///< Whether the bucket of each frequency has changed since the window was sorted
+    int _maxFrequency; ///< Number of elements of _ends, _sortedEnds and _changed minus one
+    int* _ranks; ///< Rank of each kmer in each reference (kmer-major order)
+    long long* _sums; ///< Sum of the differences of ranks with each reference
+    int* _referenceSizes; ///< Number of kmers of each reference
+    int _numReferences; ///< Number of references
+    signed char _values[256]; ///< Value of each character in _allNucleotides
+
+    void allocate();
+    void deallocate();
+    void copy(const SlidingProfile& orig);
+
+    /**
+     * @brief Returns the position of a kmer in the table of kmers
+     * @param sequence A sequence of nucleotides. Input parameter
+     * @param first The position of the first nucleotide of the kmer.
+     * Input parameter
+     * @return The position of the kmer in the table of kmers
+     */
+    int getCode(const std::string& sequence, int first) const;
+
+    /**
+     * @brief Adds to the window or removes from it the kmers of @p sequence
+     * that begin in the positions [first, last), without sorting the window
+     * (see sortBuckets())
+     * @param sequence A sequence of nucleotides. Input parameter
+     * @param first The first position of a kmer. Input parameter
+     * @param last The position after the last one of a kmer. Input parameter
+     * @param add Whether the kmers are added or removed. Input parameter
+     */
+    void updateKmers(const std::string& sequence, int first, int last,
+        bool add);
+
+    /**
+     * @brief Increases the frequency of a kmer by one, without sorting the
+     * window (see sortBuckets())
+     * @param code The position of the kmer in the table. Input parameter
+     */
+    void increase(int code);
+
+    /**
+     * @brief Decreases the frequency of a kmer by one, without sorting the
+     * window (see sortBuckets())
+     * @param code The position of the kmer in the table. Input parameter
+     */
+    void decrease(int code);
+
+    /**
+     * @brief Marks a kmer whose frequency changes, so it is placed again
+     * when the window is sorted
+     * @param code The position of the kmer in the table. Input parameter
+     */
+    void touch(int code);
+
+    /**
+     * @brief Moves a kmer of the window to another rank, updating the sums
+     * of the differences of ranks. A rank equal to -1 means that the kmer
+     * is not in the window
+     * @param code The position of the kmer in the table. Input parameter
+     * @param position The new rank of the kmer. Input parameter
+     */
+    void setRank(int code, int position);
+
+    /**
+     * @brief Sorts the window after its frequencies have changed: the
+     * kmers whose frequency has changed are sorted and merged with the
+     * ones that stay in each bucket, and the sums of the differences of
+     * ranks are updated for the kmers whose rank has changed
+     */
+    void sortBuckets();
+};
+
+#endif /* SLIDING_PROFILE_H */
@@ -0,0 +1,178 @@
+/*
+ * Metodología de la Programación: Kmer5
+ * Curso 2023/2024
+ */
+
+/**
+ * @file SpaceSaving.h
+ */
+
+#ifndef SPACE_SAVING_H
+#define SPACE_SAVING_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "KmerCoder.h"
+#include "Profile.h"
+
+/**
+ * @class SpaceSaving
+ * @brief Keeps the most frequent kmers of sequences in a single pass with a
+ * fixed number of counters (the Space-Saving algorithm), so the top of a
+ * Profile is learned without counting all the different kmers, for
+ * example for large values of k. The kmers are the same as the ones of a
+ * KmerCounter with the same parameters (see KmerCoder).
+ *
+ * Each counter monitors a kmer, with an estimation of its frequency and
+ * the maximum error of the estimation. A kmer that is monitored increases
+ * its counter. A kmer that is not monitored takes the counter with the
+ * smallest estimation when all the counters are used: its estimation is
+ * that one plus 1, and its error is that one. So an estimation is never
+ * smaller than the frequency of its kmer and it exceeds it at most in the
+ * smallest estimation (see getErrorBound()), which is at most N divided by
+ * the number of counters, where N is the number of kmers counted. Any kmer
+ * whose frequency is larger than the smallest estimation is monitored.
+ *
+ * The counters form a min-heap by estimation, and a hash table gives the
+ * counter of each monitored kmer, so the memory only depends on the number
+ * of counters.
+ */
+class SpaceSaving {
+public:
+    /**
+     * @brief Constructor of the class. No kmer is monitored.
+     * @param k The number of nucleotides in each kmer. Input parameter
+     * @param validNucleotides The set of valid nucleotides. Input parameter
+     * @param numCounters The number of counters, that is, the maximum
+     * number of kmers monitored. Input parameter
+     * @param canonical Whether canonical kmers are counted (see class
+     * KmerCounter). Input parameter
+     * @param onlyValidKmers Whether only the kmers without missing
+     * nucleotides are counted (see class KmerCounter). Input parameter
+     * @throw std::invalid_argument Throws an std::invalid_argument exception
+     * if @p numCounters is not positive, if the nucleotides of a kmer cannot
+     * be packed in 64 bits (see KmerCoder::CanPack()), or if @p canonical
+     * is true and the complementary nucleotides of @p validNucleotides
+     * cannot be obtained (see KmerCounter::GetComplementaryNucleotides())
+     */
+    SpaceSaving(int k, const std::string& validNucleotides, int numCounters,
+        bool canonical = false, bool onlyValidKmers = false);
+
+    /**
+     * @brief Returns the number of nucleotides in each kmer
+     * Query method
+     * @return The value of k
+     */
+    int getK() const;
+
+    /**
+     * @brief Returns the number of counters
+     * Query method
+     * @return The maximum number of kmers monitored
+     */
+    int getNumCounters() const;
+
+    /**
+     * @brief Returns the number of kmers counted, that is, the sum of the
+     * frequencies of all the kmers
+     * Query method
+     * @return The number of kmers counted
+     */
+    long long getNumKmers() const;
+
+    /**
+     * @brief Returns the maximum error of an estimation: the smallest
+     * estimation if all the counters are used, or 0 otherwise. The kmers
+     * that are not monitored have at most this frequency
+     * Query method
+     * @return The maximum error of an estimation
+     */
+    long long getErrorBound() const;
+
+    /**
+     * @brief Returns the number of kmers at the beginning of toProfile()
+     * that are guaranteed to be the most frequent ones: the largest g such
+     * that the smallest guaranteed frequency (the estimation minus its
+     * error) of the first g kmers is not smaller than the estimation of the
+     * next one
+     * Query method
+     * @return The number of kmers whose ranking is guaranteed
+     */
+    int getNumGuaranteed() const;
+
+    /**
+     * @brief Returns the memory used by the counters
+     * Query method
+     * @return An estimation of the number of bytes
+     */
+    long long getMemory() const;
+
+    /**
+     * @brief Adds the kmers of the given sequence to the counters, in the
+     * same way as KmerCounter::addSequenceFrequencies()
+     * Modifier method
+     * @param sequence A sequence of nucleotides. Input parameter
+     */
+    void addSequenceFrequencies(const std::string& sequence);
+
+    /**
+     * @brief Builds a Profile object with the monitored kmers and their
+     * estimations as frequencies. Only the counters are sorted
+     * Query method
+     * @return A sorted Profile object (see Profile::sort())
+     */
+    Profile toProfile() const;
+
+private:
+    /**
+     * A counter: the monitored kmer, its estimation and its error
+     */
+    struct Counter {
+        unsigned long long code; ///< Code of the kmer
+        long long count; ///< Estimation of the frequency of the kmer
+        long long error; ///< Maximum error of the estimation
+    };
+
+    KmerCoder _coder; ///< Codes of the kmers of the sequences
+    int _numCounters; ///< Maximum number of counters
+    long long _numKmers; ///< Number of kmers counted
+    std::vector<Counter> _heap; ///< The used counters, a min-heap by count
+    std::unordered_map<unsigned long long, int> _positions; ///< Position in _heap of each monitored kmer
+
+    /**
+     * @brief Adds a value to the counter of a kmer, replacing the smallest
+     * counter if the kmer is not monitored and all the counters are used
+     * Modifier method
+     * @param code The code of the kmer. Input parameter
+     * @param value The value to add. Input parameter
+     */
+    void increase(unsigned long long code, long long value);
+
+    /**
+     * @brief Moves a counter down in the heap after increasing it
+     * Modifier method
+     * @param pos The position of the counter in the heap. Input parameter
+     */
+    void siftDown(int pos);
+
+    /**
+     * @brief Moves a new counter up in the heap
+     * Modifier method
+     * @param pos The position of the counter in the heap. Input parameter
+     */
+    void siftUp(int pos);
+
+    /**
+     * @brief Returns the positions in the heap of the counters in the order
+     * of Profile::sort(): decreasing estimation and then increasing kmer
+     * Query method
+     * @param kmers The nucleotides of the kmer of each counter of the heap.
+     * Output parameter
+     * @return The sorted positions
+     */
+    std::vector<int> sortCounters(std::vector<std::string>& kmers) const;
+};
+
+#endif /* SPACE_SAVING_H */
@@ -0,0 +1,157 @@
+/*
+ * Metodología de la Programación: Kmer5
+ * Curso 2023/2024
+ */
+
+/**
+ * @file VPTree.h
+ */
+
+#ifndef VP_TREE_H
+#define VP_TREE_H
+
+#include <queue>
+#include <utility>
+
+#include "RankVector.h"
+
+/**
+ * @class VPTree
+ * @brief A vantage-point tree over the RankVector objects of a set of
+ * reference Profiles. It is used to search the references closest to a
+ * query with the metric of RankVector, evaluating the distance to a
+ * fraction of the references.
+ *
+ * The tree is stored in arrays: the subtree of the range [lo, hi) of the
+ * array _items has the vantage point _items[lo]; the references at a
+ * distance less or equal than _thresholds[lo] from it are in the range
+ * [lo+1, _middles[lo]) and the rest in the range [_middles[lo], hi).
+ * The references are identified by their position in the array given to
+ * build() (for example, their position in a ProfileDatabase).
+ */
+class VPTree {
+public:
+    /**
+     * @brief Base constructor. It builds an empty tree
+     */
+    VPTree();
+
+    /**
+     * @brief Destructor
+     */
+    ~VPTree();
+
+    /**
+     * @brief Returns the number of references in this tree.
+     * Query method
+     * @return The number of references in this tree
+     */
+    int getSize() const;
+
+    /**
+     * @brief Returns the depth of the RankVectors of this tree.
+     * Query method
+     * @return The depth of the RankVectors of this tree, or 0 if the tree
+     * is empty
+     */
+    int getDepth() const;
+
+    /**
+     * @brief Builds this tree with a copy of the given RankVectors.
+     * Modifier method
+     * @param vectors An array of RankVectors, all of them with the same
+     * depth. Input parameter
+     * @param numVectors The number of elements in @p vectors. Input parameter
+     */
+    void build(const RankVector vectors[], int numVectors);
+
+    /**
+     * @brief Searches the @p k references closest to the given query.
+     * If @p epsilon is greater than 0, the search is approximate: a subtree
+     * is discarded if it cannot contain a reference closer than
+     * \f$\tau / (1 + \epsilon)\f$, where \f$\tau\f$ is the distance to the
+     * k-th closest reference found so far.
+     * Query method
+     * @param query The RankVector of the query. Input parameter
+     * @param k The number of references to search. Input parameter
+     * @param neighbours The positions of the closest references, in
+     * increasing order of distance. It should have space for @p k elements.
+     * Output parameter
+     * @param distances The distances to the closest references. It should
+     * have space for @p k elements. Output parameter
+     * @param numEvaluations The number of distances evaluated. Output
+     * parameter
+     * @param epsilon The allowed error of the search (0 for an exact search).
+     * Input parameter
+     * @return The number of references found (@p k, or the size of the
+     * tree if it is smaller)
+     */
+    int search(const RankVector& query, int k, int neighbours[],
+        double distances[], int& numEvaluations, double epsilon = 0) const;
+
+    /**
+     * @brief Saves this tree in the given file.
+     * Query method
+     * @param fileName A c-string with the name of the file. Input parameter
+     * @throw std::ios_base::failure Throws a std::ios_base::failure exception
+     * if the given file cannot be opened or if an error occurs while writing
+     * to the file
+     */
+    void save(const char fileName[]) const;
+
+    /**
+     * @brief Loads this tree from the given file.
+     * Modifier method
+     * @param fileName A c-string with the name of the file. Input parameter
+     * @throw std::ios_base::failure Throws a std::ios_base::failure exception
+     * if the given file cannot be opened, if an error occurs while reading
+     * from the file, or if its tree is not valid (a size larger than the 
+     * file, or positions or depths out of range)
+     * @throw std::invalid_argument Throws a std::invalid_argument exception if
+     * an invalid magic string is found in the given file
+     */
+    void load(const char fileName[]);
+
+private:
+    RankVector* _vectors; ///< RankVector of each reference
+    int* _items; ///< Positions of the references in the order of the tree
+    double* _thresholds; ///< Radius of the vantage point of each subtree
+    int* _middles; ///< First position of the outer part of each subtree
+    int _size; ///< Number of references
+
+    static const std::string MAGIC_STRING; ///< A const string with the magic string for tree files
+
+    void allocate(int size);
+    void deallocate();
+
+    /**
+     * @brief Builds the subtree of the range [lo, hi) of _items
+     * @param lo First position of the range. Input parameter
+     * @param hi Position after the last one of the range. Input parameter
+     * @param distances Auxiliary array with space for _size elements
+     */
+    void build(int lo, int hi, double distances[]);
+
+    /**
+     * @brief Searches the closest references in the subtree of the range
+     * [lo, hi) of _items (see search(const RankVector&, int, int[], double[],
+     * int&, double)).
+     * @param lo First position of the range. Input parameter
+     * @param hi Position after the last one of the range. Input parameter
+     * @param query The RankVector of the query. Input parameter
+     * @param k The number of references to search. Input parameter
+     * @param epsilon The allowed error of the search. Input parameter
+     * @param heap The closest references found so far, with the farthest
+     * one at the top. Input/Output parameter
+     * @param numEvaluations The number of distances evaluated.
+     * Input/Output parameter
+     */
+    void search(int lo, int hi, const RankVector& query, int k,
+        double epsilon, std::priority_queue<std::pair<double, int> >& heap,
+        int& numEvaluations) const;
+
+    VPTree(const VPTree& orig); ///< Not copyable
+    VPTree& operator=(const VPTree& orig); ///< Not copyable
+};
+
+#endif /* VP_TREE_H */
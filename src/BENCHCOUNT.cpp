@@ -0,0 +1,365 @@
+/*
+ * Metodología de la Programación: Kmer5
+ * Curso 2023/2024
+ */
+
+/**
+ * @file BENCHCOUNT.cpp
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include "KmerCounter.h"
+#include "ConcurrentKmerMap.h"
+
+using namespace std;
+
+/**
+ * Shows help about the use of this program in the given output stream
+ * @param outputStream The output stream where the help will be shown (for example,
+ * cout, cerr, etc)
+ */
+void showEnglishHelp(ostream& outputStream) {
+    outputStream << "ERROR in BENCHCOUNT parameters" << endl;
+    outputStream << "Run with the following parameters:" << endl;
+    outputStream << "BENCHCOUNT [-n nucleotidesSet] [-a] [-x] [-k minK] [-m maxK] [-r repetitions] [-d prefetchDistance] [-j maxThreads] [-W cellBits] [-G seed] <file.dna>" << endl;
+    outputStream << endl;
+    outputStream << "Parameters:" << endl;
+    outputStream << "-n nucletiodesSet: set of possible nucleotides in a kmer (ACGT by default). "
+                 << "Note that the characters should be provided in uppercase" << endl;
+    outputStream << "-a: count canonical kmers" << endl;
+    outputStream << "-x: count only the kmers without missing nucleotides" << endl;
+    outputStream << "-k minK: smallest number of nucleotides in a kmer (6 by default)" << endl;
+    outputStream << "-m maxK: largest number of nucleotides in a kmer (10 by default)" << endl;
+    outputStream << "-r repetitions: number of times that the kmers are counted with "
+                 << "each distance. The fastest time is reported (3 by default)" << endl;
+    outputStream << "-d prefetchDistance: a prefetch distance to measure. It can be "
+                 << "given several times (" << KmerCounter::DEFAULT_PREFETCH_DISTANCE
+                 << " by default). The distance 0 is always measured" << endl;
+    outputStream << "-j maxThreads: also measure the shared counting with 1, 2, 4, ... and "
+                 << "maxThreads threads, in the matrix and in a hash table (1 by default)" << endl;
+    outputStream << "-W cellBits: number of bits of the counters of the matrix: 8, 16 or 32 ("
+                 << CounterTable::DEFAULT_CELL_BITS << " by default)" << endl;
+    outputStream << "-G seed: count the spaced kmers of the seed, whose number of 1 is the "
+                 << "only k measured (see LEARN -G). The hash table is not measured" << endl;
+    outputStream << "<file.dna>: name of the DNA file whose kmers are counted" << endl;
+    outputStream << endl;
+    outputStream << "This program measures the kmers per second counted by KmerCounter "
+                 << "for each k, with the direct engine and each prefetch distance, "
+                 << "with the partitioned engine, and with several threads that share "
+                 << "the counters" << endl;
+    outputStream << endl;
+}
+
+/**
+ * This program measures the speed of KmerCounter for each value of k in
+ * [minK, maxK]: with the direct engine and each prefetch distance (see
+ * KmerCounter::setPrefetchDistance()), and with the partitioned engine (see
+ * KmerCounter::setPartitioned()). The kmers of the DNA of the input file
+ * (<file.dna>) are counted repetitions times with each engine and distance,
+ * and the fastest time is used. The time to set the frequencies to 0 before
+ * each repetition is not measured. The direct engine with the distance 0 (the
+ * counters are increased without prefetching them) is always measured first
+ * and used as  * used as reference: the Profile obtained in any other way is compared
+ * with the one of the reference, and the program fails if they are
+ * different.
+ *
+ * With the option -j, the contention of several threads that count the 
+ * kmers in the same table is also measured, with 1, 2, 4, ... and 
+ * maxThreads threads (see KmerCounter::addSequenceFrequencies()): in the
+ * matrix of the KmerCounter, with the default prefetch distance (shared 
+ * engine), and in a ConcurrentKmerMap (hash engine) with space for all the
+ * kmers of the DNA, if its codes can be packed. A DNA with long runs of a
+ * nucleotide (for example, rich in AAAAA) measures the worst case, since 
+ * the threads increase the same few counters.
+ *
+ * With the option -W, the counters of the matrix have cellBits bits (see
+ * KmerCounter::setCellBits()), so the speed and the memory of the smaller
+ * counters can be compared with the ones of the default 32 bits.
+ *
+ * With the option -G, the spaced kmers of the seed are counted (see 
+ * KmerCounter::setSeed()), only for the k given by the seed, so the speed
+ * of the extraction of their nucleotides can be compared with the one of
+ * the contiguous kmers of the same k. The hash engine only counts 
+ * contiguous kmers, so it is not measured.
+ *
+ * The output has a line for each k and engine, distance or number of 
+ * threads: the value of k, the memory of the frequencies in MB (the cells
+ * and the overflow map of the matrix, or the hash table), the
+ * engine, the prefetch distance (- for the partitioned and hash engines),
+ * the number of threads, the millions of kmers counted per second, the 
+ * speedup with respect to the reference and whether the frequencies are 
+ * the same as in the reference, separated by tabs.
+ *
+ * Running sintax:
+ * > BENCHCOUNT [-n nucleotidesSet] [-a] [-x] [-k minK] [-m maxK] [-r repetitions] [-d prefetchDistance] [-j maxThreads] [-W cellBits] [-G seed] <file.dna>
+ *
+ * Running example:
+ * > BENCHCOUNT -k 8 -m 10 -d 8 -d 16 ../Genomes/human_chr9_s10000_l500000.dna
+ * k	MB	engine	distance	threads	Mkmers/s	speedup	counts
+ * 8	1.49	direct	0	1	178.34	1.00	reference
+ * 8	1.49	direct	8	1	201.57	1.13	identical
+ * 8	1.49	direct	16	1	199.02	1.12	identical
+ * 8	1.49	partitioned	-	1	150.61	0.84	identical
+ * ...
+ *
+ * @param argc The number of command line parameters
+ * @param argv The vector of command line parameters (cstrings)
+ * @return 0 If there is no error; a value > 0 if error
+ */
+int main(int argc, char *argv[]) {
+    // Process the main() arguments
+    if (argc < 2) {
+        showEnglishHelp(cerr);
+        return 1;
+    }
+
+    string n = KmerCounter::DEFAULT_VALID_NUCLEOTIDES;
+    bool a = false;
+    bool x = false;
+    int min_k = 6;
+    int max_k = 10;
+    int r = 3;
+    vector<int> distances(1, 0);
+    int max_threads = 1;
+    int w = CounterTable::DEFAULT_CELL_BITS;
+    string seed = "";
+
+    bool sigo = true;
+    int i = 1;
+    while (sigo && i < argc-1) {
+        if (string(argv[i]).at(0) == '-') {
+            if (string(argv[i]) == "-n") {
+                n = argv[i+1];
+                i += 2;
+            }
+            else if (string(argv[i]) == "-a") {
+                a = true;
+                i++;
+            }
+            else if (string(argv[i]) == "-x") {
+                x = true;
+                i++;
+            }
+            else if (string(argv[i]) == "-k") {
+                min_k = stoi(argv[i+1]);
+                i += 2;
+            }
+            else if (string(argv[i]) == "-m") {
+                max_k = stoi(argv[i+1]);
+                i += 2;
+            }
+            else if (string(argv[i]) == "-r") {
+                r = stoi(argv[i+1]);
+                i += 2;
+            }
+            else if (string(argv[i]) == "-d") {
+                distances.push_back(stoi(argv[i+1]));
+                i += 2;
+            }
+            else if (string(argv[i]) == "-j") {
+                max_threads = stoi(argv[i+1]);
+                i += 2;
+            }
+            else if (string(argv[i]) == "-W") {
+                w = stoi(argv[i+1]);
+                i += 2;
+            }
+            else if (string(argv[i]) == "-G") {
+                seed = argv[i+1];
+                i += 2;
+            }
+            else {
+                showEnglishHelp(cerr);
+                return 1;
+            }
+        }
+        else {
+            sigo = false;
+        }
+    }
+
+    if (i != argc-1 || string(argv[i]).at(0) == '-' || min_k <= 0 ||
+            max_k < min_k || r <= 0 || max_threads <= 0 ||
+            (w != 8 && w != 16 && w != 32)) {
+        showEnglishHelp(cerr);
+        return 1;
+    }
+    if (seed != "") {
+        min_k = max_k = count(seed.begin(), seed.end(), '1');
+    }
+    if (distances.size() == 1) {
+        distances.push_back(KmerCounter::DEFAULT_PREFETCH_DISTANCE);
+    }
+
+    // Read the input DNA in the same way as KmerCounter::calculateFrequencies()
+    ifstream input(argv[i]);
+    if (!input) {
+        cerr << "The DNA file " << argv[i] << " cannot be opened" << endl;
+        return 1;
+    }
+    string dna;
+    input >> dna;
+    input.close();
+
+    // Numbers of threads of the shared and hash engines
+    vector<int> threads;
+    if (max_threads > 1) {
+        for (int t = 1; t < max_threads; t *= 2) {
+            threads.push_back(t);
+        }
+        threads.push_back(max_threads);
+    }
+
+    cout << "k\tMB\tengine\tdistance\tthreads\tMkmers/s\tspeedup\tcounts" << endl;
+    cout << fixed << setprecision(2);
+    try {
+        for (int k = min_k; k <= max_k; k++) {
+            int span = seed != "" ? seed.length() : k;
+            int num_kmers = (int) dna.length() - span + 1;
+            if (num_kmers <= 0) {
+                cerr << "The DNA file " << argv[i] << " has less than "
+                     << span << " nucleotides" << endl;
+                return 1;
+            }
+
+            KmerCounter kc(k, n, a, x, w);
+            kc.setSeed(seed);
+            Profile reference;
+            double reference_seconds = 0.0;
+            // The direct engine with each distance, and then the
+            //    partitioned engine
+            int num_runs = distances.size() + 1;
+            for (int d = 0; d < num_runs; d++) {
+                bool partitioned = d == num_runs - 1;
+                kc.setPartitioned(partitioned);
+                if (!partitioned)
+                    kc.setPrefetchDistance(distances[d]);
+
+                double seconds = 0.0;
+                for (int rep = 0; rep < r; rep++) {
+                    // The frequencies are set to 0 before the measure
+                    kc.calculateSequenceFrequencies("");
+                    chrono::steady_clock::time_point start =
+                            chrono::steady_clock::now();
+                    kc.addSequenceFrequencies(dna);
+                    chrono::duration<double> elapsed =
+                            chrono::steady_clock::now() - start;
+                    if (rep == 0 || elapsed.count() < seconds)
+                        seconds = elapsed.count();
+                }
+
+                Profile profile = kc.toProfile();
+                double megabytes = kc.getMemory() / 1048576.0;
+                string counts = "reference";
+                if (d == 0) {
+                    reference = profile;
+                    reference_seconds = seconds;
+                }
+                else {
+                    bool identical = profile.getSize() == reference.getSize();
+                    for (int j = 0; identical && j < profile.getSize(); j++) {
+                        identical = profile.at(j) == reference.at(j);
+                    }
+                    counts = identical ? "identical" : "DIFFERENT";
+                    if (!identical) {
+                        cerr << "The frequencies of the "
+                             << (partitioned ? "partitioned engine" :
+                                 "prefetch distance " + to_string(distances[d]))
+                             << " with k=" << k << " are different from the "
+                             << "ones without prefetch" << endl;
+                    }
+                }
+
+                cout << k << '\t' << megabytes << '\t'
+                     << (partitioned ? "partitioned\t-" : "direct\t" +
+                         to_string(distances[d])) << "\t1\t"
+                     << num_kmers / seconds / 1e6 << '\t'
+                     << reference_seconds / seconds << '\t' << counts << endl;
+                if (counts == "DIFFERENT")
+                    return 1;
+            }
+
+            // The hash engine gives the kmers in another order, so its
+            //    Profile is compared with the sorted reference
+            Profile sorted_reference = reference;
+            sorted_reference.zip();
+            sorted_reference.sort();
+            bool hash = seed == "" && ConcurrentKmerMap::CanPack(k, n, x);
+            kc.setPartitioned(false);
+            kc.setPrefetchDistance(KmerCounter::DEFAULT_PREFETCH_DISTANCE);
+            for (int e = 0; e < (hash ? 2 : 1); e++) {
+                for (size_t t = 0; t < threads.size(); t++) {
+                    double seconds = 0.0;
+                    Profile profile;
+                    double megabytes = 0.0;
+                    for (int rep = 0; rep < r; rep++) {
+                        if (e == 0) {
+                            kc.calculateSequenceFrequencies("");
+                            chrono::steady_clock::time_point start =
+                                    chrono::steady_clock::now();
+                            kc.addSequenceFrequencies(dna, threads[t]);
+                            chrono::duration<double> elapsed =
+                                    chrono::steady_clock::now() - start;
+                            if (rep == 0 || elapsed.count() < seconds)
+                                seconds = elapsed.count();
+                            if (rep == r - 1) {
+                                profile = kc.toProfile();
+                                megabytes = kc.getMemory() / 1048576.0;
+                            }
+                        }
+                        else {
+                            ConcurrentKmerMap map(k, n, min(num_kmers, 
+                                    kc.getNumKmers()), a, x);
+                            chrono::steady_clock::time_point start =
+                                    chrono::steady_clock::now();
+                            map.addSequenceFrequencies(dna, threads[t]);
+                            chrono::duration<double> elapsed =
+                                    chrono::steady_clock::now() - start;
+                            if (rep == 0 || elapsed.count() < seconds)
+                                seconds = elapsed.count();
+                            if (rep == r - 1) {
+                                profile = map.toProfile();
+                                profile.zip();
+                                profile.sort();
+                                megabytes = map.getMemory() / 1048576.0;
+                            }
+                        }
+                    }
+
+                    const Profile& expected = e == 0 ? reference :
+                            sorted_reference;
+                    bool identical = profile.getSize() == expected.getSize();
+                    for (int j = 0; identical && j < profile.getSize(); j++) {
+                        identical = profile.at(j) == expected.at(j);
+                    }
+                    cout << k << '\t' << megabytes << '\t'
+                         << (e == 0 ? "shared\t" + to_string(
+                             KmerCounter::DEFAULT_PREFETCH_DISTANCE) :
+                             string("hash\t-")) << '\t' << threads[t] << '\t'
+                         << num_kmers / seconds / 1e6 << '\t'
+                         << reference_seconds / seconds << '\t'
+                         << (identical ? "identical" : "DIFFERENT") << endl;
+                    if (!identical) {
+                        cerr << "The frequencies of the " 
+                             << (e == 0 ? "shared" : "hash") << " engine with "
+                             << threads[t] << " threads and k=" << k
+                             << " are different from the ones without "
+                             << "prefetch" << endl;
+                        return 1;
+                    }
+                }
+            }
+        }
+    }
+    catch (exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
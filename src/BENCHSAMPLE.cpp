@@ -0,0 +1,232 @@
+/*
+ * Metodología de la Programación: Kmer5
+ * Curso 2023/2024
+ */
+
+/**
+ * @file BENCHSAMPLE.cpp
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include "KmerCounter.h"
+#include "SampledKmerCounter.h"
+#include "RankVector.h"
+
+using namespace std;
+
+/**
+ * Shows help about the use of this program in the given output stream
+ * @param outputStream The output stream where the help will be shown (for example,
+ * cout, cerr, etc)
+ */
+void showEnglishHelp(ostream& outputStream) {
+    outputStream << "ERROR in BENCHSAMPLE parameters" << endl;
+    outputStream << "Run with the following parameters:" << endl;
+    outputStream << "BENCHSAMPLE [-n nucleotidesSet] [-a] [-x] [-k kValue] [-h sampling] -r numReferences <ref1.dna> ... <query1.dna> [<query2.dna> ...]" << endl;
+    outputStream << endl;
+    outputStream << "Parameters:" << endl;
+    outputStream << "-n nucletiodesSet: set of possible nucleotides in a kmer (ACGT by default). "
+                 << "Note that the characters should be provided in uppercase" << endl;
+    outputStream << "-a: count canonical kmers" << endl;
+    outputStream << "-x: count only the kmers without missing nucleotides" << endl;
+    outputStream << "-k kValue: number of nucleotides in a kmer (12 by default)" << endl;
+    outputStream << "-h sampling: a sampling to measure: fracminhash=S or minimizer=W (see "
+                 << "LEARN -h). It can be given several times (fracminhash=10, "
+                 << "fracminhash=100, fracminhash=1000 and minimizer=10 by default)" << endl;
+    outputStream << "-r numReferences: number of input files that are references. The "
+                 << "other ones are the queries (mandatory)" << endl;
+    outputStream << "<ref1.dna> ... <query1.dna> <query2.dna> ...: names of the DNA files "
+                 << "of the references, followed by the ones of the queries" << endl;
+    outputStream << endl;
+    outputStream << "This program measures the size of the sampled profiles, the time to "
+                 << "learn and to classify them, and how many queries are assigned to "
+                 << "the same reference as with the profiles of all the kmers" << endl;
+    outputStream << endl;
+}
+
+/**
+ * Learns the sampled profiles of the given DNA files
+ * @param files The names of the DNA files. Input parameter
+ * @param numFiles The number of files. Input parameter
+ * @param counter The counter of the sampled kmers. Input/output parameter
+ * @param profiles The sampled profiles, sorted. Output parameter
+ * @return The number of kmers of all the profiles
+ */
+long long LearnSampled(char* const files[], int numFiles,
+        SampledKmerCounter& counter, vector<Profile>& profiles) {
+    long long num_kmers = 0;
+    profiles.assign(numFiles, Profile());
+    for (int f = 0; f < numFiles; f++) {
+        counter.calculateFrequencies(files[f]);
+        profiles[f] = counter.toProfile();
+        profiles[f].zip();
+        profiles[f].sort();
+        num_kmers += profiles[f].getSize();
+    }
+
+    return num_kmers;
+}
+
+/**
+ * This program measures how the sampled profiles of SampledKmerCounter
+ * approximate the classification of CLASSIFY with all the kmers. The kmers
+ * of the DNA of each input file (its first word, as in
+ * KmerCounter::calculateFrequencies()) are sampled with each sampling, and
+ * each query is assigned to the closest reference, with the distance of
+ * Profile::getDistance() (see RankVector::getProfileDistance()). The
+ * sampling "fracminhash=1", which keeps all the kmers, is always measured
+ * first and used as reference: its decisions are the ones of CLASSIFY
+ * without sampling.
+ *
+ * The output has a line for each sampling: the sampling, the mean number of
+ * kmers of a profile, the reduction of the number of kmers with respect to
+ * the reference, the seconds to learn all the profiles, the seconds to
+ * classify all the queries, and the number of queries assigned to the same
+ * reference as with all the kmers, separated by tabs.
+ *
+ * Running sintax:
+ * > BENCHSAMPLE [-n nucleotidesSet] [-a] [-x] [-k kValue] [-h sampling] -r numReferences <ref1.dna> ... <query1.dna> [<query2.dna> ...]
+ *
+ * Running example:
+ * > BENCHSAMPLE -k 21 -x -r 2 ../Genomes/human_chr9_s10000_l500000.dna ../Genomes/mouse_chr9_s10000_l500000.dna ../Genomes/human_chr6_s10000_l500000.dna
+ *
+ * @param argc The number of command line parameters
+ * @param argv The vector of command line parameters (cstrings)
+ * @return 0 If there is no error; a value > 0 if error
+ */
+int main(int argc, char *argv[]) {
+    // Process the main() arguments
+    if (argc < 2) {
+        showEnglishHelp(cerr);
+        return 1;
+    }
+
+    string n = KmerCounter::DEFAULT_VALID_NUCLEOTIDES;
+    bool a = false;
+    bool x = false;
+    int k = 12;
+    vector<string> samplings(1, SampledKmerCounter::FRAC_MIN_HASH + "=1");
+    int r = 0;
+
+    bool sigo = true;
+    int i = 1;
+    while (sigo && i < argc-1) {
+        if (string(argv[i]).at(0) == '-') {
+            if (string(argv[i]) == "-n") {
+                n = argv[i+1];
+                i += 2;
+            }
+            else if (string(argv[i]) == "-a") {
+                a = true;
+                i++;
+            }
+            else if (string(argv[i]) == "-x") {
+                x = true;
+                i++;
+            }
+            else if (string(argv[i]) == "-k") {
+                k = stoi(argv[i+1]);
+                i += 2;
+            }
+            else if (string(argv[i]) == "-h") {
+                samplings.push_back(argv[i+1]);
+                i += 2;
+            }
+            else if (string(argv[i]) == "-r") {
+                r = stoi(argv[i+1]);
+                i += 2;
+            }
+            else {
+                showEnglishHelp(cerr);
+                return 1;
+            }
+        }
+        else {
+            sigo = false;
+        }
+    }
+
+    if (i >= argc || string(argv[i]).at(0) == '-' || k <= 0 || r <= 0 ||
+            argc - i <= r) {
+        showEnglishHelp(cerr);
+        return 1;
+    }
+    if (samplings.size() == 1) {
+        samplings.push_back(SampledKmerCounter::FRAC_MIN_HASH + "=10");
+        samplings.push_back(SampledKmerCounter::FRAC_MIN_HASH + "=100");
+        samplings.push_back(SampledKmerCounter::FRAC_MIN_HASH + "=1000");
+        samplings.push_back(SampledKmerCounter::MINIMIZER + "=10");
+    }
+    char* const* ref_files = argv + i;
+    char* const* query_files = argv + i + r;
+    int num_queries = argc - i - r;
+
+    cout << "sampling\tkmers\treduction\tlearn(s)\tclassify(s)\tagreement"
+         << endl;
+    try {
+        vector<int> full_decisions(num_queries, -1);
+        double full_kmers = 0.0;
+        for (size_t s = 0; s < samplings.size(); s++) {
+            SampledKmerCounter counter(k, n, samplings[s], a, x);
+            vector<Profile> refs, queries;
+            chrono::steady_clock::time_point start =
+                    chrono::steady_clock::now();
+            long long num_kmers = LearnSampled(ref_files, r, counter, refs) +
+                    LearnSampled(query_files, num_queries, counter, queries);
+            chrono::duration<double> learn_seconds =
+                    chrono::steady_clock::now() - start;
+
+            // The queries are classified as in CLASSIFY, with complete
+            //    RankVectors of the references
+            start = chrono::steady_clock::now();
+            vector<RankVector> ref_vectors(r);
+            for (int j = 0; j < r; j++) {
+                ref_vectors[j] = RankVector(max(refs[j].getSize(), 1));
+                ref_vectors[j].build(refs[j]);
+            }
+            int agreement = 0;
+            for (int q = 0; q < num_queries; q++) {
+                int decision = -1;
+                double best = 0.0;
+                if (queries[q].getSize() > 0) {
+                    RankVector query(queries[q].getSize());
+                    query.build(queries[q]);
+                    for (int j = 0; j < r; j++) {
+                        double distance =
+                                query.getProfileDistance(ref_vectors[j]);
+                        if (decision < 0 || distance < best) {
+                            decision = j;
+                            best = distance;
+                        }
+                    }
+                }
+                if (s == 0)
+                    full_decisions[q] = decision;
+                if (decision == full_decisions[q])
+                    agreement++;
+            }
+            chrono::duration<double> classify_seconds =
+                    chrono::steady_clock::now() - start;
+
+            double mean_kmers = (double) num_kmers / (r + num_queries);
+            if (s == 0)
+                full_kmers = mean_kmers;
+            cout << counter.getSampling() << '\t' << fixed << setprecision(1)
+                 << mean_kmers << '\t' << setprecision(2)
+                 << (mean_kmers > 0 ? full_kmers / mean_kmers : 0.0) << '\t'
+                 << setprecision(3) << learn_seconds.count() << '\t'
+                 << classify_seconds.count() << '\t' << agreement << '/'
+                 << num_queries << endl;
+        }
+    }
+    catch (exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
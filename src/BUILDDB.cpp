@@ -0,0 +1,226 @@
+/*
+ * Metodología de la Programación: Kmer5
+ * Curso 2023/2024
+ */
+
+/**
+ * @file BUILDDB.cpp
+ */
+
+#include <iostream>
+#include <fstream>
+#include "KmerCounter.h"
+#include "KmerIndex.h"
+#include "ProfileDatabase.h"
+#include "Sketch.h"
+#include "VPTree.h"
+
+using namespace std;
+
+/**
+ * Shows help about the use of this program in the given output stream
+ * @param outputStream The output stream where the help will be shown (for example,
+ * cout, cerr, etc)
+ */
+void showEnglishHelp(ostream& outputStream) {
+    outputStream << "ERROR in BUILDDB parameters" << endl;
+    outputStream << "Run with the following parameters:" << endl;
+    outputStream << "BUILDDB [-n nucleotidesSet] [-o outputFilename] [-l listFilename] [-s sketchSize] [-x depth] [-i kValue] [<profile1.prf> <profile2.prf> .... ]" << endl;
+    outputStream << endl;
+    outputStream << "Parameters:" << endl;
+    outputStream << "-n nucleotidesSet: set of possible nucleotides used to learn the profiles (ACGT by default). "
+                 << "Note that the characters should be provided in uppercase" << endl;
+    outputStream << "-o outputFilename: name of the output database file (refs.db by default)" << endl;
+    outputStream << "-l listFilename: name of a text file with the names of the profile files, one per line" << endl;
+    outputStream << "-s sketchSize: also save a MinHash sketch with sketchSize hash values for each "
+                 << "profile in the file outputFilename.skt (not saved by default)" << endl;
+    outputStream << "-x depth: also save a vantage-point tree over the first depth kmers of each "
+                 << "profile in the file outputFilename.vpt (not saved by default)" << endl;
+    outputStream << "-i kValue: also save an index with the kmers of the profiles learned with kValue "
+                 << "in the file outputFilename.kix, used by CLASSIFYREADS (not saved by default)" << endl;
+    outputStream << "<profile1.prf> <profile2.prf> ....: names of the profile files (at least one "
+                 << "is mandatory if -l is not given)" << endl;
+    outputStream << endl;
+    outputStream << "This program builds a reference database file with a set of profile models "
+                 << "that can be used by CLASSIFY with the option -d" << endl;
+    outputStream << endl;
+}
+
+/**
+ * This program builds a reference database file (see class ProfileDatabase)
+ * from a set of profile files (text or binary). The profiles can be given
+ * in the command line or in a text file with a name per line (option -l),
+ * which avoids the limit in the length of the command line when there are
+ * thousands of profiles.
+ *
+ * With the option -s, the MinHash sketches of the profiles (see class Sketch)
+ * are also saved, in the order of the database, in the file 
+ * outputFilename.skt. CLASSIFY uses them to select candidate profiles
+ * (option -c).
+ *
+ * With the option -x, a vantage-point tree (see class VPTree) over the 
+ * RankVector objects of the profiles is also saved in the file 
+ * outputFilename.vpt. CLASSIFY uses it to search the closest profiles with
+ * the metric of RankVector (option -v).
+ *
+ * With the option -i, an index with the kmers of the profiles learned with
+ * the given value of k and the given set of nucleotides (see class
+ * KmerIndex) is also saved in the file outputFilename.kix. CLASSIFYREADS
+ * uses it to classify each read of a sequencing file.
+ *
+ * Running sintax:
+ * > BUILDDB [-n nucleotidesSet] [-o outputFilename] [-l listFilename] [-s sketchSize] [-x depth] [-i kValue] [<profile1.prf> <profile2.prf> ....]
+ *
+ * Running example:
+ * > BUILDDB -o /tmp/refs.db ../Genomes/human_chr9_s10000_l500000.prf ../Genomes/worm1.prf
+ *
+ * @param argc The number of command line parameters
+ * @param argv The vector of command line parameters (cstrings)
+ * @return 0 If there is no error; a value > 0 if error
+ */
+int main(int argc, char *argv[]) {
+    // Process the main() arguments
+    if (argc < 2) {
+        showEnglishHelp(cerr);
+        return 1;
+    }
+
+    string n = KmerCounter::DEFAULT_VALID_NUCLEOTIDES;
+    string o = "refs.db";
+    string l = "";
+    int s = 0;
+    int x = 0;
+    int k = 0;
+
+    bool sigo = true;
+    int i = 1;
+    while (sigo && i < argc) {
+        if (string(argv[i]).at(0) == '-') {
+            if (i + 1 >= argc) {
+                showEnglishHelp(cerr);
+                return 1;
+            }
+            else if (string(argv[i]) == "-n") {
+                n = argv[i+1];
+                i += 2;
+            }
+            else if (string(argv[i]) == "-o") {
+                o = argv[i+1];
+                i += 2;
+            }
+            else if (string(argv[i]) == "-l") {
+                l = argv[i+1];
+                i += 2;
+            }
+            else if (string(argv[i]) == "-s") {
+                s = stoi(argv[i+1]);
+                i += 2;
+            }
+            else if (string(argv[i]) == "-x") {
+                x = stoi(argv[i+1]);
+                i += 2;
+            }
+            else if (string(argv[i]) == "-i") {
+                k = stoi(argv[i+1]);
+                i += 2;
+            }
+            else {
+                showEnglishHelp(cerr);
+                return 1;
+            }
+        }
+        else {
+            sigo = false;
+        }
+    }
+
+    // Count the names of the profile files
+    int num_list = 0;
+    string name;
+    ifstream list;
+    if (l != "") {
+        list.open(l.c_str());
+        if (!list) {
+            cerr << "The list file " << l << " cannot be opened" << endl;
+            return 1;
+        }
+        while (getline(list, name)) {
+            if (name != "")
+                num_list++;
+        }
+        list.clear();
+        list.seekg(0);
+    }
+
+    int num_args = argc - i + num_list;
+    if (num_args == 0) {
+        showEnglishHelp(cerr);
+        return 1;
+    }
+
+    string* profileFiles = new string[num_args];
+    for (int j = 0; j < argc - i; j++) {
+        profileFiles[j] = argv[i + j];
+    }
+    int pos = argc - i;
+    while (pos < num_args && getline(list, name)) {
+        if (name != "") {
+            profileFiles[pos] = name;
+            pos++;
+        }
+    }
+
+    // Build the database with all the profiles and, if requested, their
+    // sketches, the tree and the kmer index (reading the profiles back from the
+    // new database)
+    try {
+        ProfileDatabase::build(o.c_str(), profileFiles, num_args, n);
+        
+        if (s > 0 || x > 0 || k > 0) {
+            ProfileDatabase database;
+            database.open(o.c_str());
+            int size = database.getSize();
+            Sketch* sketches = new Sketch[s > 0 ? size : 0];
+            RankVector* vectors = new RankVector[x > 0 ? size : 0];
+            KmerIndex index(k > 0 ? k : 1, n);
+            for (int j = 0; j < size; j++) {
+                Profile profile = database.getProfile(j);
+                if (s > 0) {
+                    sketches[j] = Sketch(s);
+                    sketches[j].build(profile);
+                }
+                if (x > 0) {
+                    vectors[j] = RankVector(x);
+                    vectors[j].build(profile);
+                }
+                if (k > 0 && database.getK(j) == k &&
+                        database.getValidNucleotides(j) == n)
+                    index.addProfile(profile, j);
+            }
+            
+            if (s > 0)
+                Sketch::Save((o + ".skt").c_str(), sketches, size);
+            if (x > 0) {
+                VPTree tree;
+                tree.build(vectors, size);
+                tree.save((o + ".vpt").c_str());
+            }
+            if (k > 0)
+                index.save((o + ".kix").c_str());
+            delete[] sketches;
+            delete[] vectors;
+        }
+    }
+    catch (exception& e) {
+        cerr << e.what() << endl;
+        delete[] profileFiles;
+        return 1;
+    }
+
+    cout << "Database " << o << " built with " << num_args << " profiles"
+         << endl;
+
+    delete[] profileFiles;
+
+    return 0;
+}
@@ -0,0 +1,168 @@
+/*
+ * Metodología de la Programación: Kmer5
+ * Curso 2023/2024
+ */
+
+/**
+ * @file BloomFilter.cpp
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#include "BloomFilter.h"
+
+using namespace std;
+
+const int BloomFilter::BLOCK_BITS;
+const int BloomFilter::DEFAULT_BITS_PER_KEY;
+const int BloomFilter::MAX_HASHES;
+
+/**
+ * Number of words of 64 bits of a block
+ */
+static const int BLOCK_WORDS = BloomFilter::BLOCK_BITS / 64;
+
+/**
+ * Mixes the bits of a key, with a different function from the one of the
+ * slots of ConcurrentKmerMap, so the keys of a slot are spread over the
+ * filter
+ * @param key A key. Input parameter
+ * @return The hash value of @p key
+ */
+static inline unsigned long long Mix(unsigned long long key) {
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9ULL;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebULL;
+    key ^= key >> 31;
+    return key;
+}
+
+/**
+ * Sets some bits of a word that other threads can modify at the same time
+ * @param word A word. Input/Output parameter
+ * @param mask The bits to set. Input parameter
+ * @return The value of the word before setting the bits
+ */
+static inline unsigned long long SetBits(unsigned long long* word,
+        unsigned long long mask) {
+#ifdef __GNUC__
+    return __atomic_fetch_or(word, mask, __ATOMIC_RELAXED);
+#else
+    return reinterpret_cast<atomic<unsigned long long>*>(word)->fetch_or(
+            mask, memory_order_relaxed);
+#endif
+}
+
+/**
+ * Reads a word that other threads can modify at the same time
+ * @param word A word. Input parameter
+ * @return The value of the word
+ */
+static inline unsigned long long LoadBits(const unsigned long long* word) {
+#ifdef __GNUC__
+    return __atomic_load_n(word, __ATOMIC_RELAXED);
+#else
+    return reinterpret_cast<const atomic<unsigned long long>*>(word)->load(
+            memory_order_relaxed);
+#endif
+}
+
+BloomFilter::BloomFilter(long long numKeys, int bitsPerKey): _numKeys(0) {
+    if (numKeys <= 0 || bitsPerKey <= 0)
+        throw std::invalid_argument(string("BloomFilter::BloomFilter(long "
+                "long numKeys, int bitsPerKey): invalid filter of ") +
+                to_string(bitsPerKey) + " bits for " + to_string(numKeys) +
+                " keys");
+
+    _numBlocks = (numKeys * bitsPerKey + BLOCK_BITS - 1) / BLOCK_BITS;
+    _numHashes = max(1, min(MAX_HASHES, (int) round(bitsPerKey * log(2.0))));
+
+    // The blocks start at a cache line
+    long long numWords = _numBlocks * BLOCK_WORDS;
+    _memory = new unsigned long long[numWords + BLOCK_WORDS - 1]();
+    uintptr_t address = reinterpret_cast<uintptr_t>(_memory);
+    uintptr_t lineBytes = BLOCK_WORDS * sizeof(unsigned long long);
+    _words = reinterpret_cast<unsigned long long*>(
+            (address + lineBytes - 1) / lineBytes * lineBytes);
+}
+
+BloomFilter::~BloomFilter() {
+    delete[] _memory;
+}
+
+long long BloomFilter::getNumBits() const {
+    return _numBlocks * BLOCK_BITS;
+}
+
+int BloomFilter::getNumHashes() const {
+    return _numHashes;
+}
+
+long long BloomFilter::getNumKeys() const {
+    return _numKeys;
+}
+
+long long BloomFilter::getMemory() const {
+    return (_numBlocks + 1) * BLOCK_WORDS * sizeof(unsigned long long);
+}
+
+double BloomFilter::getFalsePositiveRate() const {
+    // Probability that the bits of a key that has not been inserted are set
+    //    in a word with i keys, weighted by the Poisson probability of i
+    double mean = (double) _numKeys / (_numBlocks * BLOCK_WORDS);
+    double rate = 0.0;
+    double probability = exp(-mean); // Probability of i keys in a block
+    int last = mean + 10 * sqrt(mean) + 10;
+    for (int i = 0; i <= last; i++) {
+        double unset = pow(1.0 - 1.0 / 64, (double) _numHashes * i);
+        rate += probability * pow(1.0 - unset, _numHashes);
+        probability *= mean / (i + 1);
+    }
+
+    return rate;
+}
+
+bool BloomFilter::contains(unsigned long long key) const {
+    unsigned long long mask;
+    long long word = locate(key, mask);
+    return (LoadBits(_words + word) & mask) == mask;
+}
+
+bool BloomFilter::insert(unsigned long long key) {
+    unsigned long long mask;
+    long long word = locate(key, mask);
+
+    // The bits are only written if some of them are not set, so the keys
+    //    that are found do not write the cache line. As all the bits are in
+    //    the same word, only one of the threads that insert a new key at the
+    //    same time finds some of them unset
+    if ((LoadBits(_words + word) & mask) == mask)
+        return true;
+    if ((SetBits(_words + word, mask) & mask) == mask)
+        return true;
+    _numKeys++;
+
+    return false;
+}
+
+long long BloomFilter::locate(unsigned long long key,
+        unsigned long long& mask) const {
+    // The block is selected with a hash of the key and the bits with
+    //    another one: 6 bits for each position in the word and 3 bits for
+    //    the word of the block
+    unsigned long long hash = Mix(key);
+    unsigned long long bits = Mix(hash ^ 0x9e3779b97f4a7c15ULL);
+    mask = 0;
+    for (int h = 0; h < _numHashes; h++) {
+        mask |= 1ULL << (bits & 63);
+        bits >>= 6;
+    }
+
+    return (long long) (hash % _numBlocks) * BLOCK_WORDS +
+            (long long) (bits % BLOCK_WORDS);
+}
@@ -11,10 +11,45 @@
  */
 
 #include <iostream>
+#include <fstream>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <vector>
 #include "KmerCounter.h"
+#include "KmerCounterT.h"
+#include "FastaReader.h"
+#include "ProfileDatabase.h"
+#include "RankVector.h"
+#include "SampledKmerCounter.h"
+#include "SequenceFilter.h"
+#include "Sketch.h"
+#include "VPTree.h"
 
 using namespace std;
 
+/**
+ * Maximum number of records of a batch with the option -f
+ */
+const int RECORDS_PER_BATCH = 1024;
+
+/**
+ * Number of nucleotides after which no more records are added to a batch
+ * with the option -f
+ */
+const long long NUCLEOTIDES_PER_BATCH = 1LL << 26;
+
+/**
+ * Default relative margin of the closest profile in the progressive mode
+ */
+const double DEFAULT_MARGIN = 0.05;
+
+/**
+ * Default number of consecutive checkpoints with the same closest profile
+ * and a margin above the threshold to stop the progressive mode
+ */
+const int DEFAULT_STABLE_CHECKPOINTS = 3;
+
 /**
  * Shows help about the use of this program in the given output stream
  * @param outputStream The output stream where the help will be shown (for example,
@@ -23,15 +58,60 @@ using namespace std;
 void showEnglishHelp(ostream& outputStream) {
     outputStream << "ERROR in CLASSIFY parameters" << endl;
     outputStream << "Run with the following parameters:" << endl;
-    outputStream << "CLASSIFY [-k kValue] [-n nucleotidesSet] <file.dna> <profile1.prf> [<profile2.prf> <profile3.prf> ....]" << endl;
+    outputStream << "CLASSIFY [-q] [-a] [-x] [-k kValue] [-n nucleotidesSet] [-h sampling] [-D dustLevel] [-d database.db] [-c numCandidates [-s sketchSize] | -v numNeighbours [-e epsilon]] [-r] [-f [-j numThreads] | -i interval [-m margin] [-w numCheckpoints] [-B maxNucleotides] [-l maxSeconds]] <file.dna> [<profile1.prf> <profile2.prf> <profile3.prf> ....]" << endl;
     outputStream << endl;
     outputStream << "Parameters:" << endl;
+    outputStream << "-q: only the final decision is printed (the distances to the profiles are not printed)" << endl;
+    outputStream << "-a: canonical kmers are counted in <file.dna> (see LEARN -a). The profiles "
+                 << "should also have been learned with -a" << endl;
+    outputStream << "-x: only the kmers without missing nucleotides are counted in <file.dna> "
+                 << "(see LEARN -x). The profiles should also have been learned with -x" << endl;
     outputStream << "-k kValue: number of nucleotides in a kmer (5 by default)" << endl;
     outputStream << "-n nucletiodesSet: set of possible nucleotides in a kmer (ACGT by default). "
                  << "It is used when learning a model for <file.dna>. " 
                  << "Note that the characters should be provided in uppercase" << endl;
+    outputStream << "-h sampling: only a sample of the kmers of <file.dna> is counted, "
+                 << "fracminhash=S or minimizer=W (see LEARN -h). The profiles should have been "
+                 << "learned with the same sampling, and the ones with all the kmers are not "
+                 << "accepted. It cannot be used with -d, -f or -i" << endl;
+    outputStream << "-D dustLevel: the windows of low complexity of <file.dna> whose DUST score is "
+                 << "greater than dustLevel are masked before counting its kmers (see LEARN -D). "
+                 << "The profiles should have been learned with the same level. It cannot be "
+                 << "used with -i" << endl;
+    outputStream << "-d database.db: reference database built with BUILDDB. Only the "
+                 << "profiles with the same kValue and nucleotidesSet are used" << endl;
+    outputStream << "-c numCandidates: the profiles are first ranked by the similarity of their "
+                 << "MinHash sketches with the one of <file.dna>, and the distance is only calculated for "
+                 << "the numCandidates most similar ones" << endl;
+    outputStream << "-s sketchSize: number of hash values in the sketch of <file.dna> (1000 by default)" << endl;
+    outputStream << "-v numNeighbours: the numNeighbours profiles of the database closest to <file.dna> "
+                 << "are searched in the vantage-point tree database.db.vpt (see BUILDDB -x), and the "
+                 << "distance is only calculated for them and for the given profile files" << endl;
+    outputStream << "-e epsilon: allowed error of the search in the vantage-point tree (0 by default, "
+                 << "an exact search)" << endl;
+    outputStream << "-r: the distances to all the profiles are also calculated to report whether the "
+                 << "closest profile was among the candidates" << endl;
+    outputStream << "-f: each record of the (multi-)FASTA file <file.dna> is classified separately, "
+                 << "and only the final decision of each record is printed. It cannot be used with "
+                 << "-c, -v or -r" << endl;
+    outputStream << "-j numThreads: number of threads used to classify the records with -f (number "
+                 << "of hardware threads by default)" << endl;
+    outputStream << "-i interval: progressive mode. <file.dna> is read in pieces of interval "
+                 << "nucleotides, and after each piece the distances from the kmers read so far to "
+                 << "the profiles are calculated. The reading stops when the decision is stable. "
+                 << "It cannot be used with -c, -v, -r or -f" << endl;
+    outputStream << "-m margin: minimum relative difference between the distances to the two closest "
+                 << "profiles of a stable decision in the progressive mode (" << DEFAULT_MARGIN
+                 << " by default)" << endl;
+    outputStream << "-w numCheckpoints: number of consecutive checkpoints with the same closest "
+                 << "profile and the minimum margin of a stable decision in the progressive mode ("
+                 << DEFAULT_STABLE_CHECKPOINTS << " by default)" << endl;
+    outputStream << "-B maxNucleotides: the progressive mode also stops after reading maxNucleotides "
+                 << "nucleotides (no limit by default)" << endl;
+    outputStream << "-l maxSeconds: the progressive mode also stops after maxSeconds seconds "
+                 << "(no limit by default)" << endl;
     outputStream << "<profile1.prf> [<profile2.prf> <profile3.prf> ....] ....: "
-                 << "names of the Profile models (at least one is mandatory)" << endl;
+                 << "names of the Profile models (at least one is mandatory if -d is not given)" << endl;
     outputStream << endl;
     outputStream << "This program obtains the identifier of the closest profile to the input DNA file" << endl;
     outputStream << endl;
@@ -58,6 +138,284 @@ int PosMinMax (double distances[], int num_args, bool(*MinMax)(double,double)) {
     return pos_minmax;
 }
 
+/**
+ * Obtains the distance from the Profile of the input genome to a reference
+ * Profile. If only the decision is requested, the calculation stops when
+ * the distance is greater than @p cutoff, and @p cutoff is updated when a
+ * closer reference is found.
+ * @param prf The Profile of the input genome. Input parameter
+ * @param reference The reference Profile. Input parameter
+ * @param onlyDecision Whether only the final decision is requested. 
+ * Input parameter
+ * @param cutoff The distance to the closest reference found so far. 
+ * Input/Output parameter
+ * @return The distance to the reference, or a value greater than 
+ * @p cutoff if it cannot be the closest one
+ */
+double GetDistance(const Profile& prf, const Profile& reference, 
+        bool onlyDecision, double& cutoff) {
+    double distance;
+    if (onlyDecision) {
+        distance = prf.getDistanceBounded(reference, cutoff);
+        if (distance < cutoff)
+            cutoff = distance;
+    }
+    else
+        distance = prf.getDistance(reference);
+    
+    return distance;
+}
+
+/**
+ * Returns the name used to print a reference profile. References are 
+ * numbered as follows: first the profile files given in the command line 
+ * and then the selected entries of the reference database.
+ * @param reference The number of the reference. Input parameter
+ * @param profileFiles The names of the profile files. Input parameter
+ * @param numFiles The number of profile files. Input parameter
+ * @param databaseName The name of the reference database. Input parameter
+ * @param databaseEntries The positions in the database of the selected 
+ * entries. Input parameter
+ * @return The name of the reference
+ */
+string GetReferenceName(int reference, char* const profileFiles[], 
+        int numFiles, const string& databaseName, const int databaseEntries[]) {
+    if (reference < numFiles)
+        return profileFiles[reference];
+    else
+        return databaseName + "[" + 
+                to_string(databaseEntries[reference - numFiles]) + "]";
+}
+
+/**
+ * Loads a reference profile (see GetReferenceName()).
+ * @param reference The number of the reference. Input parameter
+ * @param profileFiles The names of the profile files. Input parameter
+ * @param numFiles The number of profile files. Input parameter
+ * @param database The reference database. Input parameter
+ * @param databaseEntries The positions in the database of the selected 
+ * entries. Input parameter
+ * @return The reference Profile
+ */
+Profile LoadReference(int reference, char* const profileFiles[], 
+        int numFiles, const ProfileDatabase& database, 
+        const int databaseEntries[]) {
+    Profile profile;
+    if (reference < numFiles)
+        profile.load(profileFiles[reference]);
+    else
+        profile = database.getProfile(databaseEntries[reference - numFiles]);
+    
+    return profile;
+}
+
+/**
+ * Obtains the sketches of the reference profiles. The sketch of a profile
+ * file is read from a file with the same name and the extension .skt 
+ * added (see LEARN -s), and the sketches of the database entries from a file
+ * with the name of the database and the extension .skt added (see 
+ * BUILDDB -s). If a sketch file is not found, the sketch is built from the 
+ * reference Profile.
+ * @param sketchSize The number of hash values in a built sketch. 
+ * Input parameter
+ * @param numRefs The number of references. Input parameter
+ * @param profileFiles The names of the profile files. Input parameter
+ * @param numFiles The number of profile files. Input parameter
+ * @param databaseName The name of the reference database. Input parameter
+ * @param database The reference database. Input parameter
+ * @param databaseEntries The positions in the database of the selected 
+ * entries. Input parameter
+ * @return A dynamic array with a sketch for each reference
+ */
+Sketch* LoadReferenceSketches(int sketchSize, int numRefs, 
+        char* const profileFiles[], int numFiles, const string& databaseName,
+        const ProfileDatabase& database, const int databaseEntries[]) {
+    Sketch* sketches = new Sketch[numRefs];
+    Sketch* databaseSketches = nullptr;
+    int numDatabaseSketches = 0;
+    
+    if (numRefs > numFiles) {
+        try {
+            databaseSketches = Sketch::Load((databaseName + ".skt").c_str(),
+                    numDatabaseSketches);
+        }
+        catch (exception& e) {
+            databaseSketches = nullptr;
+            numDatabaseSketches = 0;
+        }
+    }
+    
+    for (int r = 0; r < numRefs; r++) {
+        bool found = false;
+        if (r < numFiles) {
+            try {
+                int numSketches;
+                Sketch* fileSketch = Sketch::Load(
+                        (string(profileFiles[r]) + ".skt").c_str(), 
+                        numSketches);
+                if (numSketches > 0) {
+                    sketches[r] = fileSketch[0];
+                    found = true;
+                }
+                delete[] fileSketch;
+            }
+            catch (exception& e) {
+                found = false;
+            }
+        }
+        else if (databaseEntries[r - numFiles] < numDatabaseSketches) {
+            sketches[r] = databaseSketches[databaseEntries[r - numFiles]];
+            found = true;
+        }
+        
+        if (!found) {
+            sketches[r] = Sketch(sketchSize);
+            sketches[r].build(LoadReference(r, profileFiles, numFiles, 
+                    database, databaseEntries));
+        }
+    }
+    
+    delete[] databaseSketches;
+    return sketches;
+}
+
+/**
+ * Loads the reference profiles (see GetReferenceName()) as complete
+ * RankVectors, so the distance of Profile::getDistance() to each one can be
+ * obtained with RankVector::getProfileDistance().
+ * @param numRefs The number of references. Input parameter
+ * @param profileFiles The names of the profile files. Input parameter
+ * @param numFiles The number of profile files. Input parameter
+ * @param database The reference database. Input parameter
+ * @param databaseEntries The positions in the database of the selected 
+ * entries. Input parameter
+ * @param referenceIds The identifier of each reference. Output parameter
+ * @return A dynamic array with a RankVector for each reference
+ */
+RankVector* LoadReferenceVectors(int numRefs, char* const profileFiles[], 
+        int numFiles, const ProfileDatabase& database, 
+        const int databaseEntries[], string referenceIds[]) {
+    RankVector* references = new RankVector[numRefs];
+    try {
+        for (int j = 0; j < numRefs; j++) {
+            Profile reference = LoadReference(j, profileFiles, numFiles, 
+                    database, databaseEntries);
+            referenceIds[j] = reference.getProfileId();
+            references[j] = RankVector(std::max(reference.getSize(), 1));
+            references[j].build(reference);
+        }
+    }
+    catch (exception& e) {
+        delete[] references;
+        throw;
+    }
+    
+    return references;
+}
+
+/**
+ * Reads the next nucleotides of a DNA file. As in 
+ * KmerCounter::calculateFrequencies(), the DNA is the first word of the 
+ * file, so the reading finishes at the first whitespace after it.
+ * @param input The DNA file. Input/Output parameter
+ * @param maxLength The maximum number of nucleotides to read. 
+ * Input parameter
+ * @param sequence The read nucleotides are appended to it. 
+ * Input/Output parameter
+ * @param finished Whether the end of the DNA has been found. 
+ * Input/Output parameter
+ * @return The number of read nucleotides
+ */
+long long ReadNucleotides(istream& input, long long maxLength, 
+        string& sequence, bool& finished) {
+    if (finished || maxLength <= 0)
+        return 0;
+    
+    size_t length = sequence.size();
+    sequence.resize(length + maxLength);
+    input.read(&sequence[length], maxLength);
+    long long numRead = input.gcount();
+    long long i = 0;
+    while (i < numRead && !isspace((unsigned char)sequence[length + i])) {
+        i++;
+    }
+    if (i < maxLength || input.peek() == EOF || 
+            isspace(input.peek()))
+        finished = true;
+    sequence.resize(length + i);
+    
+    return i;
+}
+
+/**
+ * Classifies a batch of records with several threads. Each thread takes the
+ * next record of the batch, filters it, learns its zipped and sorted 
+ * Profile with its own KmerCounter, which is reused for all its records, 
+ * and obtains the closest reference with RankVector::getProfileDistance().
+ * @param sequences The sequences of the records, which are filtered in 
+ * place. Input/Output parameter
+ * @param numRecords The number of records. Input parameter
+ * @param counters A KmerCounter for each thread. Input/Output parameter
+ * @param numThreads The number of threads. Input parameter
+ * @param filter The filter of the records. Input parameter
+ * @param references The complete RankVectors of the references. 
+ * Input parameter
+ * @param numRefs The number of references. Input parameter
+ * @param decisions The number of the closest reference to each record, or
+ * -1 if the record has not any kmer. Output parameter
+ * @param distances The distance from each record to its closest reference.
+ * Output parameter
+ * @throw std::exception The first exception thrown by a thread is rethrown
+ * once all the threads have finished
+ */
+void ClassifyBatch(string sequences[], int numRecords, 
+        KmerCounter counters[], int numThreads, const SequenceFilter& filter,
+        const RankVector references[], int numRefs, int decisions[], 
+        double distances[]) {
+    atomic<int> next(0);
+    atomic<bool> failed(false);
+    vector<exception_ptr> errors(numThreads);
+    vector<thread> workers;
+    for (int w = 0; w < numThreads; w++) {
+        workers.push_back(thread([&, w]() {
+            try {
+                for (int r = next++; r < numRecords && !failed; r = next++) {
+                    filter.filter(sequences[r]);
+                    counters[w].calculateSequenceFrequencies(sequences[r]);
+                    Profile prf = counters[w].toProfile();
+                    prf.zip();
+                    prf.sort();
+                    decisions[r] = -1;
+                    if (prf.getSize() == 0)
+                        continue;
+                    
+                    RankVector query(prf.getSize());
+                    query.build(prf);
+                    for (int j = 0; j < numRefs; j++) {
+                        double distance = 
+                                query.getProfileDistance(references[j]);
+                        if (decisions[r] < 0 || distance < distances[r]) {
+                            decisions[r] = j;
+                            distances[r] = distance;
+                        }
+                    }
+                }
+            }
+            catch (...) {
+                failed = true;
+                errors[w] = current_exception();
+            }
+        }));
+    }
+    for (int w = 0; w < numThreads; w++) {
+        workers[w].join();
+    }
+    for (int w = 0; w < numThreads; w++) {
+        if (errors[w] != nullptr)
+            rethrow_exception(errors[w]);
+    }
+}
+
 /**
  * This program prints the profile identifier of the closest profile model
  * for an input DNA file (<file.dna>) among the set of provided models:
@@ -70,12 +428,87 @@ int PosMinMax (double distances[], int num_args, bool(*MinMax)(double,double)) {
  * It classifies the input DNA file with the identifier of the Profile with
  * a minor distance.
  * 
+ * The reference profiles can also be provided in a database file built with
+ * BUILDDB (option -d). In that case, only the offset table of the database
+ * is read at the beginning, and each profile is read from the database when
+ * it is going to be compared with the input file. Profiles learned with a
+ * different value of k or a different set of nucleotides are skipped.
+ * 
+ * With the option -c, the references are first ranked by the estimation of
+ * the Jaccard similarity between the MinHash sketches (see class Sketch) of 
+ * their kmers and the one of the input file, and the distance is only
+ * calculated for the most similar ones. With the option -r, the closest
+ * profile among all the references is also obtained to report whether it
+ * was among the candidates.
+ * 
+ * With the option -v, the closest profiles of the database are searched in 
+ * the vantage-point tree saved next to the database by BUILDDB -x (see 
+ * class VPTree). The tree uses the metric of class RankVector, which is not
+ * the distance of Profile::getDistance(), so the found neighbours are 
+ * re-ranked by calculating their exact distances.
+ * 
+ * With the option -q, only the final decision is printed. In that case, the
+ * distance to each profile is calculated with Profile::getDistanceBounded(),
+ * using the distance to the closest profile found so far as cutoff, so the
+ * calculation stops as soon as a profile cannot be the closest one.
+ * 
+ * With the option -a, canonical kmers are counted in <file.dna> (see class
+ * KmerCounter), so a sequence and its reverse complement are classified
+ * in the same way. The reference profiles should also have been learned
+ * with canonical kmers (LEARN -a). This is not checked in this program.
+ * 
+ * With the option -x, only the kmers without missing nucleotides are 
+ * counted in <file.dna> (see class KmerCounter), with a smaller table of
+ * kmers. The reference profiles should also have been learned in that way
+ * (LEARN -x). This is not checked in this program.
+ * 
+ * With the option -h, only a sample of the kmers of <file.dna> is counted
+ * (see class SampledKmerCounter and LEARN -h), so a genome with a large k
+ * is classified with small profiles. The sampling is saved in the header of
+ * the sampled profiles, and a profile is only compared with <file.dna> if
+ * it has been learned with the same sampling, or without sampling if -h is
+ * not given. Otherwise, the program fails without comparing any profile.
+ * The profiles of a database are never sampled.
+ * 
+ * If the profile files have been learned with a spaced seed (LEARN -G), 
+ * the kmers of <file.dna> are counted with the seed saved in the first one
+ * (see KmerCounter::setSeed()), and the other ones should have the same 
+ * seed. Those profiles cannot be compared with the ones of a database.
+ * 
+ * With the option -D, the regions of low complexity of <file.dna> are 
+ * masked before its kmers are counted, as in LEARN -D (see class 
+ * SequenceFilter). The reference profiles should also have been learned
+ * with the same level. This is not checked in this program.
+ * 
+ * With the option -f, <file.dna> is read as a (multi-)FASTA file and each
+ * of its records (for example, the contigs of an assembly) is classified
+ * separately. The references are loaded once as complete RankVectors, so
+ * the distance of Profile::getDistance() to each one is obtained by merging
+ * both lists of kmers (see RankVector::getProfileDistance()). The records
+ * are read in batches, and while a batch is classified by several threads,
+ * each one reusing its own KmerCounter, the next batch is read. The final
+ * decision of each record is printed in the order of the input file, or
+ * "unclassified" if the record has not any kmer.
+ * 
+ * With the option -i, the classification is progressive: the kmers of
+ * <file.dna> are counted in pieces of interval nucleotides with the same
+ * KmerCounter, and after each piece (a checkpoint) the distances from the
+ * Profile of the kmers counted so far to the references, loaded once as
+ * complete RankVectors, are calculated. The reading stops as soon as the
+ * closest reference has been the same one in numCheckpoints consecutive
+ * checkpoints with a relative margin (the difference between the two
+ * smallest distances divided by the second one) of at least margin, or
+ * when the budget of nucleotides (-B) or seconds (-l) is exhausted. The
+ * decision of the last checkpoint is printed together with the number of
+ * nucleotides read, so a large file does not need to be read completely
+ * when its closest reference is clear.
+ * 
  * This program assumes that the profile files are already normalized and 
  * sorted by frequency. This is not checked in this program. Unexpected results
  * will be obtained if those conditions are not met.
  * 
  * Running sintax:
- * > CLASSIFY [-k kValue] [-n nucleotidesSet] <file.dna> <profile1.prf> [<profile2.prf> <profile3.prf> ....]
+ * > CLASSIFY [-q] [-a] [-x] [-k kValue] [-n nucleotidesSet] [-h sampling] [-D dustLevel] [-d database.db] [-c numCandidates [-s sketchSize] | -v numNeighbours [-e epsilon]] [-r] [-f [-j numThreads] | -i interval [-m margin] [-w numCheckpoints] [-B maxNucleotides] [-l maxSeconds]] <file.dna> [<profile1.prf> <profile2.prf> <profile3.prf> ....]
  * 
  * Running example: 
  * > CLASSIFY ../Genomes/human_chr6_s60000_l500000.dna ../Genomes/brewers_yeast_chrVII.s1_l500000.prf ../Genomes/chimpanzee_chr9_s1_l500000.prf ../Genomes/covidFullGenomeDNA.prf ../Genomes/drosophila_chr2L_s1_l500000.prf ../Genomes/ebolaFullGenomeDNA.prf ../Genomes/human_chr9_s10000_l500000.prf ../Genomes/monkeypoxFullGenomeDNA.prf ../Genomes/mouse_chr6_s3050050_l500000.prf ../Genomes/nematode_chrI_s1l500000.prf ../Genomes/rat_chr6_s1l500000.prf ../Genomes/zebrafish_chr6_s1l500000.prf
@@ -92,6 +525,19 @@ Distance to ../Genomes/rat_chr6_s1l500000.prf (rattus norvegicus): 0.111126
 Distance to ../Genomes/zebrafish_chr6_s1l500000.prf (danio rerio): 0.145231
 
 Final decision: homo sapiens with a distance of 0.0557804
+ * 
+ * > CLASSIFY -f -j 8 assembly.fasta ../Genomes/human_chr9_s10000_l500000.prf ../Genomes/worm1.prf
+Final decision for contig_1: homo sapiens with a distance of 0.0712301
+Final decision for contig_2: caenorhabditis elegans with a distance of 0.0951227
+...
+ * 
+ * > CLASSIFY -k 21 -x -h fracminhash=1000 ../Genomes/human_chr6_s60000_l500000.dna /tmp/human_chr9.prf /tmp/worm1.prf
+ * 
+ * > CLASSIFY -q -x -D 20 ../Genomes/human_chr6_s60000_l500000.dna /tmp/human_chr9.prf /tmp/worm1.prf
+ * 
+ * > CLASSIFY -q -i 1000000 ../Genomes/human_chr6_s60000_l500000.dna ../Genomes/human_chr9_s10000_l500000.prf ../Genomes/worm1.prf
+Final decision: homo sapiens with a distance of 0.0560412
+Input consumed: 3000000 nucleotides of a file of 50000001 bytes (5.99999%), stopped by a stable decision
  * 
  * @param argc The number of command line parameters
  * @param argv The vector of command line parameters (cstrings)
@@ -100,6 +546,7 @@ Final decision: homo sapiens with a distance of 0.0557804
 
 #include <regex>
 #include <cmath>
+#include <algorithm>
 
 const string VALID_NUCLEOTIDES_ADN = "ACGT";
 const string COMPLEMENTARY_NUCLEOTIDES_ADN = "TGCA";
@@ -118,12 +565,46 @@ int main(int argc, char *argv[]) {
     int num_args, first_arg;
     int k = 5;
     string n = KmerCounter::DEFAULT_VALID_NUCLEOTIDES;
+    string d = "";
+    bool q = false;
+    int c = 0;
+    int s = Sketch::DEFAULT_SIZE;
+    bool r = false;
+    int v = 0;
+    double e = 0;
+    bool f = false;
+    int t = thread::hardware_concurrency();
+    bool a = false;
+    bool x = false;
+    long long interval = 0;
+    double margin = DEFAULT_MARGIN;
+    int stable = DEFAULT_STABLE_CHECKPOINTS;
+    long long budget = 0;
+    double time_limit = 0;
+    string h = "";
+    int dust = 0;
     
     bool sigo = true;
     int i = 1;
     while (sigo && i < argc-1) {
         if (string(argv[i]).at(0) == '-') {
-            if (string(argv[i]) == "-k") {
+            if (string(argv[i]) == "-q") {
+                q = true;
+                i++;
+            }
+            else if (string(argv[i]) == "-r") {
+                r = true;
+                i++;
+            }
+            else if (string(argv[i]) == "-a") {
+                a = true;
+                i++;
+            }
+            else if (string(argv[i]) == "-x") {
+                x = true;
+                i++;
+            }
+            else if (string(argv[i]) == "-k") {
                 k = stoi(argv[i+1]);
                 i += 2;
             }
@@ -131,6 +612,62 @@ int main(int argc, char *argv[]) {
                 n = argv[i+1];
                 i += 2;
             }
+            else if (string(argv[i]) == "-h") {
+                h = argv[i+1];
+                i += 2;
+            }
+            else if (string(argv[i]) == "-D") {
+                dust = stoi(argv[i+1]);
+                i += 2;
+            }
+            else if (string(argv[i]) == "-d") {
+                d = argv[i+1];
+                i += 2;
+            }
+            else if (string(argv[i]) == "-c") {
+                c = stoi(argv[i+1]);
+                i += 2;
+            }
+            else if (string(argv[i]) == "-s") {
+                s = stoi(argv[i+1]);
+                i += 2;
+            }
+            else if (string(argv[i]) == "-v") {
+                v = stoi(argv[i+1]);
+                i += 2;
+            }
+            else if (string(argv[i]) == "-e") {
+                e = stod(argv[i+1]);
+                i += 2;
+            }
+            else if (string(argv[i]) == "-f") {
+                f = true;
+                i++;
+            }
+            else if (string(argv[i]) == "-j") {
+                t = stoi(argv[i+1]);
+                i += 2;
+            }
+            else if (string(argv[i]) == "-i") {
+                interval = stoll(argv[i+1]);
+                i += 2;
+            }
+            else if (string(argv[i]) == "-m") {
+                margin = stod(argv[i+1]);
+                i += 2;
+            }
+            else if (string(argv[i]) == "-w") {
+                stable = stoi(argv[i+1]);
+                i += 2;
+            }
+            else if (string(argv[i]) == "-B") {
+                budget = stoll(argv[i+1]);
+                i += 2;
+            }
+            else if (string(argv[i]) == "-l") {
+                time_limit = stod(argv[i+1]);
+                i += 2;
+            }
             else {
                 showEnglishHelp(cerr);
                 return 1;
@@ -144,51 +681,502 @@ int main(int argc, char *argv[]) {
     num_args = argc - i - 1;
     first_arg = i + 1;
     
-    if (string(argv[argc-1]).at(0)== '-' || string(argv[argc-2]).at(0) == '-') {
+    if (i >= argc || string(argv[argc-1]).at(0)== '-' || 
+            (num_args == 0 && d == "") || c < 0 || s <= 0 || v < 0 || 
+            e < 0 || (v > 0 && (c > 0 || d == "")) || 
+            (f && (c > 0 || v > 0 || r)) || interval < 0 || margin < 0 ||
+            stable <= 0 || budget < 0 || time_limit < 0 ||
+            (interval > 0 && (c > 0 || v > 0 || r || f)) ||
+            (h != "" && (d != "" || f || interval > 0)) || 
+            (dust != 0 && interval > 0)) {
         showEnglishHelp(cerr);
         return 1;
     }
+    if (t <= 0)
+        t = 1;
+    SequenceFilter filter;
+    try {
+        filter = SequenceFilter(0, dust);
+    }
+    catch (exception& ex) {
+        cerr << ex.what() << endl;
+        return 1;
+    }
+    if (a) {
+        try {
+            KmerCounter::GetComplementaryNucleotides(n);
+        }
+        catch (exception& e) {
+            cerr << e.what() << endl;
+            return 1;
+        }
+    }
+    
+    // The profile files should have been learned with the same sampling as
+    //    <file.dna>, or without sampling. The kmers of <file.dna> are 
+    //    counted with the spaced seed of the first profile, if it has one
+    string parameters = "";
+    string seed = "";
+    try {
+        string seed_prefix = KmerCounter::SEED + "=";
+        if (h != "")
+            parameters = SampledKmerCounter(k, n, h, a, x).getSampling();
+        else if (num_args > 0) {
+            string first = Profile::LoadParameters(argv[first_arg]);
+            if (first.compare(0, seed_prefix.size(), seed_prefix) == 0) {
+                parameters = first;
+                seed = first.substr(seed_prefix.size());
+            }
+        }
+        for (int j = 0; j < num_args; j++) {
+            string reference = Profile::LoadParameters(argv[first_arg + j]);
+            if (reference != parameters) {
+                cerr << "The profile " << argv[first_arg + j] << " has been "
+                     << "learned with " << (reference == "" ? "all the kmers" :
+                        reference) << ", and " << argv[first_arg-1] 
+                     << " with " << (parameters == "" ? "all the kmers" : 
+                        parameters) << endl;
+                return 1;
+            }
+        }
+        if (seed != "" && d != "") {
+            cerr << "The profiles of the database " << d << " cannot be "
+                 << "compared with the kmers of the seed " << seed << endl;
+            return 1;
+        }
+    }
+    catch (exception& ex) {
+        cerr << ex.what() << endl;
+        return 1;
+    }
+    
+    // Open the reference database. Only its offset table is read here, to 
+    //    select the entries learned with the same k and nucleotides
+    ProfileDatabase database;
+    int num_db = 0;
+    try {
+        if (d != "") {
+            database.open(d.c_str());
+            num_db = database.getSize();
+        }
+    }
+    catch (exception& ex) {
+        cerr << ex.what() << endl;
+        return 1;
+    }
     
-    // Calculate the kmer frecuencies of the input genome file using 
-    //    a KmerCounter object
-    KmerCounter kc(k,n);
-    kc.calculateFrequencies(argv[first_arg-1]);
+    int* databaseEntries = new int[num_db];
+    int num_selected = 0;
+    for (int j = 0; j < num_db; j++) {
+        if (database.getK(j) == k && database.getValidNucleotides(j) == n) {
+            databaseEntries[num_selected] = j;
+            num_selected++;
+        }
+    }
     
-    // Obtain a Profile object for the input genome from the KmerCounter object
-    Profile prf = kc.toProfile();
+    int num_refs = num_args + num_selected;
+    if (num_refs == 0) {
+        cerr << "There is not any profile learned with k=" << k
+             << " and nucleotides " << n << endl;
+        delete[] databaseEntries;
+        return 1;
+    }
     
-    // Zip the for the input genome Profile object
-    prf.zip();
+    if (f) {
+        // Load all the references once as complete RankVectors
+        RankVector* references = nullptr;
+        string* referenceIds = new string[num_refs];
+        string* names[2] = {new string[RECORDS_PER_BATCH],
+                new string[RECORDS_PER_BATCH]};
+        string* sequences[2] = {new string[RECORDS_PER_BATCH],
+                new string[RECORDS_PER_BATCH]};
+        int* decisions = new int[RECORDS_PER_BATCH];
+        double* distances = new double[RECORDS_PER_BATCH];
+        KmerCounter* counters = new KmerCounter[t];
+        int status = 0;
+        
+        try {
+            references = LoadReferenceVectors(num_refs, argv + first_arg, 
+                    num_args, database, databaseEntries, referenceIds);
+            for (int w = 0; w < t; w++) {
+                counters[w] = KmerCounter(k, n, a, x);
+                counters[w].setSeed(seed);
+            }
+            
+            // Two batches: one is classified while the other one is read
+            FastaReader reader;
+            reader.open(argv[first_arg-1]);
+            int current = 0;
+            int num_records = reader.next(names[current], sequences[current],
+                    RECORDS_PER_BATCH, NUCLEOTIDES_PER_BATCH);
+            while (num_records > 0) {
+                // The thread is always joined before an error is rethrown
+                exception_ptr error = nullptr;
+                thread classifier([&]() {
+                    try {
+                        ClassifyBatch(sequences[current], num_records, 
+                                counters, t, filter, references, num_refs, 
+                                decisions, distances);
+                    }
+                    catch (...) {
+                        error = current_exception();
+                    }
+                });
+                int num_next = 0;
+                exception_ptr readError = nullptr;
+                try {
+                    num_next = reader.next(names[1 - current], 
+                            sequences[1 - current], RECORDS_PER_BATCH, 
+                            NUCLEOTIDES_PER_BATCH);
+                }
+                catch (...) {
+                    readError = current_exception();
+                }
+                classifier.join();
+                if (error != nullptr)
+                    rethrow_exception(error);
+                
+                for (int j = 0; j < num_records; j++) {
+                    cout << "Final decision for " << names[current][j] << ": ";
+                    if (decisions[j] < 0)
+                        cout << "unclassified" << ENDL;
+                    else
+                        cout << referenceIds[decisions[j]] 
+                             << " with a distance of " << distances[j] << ENDL;
+                }
+
+                if (readError != nullptr)
+                    rethrow_exception(readError);
+                current = 1 - current;
+                num_records = num_next;
+            }
+        }
+        catch (exception& ex) {
+            cerr << ex.what() << endl;
+            status = 1;
+        }
+        
+        delete[] references;
+        delete[] referenceIds;
+        for (int b = 0; b < 2; b++) {
+            delete[] names[b];
+            delete[] sequences[b];
+        }
+        delete[] decisions;
+        delete[] distances;
+        delete[] counters;
+        delete[] databaseEntries;
+        
+        return status;
+    }
     
-    // Sort the for the input genome Profile object
-    prf.sort();
+    if (interval > 0) {
+        // Progressive mode: the kmers of <file.dna> are counted piece by 
+        //    piece, and the closest reference to the kmers counted so far
+        //    is obtained after each piece
+        RankVector* references = nullptr;
+        string* referenceIds = new string[num_refs];
+        int status = 0;
+        
+        try {
+            references = LoadReferenceVectors(num_refs, argv + first_arg, 
+                    num_args, database, databaseEntries, referenceIds);
+            
+            ifstream input(argv[first_arg-1], ios::in | ios::binary);
+            if (!input) {
+                throw ios_base::failure(string("The DNA file ") + 
+                        argv[first_arg-1] + " cannot be opened");
+            }
+            input.seekg(0, ios::end);
+            long long file_size = input.tellg();
+            input.seekg(0, ios::beg);
+            input >> ws;
+            
+            chrono::steady_clock::time_point start = 
+                    chrono::steady_clock::now();
+            KmerCounter kc(k, n, a, x);
+            kc.setSeed(seed);
+            string piece;
+            bool finished = false;
+            long long consumed = 0;
+            int pos_min = -1;
+            double distance_min = 0;
+            int num_stable = 0;
+            string reason = "";
+            
+            while (reason == "") {
+                // Each piece begins with the last nucleotides of the 
+                //    previous one, so the kmers between them are counted
+                if ((int) piece.size() > kc.getSpan() - 1)
+                    piece.erase(0, piece.size() - (kc.getSpan() - 1));
+                long long length = interval;
+                if (budget > 0)
+                    length = std::min(length, budget - consumed);
+                consumed += ReadNucleotides(input, length, piece, finished);
+                kc.addSequenceFrequencies(piece);
+                
+                Profile prf = kc.toProfile();
+                prf.zip();
+                prf.sort();
+                
+                // Closest and second closest references
+                int previous = pos_min;
+                double second = HUGE_VAL;
+                pos_min = -1;
+                if (prf.getSize() > 0) {
+                    RankVector query(prf.getSize());
+                    query.build(prf);
+                    for (int j = 0; j < num_refs; j++) {
+                        double distance = 
+                                query.getProfileDistance(references[j]);
+                        if (pos_min < 0 || distance < distance_min) {
+                            second = pos_min < 0 ? HUGE_VAL : distance_min;
+                            distance_min = distance;
+                            pos_min = j;
+                        }
+                        else if (distance < second)
+                            second = distance;
+                    }
+                }
+                
+                // The decision is stable after some consecutive checkpoints
+                //    with the same closest reference and enough margin
+                double relative_margin = 0;
+                if (pos_min >= 0) {
+                    if (second == HUGE_VAL)
+                        relative_margin = 1;
+                    else if (second > 0)
+                        relative_margin = (second - distance_min) / second;
+                }
+                if (pos_min >= 0 && relative_margin >= margin)
+                    num_stable = pos_min == previous ? num_stable + 1 : 1;
+                else
+                    num_stable = 0;
+                
+                if (!q && pos_min >= 0) {
+                    cout << "Checkpoint at " << consumed << " nucleotides: "
+                         << referenceIds[pos_min] << " with a distance of " 
+                         << distance_min << " (margin " << relative_margin 
+                         << ")" << endl;
+                }
+                
+                double seconds = chrono::duration<double>(
+                        chrono::steady_clock::now() - start).count();
+                if (num_stable >= stable)
+                    reason = "a stable decision";
+                else if (finished)
+                    reason = "the end of the DNA";
+                else if (budget > 0 && consumed >= budget)
+                    reason = "the nucleotide budget";
+                else if (time_limit > 0 && seconds >= time_limit)
+                    reason = "the time budget";
+            }
+            
+            if (!q)
+                cout << endl;
+            if (pos_min >= 0) {
+                cout << "Final decision: " << referenceIds[pos_min] 
+                     << " with a distance of " << distance_min << endl;
+            }
+            else
+                cout << "Final decision: unclassified" << endl;
+            cout << "Input consumed: " << consumed << " nucleotides of a file "
+                 << "of " << file_size << " bytes (" 
+                 << (file_size > 0 ? 100.0 * consumed / file_size : 100.0)
+                 << "%), stopped by " << reason << endl;
+        }
+        catch (exception& ex) {
+            cerr << ex.what() << endl;
+            status = 1;
+        }
+        
+        delete[] references;
+        delete[] referenceIds;
+        delete[] databaseEntries;
+        
+        return status;
+    }
     
-    // Use a loop to print the distance from the input genome to 
-    //   each one of the provided profile models
-    Profile* arrayProfiles;
-    double* distances;
-    arrayProfiles = new Profile[num_args];
-    distances = new double[num_args];
+    // Learn the zipped and sorted Profile of the input genome with a 
+    //    KmerCounterT specialized for k, if there is one for k and n, or 
+    //    only a sample of its kmers with -h
+    Profile prf;
+    if (h != "") {
+        SampledKmerCounter counter(k, n, h, a, x);
+        if (filter.isEnabled())
+            counter.addSequenceFrequencies(
+                    KmerCounter::ReadSequence(argv[first_arg-1], filter));
+        else
+            counter.calculateFrequencies(argv[first_arg-1]);
+        prf = counter.toProfile();
+        prf.zip();
+        prf.sort();
+    }
+    else if (a || x || seed != "" || filter.isEnabled() ||
+            !LearnSortedProfile(k, n, argv + first_arg - 1, 1, prf)) {
+        // Calculate the kmer frecuencies of the input genome file using 
+        //    a KmerCounter object
+        KmerCounter kc(k, n, a, x);
+        try {
+            kc.setSeed(seed);
+        }
+        catch (exception& ex) {
+            cerr << ex.what() << endl;
+            delete[] databaseEntries;
+            return 1;
+        }
+        if (filter.isEnabled())
+            kc.calculateSequenceFrequencies(
+                    KmerCounter::ReadSequence(argv[first_arg-1], filter));
+        else
+            kc.calculateFrequencies(argv[first_arg-1]);
+
+        // Obtain a Profile object for the input genome from the KmerCounter 
+        //    object
+        prf = kc.toProfile();
+
+        // Zip the for the input genome Profile object
+        prf.zip();
+
+        // Sort the for the input genome Profile object
+        prf.sort();
+    }
+    
+    // Select the references whose distance will be calculated: all of them,
+    //    or the numCandidates ones with the most similar sketches
+    int* candidates = new int[num_refs];
+    int num_candidates = num_refs;
+    for (int j = 0; j < num_refs; j++) {
+        candidates[j] = j;
+    }
     
-    for (int k = 0; k < num_args; k++) {
-        arrayProfiles[k].load(argv[k+ first_arg]);
+    if (c > 0 && c < num_refs) {
+        Sketch query(s);
+        query.build(prf);
+        Sketch* sketches = LoadReferenceSketches(s, num_refs, argv + first_arg,
+                num_args, d, database, databaseEntries);
+        double* similarities = new double[num_refs];
+        for (int j = 0; j < num_refs; j++) {
+            similarities[j] = query.getJaccard(sketches[j]);
+        }
+        
+        std::stable_sort(candidates, candidates + num_refs, 
+                [similarities](int a, int b) {
+                    return similarities[a] > similarities[b];
+                });
+        num_candidates = c;
+        std::sort(candidates, candidates + num_candidates);
+        
+        delete[] similarities;
+        delete[] sketches;
+    }
+    else if (v > 0) {
+        VPTree tree;
+        int* neighbours = new int[v];
+        double* metricDistances = new double[v];
+        int numEvaluations = 0;
+        int found = 0;
+        try {
+            tree.load((d + ".vpt").c_str());
+            RankVector query(tree.getDepth());
+            query.build(prf);
+            found = tree.search(query, v, neighbours, metricDistances, 
+                    numEvaluations, e);
+        }
+        catch (exception& ex) {
+            cerr << ex.what() << endl;
+            delete[] neighbours;
+            delete[] metricDistances;
+            delete[] candidates;
+            delete[] databaseEntries;
+            return 1;
+        }
+        
+        // The profile files and the neighbours learned with the same k and
+        //    nucleotides are the candidates
+        num_candidates = num_args;
+        for (int j = 0; j < found; j++) {
+            int* pos = std::lower_bound(databaseEntries, 
+                    databaseEntries + num_selected, neighbours[j]);
+            if (pos != databaseEntries + num_selected && *pos == neighbours[j]) {
+                candidates[num_candidates] = num_args + (pos - databaseEntries);
+                num_candidates++;
+            }
+        }
+        std::sort(candidates, candidates + num_candidates);
+        if (r) {
+            cout << "Vantage-point tree: " << numEvaluations 
+                 << " distances evaluated for " << tree.getSize() 
+                 << " profiles" << endl;
+        }
+        
+        delete[] neighbours;
+        delete[] metricDistances;
+        
+        if (num_candidates == 0) {
+            cerr << "There is not any neighbour learned with k=" << k
+                 << " and nucleotides " << n << endl;
+            delete[] candidates;
+            delete[] databaseEntries;
+            return 1;
+        }
     }
     
-    for (int j = 0; j < num_args; j++) {
-        distances[j] = prf.getDistance(arrayProfiles[j]);
-        cout << "Distance to " << argv[j + first_arg] << " ("
-             << arrayProfiles[j].getProfileId() << "): " 
-             << distances[j] << endl;
+    // Use a loop to print the distance from the input genome to 
+    //   each one of the candidate profile models. Each model is loaded
+    //   just before it is used. If only the decision is requested, the 
+    //   distance to the closest model found so far is used to stop the
+    //   calculation of the distances to the remaining ones
+    string* profileIds = new string[num_candidates];
+    double* distances = new double[num_candidates];
+    double cutoff = HUGE_VAL;
+    
+    for (int j = 0; j < num_candidates; j++) {
+        Profile reference = LoadReference(candidates[j], argv + first_arg, 
+                num_args, database, databaseEntries);
+        profileIds[j] = reference.getProfileId();
+        distances[j] = GetDistance(prf, reference, q, cutoff);
+        if (!q) {
+            cout << "Distance to " << GetReferenceName(candidates[j], 
+                    argv + first_arg, num_args, d, databaseEntries) << " ("
+                 << profileIds[j] << "): " << distances[j] << endl;
+        }
     }
     
     // Print the identifier and distance to the closest profile
-    int pos_min = PosMinMax(distances, num_args, min);    
-    cout << "Final decision: "  << arrayProfiles[pos_min].getProfileId() 
-         << "with a distance of " << distances[pos_min] << endl;;
+    int pos_min = PosMinMax(distances, num_candidates, min);
+    if (!q)
+        cout << endl;
+    cout << "Final decision: "  << profileIds[pos_min] 
+         << " with a distance of " << distances[pos_min] << endl;
     
-    delete[] arrayProfiles;
+    // Report whether the closest profile among all the references was 
+    //    selected as a candidate
+    if (r && num_candidates < num_refs) {
+        double best = HUGE_VAL;
+        int pos_best = 0;
+        for (int j = 0; j < num_refs; j++) {
+            Profile reference = LoadReference(j, argv + first_arg, num_args,
+                    database, databaseEntries);
+            double distance = prf.getDistanceBounded(reference, best);
+            if (distance < best) {
+                best = distance;
+                pos_best = j;
+            }
+        }
+        bool found = std::binary_search(candidates, 
+                candidates + num_candidates, pos_best);
+        cout << (v > 0 ? "Tree" : "Sketch") << " recall: " << (found ? 1 : 0) 
+             << "/1 (closest profile "
+             << GetReferenceName(pos_best, argv + first_arg, num_args, d, 
+                    databaseEntries)
+             << " with a distance of " << best << ")" << endl;
+    }
+    
+    delete[] profileIds;
     delete[] distances;
+    delete[] candidates;
+    delete[] databaseEntries;
     
     return 0;
 }
-
@@ -0,0 +1,364 @@
+/*
+ * Metodología de la Programación: Kmer5
+ * Curso 2023/2024
+ */
+
+/**
+ * @file CLASSIFYREADS.cpp
+ */
+
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "KmerIndex.h"
+#include "ProfileDatabase.h"
+#include "SequenceFilter.h"
+
+using namespace std;
+
+/**
+ * Number of reads of a batch
+ */
+const int READS_PER_BATCH = 1 << 16;
+
+/**
+ * Number of reads taken each time by a thread from a batch
+ */
+const int READS_PER_CHUNK = 256;
+
+/**
+ * Shows help about the use of this program in the given output stream
+ * @param outputStream The output stream where the help will be shown (for example,
+ * cout, cerr, etc)
+ */
+void showEnglishHelp(ostream& outputStream) {
+    outputStream << "ERROR in CLASSIFYREADS parameters" << endl;
+    outputStream << "Run with the following parameters:" << endl;
+    outputStream << "CLASSIFYREADS [-j numThreads] [-V minVotes] [-o assignmentsFilename] [-Q minQuality] [-D dustLevel] -d database.db <reads.fastq>" << endl;
+    outputStream << endl;
+    outputStream << "Parameters:" << endl;
+    outputStream << "-j numThreads: number of threads used to classify the reads (number of "
+                 << "hardware threads by default)" << endl;
+    outputStream << "-V minVotes: minimum number of kmers of a read that should vote for its "
+                 << "reference (1 by default)" << endl;
+    outputStream << "-o assignmentsFilename: name of a file where the reference of each read "
+                 << "is saved (not saved by default)" << endl;
+    outputStream << "-Q minQuality: the nucleotides whose Phred quality is smaller than "
+                 << "minQuality are masked before the kmers are looked up (none by default)" << endl;
+    outputStream << "-D dustLevel: the windows of " << SequenceFilter::DUST_WINDOW 
+                 << " nucleotides of low complexity (for example, poly-A) whose DUST score is "
+                 << "greater than dustLevel are masked before the kmers are looked up ("
+                 << SequenceFilter::DEFAULT_DUST_LEVEL << " is usual; none by default)" << endl;
+    outputStream << "-d database.db: reference database built with BUILDDB -i. The kmer index "
+                 << "is read from the file database.db.kix" << endl;
+    outputStream << "<reads.fastq>: name of the FASTQ file with the reads" << endl;
+    outputStream << endl;
+    outputStream << "This program classifies each read of a FASTQ file and reports the number of "
+                 << "reads of each profile of the database" << endl;
+    outputStream << endl;
+}
+
+/**
+ * Reads a batch of reads from a FASTQ file. Each record has four lines: the
+ * name (beginning with '@'), the sequence, a separator (beginning with '+')
+ * and the qualities.
+ * @param input The FASTQ file. Input/Output parameter
+ * @param names The names of the reads, without the '@'. Output parameter
+ * @param sequences The sequences of the reads. Output parameter
+ * @param qualities The qualities of the reads. Output parameter
+ * @return The number of reads of the batch (0 at the end of the file)
+ * @throw std::invalid_argument Throws an std::invalid_argument exception
+ * if a record is not a valid FASTQ record
+ */
+int ReadBatch(istream& input, vector<string>& names, vector<string>& sequences,
+        vector<string>& qualities) {
+    string separator;
+    int numReads = 0;
+
+    while (numReads < READS_PER_BATCH &&
+            getline(input, names[numReads])) {
+        string& name = names[numReads];
+        if (name == "")
+            continue;
+        if (name[0] != '@' || !getline(input, sequences[numReads]) ||
+                !getline(input, separator) || separator == "" ||
+                separator[0] != '+' || !getline(input, qualities[numReads]) ||
+                qualities[numReads].size() != sequences[numReads].size()) {
+            throw invalid_argument(string("int ReadBatch(istream& input, "
+                    "vector<string>& names, vector<string>& sequences, "
+                    "vector<string>& qualities): invalid FASTQ record ") +
+                    name);
+        }
+        name.erase(0, 1);
+        numReads++;
+    }
+
+    return numReads;
+}
+
+/**
+ * This program classifies each read of a FASTQ file (<reads.fastq>) with
+ * the profiles of a reference database (see BUILDDB). Instead of learning a
+ * single Profile for the whole file, which is useless for a sample with
+ * several organisms, each kmer of a read votes for the reference that
+ * contains it and the read is assigned to the reference with most votes.
+ *
+ * The kmers of the references are looked up in a KmerIndex built once by
+ * BUILDDB -i and saved next to the database (database.db.kix). Kmers that
+ * appear in several references do not vote. A read is ambiguous if there is
+ * a tie between the references with most votes, and it is unclassified if
+ * no reference has minVotes votes (option -V, 1 by default).
+ *
+ * The reads are read in batches. While a batch is classified by the
+ * threads, which share the read-only index and reuse their auxiliary
+ * arrays, the next batch is read from the file. With the option -o, the
+ * name of each read and the position in the database of its reference
+ * (or - if it is ambiguous or unclassified) are saved in the given file,
+ * in the order of the input file.
+ *
+ * Each read can be filtered in place before its kmers are looked up (see
+ * class SequenceFilter): with the option -Q, the nucleotides whose Phred
+ * quality is smaller than minQuality are masked, and with the option -D,
+ * the windows of low complexity (poly-A, microsatellites) whose DUST score
+ * is greater than dustLevel are masked. The kmers with masked nucleotides
+ * do not vote, so the sequencing errors and the repeats shared by most
+ * genomes do not decide the reference of a read. The number of masked
+ * nucleotides is shown after the number of reads.
+ *
+ * The output shows the number of reads assigned to each profile (the
+ * profiles without any read are not shown), followed by the number of
+ * ambiguous, unclassified and total reads.
+ *
+ * Running sintax:
+ * > CLASSIFYREADS [-j numThreads] [-V minVotes] [-o assignmentsFilename] [-Q minQuality] [-D dustLevel] -d database.db <reads.fastq>
+ *
+ * Running example:
+ * > BUILDDB -i 11 -o /tmp/refs.db ../Genomes/human_chr9_s10000_l500000.prf ../Genomes/worm1.prf
+ * > CLASSIFYREADS -d /tmp/refs.db sample.fastq
+ * Reads assigned to /tmp/refs.db[0] (homo sapiens): 9120
+ * Reads assigned to /tmp/refs.db[1] (caenorhabditis elegans): 4011
+ * Ambiguous reads: 12
+ * Unclassified reads: 857
+ * Total reads: 14000
+ *
+ * > CLASSIFYREADS -Q 20 -D 20 -j 16 -d /tmp/refs.db sample.fastq
+ *
+ * @param argc The number of command line parameters
+ * @param argv The vector of command line parameters (cstrings)
+ * @return 0 If there is no error; a value > 0 if error
+ */
+int main(int argc, char *argv[]) {
+    // Process the main() arguments
+    if (argc < 4) {
+        showEnglishHelp(cerr);
+        return 1;
+    }
+
+    int j = thread::hardware_concurrency();
+    int v = 1;
+    string o = "";
+    string d = "";
+    int q = 0;
+    int dust = 0;
+
+    bool sigo = true;
+    int i = 1;
+    while (sigo && i < argc-1) {
+        if (string(argv[i]).at(0) == '-') {
+            if (string(argv[i]) == "-j") {
+                j = stoi(argv[i+1]);
+                i += 2;
+            }
+            else if (string(argv[i]) == "-V") {
+                v = stoi(argv[i+1]);
+                i += 2;
+            }
+            else if (string(argv[i]) == "-o") {
+                o = argv[i+1];
+                i += 2;
+            }
+            else if (string(argv[i]) == "-Q") {
+                q = stoi(argv[i+1]);
+                i += 2;
+            }
+            else if (string(argv[i]) == "-D") {
+                dust = stoi(argv[i+1]);
+                i += 2;
+            }
+            else if (string(argv[i]) == "-d") {
+                d = argv[i+1];
+                i += 2;
+            }
+            else {
+                showEnglishHelp(cerr);
+                return 1;
+            }
+        }
+        else {
+            sigo = false;
+        }
+    }
+
+    if (i != argc-1 || string(argv[argc-1]).at(0) == '-' || d == "" ||
+            v <= 0) {
+        showEnglishHelp(cerr);
+        return 1;
+    }
+    if (j <= 0)
+        j = 1;
+    SequenceFilter filter;
+    try {
+        filter = SequenceFilter(q, dust);
+    }
+    catch (exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    // Load the kmer index and the names of the references
+    KmerIndex index;
+    ProfileDatabase database;
+    try {
+        index.load((d + ".kix").c_str());
+        database.open(d.c_str());
+    }
+    catch (exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+    int num_refs = index.getNumReferences();
+
+    ifstream input(argv[argc-1]);
+    if (!input) {
+        cerr << "The reads file " << argv[argc-1] << " cannot be opened" << endl;
+        return 1;
+    }
+
+    ofstream assignments;
+    if (o != "") {
+        assignments.open(o.c_str());
+        if (!assignments) {
+            cerr << "The output file " << o << " cannot be opened" << endl;
+            return 1;
+        }
+    }
+
+    // Two batches: one is classified while the other one is read
+    vector<string> names[2], sequences[2], qualities[2];
+    vector<int> results(READS_PER_BATCH);
+    for (int b = 0; b < 2; b++) {
+        names[b].resize(READS_PER_BATCH);
+        sequences[b].resize(READS_PER_BATCH);
+        qualities[b].resize(READS_PER_BATCH);
+    }
+
+    // Auxiliary arrays of each thread for KmerIndex::classify()
+    vector<vector<int> > votes(j, vector<int>(num_refs, 0));
+    vector<vector<int> > voted(j);
+    vector<long long> masked(j, 0);
+
+    long long* counts = new long long[num_refs]();
+    long long ambiguous = 0, unclassified = 0, total = 0;
+
+    try {
+        int current = 0;
+        int num_reads = ReadBatch(input, names[current], sequences[current],
+                qualities[current]);
+        while (num_reads > 0) {
+            atomic<int> next(0);
+            vector<thread> workers;
+            for (int w = 0; w < j; w++) {
+                workers.push_back(thread([&, w]() {
+                    // The masked nucleotides are counted in a local
+                    //    variable, since the counters of the threads share
+                    //    a cache line
+                    vector<string>& batch = sequences[current];
+                    long long num_masked = 0;
+                    for (int first = next.fetch_add(READS_PER_CHUNK);
+                            first < num_reads;
+                            first = next.fetch_add(READS_PER_CHUNK)) {
+                        int last = min(first + READS_PER_CHUNK, num_reads);
+                        for (int r = first; r < last; r++) {
+                            if (filter.isEnabled())
+                                num_masked += filter.filter(&batch[r][0],
+                                        batch[r].size(),
+                                        qualities[current][r].data());
+                            if (voted[w].size() < batch[r].size())
+                                voted[w].resize(batch[r].size());
+                            results[r] = index.classify(batch[r].data(),
+                                    batch[r].size(), v, votes[w].data(),
+                                    voted[w].data());
+                        }
+                    }
+                    masked[w] += num_masked;
+                }));
+            }
+
+            int num_next = 0;
+            string error = "";
+            try {
+                num_next = ReadBatch(input, names[1 - current],
+                        sequences[1 - current], qualities[1 - current]);
+            }
+            catch (exception& e) {
+                error = e.what();
+            }
+            for (int w = 0; w < j; w++) {
+                workers[w].join();
+            }
+
+            for (int r = 0; r < num_reads; r++) {
+                if (results[r] >= 0)
+                    counts[results[r]]++;
+                else if (results[r] == KmerIndex::AMBIGUOUS)
+                    ambiguous++;
+                else
+                    unclassified++;
+                if (o != "") {
+                    assignments << names[current][r] << '\t';
+                    if (results[r] >= 0)
+                        assignments << results[r] << '\n';
+                    else
+                        assignments << '-' << '\n';
+                }
+            }
+            total += num_reads;
+
+            if (error != "")
+                throw invalid_argument(error);
+            current = 1 - current;
+            num_reads = num_next;
+        }
+    }
+    catch (exception& e) {
+        cerr << e.what() << endl;
+        delete[] counts;
+        return 1;
+    }
+
+    for (int r = 0; r < num_refs; r++) {
+        if (counts[r] > 0) {
+            cout << "Reads assigned to " << d << "[" << r << "] (";
+            if (r < database.getSize())
+                cout << database.getProfileId(r);
+            cout << "): " << counts[r] << endl;
+        }
+    }
+    cout << "Ambiguous reads: " << ambiguous << endl;
+    cout << "Unclassified reads: " << unclassified << endl;
+    cout << "Total reads: " << total << endl;
+    if (filter.isEnabled()) {
+        long long num_masked = 0;
+        for (int w = 0; w < j; w++) {
+            num_masked += masked[w];
+        }
+        cout << "Masked nucleotides: " << num_masked << endl;
+    }
+
+    delete[] counts;
+
+    return 0;
+}
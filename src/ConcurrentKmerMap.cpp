@@ -0,0 +1,164 @@
+/*
+ * Metodología de la Programación: Kmer5
+ * Curso 2023/2024
+ */
+
+/**
+ * @file ConcurrentKmerMap.cpp
+ */
+
+#include <algorithm>
+#include <climits>
+#include <stdexcept>
+
+#include "ConcurrentKmerMap.h"
+#include "KmerCounter.h"
+
+using namespace std;
+
+const double ConcurrentKmerMap::MAX_LOAD = 0.75;
+
+/**
+ * Mixes the bits of the code of a kmer to select its slot, so the kmers
+ * with common prefixes are spread over the table
+ * @param code The code of a kmer. Input parameter
+ * @return The hash value of @p code
+ */
+static inline unsigned long long SlotHash(unsigned long long code) {
+    code ^= code >> 33;
+    code *= 0xff51afd7ed558ccdULL;
+    code ^= code >> 33;
+    return code;
+}
+
+ConcurrentKmerMap::ConcurrentKmerMap(int k,
+        const std::string& validNucleotides, long long capacity,
+        bool canonical, bool onlyValidKmers): _coder(k, validNucleotides,
+        canonical, onlyValidKmers), _size(0), _filter(nullptr) {
+    if (capacity <= 0)
+        throw std::invalid_argument(string("ConcurrentKmerMap::"
+                "ConcurrentKmerMap(int k, const std::string& "
+                "validNucleotides, long long capacity, bool canonical, bool "
+                "onlyValidKmers): the kmers of ") + to_string(k) +
+                " nucleotides of " + validNucleotides + " cannot be counted "
+                "with capacity " + to_string(capacity));
+
+    _numSlots = 1;
+    while (_numSlots * MAX_LOAD < capacity) {
+        _numSlots *= 2;
+    }
+    _maxSize = _numSlots * MAX_LOAD;
+    _keys = new atomic<unsigned long long>[_numSlots]();
+    _frequencies = new atomic<long long>[_numSlots]();
+}
+
+ConcurrentKmerMap::~ConcurrentKmerMap() {
+    delete[] _keys;
+    delete[] _frequencies;
+    delete _filter;
+}
+
+int ConcurrentKmerMap::getK() const {
+    return _coder.getK();
+}
+
+long long ConcurrentKmerMap::getNumSlots() const {
+    return _numSlots;
+}
+
+long long ConcurrentKmerMap::getSize() const {
+    return _size;
+}
+
+long long ConcurrentKmerMap::getMemory() const {
+    long long memory = _numSlots * (sizeof(unsigned long long) +
+            sizeof(long long));
+    if (_filter != nullptr)
+        memory += _filter->getMemory();
+
+    return memory;
+}
+
+double ConcurrentKmerMap::getFalsePositiveRate() const {
+    return _filter != nullptr ? _filter->getFalsePositiveRate() : 0.0;
+}
+
+void ConcurrentKmerMap::filterSingletons(long long numKmers,
+        int bitsPerKmer) {
+    if (numKmers <= 0 || bitsPerKmer <= 0)
+        throw std::invalid_argument(string("void ConcurrentKmerMap::"
+                "filterSingletons(long long numKmers, int bitsPerKmer): "
+                "invalid filter of ") + to_string(bitsPerKmer) + " bits for " +
+                to_string(numKmers) + " kmers");
+
+    delete _filter;
+    _filter = nullptr;
+    _filter = new BloomFilter(numKmers, bitsPerKmer);
+}
+
+bool ConcurrentKmerMap::CanPack(int k, const std::string& validNucleotides,
+        bool onlyValidKmers) {
+    return KmerCoder::CanPack(k, validNucleotides, onlyValidKmers);
+}
+
+void ConcurrentKmerMap::addSequenceFrequencies(const std::string& sequence,
+        int numThreads) {
+    KmerCounter::ForEachPiece(sequence.length(), getK(), numThreads,
+            [&](int begin, int end) {
+                _coder.forEachCode(sequence.data() + begin, end - begin,
+                        [this](unsigned long long code, int count) {
+                            // The first occurrence of a kmer only goes to
+                            //    the filter
+                            if (_filter != nullptr && !_filter->insert(code))
+                                count--;
+                            if (count > 0)
+                                increase(code, count);
+                        });
+            });
+}
+
+void ConcurrentKmerMap::increase(unsigned long long code, int value) {
+    unsigned long long key = code + 1;
+    long long slot = SlotHash(code) & (_numSlots - 1);
+    while (true) {
+        unsigned long long current = _keys[slot].load(memory_order_acquire);
+        if (current == 0) {
+            if (_size.load(memory_order_relaxed) >= _maxSize)
+                throw std::length_error(string("void "
+                        "ConcurrentKmerMap::addSequenceFrequencies(const "
+                        "std::string& sequence, int numThreads): the table "
+                        "of ") + to_string(_numSlots) + " slots is full");
+            if (_keys[slot].compare_exchange_strong(current, key,
+                    memory_order_acq_rel)) {
+                _size++;
+                current = key;
+            }
+        }
+        if (current == key) {
+            _frequencies[slot].fetch_add(value, memory_order_relaxed);
+            return;
+        }
+        slot = (slot + 1) & (_numSlots - 1);
+    }
+}
+
+Profile ConcurrentKmerMap::toProfile() const {
+    if (_size > INT_MAX)
+        throw std::out_of_range(string("Profile ConcurrentKmerMap::"
+                "toProfile() const: ") + to_string(_size) + " kmers do not "
+                "fit in a Profile");
+
+    Profile profile(_size);
+    int pos = 0;
+    for (long long slot = 0; slot < _numSlots; slot++) {
+        unsigned long long key = _keys[slot];
+        if (key == 0)
+            continue;
+        profile.at(pos).setKmer(Kmer(_coder.decode(key - 1)));
+        profile.at(pos).setFrequency(_frequencies[slot] +
+                (_filter != nullptr ? 1 : 0));
+        pos++;
+    }
+
+    return profile;
+}
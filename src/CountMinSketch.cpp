@@ -0,0 +1,159 @@
+/*
+ * Metodología de la Programación: Kmer5
+ * Curso 2023/2024
+ */
+
+/**
+ * @file CountMinSketch.cpp
+ */
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <stdexcept>
+
+#include "CountMinSketch.h"
+
+using namespace std;
+
+/**
+ * Estimated number of bytes of a heavy hitter: its entries in the map and
+ * in the set, with the pointers of their nodes
+ */
+static const int HEAVY_HITTER_BYTES = 2 * (sizeof(unsigned long long) +
+        sizeof(long long)) + 5 * sizeof(void*);
+
+/**
+ * Returns the column of the counter of a kmer in a row of the sketch. Each
+ * row mixes the bits of the code with a different constant, so the hash
+ * functions of the rows are independent
+ * @param code The code of a kmer. Input parameter
+ * @param row The row. Input parameter
+ * @param width The number of counters of each row. Input parameter
+ * @return The column of the kmer in @p row
+ */
+static inline int Column(unsigned long long code, int row, int width) {
+    code += (row + 1) * 0x9e3779b97f4a7c15ULL;
+    code ^= code >> 33;
+    code *= 0xff51afd7ed558ccdULL;
+    code ^= code >> 33;
+    code *= 0xc4ceb9fe1a85ec53ULL;
+    code ^= code >> 33;
+    return code % width;
+}
+
+CountMinSketch::CountMinSketch(int k, const std::string& validNucleotides,
+        int numHeavyHitters, int width, int depth, bool canonical,
+        bool onlyValidKmers): _coder(k, validNucleotides, canonical,
+        onlyValidKmers) {
+    if (numHeavyHitters <= 0 || width <= 0 || depth <= 0 ||
+            depth > MAX_DEPTH || width > INT_MAX / depth)
+        throw std::invalid_argument(string("CountMinSketch::CountMinSketch("
+                "int k, const std::string& validNucleotides, int "
+                "numHeavyHitters, int width, int depth, bool canonical, bool "
+                "onlyValidKmers): the kmers of ") + to_string(k) +
+                " nucleotides of " + validNucleotides + " cannot be counted "
+                "in " + to_string(depth) + " rows of " + to_string(width) +
+                " counters with " + to_string(numHeavyHitters) +
+                " heavy hitters");
+
+    _width = width;
+    _depth = depth;
+    _counters.reset(width * depth, CounterTable::DEFAULT_CELL_BITS);
+    _numKmers = 0;
+    _numHeavyHitters = numHeavyHitters;
+}
+
+int CountMinSketch::getK() const {
+    return _coder.getK();
+}
+
+int CountMinSketch::getWidth() const {
+    return _width;
+}
+
+int CountMinSketch::getDepth() const {
+    return _depth;
+}
+
+long long CountMinSketch::getNumKmers() const {
+    return _numKmers;
+}
+
+long long CountMinSketch::getErrorBound() const {
+    return ceil(M_E / _width * _numKmers);
+}
+
+double CountMinSketch::getConfidence() const {
+    return 1.0 - exp(-_depth);
+}
+
+long long CountMinSketch::getMemory() const {
+    return _counters.getMemory() +
+            (long long) _numHeavyHitters * HEAVY_HITTER_BYTES;
+}
+
+void CountMinSketch::addSequenceFrequencies(const std::string& sequence) {
+    _coder.forEachCode(sequence.data(), sequence.length(),
+            [this](unsigned long long code, int count) {
+                increase(code, count);
+            });
+}
+
+void CountMinSketch::increase(unsigned long long code, long long value) {
+    int cells[MAX_DEPTH];
+    long long counts[MAX_DEPTH];
+    long long estimation = LLONG_MAX;
+    for (int row = 0; row < _depth; row++) {
+        cells[row] = row * _width + Column(code, row, _width);
+        counts[row] = _counters.get(cells[row]);
+        estimation = min(estimation, counts[row]);
+    }
+
+    // Conservative update: each counter is raised to the new estimation,
+    //    the counters above it are not changed
+    estimation += value;
+    for (int row = 0; row < _depth; row++) {
+        if (counts[row] < estimation)
+            _counters.add(cells[row], estimation - counts[row]);
+    }
+    _numKmers += value;
+
+    updateHeavyHitters(code, estimation);
+}
+
+void CountMinSketch::updateHeavyHitters(unsigned long long code,
+        long long estimation) {
+    unordered_map<unsigned long long, long long>::iterator heavy =
+            _heavyHitters.find(code);
+    if (heavy != _heavyHitters.end()) {
+        _ranking.erase(make_pair(heavy->second, code));
+        heavy->second = estimation;
+        _ranking.insert(make_pair(estimation, code));
+        return;
+    }
+
+    if ((int) _heavyHitters.size() == _numHeavyHitters) {
+        // The kmer replaces the heavy hitter with the smallest estimation
+        if (estimation <= _ranking.begin()->first)
+            return;
+        _heavyHitters.erase(_ranking.begin()->second);
+        _ranking.erase(_ranking.begin());
+    }
+    _heavyHitters[code] = estimation;
+    _ranking.insert(make_pair(estimation, code));
+}
+
+Profile CountMinSketch::toProfile() const {
+    Profile profile(_heavyHitters.size());
+    int pos = 0;
+    for (set<pair<long long, unsigned long long> >::const_iterator heavy =
+            _ranking.begin(); heavy != _ranking.end(); ++heavy) {
+        profile.at(pos).setKmer(Kmer(_coder.decode(heavy->second)));
+        profile.at(pos).setFrequency(heavy->first);
+        pos++;
+    }
+    profile.sort();
+
+    return profile;
+}
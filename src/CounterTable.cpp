@@ -0,0 +1,466 @@
+/*
+ * Metodología de la Programación: Kmer5
+ * Curso 2023/2024
+ */
+
+/**
+ * @file CounterTable.cpp
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+#include "CounterTable.h"
+
+using namespace std;
+
+const int CounterTable::DEFAULT_CELL_BITS;
+
+/**
+ * The overflow map of a CounterTable
+ */
+typedef unordered_map<int, long long> Overflow;
+
+/**
+ * Lock of the overflow maps of the counters shared by several threads. A
+ * cell is rarely promoted, so a single lock is enough
+ */
+static mutex OverflowMutex;
+
+/**
+ * Estimated number of bytes of an entry of an overflow map: its key, its
+ * value and the pointers of its node and its bucket
+ */
+static const int OVERFLOW_ENTRY_BYTES = sizeof(int) + sizeof(long long) +
+        2 * sizeof(void*);
+
+/**
+ * Asks the processor to bring a cell to the cache before it is written, if
+ * the compiler supports it
+ * @param cell A cell. Input parameter
+ */
+static inline void Prefetch(const void* cell) {
+#ifdef __GNUC__
+    __builtin_prefetch(cell, 1);
+#else
+    (void) cell;
+#endif
+}
+
+/**
+ * Adds a value to a cell, until its maximum value
+ * @param cell A cell. Input/Output parameter
+ * @param value The value to add, not negative. Input parameter
+ * @return The part of @p value that does not fit in the cell
+ */
+template <typename Cell>
+static inline long long AddCell(Cell* cell, long long value) {
+    long long room = numeric_limits<Cell>::max() - *cell;
+    if (value <= room) {
+        *cell += value;
+        return 0;
+    }
+    *cell = numeric_limits<Cell>::max();
+    return value - room;
+}
+
+/**
+ * Adds a value to a cell that other threads can modify at the same time,
+ * until its maximum value. The cell is updated with a relaxed atomic
+ * compare-and-swap: the threads only need that no addition is lost
+ * @param cell A cell. Input/Output parameter
+ * @param value The value to add, not negative. Input parameter
+ * @return The part of @p value that does not fit in the cell
+ */
+template <typename Cell>
+static inline long long AddSharedCell(Cell* cell, long long value) {
+    const Cell max = numeric_limits<Cell>::max();
+#ifdef __GNUC__
+    Cell current = __atomic_load_n(cell, __ATOMIC_RELAXED);
+    Cell next;
+    do {
+        next = value <= max - current ? current + value : max;
+    } while (!__atomic_compare_exchange_n(cell, &current, next, true,
+            __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+#else
+    atomic<Cell>* shared = reinterpret_cast<atomic<Cell>*>(cell);
+    Cell current = shared->load(memory_order_relaxed);
+    Cell next;
+    do {
+        next = value <= max - current ? current + value : max;
+    } while (!shared->compare_exchange_weak(current, next,
+            memory_order_relaxed));
+#endif
+    return value - (next - current);
+}
+
+/**
+ * Increases by 1 a counter of a table
+ * @param cells The cells of the table. Input/Output parameter
+ * @param position The position of the counter. Input parameter
+ * @param shared Whether other threads can increase the counters at the same
+ * time. Input parameter
+ * @param overflow The overflow map of the table. Input/Output parameter
+ */
+template <typename Cell>
+static inline void IncreaseCell(Cell cells[], int position, bool shared,
+        Overflow& overflow) {
+    if (!shared) {
+        if (cells[position] != numeric_limits<Cell>::max())
+            cells[position]++;
+        else
+            overflow[position]++;
+    }
+    else if (AddSharedCell(cells + position, 1) > 0) {
+        lock_guard<mutex> lock(OverflowMutex);
+        overflow[position]++;
+    }
+}
+
+/**
+ * Increases by 1 the given counters of a table, prefetching the cell of the
+ * counter @p prefetchDistance positions ahead before each increment, so the
+ * cache misses of a large table overlap
+ * @param cells The cells of the table. Input/Output parameter
+ * @param positions The positions of the counters. Input parameter
+ * @param numPositions The number of positions. Input parameter
+ * @param prefetchDistance The prefetch distance, or 0. Input parameter
+ * @param shared Whether other threads can increase the counters at the same
+ * time. Input parameter
+ * @param overflow The overflow map of the table. Input/Output parameter
+ */
+template <typename Cell>
+static void IncreaseCells(Cell cells[], const int positions[],
+        int numPositions, int prefetchDistance, bool shared,
+        Overflow& overflow) {
+    int i = 0;
+    if (prefetchDistance > 0) {
+        for (; i < numPositions && i < prefetchDistance; i++) {
+            Prefetch(cells + positions[i]);
+        }
+        for (i = 0; i + prefetchDistance < numPositions; i++) {
+            Prefetch(cells + positions[i + prefetchDistance]);
+            IncreaseCell(cells, positions[i], shared, overflow);
+        }
+    }
+    for (; i < numPositions; i++) {
+        IncreaseCell(cells, positions[i], shared, overflow);
+    }
+}
+
+/**
+ * Returns the number of cells that are not 0
+ * @param cells The cells. Input parameter
+ * @param numCells The number of cells. Input parameter
+ * @return The number of cells greater than 0
+ */
+template <typename Cell>
+static int CountNonZero(const Cell cells[], int numCells) {
+    int count = 0;
+    for (int i = 0; i < numCells; i++) {
+        count += cells[i] != 0;
+    }
+
+    return count;
+}
+
+/**
+ * Calls a function with each counter of a table that is not 0
+ * @param cells The cells of the table. Input parameter
+ * @param numCells The number of cells. Input parameter
+ * @param overflow The overflow map of the table. Input parameter
+ * @param visit The function. Input parameter
+ */
+template <typename Cell>
+static void VisitNonZero(const Cell cells[], int numCells,
+        const Overflow& overflow,
+        const function<void(int, long long)>& visit) {
+    for (int i = 0; i < numCells; i++) {
+        if (cells[i] == 0)
+            continue;
+        long long value = cells[i];
+        if (cells[i] == numeric_limits<Cell>::max()) {
+            Overflow::const_iterator entry = overflow.find(i);
+            if (entry != overflow.end())
+                value += entry->second;
+        }
+        visit(i, value);
+    }
+}
+
+/**
+ * Adds to the cells of a table the ones of another table with the same
+ * size of cells. The parts of the sums that do not fit in the cells are
+ * added to the overflow map
+ * @param cells The cells of the table. Input/Output parameter
+ * @param others The cells of the other table. Input parameter
+ * @param numCells The number of cells. Input parameter
+ * @param overflow The overflow map of the table. Input/Output parameter
+ * @param maxOverflow The maximum value of an entry of the overflow map.
+ * Input parameter
+ * @return The position of the first cell whose overflow would exceed
+ * @p maxOverflow (and which is not added), or -1
+ */
+template <typename Cell>
+static int AddCells(Cell cells[], const Cell others[], int numCells,
+        Overflow& overflow, long long maxOverflow) {
+    for (int i = 0; i < numCells; i++) {
+        long long rest = AddCell(cells + i, others[i]);
+        if (rest > 0) {
+            long long& extra = overflow[i];
+            if (rest > maxOverflow - extra)
+                return i;
+            extra += rest;
+        }
+    }
+
+    return -1;
+}
+
+CounterTable::CounterTable(int numCells, int cellBits) {
+    if (numCells < 0 || (cellBits != 8 && cellBits != 16 && cellBits != 32))
+        throw std::invalid_argument(string("CounterTable::CounterTable(int "
+                "numCells, int cellBits): invalid table of ") +
+                to_string(numCells) + " cells of " + to_string(cellBits) +
+                " bits");
+    _numCells = numCells;
+    _cellBits = cellBits;
+    allocate();
+}
+
+void CounterTable::reset(int numCells, int cellBits) {
+    if (numCells < 0 || (cellBits != 8 && cellBits != 16 && cellBits != 32))
+        throw std::invalid_argument(string("void CounterTable::reset(int "
+                "numCells, int cellBits): invalid table of ") +
+                to_string(numCells) + " cells of " + to_string(cellBits) +
+                " bits");
+    delete[] _cells;
+    _numCells = numCells;
+    _cellBits = cellBits;
+    _overflow.clear();
+    allocate();
+}
+
+CounterTable::CounterTable(const CounterTable& orig):
+        _overflow(orig._overflow) {
+    _numCells = orig._numCells;
+    _cellBits = orig._cellBits;
+    allocate();
+    copy(orig._cells, orig._cells + (size_t) _numCells * (_cellBits / 8),
+            _cells);
+}
+
+CounterTable::~CounterTable() {
+    delete[] _cells;
+}
+
+CounterTable& CounterTable::operator=(const CounterTable& orig) {
+    if (this != &orig) {
+        delete[] _cells;
+        _numCells = orig._numCells;
+        _cellBits = orig._cellBits;
+        _overflow = orig._overflow;
+        allocate();
+        copy(orig._cells, orig._cells + (size_t) _numCells * (_cellBits / 8),
+                _cells);
+    }
+
+    return *this;
+}
+
+int CounterTable::getNumCells() const {
+    return _numCells;
+}
+
+int CounterTable::getCellBits() const {
+    return _cellBits;
+}
+
+void CounterTable::setCellBits(int cellBits) {
+    if (cellBits != 8 && cellBits != 16 && cellBits != 32)
+        throw std::invalid_argument(string("void CounterTable::setCellBits("
+                "int cellBits): invalid number of bits ") + 
+                to_string(cellBits));
+    if (cellBits == _cellBits)
+        return;
+
+    // The counters are added to a new table, which is exchanged with this one
+    CounterTable table(_numCells, cellBits);
+    forEachNonZero([&](int cell, long long value) {
+        table.add(cell, value);
+    });
+    std::swap(_cells, table._cells);
+    std::swap(_cellBits, table._cellBits);
+    _overflow.swap(table._overflow);
+}
+
+int CounterTable::getNumOverflows() const {
+    return _overflow.size();
+}
+
+long long CounterTable::getMemory() const {
+    return (long long) _numCells * (_cellBits / 8) +
+            (long long) _overflow.size() * OVERFLOW_ENTRY_BYTES;
+}
+
+long long CounterTable::get(int cell) const {
+    long long value;
+    if (_cellBits == 8)
+        value = _cells[cell];
+    else if (_cellBits == 16)
+        value = reinterpret_cast<const uint16_t*>(_cells)[cell];
+    else
+        value = reinterpret_cast<const uint32_t*>(_cells)[cell];
+
+    if (value == getMaxCell()) {
+        Overflow::const_iterator entry = _overflow.find(cell);
+        if (entry != _overflow.end())
+            value += entry->second;
+    }
+
+    return value;
+}
+
+int CounterTable::getNumNonZero() const {
+    if (_cellBits == 8)
+        return CountNonZero(_cells, _numCells);
+    else if (_cellBits == 16)
+        return CountNonZero(reinterpret_cast<const uint16_t*>(_cells),
+                _numCells);
+    else
+        return CountNonZero(reinterpret_cast<const uint32_t*>(_cells),
+                _numCells);
+}
+
+void CounterTable::forEachNonZero(
+        const std::function<void(int, long long)>& visit) const {
+    if (_cellBits == 8)
+        VisitNonZero(_cells, _numCells, _overflow, visit);
+    else if (_cellBits == 16)
+        VisitNonZero(reinterpret_cast<const uint16_t*>(_cells), _numCells,
+                _overflow, visit);
+    else
+        VisitNonZero(reinterpret_cast<const uint32_t*>(_cells), _numCells,
+                _overflow, visit);
+}
+
+void CounterTable::add(int cell, long long value, bool shared) {
+    if (value < 0)
+        throw std::out_of_range(string("void CounterTable::add(int cell, "
+                "long long value, bool shared): the value ") +
+                to_string(value) + " is negative");
+
+    long long rest;
+    if (_cellBits == 8) {
+        rest = shared ? AddSharedCell(_cells + cell, value) :
+                AddCell(_cells + cell, value);
+    }
+    else if (_cellBits == 16) {
+        uint16_t* cells = reinterpret_cast<uint16_t*>(_cells);
+        rest = shared ? AddSharedCell(cells + cell, value) :
+                AddCell(cells + cell, value);
+    }
+    else {
+        uint32_t* cells = reinterpret_cast<uint32_t*>(_cells);
+        rest = shared ? AddSharedCell(cells + cell, value) :
+                AddCell(cells + cell, value);
+    }
+    if (rest == 0)
+        return;
+
+    // The cell is saturated: the rest goes to the overflow map
+    unique_lock<mutex> lock(OverflowMutex, defer_lock);
+    if (shared)
+        lock.lock();
+    long long& extra = _overflow[cell];
+    if (rest > LLONG_MAX - getMaxCell() - extra)
+        throw std::out_of_range(string("void CounterTable::add(int cell, "
+                "long long value, bool shared): the counter ") +
+                to_string(cell) + " exceeds " + to_string(LLONG_MAX));
+    extra += rest;
+}
+
+void CounterTable::increase(const int cells[], int numCells,
+        int prefetchDistance, bool shared) {
+    if (_cellBits == 8) {
+        IncreaseCells(_cells, cells, numCells, prefetchDistance, shared,
+                _overflow);
+    }
+    else if (_cellBits == 16) {
+        IncreaseCells(reinterpret_cast<uint16_t*>(_cells), cells, numCells,
+                prefetchDistance, shared, _overflow);
+    }
+    else {
+        IncreaseCells(reinterpret_cast<uint32_t*>(_cells), cells, numCells,
+                prefetchDistance, shared, _overflow);
+    }
+}
+
+void CounterTable::clear() {
+    fill(_cells, _cells + (size_t) _numCells * (_cellBits / 8), 0);
+    _overflow.clear();
+}
+
+CounterTable& CounterTable::operator+=(const CounterTable& table) {
+    if (_numCells != table._numCells)
+        throw std::invalid_argument(string("CounterTable& "
+                "CounterTable::operator+=(const CounterTable& table): the "
+                "tables have ") + to_string(_numCells) + " and " +
+                to_string(table._numCells) + " counters");
+
+    if (_cellBits != table._cellBits) {
+        table.forEachNonZero([&](int cell, long long value) {
+            add(cell, value);
+        });
+        return *this;
+    }
+
+    // The same size of cells: the cells are added directly, and then the
+    //    overflows of the other table, whose cells are saturated, so the
+    //    sums of those cells are saturated too
+    long long maxOverflow = LLONG_MAX - getMaxCell();
+    int exceeded;
+    if (_cellBits == 8) {
+        exceeded = AddCells(_cells, table._cells, _numCells, _overflow,
+                maxOverflow);
+    }
+    else if (_cellBits == 16) {
+        exceeded = AddCells(reinterpret_cast<uint16_t*>(_cells),
+                reinterpret_cast<const uint16_t*>(table._cells), _numCells,
+                _overflow, maxOverflow);
+    }
+    else {
+        exceeded = AddCells(reinterpret_cast<uint32_t*>(_cells),
+                reinterpret_cast<const uint32_t*>(table._cells), _numCells,
+                _overflow, maxOverflow);
+    }
+    for (Overflow::const_iterator entry = table._overflow.begin();
+            exceeded < 0 && entry != table._overflow.end(); ++entry) {
+        long long& extra = _overflow[entry->first];
+        if (entry->second > maxOverflow - extra)
+            exceeded = entry->first;
+        else
+            extra += entry->second;
+    }
+    if (exceeded >= 0)
+        throw std::out_of_range(string("CounterTable& "
+                "CounterTable::operator+=(const CounterTable& table): the "
+                "counter ") + to_string(exceeded) + " exceeds " +
+                to_string(LLONG_MAX));
+
+    return *this;
+}
+
+long long CounterTable::getMaxCell() const {
+    return (1LL << _cellBits) - 1;
+}
+
+void CounterTable::allocate() {
+    _cells = new unsigned char[(size_t) _numCells * (_cellBits / 8)]();
+}
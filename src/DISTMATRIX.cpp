@@ -0,0 +1,378 @@
+/*
+ * Metodología de la Programación: Kmer5
+ * Curso 2023/2024
+ */
+
+/**
+ * @file DISTMATRIX.cpp
+ */
+
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "KmerCounter.h"
+#include "ProfileDatabase.h"
+#include "RankVector.h"
+
+using namespace std;
+
+/**
+ * Shows help about the use of this program in the given output stream
+ * @param outputStream The output stream where the help will be shown (for example,
+ * cout, cerr, etc)
+ */
+void showEnglishHelp(ostream& outputStream) {
+    outputStream << "ERROR in DISTMATRIX parameters" << endl;
+    outputStream << "Run with the following parameters:" << endl;
+    outputStream << "DISTMATRIX [-b] [-j numThreads] [-t tileSize] [-o outputFilename] [-d database.db] [-l listFilename] [<profile1.prf> <profile2.prf> .... ]" << endl;
+    outputStream << endl;
+    outputStream << "Parameters:" << endl;
+    outputStream << "-b: the matrix is saved in binary format (PHYLIP text format by default)" << endl;
+    outputStream << "-j numThreads: number of threads used to calculate the distances (number of "
+                 << "hardware threads by default)" << endl;
+    outputStream << "-t tileSize: number of profiles in the side of a tile of the matrix (64 by default)" << endl;
+    outputStream << "-o outputFilename: name of the output matrix file (matrix.phy by default)" << endl;
+    outputStream << "-d database.db: reference database built with BUILDDB. All its profiles are "
+                 << "included after the given profile files" << endl;
+    outputStream << "-l listFilename: name of a text file with the names of the profile files, one per line" << endl;
+    outputStream << "<profile1.prf> <profile2.prf> ....: names of the profile files" << endl;
+    outputStream << endl;
+    outputStream << "This program saves the matrix of the distances between every pair of profiles. "
+                 << "At least two profiles should be given" << endl;
+    outputStream << endl;
+}
+
+/**
+ * Calculates the distances of a tile of the matrix: the ones from the
+ * profiles in the rows [firstRow, lastRow) to the profiles in the columns
+ * [firstColumn, lastColumn).
+ * @param vectors The complete RankVectors of the profiles. Input parameter
+ * @param numProfiles The number of profiles. Input parameter
+ * @param firstRow The first row of the tile. Input parameter
+ * @param lastRow The row after the last one of the tile. Input parameter
+ * @param firstColumn The first column of the tile. Input parameter
+ * @param lastColumn The column after the last one of the tile. Input parameter
+ * @param block The distances of the rows [firstRow, lastRow), one row after
+ * another. Output parameter
+ */
+void CalculateTile(const RankVector vectors[], int numProfiles, int firstRow,
+        int lastRow, int firstColumn, int lastColumn, double block[]) {
+    for (int row = firstRow; row < lastRow; row++) {
+        double* distances = block + (long long)(row - firstRow) * numProfiles;
+        for (int column = firstColumn; column < lastColumn; column++) {
+            distances[column] = vectors[row].getProfileDistance(
+                    vectors[column]);
+        }
+    }
+}
+
+/**
+ * Writes a name in a line of a PHYLIP matrix. The spaces are replaced by
+ * underscores, since the name cannot contain them.
+ * @param outputStream The output stream. Input/Output parameter
+ * @param name The name. Input parameter
+ */
+void WritePhylipName(ostream& outputStream, const string& name) {
+    for (size_t i = 0; i < name.size(); i++) {
+        outputStream << (name[i] == ' ' || name[i] == '\t' ? '_' : name[i]);
+    }
+}
+
+/**
+ * This program calculates the distance of Profile::getDistance() from every
+ * profile to every other one, that is, the complete (not symmetric) matrix
+ * with the distance from the profile of each row to the profile of each
+ * column. The profiles can be given in the command line, in a text file
+ * with a name per line (option -l) and in a database built with BUILDDB
+ * (option -d).
+ *
+ * The profiles are loaded only once: each one is converted into a complete
+ * RankVector (with a depth equal to the number of kmers of the profile),
+ * which allows to calculate each distance by merging two sorted lists
+ * (see RankVector::getProfileDistance()) instead of searching each kmer of
+ * a profile in the other one. All the profiles should have been learned
+ * with the same sampling or spaced seed (see LEARN -h and -G), or with all
+ * the contiguous kmers.
+ *
+ * The matrix is calculated by blocks of tileSize rows. Each block is divided
+ * in tiles of tileSize columns, which are distributed among the threads, so
+ * the RankVectors of a tile are reused while they are in the cache. When
+ * all the tiles of a block have been calculated, its rows are written in the
+ * output file, so only a block of the matrix is kept in memory.
+ *
+ * The output file is a square matrix in PHYLIP format: the number of
+ * profiles in the first line, followed by a line for each profile with its
+ * identifier (with the spaces replaced by underscores) and its distances.
+ * With the option -b, the output file is binary: the magic string
+ * MP-KMER-DIST-1.0 followed by a '\n', the number of profiles (a 32 bits
+ * int), the identifiers of the profiles (each one followed by a '\n') and
+ * the distances (64 bits doubles) in row-major order.
+ *
+ * Running sintax:
+ * > DISTMATRIX [-b] [-j numThreads] [-t tileSize] [-o outputFilename] [-d database.db] [-l listFilename] [<profile1.prf> <profile2.prf> ....]
+ *
+ * Running example:
+ * > DISTMATRIX -o /tmp/genomes.phy ../Genomes/human_chr9_s10000_l500000.prf ../Genomes/worm1.prf ../Genomes/mouse_chr6_s3050050_l500000.prf
+ * Distance matrix /tmp/genomes.phy saved with 3 profiles
+ *
+ * @param argc The number of command line parameters
+ * @param argv The vector of command line parameters (cstrings)
+ * @return 0 If there is no error; a value > 0 if error
+ */
+int main(int argc, char *argv[]) {
+    // Process the main() arguments
+    if (argc < 2) {
+        showEnglishHelp(cerr);
+        return 1;
+    }
+
+    bool b = false;
+    int j = thread::hardware_concurrency();
+    int t = 64;
+    string o = "matrix.phy";
+    string d = "";
+    string l = "";
+
+    bool sigo = true;
+    int i = 1;
+    while (sigo && i < argc) {
+        if (string(argv[i]).at(0) == '-') {
+            if (string(argv[i]) == "-b") {
+                b = true;
+                i++;
+            }
+            else if (i + 1 >= argc) {
+                showEnglishHelp(cerr);
+                return 1;
+            }
+            else if (string(argv[i]) == "-j") {
+                j = stoi(argv[i+1]);
+                i += 2;
+            }
+            else if (string(argv[i]) == "-t") {
+                t = stoi(argv[i+1]);
+                i += 2;
+            }
+            else if (string(argv[i]) == "-o") {
+                o = argv[i+1];
+                i += 2;
+            }
+            else if (string(argv[i]) == "-d") {
+                d = argv[i+1];
+                i += 2;
+            }
+            else if (string(argv[i]) == "-l") {
+                l = argv[i+1];
+                i += 2;
+            }
+            else {
+                showEnglishHelp(cerr);
+                return 1;
+            }
+        }
+        else {
+            sigo = false;
+        }
+    }
+    if (j <= 0)
+        j = 1;
+
+    // Collect the names of the profile files
+    int num_list = 0;
+    string name;
+    ifstream list;
+    if (l != "") {
+        list.open(l.c_str());
+        if (!list) {
+            cerr << "The list file " << l << " cannot be opened" << endl;
+            return 1;
+        }
+        while (getline(list, name)) {
+            if (name != "")
+                num_list++;
+        }
+        list.clear();
+        list.seekg(0);
+    }
+
+    ProfileDatabase database;
+    int num_db = 0;
+    try {
+        if (d != "") {
+            database.open(d.c_str());
+            num_db = database.getSize();
+        }
+    }
+    catch (exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    int num_files = argc - i + num_list;
+    int num_profiles = num_files + num_db;
+    if (num_profiles < 2 || t <= 0) {
+        showEnglishHelp(cerr);
+        return 1;
+    }
+
+    string* profileFiles = new string[num_files];
+    for (int f = 0; f < argc - i; f++) {
+        profileFiles[f] = argv[i + f];
+    }
+    int pos = argc - i;
+    while (pos < num_files && getline(list, name)) {
+        if (name != "") {
+            profileFiles[pos] = name;
+            pos++;
+        }
+    }
+
+    // Load each profile once and keep only its identifier and its complete
+    //    RankVector. The profile files are loaded in parallel; the database
+    //    is read sequentially, since it has a single input stream
+    string* ids = new string[num_profiles];
+    RankVector* vectors = new RankVector[num_profiles];
+    vector<string> parameters(num_profiles);
+    vector<string> errors(j);
+    atomic<int> next(0);
+    vector<thread> workers;
+    for (int w = 0; w < j; w++) {
+        workers.push_back(thread([&, w]() {
+            try {
+                for (int p = next++; p < num_files; p = next++) {
+                    Profile profile;
+                    profile.load(profileFiles[p].c_str());
+                    ids[p] = profile.getProfileId();
+                    parameters[p] = profile.getParameters();
+                    vectors[p] = RankVector(max(profile.getSize(), 1));
+                    vectors[p].build(profile);
+                }
+            }
+            catch (exception& e) {
+                errors[w] = e.what();
+            }
+        }));
+    }
+    for (int w = 0; w < j; w++) {
+        workers[w].join();
+    }
+    workers.clear();
+
+    try {
+        for (int p = 0; p < num_db; p++) {
+            Profile profile = database.getProfile(p);
+            ids[num_files + p] = profile.getProfileId();
+            vectors[num_files + p] = RankVector(max(profile.getSize(), 1));
+            vectors[num_files + p].build(profile);
+        }
+    }
+    catch (exception& e) {
+        errors[0] = e.what();
+    }
+    database.close();
+
+    for (int p = 0; p < num_profiles; p++) {
+        if (vectors[p].getProfileSize() == 0 && errors[0] == "")
+            errors[0] = string("The profile ") + (p < num_files ?
+                    profileFiles[p] : d + "[" + to_string(p - num_files) + "]")
+                    + " is empty";
+        // The sampled or spaced profiles are only compared with the ones
+        //    learned in the same way (see LEARN -h and -G)
+        if (parameters[p] != parameters[0] && errors[0] == "")
+            errors[0] = string("The profile ") + (p < num_files ?
+                    profileFiles[p] : d + "[" + to_string(p - num_files) + "]")
+                    + " has not been learned with the same parameters as " +
+                    (num_files > 0 ? profileFiles[0] : d + "[0]");
+    }
+    for (int w = 0; w < j; w++) {
+        if (errors[w] != "") {
+            cerr << errors[w] << endl;
+            delete[] vectors;
+            delete[] ids;
+            delete[] profileFiles;
+            return 1;
+        }
+    }
+
+    // Write the header of the matrix
+    ofstream output;
+    output.open(o.c_str(), b ? ios::out | ios::binary : ios::out);
+    if (!output) {
+        cerr << "The output file " << o << " cannot be opened" << endl;
+        delete[] vectors;
+        delete[] ids;
+        delete[] profileFiles;
+        return 1;
+    }
+
+    if (b) {
+        output << "MP-KMER-DIST-1.0" << '\n';
+        output.write(reinterpret_cast<const char*>(&num_profiles),
+                sizeof(num_profiles));
+        for (int p = 0; p < num_profiles; p++) {
+            output << ids[p] << '\n';
+        }
+    }
+    else
+        output << num_profiles << '\n';
+
+    // Calculate the matrix by blocks of t rows. The tiles of a block are
+    //    shared among the threads, and the block is written when all of them
+    //    have been calculated
+    int num_tiles = (num_profiles + t - 1) / t;
+    double* block = new double[(long long)t * num_profiles];
+    for (int firstRow = 0; firstRow < num_profiles && output; firstRow += t) {
+        int lastRow = min(firstRow + t, num_profiles);
+
+        next = 0;
+        for (int w = 0; w < j; w++) {
+            workers.push_back(thread([&]() {
+                for (int tile = next++; tile < num_tiles; tile = next++) {
+                    CalculateTile(vectors, num_profiles, firstRow, lastRow,
+                            tile * t, min((tile + 1) * t, num_profiles),
+                            block);
+                }
+            }));
+        }
+        for (int w = 0; w < j; w++) {
+            workers[w].join();
+        }
+        workers.clear();
+
+        for (int row = firstRow; row < lastRow; row++) {
+            const double* distances = block +
+                    (long long)(row - firstRow) * num_profiles;
+            if (b)
+                output.write(reinterpret_cast<const char*>(distances),
+                        num_profiles * sizeof(double));
+            else {
+                WritePhylipName(output, ids[row]);
+                for (int column = 0; column < num_profiles; column++) {
+                    output << ' ' << distances[column];
+                }
+                output << '\n';
+            }
+        }
+    }
+
+    bool ok = (bool)output;
+    output.close();
+
+    delete[] block;
+    delete[] vectors;
+    delete[] ids;
+    delete[] profileFiles;
+
+    if (!ok) {
+        cerr << "An error ocurred while writing the output file " << o << endl;
+        return 1;
+    }
+
+    cout << "Distance matrix " << o << " saved with " << num_profiles
+         << " profiles" << endl;
+
+    return 0;
+}
@@ -0,0 +1,440 @@
+/*
+ * Metodología de la Programación: Kmer5
+ * Curso 2023/2024
+ */
+
+/**
+ * @file DiskKmerCounter.cpp
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <climits>
+#include <cstdio>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "DiskKmerCounter.h"
+#include "KmerCounter.h"
+
+using namespace std;
+
+const long long DiskKmerCounter::DEFAULT_MEMORY_LIMIT;
+
+const long long DiskKmerCounter::MIN_MEMORY_LIMIT;
+
+const int DiskKmerCounter::MAX_BUCKETS;
+
+/**
+ * Number of characters of a DNA file that are read at once
+ */
+static const int READ_BLOCK = 1 << 20;
+
+/**
+ * Minimum and maximum number of codes of the buffer of a bucket file
+ */
+static const int MIN_BUFFER_CODES = 1 << 10;
+static const int MAX_BUFFER_CODES = 1 << 20;
+
+/**
+ * A kmer of a partial Profile: the code of the kmer with the positions of
+ * its nucleotides in the sorted set of valid nucleotides, so the codes have
+ * the order of the kmers, and its frequency
+ */
+struct PartialEntry {
+    unsigned long long key; ///< Code of the kmer
+    long long frequency; ///< Frequency of the kmer
+};
+
+/**
+ * Compares two kmers in the order of Profile::sort(): decreasing frequency
+ * and then increasing kmer
+ * @param a A kmer. Input parameter
+ * @param b A kmer. Input parameter
+ * @return true if @p a goes before @p b
+ */
+static bool Before(const PartialEntry& a, const PartialEntry& b) {
+    return a.frequency > b.frequency ||
+            (a.frequency == b.frequency && a.key < b.key);
+}
+
+/**
+ * Mixes the bits of the code of a kmer to select its bucket, so the buckets
+ * have similar sizes even if the kmers have long common prefixes
+ * @param code The code of a kmer. Input parameter
+ * @return The hash value of @p code
+ */
+static inline unsigned long long BucketHash(unsigned long long code) {
+    code ^= code >> 33;
+    code *= 0xff51afd7ed558ccdULL;
+    code ^= code >> 33;
+    return code;
+}
+
+DiskKmerCounter::DiskKmerCounter(int k, const std::string& validNucleotides,
+        bool canonical): _table(validNucleotides) {
+    _bits = 1;
+    while ((1 << _bits) < (int) validNucleotides.size()) {
+        _bits++;
+    }
+    if (k <= 0 || k * _bits > 64)
+        throw std::invalid_argument(string("DiskKmerCounter::DiskKmerCounter("
+                "int k, const std::string& validNucleotides, bool canonical): "
+                "the kmers of ") + to_string(k) + " nucleotides of " +
+                validNucleotides + " cannot be packed in 64 bits");
+
+    _k = k;
+    _validNucleotides = validNucleotides;
+    _canonical = canonical;
+    if (_canonical) {
+        string complementary =
+                KmerCounter::GetComplementaryNucleotides(validNucleotides);
+        for (size_t v = 0; v < validNucleotides.size(); v++) {
+            _complements[v] = validNucleotides.find(complementary[v]);
+        }
+    }
+    _sortedNucleotides = validNucleotides;
+    sort(_sortedNucleotides.begin(), _sortedNucleotides.end());
+    for (size_t v = 0; v < validNucleotides.size(); v++) {
+        _ranks[v] = _sortedNucleotides.find(validNucleotides[v]);
+    }
+
+    _directory = ".";
+    _memoryLimit = DEFAULT_MEMORY_LIMIT;
+    _diskLimit = 0;
+    _numThreads = 1;
+    _numBuckets = 0;
+    _diskUsage = 0;
+
+    // Several counters can share the temporary directory
+    random_device device;
+    _prefix = "kmers" + to_string(device()) + "_" + to_string(device());
+}
+
+DiskKmerCounter::~DiskKmerCounter() {
+    removeFiles();
+}
+
+void DiskKmerCounter::setTemporaryDirectory(const std::string& directory) {
+    _directory = directory;
+}
+
+void DiskKmerCounter::setMemoryLimit(long long bytes) {
+    if (bytes < MIN_MEMORY_LIMIT)
+        throw std::invalid_argument(string("void "
+                "DiskKmerCounter::setMemoryLimit(long long bytes): the limit "
+                "should be at least ") + to_string(MIN_MEMORY_LIMIT) +
+                " bytes");
+    _memoryLimit = bytes;
+}
+
+void DiskKmerCounter::setDiskLimit(long long bytes) {
+    if (bytes < 0)
+        throw std::invalid_argument(string("void "
+                "DiskKmerCounter::setDiskLimit(long long bytes): negative "
+                "limit"));
+    _diskLimit = bytes;
+}
+
+void DiskKmerCounter::setNumThreads(int numThreads) {
+    if (numThreads <= 0)
+        throw std::invalid_argument(string("void "
+                "DiskKmerCounter::setNumThreads(int numThreads): the number "
+                "of threads should be positive"));
+    _numThreads = numThreads;
+}
+
+int DiskKmerCounter::getNumBuckets() const {
+    return _numBuckets;
+}
+
+long long DiskKmerCounter::getDiskUsage() const {
+    return _diskUsage;
+}
+
+Profile DiskKmerCounter::count(char* const fileNames[], int numFiles) {
+    removeFiles();
+
+    // Each input character gives at most a kmer. The codes of a bucket are
+    //    sorted in a vector of 8 bytes per kmer, and the distinct kmers
+    //    need up to 16 more bytes, so each one of the threads needs 24 bytes
+    //    per kmer of its bucket. The buffers of the first pass use half of
+    //    the memory
+    long long totalBytes = 0;
+    for (int i = 0; i < numFiles; i++) {
+        ifstream input(fileNames[i], ios::binary | ios::ate);
+        if (!input)
+            throw ios_base::failure(string("Profile DiskKmerCounter::count("
+                    "char* const fileNames[], int numFiles): the file ") +
+                    fileNames[i] + " cannot be opened");
+        totalBytes += input.tellg();
+    }
+    long long bucketKmers = _memoryLimit / 24 / _numThreads;
+    _numBuckets = min((long long) MAX_BUCKETS,
+            max(1LL, (totalBytes + bucketKmers - 1) / bucketKmers));
+    int capacity = min((long long) MAX_BUFFER_CODES,
+            max((long long) MIN_BUFFER_CODES,
+                _memoryLimit / 2 / 8 / _numBuckets));
+    _diskUsage = 0;
+
+    // First pass: spill the codes to the bucket files
+    try {
+        vector<ofstream> outputs(_numBuckets);
+        for (int b = 0; b < _numBuckets; b++) {
+            outputs[b].open(getFileName(b, false).c_str(), ios::binary);
+            if (!outputs[b])
+                throw ios_base::failure(string("Profile "
+                        "DiskKmerCounter::count(char* const fileNames[], int "
+                        "numFiles): the temporary file ") +
+                        getFileName(b, false) + " cannot be created");
+        }
+        vector<unsigned long long> buffers((long long) _numBuckets * capacity);
+        vector<int> sizes(_numBuckets, 0);
+        for (int i = 0; i < numFiles; i++) {
+            spill(fileNames[i], outputs.data(), buffers.data(), sizes.data(),
+                    capacity);
+        }
+        for (int b = 0; b < _numBuckets; b++) {
+            write(outputs[b], buffers.data() + (long long) b * capacity,
+                    sizes[b]);
+            outputs[b].close();
+        }
+    }
+    catch (...) {
+        removeFiles();
+        throw;
+    }
+
+    // Second pass: count each bucket in a thread
+    vector<long long> numKmers(_numBuckets, 0);
+    atomic<int> next(0);
+    mutex errorMutex;
+    string error = "";
+    vector<thread> workers;
+    for (int w = 0; w < _numThreads; w++) {
+        workers.push_back(thread([&]() {
+            for (int b = next++; b < _numBuckets; b = next++) {
+                try {
+                    numKmers[b] = countBucket(b);
+                }
+                catch (exception& e) {
+                    lock_guard<mutex> lock(errorMutex);
+                    error = e.what();
+                }
+            }
+        }));
+    }
+    for (int w = 0; w < _numThreads; w++) {
+        workers[w].join();
+    }
+    if (error != "") {
+        removeFiles();
+        throw ios_base::failure(error);
+    }
+
+    // Merge the partial Profiles, which are already sorted
+    long long total = 0;
+    for (int b = 0; b < _numBuckets; b++) {
+        total += numKmers[b];
+    }
+    if (total > INT_MAX) {
+        removeFiles();
+        throw out_of_range(string("Profile DiskKmerCounter::count(char* "
+                "const fileNames[], int numFiles): ") + to_string(total) +
+                " different kmers do not fit in a Profile");
+    }
+    Profile profile(total);
+    vector<ifstream> inputs(_numBuckets);
+    auto after = [](const pair<PartialEntry, int>& a,
+            const pair<PartialEntry, int>& b) {
+        return Before(b.first, a.first);
+    };
+    priority_queue<pair<PartialEntry, int>, vector<pair<PartialEntry, int> >,
+            decltype(after)> heads(after);
+    PartialEntry entry;
+    for (int b = 0; b < _numBuckets; b++) {
+        inputs[b].open(getFileName(b, true).c_str(), ios::binary);
+        if (inputs[b].read(reinterpret_cast<char*>(&entry), sizeof(entry)))
+            heads.push(make_pair(entry, b));
+    }
+    for (long long pos = 0; !heads.empty(); pos++) {
+        pair<PartialEntry, int> head = heads.top();
+        heads.pop();
+        profile.at(pos).setKmer(Kmer(getKmer(head.first.key)));
+        profile.at(pos).setFrequency(head.first.frequency);
+        int b = head.second;
+        if (inputs[b].read(reinterpret_cast<char*>(&entry), sizeof(entry)))
+            heads.push(make_pair(entry, b));
+    }
+    for (int b = 0; b < _numBuckets; b++) {
+        inputs[b].close();
+    }
+    removeFiles();
+
+    return profile;
+}
+
+std::string DiskKmerCounter::getFileName(int bucket, bool partial) const {
+    return _directory + "/" + _prefix + "_" + to_string(bucket) +
+            (partial ? ".prf.tmp" : ".kmers.tmp");
+}
+
+void DiskKmerCounter::spill(const char* fileName, std::ofstream outputs[],
+        unsigned long long buffers[], int sizes[], int capacity) {
+    ifstream input(fileName, ios::binary);
+    if (!input)
+        throw ios_base::failure(string("Profile DiskKmerCounter::count("
+                "char* const fileNames[], int numFiles): the file ") +
+                fileName + " cannot be opened");
+
+    // The sequence is the first word of the file, as with operator>>. The
+    //    window of the kmer restarts after each invalid nucleotide, as in
+    //    a KmerCounter that counts only valid kmers
+    int numBits = _k * _bits;
+    unsigned long long mask = numBits == 64 ? ~0ULL : (1ULL << numBits) - 1;
+    int shift = numBits - _bits;
+    unsigned long long code = 0;
+    unsigned long long reverse = 0;
+    int run = 0;
+    vector<char> text(READ_BLOCK);
+    vector<unsigned char> values(READ_BLOCK);
+    bool started = false;
+    bool finished = false;
+    while (!finished) {
+        input.read(text.data(), READ_BLOCK);
+        int size = input.gcount();
+        if (size == 0)
+            break;
+        int begin = 0;
+        if (!started) {
+            while (begin < size && isspace((unsigned char) text[begin])) {
+                begin++;
+            }
+            started = begin < size;
+        }
+        int end = begin;
+        while (end < size && !isspace((unsigned char) text[end])) {
+            end++;
+        }
+        finished = end < size;
+
+        _table.translate(text.data() + begin, end - begin, values.data());
+        for (int i = 0; i < end - begin; i++) {
+            if (values[i] == 0) {
+                run = 0;
+                continue;
+            }
+            int value = values[i] - 1;
+            code = ((code << _bits) | value) & mask;
+            if (_canonical) {
+                reverse = (reverse >> _bits) |
+                        ((unsigned long long) _complements[value] << shift);
+            }
+            if (run < _k - 1) {
+                run++;
+                continue;
+            }
+
+            unsigned long long kmer = _canonical && reverse < code ?
+                    reverse : code;
+            int b = BucketHash(kmer) % _numBuckets;
+            unsigned long long* buffer = buffers + (long long) b * capacity;
+            buffer[sizes[b]++] = kmer;
+            if (sizes[b] == capacity) {
+                write(outputs[b], buffer, capacity);
+                sizes[b] = 0;
+            }
+        }
+    }
+}
+
+void DiskKmerCounter::write(std::ofstream& output,
+        const unsigned long long buffer[], int size) {
+    output.write(reinterpret_cast<const char*>(buffer),
+            size * sizeof(unsigned long long));
+    if (!output)
+        throw ios_base::failure(string("Profile DiskKmerCounter::count("
+                "char* const fileNames[], int numFiles): error writing a "
+                "temporary file in ") + _directory);
+    _diskUsage += size * sizeof(unsigned long long);
+    if (_diskLimit > 0 && _diskUsage > _diskLimit)
+        throw ios_base::failure(string("Profile DiskKmerCounter::count("
+                "char* const fileNames[], int numFiles): the temporary files "
+                "exceed the limit of ") + to_string(_diskLimit) + " bytes");
+}
+
+long long DiskKmerCounter::countBucket(int bucket) const {
+    string fileName = getFileName(bucket, false);
+    ifstream input(fileName.c_str(), ios::binary | ios::ate);
+    if (!input)
+        throw ios_base::failure(string("Profile DiskKmerCounter::count("
+                "char* const fileNames[], int numFiles): the temporary file ") +
+                fileName + " cannot be read");
+    long long numCodes = input.tellg() / (long long) sizeof(unsigned long long);
+    vector<unsigned long long> codes(numCodes);
+    input.seekg(0);
+    input.read(reinterpret_cast<char*>(codes.data()),
+            numCodes * sizeof(unsigned long long));
+    if (!input)
+        throw ios_base::failure(string("Profile DiskKmerCounter::count("
+                "char* const fileNames[], int numFiles): the temporary file ") +
+                fileName + " cannot be read");
+    input.close();
+    remove(fileName.c_str());
+
+    // The frequency of a kmer is the length of its run in the sorted codes
+    sort(codes.begin(), codes.end());
+    vector<PartialEntry> entries;
+    unsigned long long digitMask = (1ULL << _bits) - 1;
+    for (long long i = 0; i < numCodes; ) {
+        long long j = i + 1;
+        while (j < numCodes && codes[j] == codes[i]) {
+            j++;
+        }
+        PartialEntry entry;
+        entry.key = 0;
+        for (int n = _k - 1; n >= 0; n--) {
+            entry.key = (entry.key << _bits) |
+                    _ranks[(codes[i] >> (n * _bits)) & digitMask];
+        }
+        entry.frequency = j - i;
+        entries.push_back(entry);
+        i = j;
+    }
+    vector<unsigned long long>().swap(codes);
+    sort(entries.begin(), entries.end(), Before);
+
+    string partialName = getFileName(bucket, true);
+    ofstream output(partialName.c_str(), ios::binary);
+    output.write(reinterpret_cast<const char*>(entries.data()),
+            entries.size() * sizeof(PartialEntry));
+    if (!output)
+        throw ios_base::failure(string("Profile DiskKmerCounter::count("
+                "char* const fileNames[], int numFiles): error writing the "
+                "temporary file ") + partialName);
+
+    return entries.size();
+}
+
+std::string DiskKmerCounter::getKmer(unsigned long long key) const {
+    string kmer(_k, Kmer::MISSING_NUCLEOTIDE);
+    unsigned long long digitMask = (1ULL << _bits) - 1;
+    for (int i = _k - 1; i >= 0; i--) {
+        kmer[i] = _sortedNucleotides[key & digitMask];
+        key >>= _bits;
+    }
+
+    return kmer;
+}
+
+void DiskKmerCounter::removeFiles() {
+    for (int b = 0; b < _numBuckets; b++) {
+        remove(getFileName(b, false).c_str());
+        remove(getFileName(b, true).c_str());
+    }
+}
@@ -0,0 +1,120 @@
+/*
+ * Metodología de la Programación: Kmer5
+ * Curso 2023/2024
+ */
+
+/**
+ * @file FastaReader.cpp
+ */
+
+#include <cctype>
+
+#include "FastaReader.h"
+
+using namespace std;
+
+/**
+ * Appends the characters of a line that are not whitespace characters to a
+ * sequence
+ * @param line A line of a FASTA file. Input parameter
+ * @param sequence The sequence. Input/Output parameter
+ */
+static void AppendLine(const string& line, string& sequence) {
+    for (size_t i = 0; i < line.size(); i++) {
+        if (!isspace((unsigned char)line[i]))
+            sequence += line[i];
+    }
+}
+
+/**
+ * Returns the name of a record from its name line, without the '>' and the
+ * final whitespace characters
+ * @param line The name line of a record. Input parameter
+ * @return The name of the record
+ */
+static string GetName(const string& line) {
+    size_t end = line.size();
+    while (end > 1 && isspace((unsigned char)line[end - 1])) {
+        end--;
+    }
+
+    return line.substr(1, end - 1);
+}
+
+FastaReader::FastaReader(): _first(true) {}
+
+FastaReader::~FastaReader() {
+    close();
+}
+
+void FastaReader::open(const char fileName[]) {
+    close();
+    _input.open(fileName);
+
+    if (!_input) {
+        throw ios_base::failure(string("void FastaReader::open(const char "
+                "fileName[]): the given file cannot be opened\n"));
+    }
+
+    _fileName = fileName;
+    _line = "";
+    _first = true;
+}
+
+void FastaReader::close() {
+    if (_input.is_open())
+        _input.close();
+    _input.clear();
+}
+
+bool FastaReader::next(std::string& name, std::string& sequence) {
+    string line;
+    sequence.clear();
+
+    if (_line != "") {
+        name = GetName(_line);
+        _line = "";
+    }
+    else {
+        // Only the first record can be found without a name line
+        bool found = false;
+        while (!found && getline(_input, line)) {
+            if (line.find_first_not_of(" \t\r") == string::npos)
+                continue;
+            if (line[0] == '>')
+                name = GetName(line);
+            else if (_first) {
+                name = _fileName;
+                AppendLine(line, sequence);
+            }
+            found = line[0] == '>' || _first;
+        }
+        if (!found)
+            return false;
+    }
+    _first = false;
+
+    while (getline(_input, line)) {
+        if (!line.empty() && line[0] == '>') {
+            _line = line;
+            break;
+        }
+        AppendLine(line, sequence);
+    }
+
+    return true;
+}
+
+int FastaReader::next(std::string names[], std::string sequences[],
+        int maxRecords, long long maxNucleotides) {
+    int numRecords = 0;
+    long long numNucleotides = 0;
+
+    while (numRecords < maxRecords && numNucleotides < maxNucleotides &&
+            next(names[numRecords], sequences[numRecords])) {
+        numNucleotides += sequences[numRecords].size();
+        numRecords++;
+    }
+
+    return numRecords;
+}
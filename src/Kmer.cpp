@@ -11,6 +11,7 @@
  */
 
 #include "Kmer.h"
+#include "NucleotideTable.h"
 
 using namespace std;
 
@@ -85,11 +86,18 @@ void Kmer::toUpper() {
 }
 
 void Kmer::normalize(const std::string& validNucleotides) {
-    toUpper();
-    
-    for (int i = 0; i < getK(); i++) {
-        if (!IsValidNucleotide(_text.at(i), validNucleotides))
-            at(i) = MISSING_NUCLEOTIDE;
+    // Conversion to uppercase and check of each nucleotide in the same pass
+    for (size_t i = 0; i < _text.size(); i++) {
+        char nucleotide = std::toupper(_text[i]);
+        if (!IsValidNucleotide(nucleotide, validNucleotides))
+            nucleotide = MISSING_NUCLEOTIDE;
+        _text[i] = nucleotide;
+    }
+}
+
+void Kmer::normalize(const NucleotideTable& table) {
+    for (size_t i = 0; i < _text.size(); i++) {
+        _text[i] = table.getNucleotide(_text[i]);
     }
 }
 
@@ -0,0 +1,83 @@
+/*
+ * Metodología de la Programación: Kmer5
+ * Curso 2023/2024
+ */
+
+/**
+ * @file KmerCoder.cpp
+ */
+
+#include <stdexcept>
+
+#include "Kmer.h"
+#include "KmerCoder.h"
+#include "KmerCounter.h"
+
+using namespace std;
+
+const int KmerCoder::TRANSLATION_BLOCK;
+
+/**
+ * Returns the number of bits of a nucleotide in the code of a kmer
+ * @param numNucleotides The number of nucleotides of the codes (including
+ * the missing nucleotide, if it is counted). Input parameter
+ * @return The number of bits needed for the positions [0, numNucleotides)
+ */
+static int BitsPerNucleotide(int numNucleotides) {
+    int bits = 1;
+    while ((1 << bits) < numNucleotides) {
+        bits++;
+    }
+
+    return bits;
+}
+
+KmerCoder::KmerCoder(int k, const std::string& validNucleotides,
+        bool canonical, bool onlyValidKmers): _table(validNucleotides) {
+    if (!CanPack(k, validNucleotides, onlyValidKmers))
+        throw std::invalid_argument(string("KmerCoder::KmerCoder(int k, "
+                "const std::string& validNucleotides, bool canonical, bool "
+                "onlyValidKmers): the kmers of ") + to_string(k) +
+                " nucleotides of " + validNucleotides + " cannot be packed "
+                "in 64 bits");
+
+    _k = k;
+    _onlyValidKmers = onlyValidKmers;
+    _allNucleotides = validNucleotides;
+    if (!_onlyValidKmers)
+        _allNucleotides = Kmer::MISSING_NUCLEOTIDE + _allNucleotides;
+    _bits = BitsPerNucleotide(_allNucleotides.size());
+    _canonical = canonical;
+    if (_canonical) {
+        string complementary =
+                KmerCounter::GetComplementaryNucleotides(validNucleotides);
+        if (!_onlyValidKmers)
+            complementary = Kmer::MISSING_NUCLEOTIDE + complementary;
+        for (size_t v = 0; v < _allNucleotides.size(); v++) {
+            _complements[v] = _allNucleotides.find(complementary[v]);
+        }
+    }
+}
+
+int KmerCoder::getK() const {
+    return _k;
+}
+
+bool KmerCoder::CanPack(int k, const std::string& validNucleotides,
+        bool onlyValidKmers) {
+    // The codes need less than 64 bits, so the code plus 1 (the key of a
+    //    kmer in ConcurrentKmerMap) does not overflow
+    int numNucleotides = validNucleotides.size() + (onlyValidKmers ? 0 : 1);
+    return k > 0 && k * BitsPerNucleotide(numNucleotides) < 64;
+}
+
+std::string KmerCoder::decode(unsigned long long code) const {
+    unsigned long long digitMask = (1ULL << _bits) - 1;
+    string kmer(_k, Kmer::MISSING_NUCLEOTIDE);
+    for (int i = _k - 1; i >= 0; i--) {
+        kmer[i] = _allNucleotides[code & digitMask];
+        code >>= _bits;
+    }
+
+    return kmer;
+}
@@ -10,9 +10,21 @@
  * Created on 22 December 2023, 10:00
  */
 
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <exception>
 #include <fstream>
+#include <thread>
+#include <vector>
+
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
 
 #include "KmerCounter.h"
+#include "PartitionedCounters.h"
+#include "SequenceFilter.h"
 
 using namespace std;
 
@@ -26,39 +38,163 @@ using namespace std;
  */
 const char* const KmerCounter::DEFAULT_VALID_NUCLEOTIDES="ACGT";
 
-KmerCounter::KmerCounter(int k, const std::string& validNucleotides) {
+const int KmerCounter::DEFAULT_PREFETCH_DISTANCE;
+
+const int KmerCounter::MAX_PREFETCH_DISTANCE;
+
+const string KmerCounter::SEED = "seed";
+
+/**
+ * Number of nucleotides of a sequence that are translated at once to their
+ * positions in the set of nucleotides
+ */
+static const int TRANSLATION_BLOCK = 4096;
+
+/**
+ * Number of kmers of the matrix from which the counters are prefetched by
+ * default (a matrix of 1 MB)
+ */
+static const int PREFETCH_MIN_KMERS = 1 << 18;
+
+/**
+ * Number of kmers of each piece of a sequence counted by several threads
+ * (see KmerCounter::ForEachPiece())
+ */
+static const int PIECE_KMERS = 1 << 20;
+
+/**
+ * Number of bits of the codes of the nucleotides of a window of a spaced
+ * kmer that are converted at once to a position in the matrix (see
+ * KmerCounter::countSpacedKmers())
+ */
+static const int CONVERSION_BITS = 12;
+
+/**
+ * The runs of consecutive bits of a mask, which are moved together to 
+ * extract the bits of a code selected by the mask without the PEXT 
+ * instruction (see ExtractBits())
+ */
+struct BitRuns {
+    int numRuns; ///< Number of runs
+    int shifts[32]; ///< Right shift of the bits of each run
+    unsigned long long masks[32]; ///< Bits of each run, once shifted
+};
+
+/**
+ * Obtains the runs of consecutive bits of a mask
+ * @param mask A mask with at most 32 runs. Input parameter
+ * @param runs The runs of @p mask. Output parameter
+ */
+static void GetBitRuns(unsigned long long mask, BitRuns& runs) {
+    runs.numRuns = 0;
+    int extracted = 0; // Number of bits of the previous runs
+    for (int bit = 0; bit < 64; bit++) {
+        if ((mask >> bit & 1) == 0)
+            continue;
+        int length = 1;
+        while (bit + length < 64 && (mask >> (bit + length) & 1) != 0) {
+            length++;
+        }
+        unsigned long long ones = length == 64 ? ~0ULL : 
+                (1ULL << length) - 1;
+        runs.shifts[runs.numRuns] = bit - extracted;
+        runs.masks[runs.numRuns] = ones << extracted;
+        runs.numRuns++;
+        extracted += length;
+        bit += length;
+    }
+}
+
+/**
+ * Extracts the bits of a code selected by a mask and packs them in the 
+ * lowest bits, in the same order, as the PEXT instruction of BMI2, which is
+ * used if it is available
+ * @param code A code. Input parameter
+ * @param mask The mask. Input parameter
+ * @param runs The runs of @p mask (see GetBitRuns()). Input parameter
+ * @return The bits of @p code selected by @p mask
+ */
+static inline unsigned long long ExtractBits(unsigned long long code, 
+        unsigned long long mask, const BitRuns& runs) {
+#ifdef __BMI2__
+    (void) runs;
+    return _pext_u64(code, mask);
+#else
+    (void) mask;
+    unsigned long long bits = 0;
+    for (int r = 0; r < runs.numRuns; r++) {
+        bits |= (code >> runs.shifts[r]) & runs.masks[r];
+    }
+    return bits;
+#endif
+}
+
+/**
+ * Returns the reverse complement of a kmer
+ * @param kmer A string with nucleotides of @p nucleotides. Input parameter
+ * @param nucleotides A set of nucleotides. Input parameter
+ * @param complementaryNucleotides The complementary nucleotide of each 
+ * nucleotide of @p nucleotides. Input parameter
+ * @return The reverse complement of @p kmer
+ */
+static string ReverseComplement(const string& kmer, const string& nucleotides,
+        const string& complementaryNucleotides) {
+    string reverse(kmer.rbegin(), kmer.rend());
+    for (size_t i = 0; i < reverse.size(); i++) {
+        size_t pos = nucleotides.find(reverse[i]);
+        if (pos != string::npos)
+            reverse[i] = complementaryNucleotides[pos];
+    }
+    
+    return reverse;
+}
+
+KmerCounter::KmerCounter(int k, const std::string& validNucleotides,
+        bool canonical, bool onlyValidKmers, int cellBits): 
+        _table(validNucleotides) {
     _k = k;
     _validNucleotides = validNucleotides;
-    _allNucleotides = Kmer::MISSING_NUCLEOTIDE + validNucleotides;
-    _frequency = new int*[getNumRows()];
-    for (int i = 0; i < getNumRows(); i++) {
-        _frequency[i] = new int[getNumCols()];
+    _onlyValidKmers = onlyValidKmers;
+    _allNucleotides = validNucleotides;
+    if (!_onlyValidKmers)
+        _allNucleotides = Kmer::MISSING_NUCLEOTIDE + _allNucleotides;
+    _canonical = canonical;
+    if (_canonical) {
+        _complementaryNucleotides = 
+                GetComplementaryNucleotides(validNucleotides);
+        if (!_onlyValidKmers) {
+            _complementaryNucleotides = Kmer::MISSING_NUCLEOTIDE + 
+                    _complementaryNucleotides;
+        }
     }
-     
-    initFrequencies();
+    _frequency.reset(getNumRows() * getNumCols(), cellBits);
+    _prefetchDistance = getNumKmers() >= PREFETCH_MIN_KMERS ? 
+            DEFAULT_PREFETCH_DISTANCE : 0;
+    _partitioned = false;
+    _seed = "";
 }
 
-KmerCounter::KmerCounter(const KmerCounter& orig) {
+KmerCounter::KmerCounter(const KmerCounter& orig): 
+        _frequency(orig._frequency), _table(orig._table) {
     _k = orig._k;
     _validNucleotides = orig._validNucleotides;
+    _onlyValidKmers = orig._onlyValidKmers;
     _allNucleotides = orig._allNucleotides;
-    _frequency = new int*[orig.getNumRows()];
-    for (int i = 0; i < orig.getNumRows(); i++) {
-        _frequency[i] = new int [orig.getNumCols()];
-    }
-    
-    for (int i = 0; i < getNumRows(); i++) {
-        for (int j = 0; j < getNumCols(); j++) {
-            _frequency[i][j] = orig._frequency[i][j];
-        }
-    }
+    _canonical = orig._canonical;
+    _complementaryNucleotides = orig._complementaryNucleotides;
+    _prefetchDistance = orig._prefetchDistance;
+    _partitioned = orig._partitioned;
+    _seed = orig._seed;
 }
 
 KmerCounter::~KmerCounter() {
-    deallocate();
     _k = 0;
     _validNucleotides = DEFAULT_VALID_NUCLEOTIDES;
+    _onlyValidKmers = false;
     _allNucleotides = Kmer::MISSING_NUCLEOTIDE + _validNucleotides;
+    _canonical = false;
+    _complementaryNucleotides = "";
+    _seed = "";
 }
 
 int KmerCounter::getNumNucleotides() const {
@@ -74,16 +210,120 @@ int KmerCounter::getNumKmers() const {
 }
 
 int KmerCounter::getNumberActiveKmers() const{
-    int activeKmers = 0;
+    return _frequency.getNumNonZero();
+}
+
+bool KmerCounter::isCanonical() const {
+    return _canonical;
+}
+
+bool KmerCounter::countsOnlyValidKmers() const {
+    return _onlyValidKmers;
+}
+
+int KmerCounter::getPrefetchDistance() const {
+    return _prefetchDistance;
+}
+
+void KmerCounter::setPrefetchDistance(int prefetchDistance) {
+    if (prefetchDistance < 0 || prefetchDistance > MAX_PREFETCH_DISTANCE)
+        throw std::invalid_argument(string("void "
+                "KmerCounter::setPrefetchDistance(int prefetchDistance): ") +
+                "invalid distance " + to_string(prefetchDistance));
+    _prefetchDistance = prefetchDistance;
+}
+
+bool KmerCounter::isPartitioned() const {
+    return _partitioned;
+}
+
+void KmerCounter::setPartitioned(bool partitioned) {
+    _partitioned = partitioned;
+}
+
+int KmerCounter::getCellBits() const {
+    return _frequency.getCellBits();
+}
+
+void KmerCounter::setCellBits(int cellBits) {
+    if (cellBits != 8 && cellBits != 16 && cellBits != 32)
+        throw std::invalid_argument(string("void "
+                "KmerCounter::setCellBits(int cellBits): invalid number of "
+                "bits ") + to_string(cellBits));
+    _frequency.setCellBits(cellBits);
+}
+
+const std::string& KmerCounter::getSeed() const {
+    return _seed;
+}
+
+int KmerCounter::getSpan() const {
+    return _seed.empty() ? _k : _seed.length();
+}
+
+void KmerCounter::setSeed(const std::string& seed) {
+    int bits = 1;
+    while ((1 << bits) < (int) _allNucleotides.length()) {
+        bits++;
+    }
+    bool valid = seed.empty() || (seed.front() == '1' && seed.back() == '1' &&
+            seed.find_first_not_of("01") == string::npos &&
+            count(seed.begin(), seed.end(), '1') == _k &&
+            seed.length() * bits <= 64);
+    if (!valid)
+        throw std::invalid_argument(string("void KmerCounter::setSeed(const "
+                "std::string& seed): invalid seed ") + seed + " for k=" + 
+                to_string(_k) + " and the nucleotides " + _allNucleotides);
+    if (_canonical && !equal(seed.begin(), seed.end(), seed.rbegin()))
+        throw std::invalid_argument(string("void KmerCounter::setSeed(const "
+                "std::string& seed): the seed ") + seed + " is not "
+                "symmetric, so it cannot be used with canonical kmers");
     
-    for (int i = 0; i < getNumRows(); i++) {
-        for (int j = 0; j < getNumCols(); j++) {
-            if (_frequency[i][j] != 0)
-                activeKmers++;
-        }
+    _seed = seed;
+    initFrequencies();
+}
+
+long long KmerCounter::getMemory() const {
+    return _frequency.getMemory();
+}
+
+std::string KmerCounter::GetComplementaryNucleotides(
+        const std::string& validNucleotides) {
+    string complementary = validNucleotides;
+    
+    for (size_t i = 0; i < validNucleotides.size(); i++) {
+        char nucleotide = validNucleotides[i];
+        char pair = Kmer::MISSING_NUCLEOTIDE;
+        if (nucleotide == 'A')
+            pair = validNucleotides.find('T') != string::npos ? 'T' : 'U';
+        else if (nucleotide == 'T' || nucleotide == 'U')
+            pair = 'A';
+        else if (nucleotide == 'C')
+            pair = 'G';
+        else if (nucleotide == 'G')
+            pair = 'C';
+        
+        if (validNucleotides.find(pair) == string::npos)
+            throw std::invalid_argument(string("std::string "
+                    "KmerCounter::GetComplementaryNucleotides(const "
+                    "std::string& validNucleotides): the complementary "
+                    "nucleotide of ") + nucleotide + " is not in " + 
+                    validNucleotides);
+        complementary[i] = pair;
     }
     
-    return activeKmers;
+    // Each nucleotide should be the complementary of its complementary
+    for (size_t i = 0; i < validNucleotides.size(); i++) {
+        if (complementary[validNucleotides.find(complementary[i])] != 
+                validNucleotides[i])
+            throw std::invalid_argument(string("std::string "
+                    "KmerCounter::GetComplementaryNucleotides(const "
+                    "std::string& validNucleotides): ") + validNucleotides[i] +
+                    " and " + complementary[i] + " are not a complementary "
+                    "pair in " + validNucleotides);
+    }
+    
+    return complementary;
 }
 
 std::string KmerCounter::toString() const{
@@ -99,35 +339,41 @@ std::string KmerCounter::toString() const{
     return outputString;
 }
 
-void KmerCounter::increaseFrequency(const Kmer& kmer, int frequency) {
+void KmerCounter::increaseFrequency(const Kmer& kmer, long long frequency) {
     for (int i = 0; i < int(kmer.toString().length()); i++) {
         if (!IsValidNucleotide(kmer.toString().at(i), _allNucleotides))
             throw std::invalid_argument(string("void "
-                    "KmerCounter::increaseFrequency(const Kmer& kmer, int "
-                    "frequency = 1): the given kmer contains invalid "
+                    "KmerCounter::increaseFrequency(const Kmer& kmer, long "
+                    "long frequency = 1): the given kmer contains invalid "
                     "nucleotides"));
     }
     
     int row, column;
     getRowColumn(kmer, row, column);
-    _frequency[row][column] += frequency;
+    try {
+        _frequency.add(row * getNumCols() + column, frequency);
+    }
+    catch (std::out_of_range& e) {
+        throw std::out_of_range(string("void "
+                "KmerCounter::increaseFrequency(const Kmer& kmer, long long "
+                "frequency = 1): the frequency ") + to_string(frequency) + 
+                " cannot be added to the one of " + kmer.toString());
+    }
 }
 
 KmerCounter& KmerCounter::operator=(const KmerCounter& orig) {
     if (this != &orig) {
-        deallocate();
+        _frequency = orig._frequency;
         _k = orig._k;
         _validNucleotides = orig._validNucleotides;
+        _onlyValidKmers = orig._onlyValidKmers;
         _allNucleotides = orig._allNucleotides;
-        _frequency = new int*[orig.getNumRows()];
-        for (int i = 0; i < orig.getNumRows(); i++)
-            _frequency[i] = new int [orig.getNumCols()];
-    
-        for (int i = 0; i < getNumRows(); i++) {
-            for (int j = 0; j < getNumCols(); j++) {
-                _frequency[i][j] = orig._frequency[i][j];
-            }
-        }
+        _canonical = orig._canonical;
+        _complementaryNucleotides = orig._complementaryNucleotides;
+        _prefetchDistance = orig._prefetchDistance;
+        _partitioned = orig._partitioned;
+        _seed = orig._seed;
+        _table = orig._table;
     }
     
     return *this;
@@ -138,12 +384,21 @@ KmerCounter& KmerCounter::operator+=(const KmerCounter& kc) {
         throw std::invalid_argument(string("KmerCounter& "
                 "KmerCounter::operator+=(const KmerCounter& kc): the number "
                 "of nucleotides is different in each KmerCounter"));
+    if(_canonical != kc._canonical)
+        throw std::invalid_argument(string("KmerCounter& "
+                "KmerCounter::operator+=(const KmerCounter& kc): only one "
+                "KmerCounter counts canonical kmers"));
+    if(_onlyValidKmers != kc._onlyValidKmers)
+        throw std::invalid_argument(string("KmerCounter& "
+                "KmerCounter::operator+=(const KmerCounter& kc): only one "
+                "KmerCounter counts only the kmers without missing "
+                "nucleotides"));
+    if(_seed != kc._seed)
+        throw std::invalid_argument(string("KmerCounter& "
+                "KmerCounter::operator+=(const KmerCounter& kc): the seed "
+                "is different in each KmerCounter"));
     
-    for (int i = 0; i < getNumRows(); i++) {
-        for (int j = 0; j < getNumCols(); j++) {
-            _frequency[i][j] += kc._frequency[i][j];
-        }
-    }
+    _frequency += kc._frequency;
     
     return *this;
 }
@@ -153,20 +408,9 @@ void KmerCounter::calculateFrequencies(const char* fileName) {
     input.open(fileName);
     
     if (input) {
-        initFrequencies();
-        string kmer;
-        input >> kmer;
-        int kmer_l = kmer.length();
-        int nkmers;
-        
-        
-        nkmers = kmer_l - _k + 1;
-        for (int i = 0; i < nkmers; i++) {
-            string subkmer = kmer.substr(i,_k);
-            Kmer k(subkmer);
-            k.normalize(_validNucleotides);
-            increaseFrequency(k);
-        }
+        string sequence;
+        input >> sequence;
+        calculateSequenceFrequencies(sequence);
         
         input.close();
     }
@@ -176,25 +420,454 @@ void KmerCounter::calculateFrequencies(const char* fileName) {
                 "the given file cannot be opened\n"));
 }
 
-Profile KmerCounter::toProfile() const {
-    Profile p;
-    KmerFreq kf;
-    for (int i = 0; i < getNumRows(); i++) {
-        for (int j = 0; j < getNumCols(); j++) {
-            if (_frequency[i][j] > 0) {
-                Kmer k(getKmer(i,j));
-                kf.setFrequency(_frequency[i][j]);
-                kf.setKmer(k);
-                p += kf;
+std::string KmerCounter::ReadSequence(const char* fileName, 
+        const SequenceFilter& filter) {
+    ifstream input(fileName);
+    if (!input)
+        throw ios_base::failure(string("std::string "
+                "KmerCounter::ReadSequence(const char* fileName, const "
+                "SequenceFilter& filter): the file ") + fileName + 
+                " cannot be opened\n");
+    string sequence;
+    input >> sequence;
+    filter.filter(sequence);
+
+    return sequence;
+}
+
+void KmerCounter::calculateSequenceFrequencies(const std::string& sequence) {
+    initFrequencies();
+    addSequenceFrequencies(sequence);
+}
+
+void KmerCounter::addSequenceFrequencies(const std::string& sequence,
+        int numThreads) {
+    if ((int) sequence.length() - getSpan() + 1 <= 0)
+        return;
+    
+    if (numThreads > 1) {
+        // The pieces are counted in the same matrix
+        ForEachPiece(sequence.length(), getSpan(), numThreads, 
+                [&](int begin, int end) {
+                    countKmers(sequence.data() + begin, end - begin, nullptr,
+                            true);
+                });
+        return;
+    }
+    
+    PartitionedCounters* partitions = nullptr;
+    if (_partitioned) {
+        partitions = new PartitionedCounters(_frequency);
+    }
+    countKmers(sequence.data(), sequence.length(), partitions, false);
+    if (partitions != nullptr) {
+        partitions->flush();
+        delete partitions;
+    }
+}
+
+void KmerCounter::ForEachPiece(int length, int k, int numThreads,
+        const std::function<void(int, int)>& countPiece) {
+    // Each piece has PIECE_KMERS kmers and the k-1 nucleotides that end its
+    //    last kmer. The threads take the next piece until there are no more
+    int numKmers = length - k + 1;
+    if (numKmers <= 0)
+        return;
+    int numPieces = (numKmers - 1) / PIECE_KMERS + 1;
+    if (numThreads > numPieces)
+        numThreads = numPieces;
+    if (numThreads <= 1) {
+        countPiece(0, length);
+        return;
+    }
+    
+    atomic<int> next(0);
+    atomic<bool> failed(false);
+    exception_ptr error = nullptr;
+    vector<thread> workers;
+    for (int w = 0; w < numThreads; w++) {
+        workers.push_back(thread([&]() {
+            for (int p = next++; p < numPieces && !failed; p = next++) {
+                int begin = p * PIECE_KMERS;
+                try {
+                    countPiece(begin, min(length, begin + PIECE_KMERS + k - 1));
+                }
+                catch (...) {
+                    if (!failed.exchange(true))
+                        error = current_exception();
+                }
+            }
+        }));
+    }
+    for (int w = 0; w < numThreads; w++) {
+        workers[w].join();
+    }
+    if (error != nullptr)
+        rethrow_exception(error);
+}
+
+void KmerCounter::countKmers(const char text[], int length, 
+        PartitionedCounters* partitions, bool shared) {
+    if (!_seed.empty())
+        countSpacedKmers(text, length, partitions, shared);
+    else if (_onlyValidKmers)
+        countValidKmers(text, length, partitions, shared);
+    else
+        countAllKmers(text, length, partitions, shared);
+}
+
+void KmerCounter::countAllKmers(const char text[], int length, 
+        PartitionedCounters* partitions, bool shared) {
+    // The sequence is translated to the positions of its nucleotides in 
+    //    _allNucleotides (see NucleotideTable) by blocks, and the first k-1 
+    //    positions only begin the first kmer. The counters of the kmers of a
+    //    block are obtained first, and then they are increased with 
+    //    increaseCells(). When a kmer only has missing nucleotides 
+    //    (position 0), the next ones are the same until the next valid 
+    //    nucleotide, so a run of invalid characters is counted at once
+    unsigned char values[TRANSLATION_BLOCK];
+    int cells[TRANSLATION_BLOCK];
+    int base = _allNucleotides.length();
+    int numCols = getNumCols();
+    int highPower = getNumKmers() / base;
+    int index = 0;
+    if (!_canonical) {
+        for (int start = 0; start < length; start += TRANSLATION_BLOCK) {
+            int size = min(TRANSLATION_BLOCK, length - start);
+            _table.translate(text + start, size, values);
+            int i = 0;
+            int numCells = 0;
+            for (; i < size && start + i < _k - 1; i++) {
+                index = index * base + values[i];
+            }
+            for (; i < size; i++) {
+                index = (index % highPower) * base + values[i];
+                if (index == 0) {
+                    int next = NucleotideTable::FindValid(values, i + 1, size);
+                    _frequency.add(0, next - i, shared);
+                    i = next - 1;
+                    continue;
+                }
+                cells[numCells++] = index;
+            }
+            increaseCells(cells, numCells, partitions, shared);
+        }
+        return;
+    }
+    
+    // Canonical kmers: the position of the reverse complement is also 
+    //    obtained from the previous one, adding the complementary of the
+    //    new nucleotide as its first nucleotide
+    int complements[256];
+    for (int v = 0; v < base; v++) {
+        complements[v] = _allNucleotides.find(_complementaryNucleotides[v]);
+    }
+    int middleValues[256], middlePositions[256];
+    int numMiddles = hasCanonicalRows() ? 
+            getMiddles(middleValues, middlePositions) : 0;
+    
+    int reverse = 0;
+    for (int start = 0; start < length; start += TRANSLATION_BLOCK) {
+        int size = min(TRANSLATION_BLOCK, length - start);
+        _table.translate(text + start, size, values);
+        int i = 0;
+        int numCells = 0;
+        for (; i < size && start + i < _k - 1; i++) {
+            index = index * base + values[i];
+            reverse = reverse / base + complements[values[i]] * highPower;
+        }
+        for (; i < size; i++) {
+            index = (index % highPower) * base + values[i];
+            reverse = reverse / base + complements[values[i]] * highPower;
+            if (index == 0) {
+                // The missing nucleotide is its own complementary, so the
+                //    canonical kmer is also at row 0 and column 0
+                int next = NucleotideTable::FindValid(values, i + 1, size);
+                _frequency.add(0, next - i, shared);
+                i = next - 1;
+                continue;
+            }
+            cells[numCells++] = getCanonicalCell(index, reverse, numCols,
+                    complements, numMiddles, middlePositions);
+        }
+        increaseCells(cells, numCells, partitions, shared);
+    }
+}
+
+void KmerCounter::countValidKmers(const char text[], int length, 
+        PartitionedCounters* partitions, bool shared) {
+    // The window of the kmer restarts after each run of invalid nucleotides
+    //    (value 0 in the NucleotideTable), which is skipped at once, and its
+    //    nucleotides are the positions in _allNucleotides, that is, the 
+    //    values minus 1
+    unsigned char values[TRANSLATION_BLOCK];
+    int cells[TRANSLATION_BLOCK];
+    int base = _allNucleotides.length();
+    int numCols = getNumCols();
+    int highPower = getNumKmers() / base;
+    int index = 0;
+    int run = 0; // Number of valid nucleotides at the end of the window
+    
+    if (base == 4 && !_canonical) {
+        // Four nucleotides: 2 bits for each one, so the positions in the 
+        //    matrix are obtained with shifts and masks
+        int mask = getNumKmers() - 1;
+        for (int start = 0; start < length; start += TRANSLATION_BLOCK) {
+            int size = min(TRANSLATION_BLOCK, length - start);
+            _table.translate(text + start, size, values);
+            int numCells = 0;
+            for (int i = 0; i < size; i++) {
+                if (values[i] == 0) {
+                    run = 0;
+                    i = NucleotideTable::FindValid(values, i + 1, size) - 1;
+                    continue;
+                }
+                index = ((index << 2) | (values[i] - 1)) & mask;
+                if (run < _k - 1) {
+                    run++;
+                    continue;
+                }
+                cells[numCells++] = index;
+            }
+            increaseCells(cells, numCells, partitions, shared);
+        }
+        return;
+    }
+    
+    int complements[256];
+    int middleValues[256], middlePositions[256];
+    int numMiddles = 0;
+    if (_canonical) {
+        for (int v = 0; v < base; v++) {
+            complements[v] = 
+                    _allNucleotides.find(_complementaryNucleotides[v]);
+        }
+        if (hasCanonicalRows())
+            numMiddles = getMiddles(middleValues, middlePositions);
+    }
+    
+    int reverse = 0;
+    for (int start = 0; start < length; start += TRANSLATION_BLOCK) {
+        int size = min(TRANSLATION_BLOCK, length - start);
+        _table.translate(text + start, size, values);
+        int numCells = 0;
+        for (int i = 0; i < size; i++) {
+            if (values[i] == 0) {
+                run = 0;
+                i = NucleotideTable::FindValid(values, i + 1, size) - 1;
+                continue;
+            }
+            int value = values[i] - 1;
+            index = (index % highPower) * base + value;
+            if (_canonical)
+                reverse = reverse / base + complements[value] * highPower;
+            if (run < _k - 1) {
+                run++;
+                continue;
+            }
+            if (_canonical) {
+                cells[numCells++] = getCanonicalCell(index, reverse, 
+                        numCols, complements, numMiddles, middlePositions);
+            }
+            else
+                cells[numCells++] = index;
+        }
+        increaseCells(cells, numCells, partitions, shared);
+    }
+}
+
+void KmerCounter::countSpacedKmers(const char text[], int length, 
+        PartitionedCounters* partitions, bool shared) {
+    // The nucleotides of the window are packed in code, with bits bits for
+    //    each one, the first one in the highest bits, and the ones at the 
+    //    1 of the seed are extracted as the code of the kmer. If the number
+    //    of nucleotides is not a power of 2 (for example, with the missing 
+    //    nucleotide), the code of the kmer is converted to its position in
+    //    the matrix by groups of nucleotides, with the table conversion
+    unsigned char values[TRANSLATION_BLOCK];
+    int cells[TRANSLATION_BLOCK];
+    int base = _allNucleotides.length();
+    int span = _seed.length();
+    int bits = 1;
+    while ((1 << bits) < base) {
+        bits++;
+    }
+    unsigned long long windowMask = span * bits == 64 ? ~0ULL : 
+            (1ULL << (span * bits)) - 1;
+    unsigned long long seedMask = 0;
+    for (int p = 0; p < span; p++) {
+        if (_seed[p] == '1')
+            seedMask |= ((1ULL << bits) - 1) << ((span - 1 - p) * bits);
+    }
+    BitRuns runs;
+    GetBitRuns(seedMask, runs);
+    
+    bool packed = (1 << bits) == base;
+    int groupSize = max(1, CONVERSION_BITS / bits);
+    int numGroups = (_k - 1) / groupSize + 1;
+    int groupPower = pow(base, groupSize);
+    vector<int> conversion(packed ? 0 : 1 << (groupSize * bits));
+    for (size_t v = 0; v < conversion.size(); v++) {
+        for (int d = groupSize - 1; d >= 0; d--) {
+            conversion[v] = conversion[v] * base + 
+                    ((v >> (d * bits)) & ((1 << bits) - 1));
+        }
+    }
+    auto toIndex = [&](unsigned long long kmerCode) {
+        if (packed)
+            return (int) kmerCode;
+        int index = 0;
+        for (int g = numGroups - 1; g >= 0; g--) {
+            index = index * groupPower + conversion[(kmerCode >> 
+                    (g * groupSize * bits)) & (conversion.size() - 1)];
+        }
+        return index;
+    };
+    
+    unsigned long long code = 0;
+    unsigned long long reverse = 0;
+    int run = 0; // Number of nucleotides at the end of the window
+    if (packed && _onlyValidKmers && !_canonical) {
+        // The code of the kmer is its position in the matrix (for example,
+        //    2 bits for each one of four nucleotides)
+        for (int start = 0; start < length; start += TRANSLATION_BLOCK) {
+            int size = min(TRANSLATION_BLOCK, length - start);
+            _table.translate(text + start, size, values);
+            int numCells = 0;
+            for (int i = 0; i < size; i++) {
+                if (values[i] == 0) {
+                    run = 0;
+                    i = NucleotideTable::FindValid(values, i + 1, size) - 1;
+                    continue;
+                }
+                code = ((code << bits) | (values[i] - 1)) & windowMask;
+                if (run < span - 1) {
+                    run++;
+                    continue;
+                }
+                cells[numCells++] = ExtractBits(code, seedMask, runs);
+            }
+            increaseCells(cells, numCells, partitions, shared);
+        }
+        return;
+    }
+    
+    int complements[256];
+    int middleValues[256], middlePositions[256];
+    int numMiddles = 0;
+    int numCols = getNumCols();
+    int shift = (span - 1) * bits;
+    if (_canonical) {
+        for (int v = 0; v < base; v++) {
+            complements[v] = 
+                    _allNucleotides.find(_complementaryNucleotides[v]);
+        }
+        if (hasCanonicalRows())
+            numMiddles = getMiddles(middleValues, middlePositions);
+    }
+    
+    for (int start = 0; start < length; start += TRANSLATION_BLOCK) {
+        int size = min(TRANSLATION_BLOCK, length - start);
+        _table.translate(text + start, size, values);
+        int numCells = 0;
+        for (int i = 0; i < size; i++) {
+            int value = values[i];
+            if (_onlyValidKmers) {
+                if (value == 0) {
+                    run = 0;
+                    i = NucleotideTable::FindValid(values, i + 1, size) - 1;
+                    continue;
+                }
+                value--;
+            }
+            code = ((code << bits) | value) & windowMask;
+            if (_canonical) {
+                reverse = (reverse >> bits) | 
+                        ((unsigned long long) complements[value] << shift);
             }
+            if (run < span - 1) {
+                run++;
+                continue;
+            }
+            if (code == 0 && !_onlyValidKmers) {
+                // Only missing nucleotides in the window, until the next 
+                //    valid one
+                int next = NucleotideTable::FindValid(values, i + 1, size);
+                _frequency.add(0, next - i, shared);
+                i = next - 1;
+                continue;
+            }
+            
+            int index = toIndex(ExtractBits(code, seedMask, runs));
+            if (_canonical) {
+                // The seed is symmetric, so it extracts the reverse 
+                //    complement of the kmer from the one of the window
+                cells[numCells++] = getCanonicalCell(index, 
+                        toIndex(ExtractBits(reverse, seedMask, runs)), 
+                        numCols, complements, numMiddles, middlePositions);
+            }
+            else
+                cells[numCells++] = index;
         }
+        increaseCells(cells, numCells, partitions, shared);
     }
+}
+
+int KmerCounter::getCanonicalCell(int index, int reverse, int numCols, 
+        const int complements[], int numMiddles, 
+        const int middlePositions[]) const {
+    int base = _allNucleotides.length();
+    int code = index;
+    if (numMiddles == 0)
+        return reverse < index ? reverse : index;
+    
+    // The kmer or its reverse complement with the first nucleotide of a 
+    //    complementary pair in the middle position (the smaller one if the
+    //    middle nucleotide is its own complementary)
+    int middle = (index / numCols) % base;
+    if (middlePositions[middle] < 0 || 
+            (complements[middle] == middle && reverse < index))
+        code = reverse;
+    int row = (code / numCols) / base * numMiddles + 
+            middlePositions[(code / numCols) % base];
+    return row * numCols + code % numCols;
+}
+
+void KmerCounter::increaseCells(const int cells[], int numCells, 
+        PartitionedCounters* partitions, bool shared) {
+    if (partitions != nullptr)
+        partitions->increase(cells, numCells);
+    else
+        _frequency.increase(cells, numCells, _prefetchDistance, shared);
+}
+
+Profile KmerCounter::toProfile() const {
+    // The kmers of the matrix are unique, so they are put directly in their
+    //    positions instead of appending them with Profile::operator+=()
+    Profile p(getNumberActiveKmers());
+    int pos = 0;
+    int numCols = getNumCols();
+    _frequency.forEachNonZero([&](int cell, long long frequency) {
+        p.at(pos).setKmer(getKmer(cell / numCols, cell % numCols));
+        p.at(pos).setFrequency(frequency);
+        pos++;
+    });
+    if (!_seed.empty())
+        p.setParameters(SEED + "=" + _seed);
     
     return p;
 }
 
 int KmerCounter::getNumRows() const {
-    return (pow(_allNucleotides.length(), (_k+1)/2));
+    int numRows = pow(_allNucleotides.length(), (_k+1)/2);
+    if (hasCanonicalRows()) {
+        // The missing nucleotide (if it is counted) and a nucleotide of each
+        //    pair in the middle
+        numRows = numRows / _allNucleotides.length() * 
+                ((_onlyValidKmers ? 0 : 1) + _validNucleotides.length() / 2);
+    }
+    
+    return numRows;
 }
 
 int KmerCounter::getNumCols() const {
@@ -225,8 +898,55 @@ string KmerCounter::getInvertedIndex(int index, int nCharacters) const {
     return result;
 }
 
+bool KmerCounter::hasCanonicalRows() const {
+    return _canonical && _k % 2 == 1;
+}
+
+int KmerCounter::getMiddles(int middleValues[], int middlePositions[]) const {
+    int numMiddles = 0;
+    for (size_t v = 0; v < _allNucleotides.size(); v++) {
+        size_t complementary = 
+                _allNucleotides.find(_complementaryNucleotides[v]);
+        if (v <= complementary) {
+            middleValues[numMiddles] = v;
+            middlePositions[v] = numMiddles;
+            numMiddles++;
+        }
+        else
+            middlePositions[v] = -1;
+    }
+    
+    return numMiddles;
+}
+
+std::string KmerCounter::getCanonicalKmer(const std::string& kmer) const {
+    string reverse = ReverseComplement(kmer, _allNucleotides, 
+            _complementaryNucleotides);
+    for (size_t i = 0; i < kmer.size(); i++) {
+        size_t a = _allNucleotides.find(kmer[i]);
+        size_t b = _allNucleotides.find(reverse[i]);
+        if (a != b)
+            return a < b ? kmer : reverse;
+    }
+    
+    return kmer;
+}
+
 void KmerCounter::getRowColumn(const Kmer& kmer, int& row, int& column) const {
     string k = kmer.toString();
+    if (_canonical)
+        k = getCanonicalKmer(k);
+    if (hasCanonicalRows()) {
+        int middleValues[256], middlePositions[256];
+        int numMiddles = getMiddles(middleValues, middlePositions);
+        if (middlePositions[_allNucleotides.find(k[_k/2])] < 0)
+            k = ReverseComplement(k, _allNucleotides, 
+                    _complementaryNucleotides);
+        row = getIndex(k.substr(0, _k/2)) * numMiddles + 
+                middlePositions[_allNucleotides.find(k[_k/2])];
+        column = getIndex(k.substr(_k/2 + 1));
+        return;
+    }
     string k1 = k.substr(0,(_k+1)/2);
     string k2 = k.substr((_k+1)/2,k.length());
     row = getIndex(k1);
@@ -239,33 +959,27 @@ Kmer KmerCounter::getKmer(int row, int column) const {
                 "int column) const: the row or the column is not "
                 "in the range"));
     
-    string k1 = getInvertedIndex(row, (_k+1)/2);
-    string k2 = getInvertedIndex(column, (_k+1)/2);
+    string k1;
+    if (hasCanonicalRows()) {
+        int middleValues[256], middlePositions[256];
+        int numMiddles = getMiddles(middleValues, middlePositions);
+        k1 = getInvertedIndex(row / numMiddles, _k/2) + 
+                _allNucleotides[middleValues[row % numMiddles]];
+    }
+    else
+        k1 = getInvertedIndex(row, (_k+1)/2);
+    string k2 = getInvertedIndex(column, _k - (_k+1)/2);
     string k = k1 + k2;
+    if (_canonical)
+        k = getCanonicalKmer(k);
     Kmer kmer(k);
     return kmer;
 }
 
 void KmerCounter::initFrequencies() {
-    for (int i = 0; i < getNumRows(); i++) {
-        for (int j = 0; j < getNumCols(); j++) {
-            _frequency[i][j] = 0;
-        }
-    }
-}
-
-const int& KmerCounter::operator()(int row, int column) const {
-    return _frequency[row][column];
+    _frequency.clear();
 }
 
-int& KmerCounter::operator()(int row, int column) {
-    return _frequency[row][column];
+long long KmerCounter::operator()(int row, int column) const {
+    return _frequency.get(row * getNumCols() + column);
 }
-
-void KmerCounter::deallocate() {
-    for (int i = 0; i < getNumRows(); i++) {
-        delete[] _frequency[i];
-    }
-    delete[] _frequency;
-    _frequency = nullptr;
-}
\ No newline at end of file
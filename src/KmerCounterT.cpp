@@ -0,0 +1,107 @@
+/*
+ * Metodología de la Programación: Kmer5
+ * Curso 2023/2024
+ */
+
+/**
+ * @file KmerCounterT.cpp
+ */
+
+#include "KmerCounterT.h"
+
+using namespace std;
+
+/**
+ * Learns the sorted Profile of a set of DNA files with a KmerCounterT<K>
+ * @param validNucleotides The set of valid nucleotides. Input parameter
+ * @param fileNames The names of the DNA files. Input parameter
+ * @param numFiles The number of DNA files. Input parameter
+ * @param cellBits The number of bits of each cell of the table of 
+ * frequencies. Input parameter
+ * @param partitioned Whether the counters are increased by partitions of
+ * the table. Input parameter
+ * @return The learned Profile
+ */
+template <int K>
+static Profile LearnProfile(const string& validNucleotides,
+        char* const fileNames[], int numFiles, int cellBits, 
+        bool partitioned) {
+    KmerCounterT<K> kc(validNucleotides, cellBits);
+    KmerCounterT<K> aux(validNucleotides, cellBits);
+    aux.setPartitioned(partitioned);
+    for (int i = 0; i < numFiles; i++) {
+        aux.calculateFrequencies(fileNames[i]);
+        kc += aux;
+    }
+
+    return kc.toProfile();
+}
+
+bool LearnSortedProfile(int k, const std::string& validNucleotides,
+        char* const fileNames[], int numFiles, Profile& profile,
+        int cellBits, bool partitioned) {
+    int base = validNucleotides.size() + 1;
+    if (base > PackedKmer<1>::MAX_SYMBOLS)
+        return false;
+    long long numKmers = 1;
+    for (int i = 0; i < k && numKmers <= INT_MAX; i++) {
+        numKmers *= base;
+    }
+    if (numKmers > INT_MAX)
+        return false;
+
+    switch (k) {
+        case 1:
+            profile = LearnProfile<1>(validNucleotides, fileNames, numFiles,
+                    cellBits, partitioned);
+            break;
+        case 2:
+            profile = LearnProfile<2>(validNucleotides, fileNames, numFiles,
+                    cellBits, partitioned);
+            break;
+        case 3:
+            profile = LearnProfile<3>(validNucleotides, fileNames, numFiles,
+                    cellBits, partitioned);
+            break;
+        case 4:
+            profile = LearnProfile<4>(validNucleotides, fileNames, numFiles,
+                    cellBits, partitioned);
+            break;
+        case 5:
+            profile = LearnProfile<5>(validNucleotides, fileNames, numFiles,
+                    cellBits, partitioned);
+            break;
+        case 6:
+            profile = LearnProfile<6>(validNucleotides, fileNames, numFiles,
+                    cellBits, partitioned);
+            break;
+        case 7:
+            profile = LearnProfile<7>(validNucleotides, fileNames, numFiles,
+                    cellBits, partitioned);
+            break;
+        case 8:
+            profile = LearnProfile<8>(validNucleotides, fileNames, numFiles,
+                    cellBits, partitioned);
+            break;
+        case 9:
+            profile = LearnProfile<9>(validNucleotides, fileNames, numFiles,
+                    cellBits, partitioned);
+            break;
+        case 10:
+            profile = LearnProfile<10>(validNucleotides, fileNames, numFiles,
+                    cellBits, partitioned);
+            break;
+        case 11:
+            profile = LearnProfile<11>(validNucleotides, fileNames, numFiles,
+                    cellBits, partitioned);
+            break;
+        case 12:
+            profile = LearnProfile<12>(validNucleotides, fileNames, numFiles,
+                    cellBits, partitioned);
+            break;
+        default:
+            return false;
+    }
+
+    return true;
+}
@@ -23,7 +23,7 @@ const Kmer& KmerFreq::getKmer() const{
     return _kmer;
 }
 
-int KmerFreq::getFrequency() const {
+long long KmerFreq::getFrequency() const {
     return _frequency;
 }
 
@@ -31,10 +31,10 @@ void KmerFreq::setKmer(const Kmer& kmer) {
     _kmer = kmer;
 }
 
-void KmerFreq::setFrequency(const int frequency) {
+void KmerFreq::setFrequency(const long long frequency) {
     if (frequency < 0)
         throw std::out_of_range(
-                std::string("setFrequency(const int& frequency): ") + 
+                std::string("setFrequency(const long long& frequency): ") + 
                 "frequency is negative");
     
     _frequency = frequency;
@@ -59,7 +59,7 @@ std::ostream& operator<<(std::ostream& os, const KmerFreq& kmerFreq) {
 }
 
 std::istream& operator>>(std::istream& is, KmerFreq& kmerFreq) {
-    int f;
+    long long f;
     Kmer k;
     is >> k >> f;
     kmerFreq.setKmer(k);
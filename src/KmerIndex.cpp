@@ -0,0 +1,372 @@
+/*
+ * Metodología de la Programación: Kmer5
+ * Curso 2023/2024
+ */
+
+/**
+ * @file KmerIndex.cpp
+ */
+
+#include <cctype>
+#include <fstream>
+
+#include "KmerIndex.h"
+
+using namespace std;
+
+const string KmerIndex::MAGIC_STRING="MP-KMER-KIX-1.0";
+
+/**
+ * Mixes the bits of a kmer code (splitmix64 finalizer), so that consecutive
+ * codes are spread over the table
+ * @param key The code of a kmer plus one. Input parameter
+ * @return The mixed value
+ */
+static unsigned long long Mix(unsigned long long key) {
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9ULL;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebULL;
+    key ^= key >> 31;
+
+    return key;
+}
+
+KmerIndex::KmerIndex(int k, const std::string& validNucleotides) {
+    if (k <= 0)
+        throw invalid_argument(string("KmerIndex::KmerIndex(int k, const "
+                "std::string& validNucleotides): k must be greater than zero"));
+
+    _k = k;
+    _validNucleotides = validNucleotides;
+    _numReferences = 0;
+    initValues();
+    allocate(INITIAL_CAPACITY);
+}
+
+KmerIndex::~KmerIndex() {
+    deallocate();
+}
+
+int KmerIndex::getK() const {
+    return _k;
+}
+
+const std::string& KmerIndex::getValidNucleotides() const {
+    return _validNucleotides;
+}
+
+int KmerIndex::getNumReferences() const {
+    return _numReferences;
+}
+
+long long KmerIndex::getSize() const {
+    return _size;
+}
+
+void KmerIndex::addProfile(const Profile& profile, int reference) {
+    if (reference < 0)
+        throw invalid_argument(string("void KmerIndex::addProfile(const "
+                "Profile& profile, int reference): reference must be greater "
+                "or equal than zero"));
+
+    if (reference >= _numReferences)
+        _numReferences = reference + 1;
+
+    unsigned long long base = _validNucleotides.size();
+    for (int i = 0; i < profile.getSize(); i++) {
+        const Kmer& kmer = profile[i].getKmer();
+        if (kmer.size() != _k)
+            continue;
+
+        unsigned long long code = 0;
+        bool valid = true;
+        for (int j = 0; j < _k && valid; j++) {
+            int value = _values[(unsigned char)kmer.at(j)];
+            valid = value >= 0;
+            code = code * base + value;
+        }
+        if (valid)
+            insert(code, reference);
+    }
+}
+
+int KmerIndex::find(const Kmer& kmer) const {
+    if (kmer.size() != _k)
+        return NOT_FOUND;
+
+    unsigned long long base = _validNucleotides.size();
+    unsigned long long code = 0;
+    for (int j = 0; j < _k; j++) {
+        int value = _values[(unsigned char)kmer.at(j)];
+        if (value < 0)
+            return NOT_FOUND;
+        code = code * base + value;
+    }
+
+    long long slot = findSlot(code + 1);
+    return _keys[slot] != 0 ? _references[slot] : NOT_FOUND;
+}
+
+int KmerIndex::classify(const char sequence[], int length, int minVotes,
+        int votes[], int voted[]) const {
+    unsigned long long base = _validNucleotides.size();
+    unsigned long long code = 0;
+    int numValid = 0;
+    int numVoted = 0;
+
+    // Rolling code of the last _k valid nucleotides: once it has _k of
+    //    them, the oldest one is subtracted before adding the new one,
+    //    without a modulus for each nucleotide
+    for (int i = 0; i < length; i++) {
+        int value = _values[(unsigned char)sequence[i]];
+        if (value < 0) {
+            numValid = 0;
+            code = 0;
+        }
+        else {
+            if (numValid >= _k)
+                code -= _values[(unsigned char)sequence[i - _k]] * _highPower;
+            code = code * base + value;
+            numValid++;
+            if (numValid >= _k) {
+                long long slot = findSlot(code + 1);
+                int reference = _keys[slot] != 0 ? _references[slot] :
+                        NOT_FOUND;
+                if (reference >= 0) {
+                    if (votes[reference] == 0) {
+                        voted[numVoted] = reference;
+                        numVoted++;
+                    }
+                    votes[reference]++;
+                }
+            }
+        }
+    }
+
+    int winner = NOT_FOUND;
+    int maxVotes = 0;
+    for (int i = 0; i < numVoted; i++) {
+        int reference = voted[i];
+        if (votes[reference] > maxVotes) {
+            maxVotes = votes[reference];
+            winner = reference;
+        }
+        else if (votes[reference] == maxVotes)
+            winner = AMBIGUOUS;
+        votes[reference] = 0;
+    }
+
+    return maxVotes >= minVotes ? winner : NOT_FOUND;
+}
+
+void KmerIndex::save(const char fileName[]) const {
+    ofstream output;
+    output.open(fileName, ios::out | ios::binary);
+
+    if (!output) {
+        throw ios_base::failure(string("void KmerIndex::save(const char "
+                "fileName[]) const: the given file cannot be opened\n"));
+    }
+
+    int length = _validNucleotides.size();
+    output << MAGIC_STRING << '\n';
+    output.write(reinterpret_cast<const char*>(&_k), sizeof(_k));
+    output.write(reinterpret_cast<const char*>(&length), sizeof(length));
+    output.write(_validNucleotides.data(), length);
+    output.write(reinterpret_cast<const char*>(&_numReferences),
+            sizeof(_numReferences));
+    output.write(reinterpret_cast<const char*>(&_capacity), sizeof(_capacity));
+    output.write(reinterpret_cast<const char*>(&_size), sizeof(_size));
+    output.write(reinterpret_cast<const char*>(_keys),
+            _capacity * sizeof(unsigned long long));
+    output.write(reinterpret_cast<const char*>(_references),
+            _capacity * sizeof(int));
+
+    if (!output) {
+        output.close();
+        throw ios_base::failure(string("void KmerIndex::save(const char "
+                "fileName[]) const: an error ocurred while writing in the "
+                "file\n"));
+    }
+
+    output.close();
+}
+
+void KmerIndex::load(const char fileName[]) {
+    ifstream input;
+    input.open(fileName, ios::in | ios::binary);
+
+    if (!input) {
+        throw ios_base::failure(string("void KmerIndex::load(const char "
+                "fileName[]): the given file cannot be opened\n"));
+    }
+
+    string magic_string;
+    getline(input, magic_string);
+    if (magic_string != MAGIC_STRING) {
+        input.close();
+        throw invalid_argument(string("void KmerIndex::load(const char "
+                "fileName[]): an invalid magic string has been found in the "
+                "given file"));
+    }
+
+    int k = 0, length = 0, numReferences = 0;
+    long long capacity = 0, size = 0;
+    input.read(reinterpret_cast<char*>(&k), sizeof(k));
+    input.read(reinterpret_cast<char*>(&length), sizeof(length));
+    // There cannot be more valid nucleotides than values of a char
+    bool validLength = length > 0 && length <= 256;
+    string validNucleotides(validLength ? length : 0, ' ');
+    input.read(&validNucleotides[0], validNucleotides.size());
+    input.read(reinterpret_cast<char*>(&numReferences), sizeof(numReferences));
+    input.read(reinterpret_cast<char*>(&capacity), sizeof(capacity));
+    input.read(reinterpret_cast<char*>(&size), sizeof(size));
+
+    // The table is read from the rest of the file, so a capacity larger
+    //    than the file is not allocated
+    streamoff begin = input.tellg();
+    input.seekg(0, ios::end);
+    streamoff end = input.tellg();
+    input.seekg(begin);
+    if (!input || k <= 0 || !validLength || numReferences < 0 ||
+            capacity <= 0 || size < 0 || size >= capacity ||
+            (capacity & (capacity - 1)) != 0 || capacity > (end - begin) /
+            (long long)(sizeof(unsigned long long) + sizeof(int))) {
+        input.close();
+        throw ios_base::failure(string("void KmerIndex::load(const char "
+                "fileName[]): an error ocurred while reading the file\n"));
+    }
+
+    // The previous values are restored if the nucleotides or k read from
+    //    the file are not valid
+    int oldK = _k;
+    string oldValidNucleotides = _validNucleotides;
+    _k = k;
+    _validNucleotides = validNucleotides;
+    try {
+        initValues();
+    } catch (const invalid_argument&) {
+        _k = oldK;
+        _validNucleotides = oldValidNucleotides;
+        initValues();
+        input.close();
+        throw ios_base::failure(string("void KmerIndex::load(const char "
+                "fileName[]): an error ocurred while reading the file\n"));
+    }
+    _numReferences = numReferences;
+    deallocate();
+    allocate(capacity);
+    input.read(reinterpret_cast<char*>(_keys),
+            _capacity * sizeof(unsigned long long));
+    input.read(reinterpret_cast<char*>(_references), _capacity * sizeof(int));
+    _size = size;
+
+    // The references of the kmers are used as indices of the votes of
+    //    classify()
+    long long numKeys = 0;
+    bool valid = true;
+    for (long long slot = 0; slot < _capacity && valid; slot++) {
+        if (_keys[slot] != 0) {
+            numKeys++;
+            valid = _references[slot] == AMBIGUOUS ||
+                    (_references[slot] >= 0 &&
+                    _references[slot] < numReferences);
+        }
+    }
+
+    if (!input || !valid || numKeys != size) {
+        deallocate();
+        allocate(INITIAL_CAPACITY);
+        _numReferences = 0;
+        input.close();
+        throw ios_base::failure(string("void KmerIndex::load(const char "
+                "fileName[]): an error ocurred while reading the file\n"));
+    }
+
+    input.close();
+}
+
+void KmerIndex::allocate(long long capacity) {
+    _capacity = capacity;
+    _size = 0;
+    _keys = new unsigned long long[_capacity]();
+    _references = new int[_capacity];
+}
+
+void KmerIndex::deallocate() {
+    delete[] _keys;
+    delete[] _references;
+    _keys = nullptr;
+    _references = nullptr;
+    _capacity = 0;
+    _size = 0;
+}
+
+void KmerIndex::initValues() {
+    unsigned long long base = _validNucleotides.size();
+    if (base == 0)
+        throw invalid_argument(string("void KmerIndex::initValues(): the set "
+                "of valid nucleotides is empty"));
+
+    // _highPower * base is the number of codes, which should fit in 64 bits
+    //    (the code plus one is stored in the table)
+    _highPower = 1;
+    for (int i = 1; i < _k; i++) {
+        if (_highPower > ~0ULL / base)
+            throw invalid_argument(string("void KmerIndex::initValues(): the "
+                    "codes of the kmers do not fit in 64 bits"));
+        _highPower *= base;
+    }
+    if (_highPower > ~0ULL / base)
+        throw invalid_argument(string("void KmerIndex::initValues(): the "
+                "codes of the kmers do not fit in 64 bits"));
+
+    for (int c = 0; c < 256; c++) {
+        _values[c] = -1;
+    }
+    for (size_t i = 0; i < _validNucleotides.size(); i++) {
+        unsigned char nucleotide = _validNucleotides[i];
+        _values[toupper(nucleotide)] = i;
+        _values[tolower(nucleotide)] = i;
+    }
+}
+
+long long KmerIndex::findSlot(unsigned long long key) const {
+    long long mask = _capacity - 1;
+    long long slot = Mix(key) & mask;
+    while (_keys[slot] != 0 && _keys[slot] != key) {
+        slot = (slot + 1) & mask;
+    }
+
+    return slot;
+}
+
+void KmerIndex::insert(unsigned long long code, int reference) {
+    // The table is doubled when it is half full
+    if (2 * (_size + 1) > _capacity) {
+        unsigned long long* keys = _keys;
+        int* references = _references;
+        long long capacity = _capacity;
+        allocate(2 * capacity);
+        for (long long i = 0; i < capacity; i++) {
+            if (keys[i] != 0) {
+                long long slot = findSlot(keys[i]);
+                _keys[slot] = keys[i];
+                _references[slot] = references[i];
+                _size++;
+            }
+        }
+        delete[] keys;
+        delete[] references;
+    }
+
+    long long slot = findSlot(code + 1);
+    if (_keys[slot] == 0) {
+        _keys[slot] = code + 1;
+        _references[slot] = reference;
+        _size++;
+    }
+    else if (_references[slot] != reference)
+        _references[slot] = AMBIGUOUS;
+}
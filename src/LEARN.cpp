@@ -11,10 +11,50 @@
  */
 
 #include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <vector>
 #include "KmerCounter.h"
+#include "KmerCounterT.h"
+#include "DiskKmerCounter.h"
+#include "ConcurrentKmerMap.h"
+#include "CountMinSketch.h"
+#include "SampledKmerCounter.h"
+#include "SpaceSaving.h"
+#include "SequenceFilter.h"
+#include "FastaReader.h"
+#include "ProfileDatabase.h"
+#include "Sketch.h"
 
 using namespace std;
 
+/**
+ * Maximum number of records of a batch with the option -f
+ */
+const int RECORDS_PER_BATCH = 1024;
+
+/**
+ * Number of nucleotides after which no more records are added to a batch
+ * with the option -f
+ */
+const long long NUCLEOTIDES_PER_BATCH = 1LL << 26;
+
+/**
+ * Maximum number of kmers of the matrix of the KmerCounter shared by the
+ * threads with the option -S (1 GB of 32 bits counters). A ConcurrentKmerMap is used for
+ * larger matrices
+ */
+const long long MAX_SHARED_KMERS = 1LL << 28;
+
+/**
+ * Upper bound of the false positive rate of the BloomFilter of the option
+ * -u when all the different kmers of the files are inserted, with
+ * BloomFilter::DEFAULT_BITS_PER_KEY bits for each one (about 0.01)
+ */
+const double MAX_SINGLETON_FALSE_POSITIVES = 0.02;
+
 /**
  * Shows help about the use of this program in the given output stream
  * @param outputStream The output stream where the help will be shown (for example,
@@ -23,15 +63,74 @@ using namespace std;
 void showEnglishHelp(ostream& outputStream) {
     outputStream << "ERROR in LEARN parameters" << endl;
     outputStream << "Run with the following parameters:" << endl;
-    outputStream << "LEARN [-t|-b] [-k kValue] [-n nucleotidesSet] [-p profileId] [-o outputFilename] <file1.dna> [<file2.dna> <file3.dna> .... ]" << endl;
+    outputStream << "LEARN [-t|-b] [-a] [-x] [-k kValue] [-n nucleotidesSet] [-p profileId] [-o outputFilename] [-s sketchSize] [-f [-j numThreads]] [-E tmpDirectory [-M memoryMB] [-L diskMB] [-j numThreads]] [-S [-j numThreads] [-u]] [-C topN [-y sketchWidth] [-z sketchDepth]] [-g topN] [-h sampling] [-G seed] [-D dustLevel] [-W cellBits] [-P] <file1.dna> [<file2.dna> <file3.dna> .... ]" << endl;
     outputStream << endl;
     outputStream << "Parameters:" << endl;
     outputStream << "-t|-b: text mode or binary mode for the output file (-t by default)" << endl;
+    outputStream << "-a: canonical kmers: each kmer is counted as the smaller one of itself and "
+                 << "its reverse complement, so both strands give the same profile" << endl;
+    outputStream << "-x: only the kmers without missing nucleotides are counted: the kmers "
+                 << "with invalid nucleotides are skipped, with a smaller table of kmers" << endl;
     outputStream << "-k kValue: number of nucleotides in a kmer (5 by default)" << endl;
     outputStream << "-n nucleotidesSet: set of possible nucleotides in a kmer (ACGT by default). " 
                  << "Note that the characters should be provided in uppercase" << endl;
     outputStream << "-p profileId: profile identifier (unknown by default)" << endl;
-    outputStream << "-o outputFilename: name of the output file (output.prf by default)" << endl;
+    outputStream << "-o outputFilename: name of the output file (output.prf by default, "
+                 << "or output.db with -f)" << endl;
+    outputStream << "-s sketchSize: also save a MinHash sketch with sketchSize hash values "
+                 << "in the file outputFilename.skt (not saved by default)" << endl;
+    outputStream << "-f: each record of the input (multi-)FASTA files is learned as a separate "
+                 << "profile, whose identifier is the name of the record. The profiles are saved "
+                 << "in a reference database (see BUILDDB) instead of a profile file" << endl;
+    outputStream << "-j numThreads: number of threads used to learn the records with -f, "
+                 << "to count the buckets with -E, or to count each file with -S (number of "
+                 << "hardware threads by default)" << endl;
+    outputStream << "-E tmpDirectory: the kmers are counted with temporary files in tmpDirectory, "
+                 << "for kmers whose table does not fit in memory (for example, k=31). Only the "
+                 << "kmers without missing nucleotides are counted, as with -x" << endl;
+    outputStream << "-M memoryMB: memory used to count the kmers with -E, in MB (" 
+                 << DiskKmerCounter::DEFAULT_MEMORY_LIMIT / (1 << 20) << " by default)" << endl;
+    outputStream << "-L diskMB: maximum space of the temporary files of -E, in MB (no limit "
+                 << "by default)" << endl;
+    outputStream << "-S: the kmers of each input file are counted by numThreads threads in a "
+                 << "single shared table, a matrix for small values of k or a hash table for "
+                 << "the large ones" << endl;
+    outputStream << "-u: the kmers that appear only once are not counted with -S (for example, "
+                 << "the ones with sequencing errors), so the hash table needs about half the "
+                 << "memory. The false positive rate of the filter is shown" << endl;
+    outputStream << "-C topN: the kmers are counted approximately in a Count-Min sketch of "
+                 << "fixed size, and the profile has the topN kmers with the largest "
+                 << "estimated frequencies. The bound of the error is shown" << endl;
+    outputStream << "-y sketchWidth: number of counters of each row of the sketch of -C ("
+                 << CountMinSketch::DEFAULT_WIDTH << " by default)" << endl;
+    outputStream << "-z sketchDepth: number of rows of the sketch of -C ("
+                 << CountMinSketch::DEFAULT_DEPTH << " by default)" << endl;
+    outputStream << "-g topN: only the topN most frequent kmers are kept while the input files "
+                 << "are read, with topN counters (Space-Saving), and the profile has those "
+                 << "kmers. The bound of the error is shown" << endl;
+    outputStream << "-h sampling: only a sample of the kmers is counted: fracminhash=S (the "
+                 << "kmers whose hash value is in the smallest 1/S of the values) or "
+                 << "minimizer=W (the kmer with the smallest hash value of each window of W "
+                 << "kmers). The sampling is saved in the profile, which can only be compared "
+                 << "with profiles sampled in the same way (see CLASSIFY -h)" << endl;
+    outputStream << "-G seed: spaced seed of the kmers, a string of 1 and 0 with kValue 1s that "
+                 << "begins and ends with 1 (for example, 1101011 with -k 5): each kmer has "
+                 << "the nucleotides at the 1 of a window of the length of the seed. The seed "
+                 << "is saved in the profile, and CLASSIFY counts the kmers with it" << endl;
+    outputStream << "-D dustLevel: the windows of " << SequenceFilter::DUST_WINDOW 
+                 << " nucleotides of low complexity (for example, poly-A) whose DUST score is "
+                 << "greater than dustLevel are masked before counting the kmers ("
+                 << SequenceFilter::DEFAULT_DUST_LEVEL << " is usual; none by default). "
+                 << "With -x, the kmers with masked nucleotides are skipped. It cannot be used "
+                 << "with -E" << endl;
+    outputStream << "-W cellBits: number of bits of the counters of the table of kmers: 8, 16 "
+                 << "or 32 (" << CounterTable::DEFAULT_CELL_BITS << " by default). The "
+                 << "smaller ones use less memory, and the frequencies that do not fit are "
+                 << "kept apart. It cannot be used with -E, -C, -g or -h" << endl;
+    outputStream << "-P: the counters of the table of kmers are increased by partitions of the "
+                 << "table instead of in the order of the kmers. It may be faster for the tables "
+                 << "that do not fit in the cache, depending on the machine (see BENCHCOUNT). "
+                 << "It cannot be used with -E, -S, -C, -g or -h" << endl;
     outputStream << "<file1.dna> <file2.dna> <file3.dna> ....: names of the input files (at least one is mandatory)" << endl;
     outputStream << endl;
     outputStream << "This program learns a profile model from a set of "<< 
@@ -39,6 +138,175 @@ void showEnglishHelp(ostream& outputStream) {
     outputStream << endl;
 }
 
+/**
+ * Reads the next batch of records of a set of (multi-)FASTA files. When a
+ * file ends, the next one is opened.
+ * @param reader The reader of the current file. Input/Output parameter
+ * @param files The names of the files. Input parameter
+ * @param numFiles The number of files. Input parameter
+ * @param file The position of the current file. Input/Output parameter
+ * @param names The names of the records. Output parameter
+ * @param sequences The sequences of the records. Output parameter
+ * @return The number of records read (0 when all the files have been read)
+ */
+int ReadBatch(FastaReader& reader, char* const files[], int numFiles,
+        int& file, string names[], string sequences[]) {
+    int num_records = 0;
+    while (num_records == 0 && file < numFiles) {
+        num_records = reader.next(names, sequences, RECORDS_PER_BATCH,
+                NUCLEOTIDES_PER_BATCH);
+        if (num_records == 0) {
+            file++;
+            if (file < numFiles)
+                reader.open(files[file]);
+        }
+    }
+
+    return num_records;
+}
+
+/**
+ * Learns the zipped and sorted Profiles of a batch of records with several
+ * threads. Each thread takes the next record of the batch and learns it
+ * with its own KmerCounter, which is reused for all its records.
+ * @param names The names of the records, used as identifiers of the
+ * Profiles. Input parameter
+ * @param sequences The sequences of the records, which are filtered in
+ * place. Input/Output parameter
+ * @param numRecords The number of records. Input parameter
+ * @param counters A KmerCounter for each thread. Input/Output parameter
+ * @param numThreads The number of threads. Input parameter
+ * @param filter The filter of the sequences. Input parameter
+ * @param profiles The Profile of each record. Output parameter
+ * @throw std::exception The first exception thrown by a thread is rethrown
+ * once all the threads have finished
+ */
+void LearnBatch(const string names[], string sequences[],
+        int numRecords, KmerCounter counters[], int numThreads,
+        const SequenceFilter& filter, Profile profiles[]) {
+    atomic<int> next(0);
+    atomic<bool> failed(false);
+    vector<exception_ptr> errors(numThreads);
+    vector<thread> workers;
+    for (int w = 0; w < numThreads; w++) {
+        workers.push_back(thread([&, w]() {
+            try {
+                for (int r = next++; r < numRecords && !failed; r = next++) {
+                    filter.filter(sequences[r]);
+                    counters[w].calculateSequenceFrequencies(sequences[r]);
+                    profiles[r] = counters[w].toProfile();
+                    profiles[r].setProfileId(names[r]);
+                    profiles[r].zip();
+                    profiles[r].sort();
+                }
+            }
+            catch (...) {
+                failed = true;
+                errors[w] = current_exception();
+            }
+        }));
+    }
+    for (int w = 0; w < numThreads; w++) {
+        workers[w].join();
+    }
+    for (int w = 0; w < numThreads; w++) {
+        if (errors[w] != nullptr)
+            rethrow_exception(errors[w]);
+    }
+}
+
+/**
+ * Learns the zipped and sorted Profile of a set of DNA files with several
+ * threads that count the kmers of each file in a shared table: the matrix
+ * of a KmerCounter if it has at most MAX_SHARED_KMERS kmers, or otherwise a
+ * ConcurrentKmerMap with a slot for each nucleotide of the files (an upper
+ * bound of their different kmers). The memory does not depend on the 
+ * number of threads. The kmers that appear only once can be dropped: the
+ * first occurrence of each kmer only goes to a BloomFilter, so the
+ * ConcurrentKmerMap only needs a slot for each 2 nucleotides (plus the
+ * singletons that are false positives of the filter), while the matrix
+ * just drops the kmers with frequency 1 when it is zipped.
+ * @param k The number of nucleotides in each kmer. Input parameter
+ * @param validNucleotides The set of valid nucleotides. Input parameter
+ * @param canonical Whether canonical kmers are counted. Input parameter
+ * @param onlyValidKmers Whether only the kmers without missing nucleotides
+ * are counted. Input parameter
+ * @param fileNames The names of the DNA files. Input parameter
+ * @param numFiles The number of DNA files. Input parameter
+ * @param numThreads The number of threads. Input parameter
+ * @param cellBits The number of bits of the counters of the matrix of the
+ * KmerCounter. Input parameter
+ * @param dropSingletons Whether the kmers that appear only once are
+ * dropped. Input parameter
+ * @param filter The filter of the DNA of the files. Input parameter
+ * @return The learned Profile
+ * @throw std::ios_base::failure Throws a std::ios_base::failure exception if
+ * a file cannot be opened
+ * @throw std::invalid_argument Throws a std::invalid_argument exception if
+ * the kmers cannot be packed in the codes of a ConcurrentKmerMap
+ */
+Profile LearnShared(int k, const string& validNucleotides, bool canonical,
+        bool onlyValidKmers, char* const fileNames[], int numFiles,
+        int numThreads, int cellBits, bool dropSingletons, 
+        const SequenceFilter& filter) {
+    long long numKmers = 1;
+    int base = validNucleotides.size() + (onlyValidKmers ? 0 : 1);
+    for (int i = 0; i < k && numKmers <= MAX_SHARED_KMERS; i++) {
+        numKmers *= base;
+    }
+
+    Profile profile;
+    if (numKmers <= MAX_SHARED_KMERS) {
+        KmerCounter kc(k, validNucleotides, canonical, onlyValidKmers,
+                cellBits);
+        for (int i = 0; i < numFiles; i++) {
+            kc.addSequenceFrequencies(
+                    KmerCounter::ReadSequence(fileNames[i], filter), 
+                    numThreads);
+        }
+        profile = kc.toProfile();
+    }
+    else {
+        long long capacity = 1;
+        for (int i = 0; i < numFiles; i++) {
+            ifstream input(fileNames[i], ios::binary | ios::ate);
+            if (!input)
+                throw ios_base::failure(string("Profile LearnShared(int k, "
+                        "const string& validNucleotides, bool canonical, bool "
+                        "onlyValidKmers, char* const fileNames[], int "
+                        "numFiles, int numThreads, int cellBits, bool "
+                        "dropSingletons, const SequenceFilter& filter): the "
+                        "file ") + 
+                        fileNames[i] + " cannot be opened");
+            capacity += input.tellg();
+        }
+        capacity = min(capacity, numKmers);
+        long long mapCapacity = capacity;
+        if (dropSingletons)
+            mapCapacity = capacity / 2 + 
+                    capacity * MAX_SINGLETON_FALSE_POSITIVES + 1;
+        ConcurrentKmerMap map(k, validNucleotides, mapCapacity, canonical,
+                onlyValidKmers);
+        if (dropSingletons)
+            map.filterSingletons(capacity);
+        for (int i = 0; i < numFiles; i++) {
+            map.addSequenceFrequencies(
+                    KmerCounter::ReadSequence(fileNames[i], filter), 
+                    numThreads);
+        }
+        profile = map.toProfile();
+        if (dropSingletons)
+            cout << "Singletons filtered with a Bloom filter (" 
+                 << map.getMemory() / 1048576.0 << " MB with the table): "
+                 << "a kmer that appears once is counted with probability "
+                 << map.getFalsePositiveRate() << endl;
+    }
+    profile.zip(false, dropSingletons ? 1 : 0);
+    profile.sort();
+
+    return profile;
+}
+
 /**
  * This program learns a Profile model from a set of input DNA files (file1.dna,
  * file2.dna, ...). The learned Profile object is then zipped (kmers with any 
@@ -46,14 +314,119 @@ void showEnglishHelp(ostream& outputStream) {
  * and ordered by frequency and saved in 
  * the file outputFilename (or output.prf if the output file is not provided).
  * 
+ * With the option -a, canonical kmers are counted (see class KmerCounter):
+ * each kmer is counted as the smaller one of itself and its reverse
+ * complement, so the Profile of a sequence is the same as the one of its
+ * reverse complement. The complementary nucleotides of "ACGT" are "TGCA",
+ * and the ones of "ACGU" are "UGCA".
+ * 
+ * With the option -x, only the kmers without missing nucleotides are 
+ * counted (see class KmerCounter): the kmers with invalid nucleotides are
+ * skipped instead of being counted with Kmer::MISSING_NUCLEOTIDE, so the 
+ * table of kmers has \f$4^k\f$ instead of \f$5^k\f$ elements for "ACGT".
+ * 
+ * With the option -f, the input files are read as (multi-)FASTA files and
+ * each record is learned as a separate Profile, whose identifier is the
+ * name of the record (the lines before the first name form a record named
+ * after the file, so a .dna file is a single record). The records are read
+ * in batches, and while the Profiles of a batch are learned by several
+ * threads, each one reusing its own KmerCounter, the next batch is read.
+ * The Profiles are saved in the order of the input files in a reference
+ * database (see BUILDDB) named outputFilename (or output.db), which is
+ * written while the records are learned. Records without any kmer are
+ * skipped. With the option -s, the sketches of all the records are saved
+ * in the file outputFilename.skt, as in BUILDDB -s.
+ * 
+ * With the option -E, the kmers are counted in external memory with a 
+ * DiskKmerCounter, for the values of k whose table of kmers does not fit
+ * in memory: the kmers of the input files are spilled to bucket files in
+ * the directory tmpDirectory, and then each bucket is counted in memory by
+ * one of numThreads threads. The memory used to count them (-M) and the 
+ * space of the temporary files (-L) can be limited. As with -x, only the 
+ * kmers without missing nucleotides are counted, and the Profile is the
+ * same as the one of -x.
+ * 
+ * With the option -S, the kmers of each input file are counted by 
+ * numThreads threads, which take consecutive pieces of its DNA, in a 
+ * single table shared by all of them (see LearnShared()): the matrix of a
+ * KmerCounter, updated with relaxed atomic increments, or a lock-free
+ * ConcurrentKmerMap for the values of k whose matrix is too large. So the
+ * memory does not depend on the number of threads, and the Profile is the
+ * same as without -S.
+ * 
+ * With the option -u, the kmers that appear only once in the input files
+ * (most of them sequencing errors in a set of reads) are dropped with -S:
+ * the first occurrence of each kmer is only inserted in a blocked 
+ * BloomFilter, so the hash table of the large values of k only holds the
+ * repeated kmers and takes about half the memory, and their frequencies
+ * are corrected with that first occurrence. A few singletons are counted
+ * with frequency 2 because of the false positives of the filter, whose
+ * rate is shown in the standard output. The matrix of the small values of
+ * k counts all the kmers and drops the singletons when it is zipped.
+ * 
+ * With the option -C, the kmers are counted approximately in a 
+ * CountMinSketch with sketchDepth rows of sketchWidth counters, whose 
+ * memory depends neither on k nor on the size of the input files, and the
+ * Profile has the topN kmers with the largest estimated frequencies. The
+ * estimations are never smaller than the real frequencies, and the bound 
+ * of their error and its probability are shown in the standard output.
+ * 
+ * With the option -g, the input files are read once with only topN 
+ * counters (see class SpaceSaving), which keep the most frequent kmers, so
+ * the Profile of a genome with a large k takes a few MB instead of the 
+ * memory of all its different kmers. The Profile has the topN kmers with 
+ * the largest estimated frequencies, and the bound of the error of the
+ * estimations and the number of kmers at the top of the Profile that are
+ * guaranteed to be the most frequent ones are shown in the standard output.
+ * 
+ * With the option -h, only a sample of the kmers of the input files is
+ * counted (see class SampledKmerCounter): the kmers whose hash value is in
+ * the smallest fraction 1/S of the hash values (FracMinHash), or the window
+ * minimizers of W consecutive kmers. The Profile is about S or (W + 1) / 2
+ * times smaller, so it is faster to learn with a large k and to compare,
+ * and the sampling is saved in its header (see Profile::getParameters()),
+ * so CLASSIFY only compares it with the profiles sampled in the same way.
+ * The number of sampled kmers is shown in the standard output.
+ * 
+ * With the option -G, the kmers are spaced (see KmerCounter::setSeed()):
+ * each one has the nucleotides at the positions of the 1 of the seed in a
+ * window of its length, so a substitution at the positions of the 0 does 
+ * not change it, and diverged strains share more kmers than with the 
+ * contiguous kmers of the same k. The seed is saved in the header of the 
+ * Profile (see Profile::getParameters()), so CLASSIFY counts the kmers of
+ * its input file with the same seed.
+ * 
+ * With the option -D, the regions of low complexity of the input files, 
+ * like the runs of poly-A or the microsatellites, are masked before their
+ * kmers are counted (see class SequenceFilter): the windows of 
+ * SequenceFilter::DUST_WINDOW nucleotides whose DUST score is greater than
+ * dustLevel are replaced with Kmer::MISSING_NUCLEOTIDE, so kmers like AAAAA
+ * and TTTTT do not lead the Profile of a genome. The kmers with masked
+ * nucleotides are skipped with -x, or counted as kmers with missing
+ * nucleotides otherwise. The same level should be used in CLASSIFY -D. 
+ * This is not checked.
+ * 
+ * With the option -W, the counters of the matrix of kmers (without -E, or
+ * with -S for the small values of k) have cellBits bits (see class
+ * CounterTable). The counters of 8 or 16 bits take 4 or 2 times less
+ * memory than the ones of 32 bits, and the frequencies that do not fit in
+ * them are promoted to an overflow map, so the Profile is always the same.
+ * 
+ * With the option -P, the counters of the matrix of kmers (without -E, -S,
+ * -C, -g or -h) are increased by partitions of the matrix (see 
+ * KmerCounter::setPartitioned()) instead of in the order of the kmers with
+ * prefetches. The Profile is the same. It is not the default, since which
+ * engine is faster for the matrices larger than the cache depends on the
+ * machine: BENCHCOUNT measures both of them.
+ * 
  * Running sintax:
- * > LEARN [-t|-b] [-k kValue] [-n nucleotidesSet] [-p profileId] [-o outputFilename] <file1.dna> [<file2.dna> <file3.dna> ....]
+ * > LEARN [-t|-b] [-a] [-x] [-k kValue] [-n nucleotidesSet] [-p profileId] [-o outputFilename] [-s sketchSize] [-f [-j numThreads]] [-E tmpDirectory [-M memoryMB] [-L diskMB] [-j numThreads]] [-S [-j numThreads] [-u]] [-C topN [-y sketchWidth] [-z sketchDepth]] [-g topN] [-h sampling] [-G seed] [-D dustLevel] [-W cellBits] [-P] <file1.dna> [<file2.dna> <file3.dna> ....]
  * 
  * Running example:
  * > LEARN -k 2 -p bug -o /tmp/unknownACGT.prf ../Genomes/unknownACGT.dna
  * 
  * > cat /tmp/unknownACGT.prf
-MP-KMER-T-1.0
+MP-KMER-S-1.0
 bug
 7
 GG 2
@@ -63,6 +436,30 @@ AT 1
 CC 1
 GA 1
 TA 1
+ * 
+ * > LEARN -f -j 8 -o /tmp/contigs.db assembly.fasta
+ * 
+ * > LEARN -k 31 -E /scratch -M 4096 -L 200000 -j 16 -o /tmp/reads.prf reads.dna
+ * 
+ * > LEARN -k 14 -S -j 64 -o /tmp/human.prf human.dna
+ * 
+ * > LEARN -k 25 -x -S -u -j 16 -o /tmp/reads.prf reads.dna
+ * 
+ * > LEARN -k 12 -x -W 8 -o /tmp/reads.prf reads.dna
+ * 
+ * > LEARN -k 12 -x -P -o /tmp/genome.prf genome.dna
+ * 
+ * > LEARN -k 25 -x -C 1000 -y 16777216 -z 4 -o /tmp/top.prf reads.dna
+ * 
+ * > LEARN -k 21 -x -g 100000 -o /tmp/genome.prf genome.dna
+ * 
+ * > LEARN -k 21 -x -h fracminhash=1000 -o /tmp/genome.prf genome.dna
+ * 
+ * > LEARN -k 9 -x -G 1101101100111 -o /tmp/strain.prf strain.dna
+ * 
+ * > LEARN -k 5 -x -D 20 -p "homo sapiens" -o /tmp/human_chr6.prf human_chr6.dna
+ * 
+ * > LEARN -a -p bug -o /tmp/unknownACGT_canonical.prf ../Genomes/unknownACGT.dna
  * 
  * @param argc The number of command line parameters
  * @param argv The vector of command line parameters (cstrings)
@@ -80,7 +477,26 @@ int main(int argc, char *argv[]) {
     int k = 5;
     string n = KmerCounter::DEFAULT_VALID_NUCLEOTIDES;
     string p = "unknown";
-    string o = "output.prf";
+    string o = "";
+    int s = 0;
+    bool f = false;
+    int j = thread::hardware_concurrency();
+    bool a = false;
+    bool x = false;
+    string e = "";
+    long long m = -1; // -1 until given, so that it can only be given with -E
+    long long d = -1;
+    bool c = false;
+    bool u = false;
+    int w = -1;
+    bool partitioned = false;
+    int q = 0;
+    int y = -1;
+    int z = -1;
+    int g = 0;
+    string h = "";
+    string l = "";
+    int dust = 0;
     
     bool sigo = true;
     int i = 1;
@@ -94,6 +510,14 @@ int main(int argc, char *argv[]) {
                 tb = 't';
                 i++;
             }
+            else if (string(argv[i]) == "-a") {
+                a = true;
+                i++;
+            }
+            else if (string(argv[i]) == "-x") {
+                x = true;
+                i++;
+            }
             else if (string(argv[i]) == "-k") {
                 k = stoi(argv[i+1]);
                 i += 2;
@@ -110,6 +534,74 @@ int main(int argc, char *argv[]) {
                 o = argv[i+1];
                 i += 2;
             }
+            else if (string(argv[i]) == "-s") {
+                s = stoi(argv[i+1]);
+                i += 2;
+            }
+            else if (string(argv[i]) == "-f") {
+                f = true;
+                i++;
+            }
+            else if (string(argv[i]) == "-j") {
+                j = stoi(argv[i+1]);
+                i += 2;
+            }
+            else if (string(argv[i]) == "-S") {
+                c = true;
+                i++;
+            }
+            else if (string(argv[i]) == "-u") {
+                u = true;
+                i++;
+            }
+            else if (string(argv[i]) == "-C") {
+                q = stoi(argv[i+1]);
+                i += 2;
+            }
+            else if (string(argv[i]) == "-y") {
+                y = stoi(argv[i+1]);
+                i += 2;
+            }
+            else if (string(argv[i]) == "-z") {
+                z = stoi(argv[i+1]);
+                i += 2;
+            }
+            else if (string(argv[i]) == "-g") {
+                g = stoi(argv[i+1]);
+                i += 2;
+            }
+            else if (string(argv[i]) == "-h") {
+                h = argv[i+1];
+                i += 2;
+            }
+            else if (string(argv[i]) == "-G") {
+                l = argv[i+1];
+                i += 2;
+            }
+            else if (string(argv[i]) == "-D") {
+                dust = stoi(argv[i+1]);
+                i += 2;
+            }
+            else if (string(argv[i]) == "-W") {
+                w = stoi(argv[i+1]);
+                i += 2;
+            }
+            else if (string(argv[i]) == "-P") {
+                partitioned = true;
+                i++;
+            }
+            else if (string(argv[i]) == "-E") {
+                e = argv[i+1];
+                i += 2;
+            }
+            else if (string(argv[i]) == "-M") {
+                m = stoll(argv[i+1]);
+                i += 2;
+            }
+            else if (string(argv[i]) == "-L") {
+                d = stoll(argv[i+1]);
+                i += 2;
+            }
             else {
                 showEnglishHelp(cerr);
                 return 1;
@@ -123,32 +615,295 @@ int main(int argc, char *argv[]) {
     num_args = argc - i;
     first_arg = i;
     
-    if (string(argv[argc-1]).at(0)== '-' || string(argv[argc-2]).at(0) == '-') {
+    // The last argument is a file, and not the value of an option
+    string last_option = argv[argc-2];
+    bool valid_files = string(argv[argc-1]).at(0) != '-' && 
+            (last_option.at(0) != '-' || last_option == "-f" || 
+            last_option == "-a" || last_option == "-x" || 
+            last_option == "-S" || last_option == "-u" || 
+            last_option == "-P");
+    // At most one way of counting the kmers: -f, -E, -S, -C, -g, -h or -G
+    int num_modes = f + (e != "") + c + (q != 0) + (g != 0) + (h != "") +
+            (l != "");
+    bool valid_modes = num_modes <= 1;
+    // Each option of a mode is only given with the mode
+    bool valid_disk = e != "" || (m < 0 && d < 0);
+    bool valid_shared = c || !u;
+    bool valid_sketch = q >= 0 && (q != 0 || (y < 0 && z < 0));
+    bool valid_space_saving = g >= 0;
+    // The filter, the cells and the partitions of the table are not used by
+    //    every mode
+    bool valid_filter = dust == 0 || e == "";
+    bool valid_cells = w < 0 || ((w == 8 || w == 16 || w == 32) && 
+            e == "" && q == 0 && g == 0 && h == "");
+    bool valid_partitioned = !partitioned || (e == "" && !c && q == 0 && 
+            g == 0 && h == "");
+    if (!valid_files || !valid_modes || !valid_disk || !valid_shared ||
+            !valid_sketch || !valid_space_saving || !valid_filter || 
+            !valid_cells || !valid_partitioned) {
         showEnglishHelp(cerr);
         return 1;
     }
+    if (m < 0)
+        m = DiskKmerCounter::DEFAULT_MEMORY_LIMIT / (1 << 20);
+    if (d < 0)
+        d = 0;
+    if (w < 0)
+        w = CounterTable::DEFAULT_CELL_BITS;
+    if (y < 0)
+        y = CountMinSketch::DEFAULT_WIDTH;
+    if (z < 0)
+        z = CountMinSketch::DEFAULT_DEPTH;
+    if (o == "")
+        o = f ? "output.db" : "output.prf";
+    if (j <= 0)
+        j = 1;
+    SequenceFilter filter;
+    try {
+        filter = SequenceFilter(0, dust);
+    }
+    catch (exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+    if (a) {
+        try {
+            KmerCounter::GetComplementaryNucleotides(n);
+        }
+        catch (exception& e) {
+            cerr << e.what() << endl;
+            return 1;
+        }
+    }
     
-    // Loop to calculate the kmer frecuencies of the input genome files using 
-    // a KmerCounter object
-    KmerCounter kc(k, n);
-    KmerCounter aux (k,n);
-    for (int j = 0; j < num_args; j++) {
-        aux.calculateFrequencies(argv[j + first_arg]);
-        kc += aux;
+    if (f) {
+        // Two batches: one is learned while the other one is read
+        string* names[2] = {new string[RECORDS_PER_BATCH],
+                new string[RECORDS_PER_BATCH]};
+        string* sequences[2] = {new string[RECORDS_PER_BATCH],
+                new string[RECORDS_PER_BATCH]};
+        Profile* profiles = new Profile[RECORDS_PER_BATCH];
+        KmerCounter* counters = new KmerCounter[j];
+        for (int t = 0; t < j; t++) {
+            counters[t] = KmerCounter(k, n, a, x, w);
+            counters[t].setPartitioned(partitioned);
+        }
+        vector<Sketch> sketches;
+        int status = 0;
+        ProfileDatabase database;
+        
+        try {
+            FastaReader reader;
+            int file = 0;
+            reader.open(argv[first_arg]);
+            database.create(o.c_str());
+            
+            int current = 0;
+            int num_records = ReadBatch(reader, argv + first_arg, num_args,
+                    file, names[current], sequences[current]);
+            while (num_records > 0) {
+                exception_ptr learnError = nullptr;
+                thread learner([&]() {
+                    try {
+                        LearnBatch(names[current], sequences[current], 
+                                num_records, counters, j, filter, profiles);
+                    }
+                    catch (...) {
+                        learnError = current_exception();
+                    }
+                });
+                int num_next = 0;
+                string error = "";
+                try {
+                    num_next = ReadBatch(reader, argv + first_arg, num_args,
+                            file, names[1 - current], sequences[1 - current]);
+                }
+                catch (exception& e) {
+                    error = e.what();
+                }
+                learner.join();
+                if (learnError != nullptr)
+                    rethrow_exception(learnError);
+                
+                // Save the Profiles in the order of the input files
+                for (int r = 0; r < num_records; r++) {
+                    if (profiles[r].getSize() == 0) {
+                        cerr << "The record " << names[current][r] 
+                             << " has not any kmer and it is skipped" << endl;
+                        continue;
+                    }
+                    database.append(profiles[r], n);
+                    if (s > 0) {
+                        sketches.push_back(Sketch(s));
+                        sketches.back().build(profiles[r]);
+                    }
+                }
+                
+                if (error != "")
+                    throw ios_base::failure(error);
+                current = 1 - current;
+                num_records = num_next;
+            }
+            database.close();
+            
+            if (s > 0) {
+                Sketch::Save((o + ".skt").c_str(), sketches.data(), 
+                        sketches.size());
+            }
+        }
+        catch (exception& e) {
+            // The records learned before the error are not left as a 
+            //    database that looks complete
+            database.discard();
+            cerr << e.what() << endl;
+            status = 1;
+        }
+        
+        for (int b = 0; b < 2; b++) {
+            delete[] names[b];
+            delete[] sequences[b];
+        }
+        delete[] profiles;
+        delete[] counters;
+        
+        return status;
     }
     
-    // Obtain a Profile object from the KmerCounter object
-    Profile prf = kc.toProfile();
+    // Learn the zipped and sorted Profile with a KmerCounterT specialized for
+    //    k, if there is one for k and n, in external memory with -E, or in a
+    //    table shared by several threads with -S, approximately with -C
+    //    and -g, or only a sample of them with -h
+    Profile prf;
+    if (e != "") {
+        try {
+            DiskKmerCounter counter(k, n, a);
+            counter.setTemporaryDirectory(e);
+            counter.setMemoryLimit(m << 20);
+            counter.setDiskLimit(d << 20);
+            counter.setNumThreads(j);
+            prf = counter.count(argv + first_arg, num_args);
+        }
+        catch (exception& e) {
+            cerr << e.what() << endl;
+            return 1;
+        }
+    }
+    else if (c) {
+        try {
+            prf = LearnShared(k, n, a, x, argv + first_arg, num_args, j, w, u,
+                    filter);
+        }
+        catch (exception& e) {
+            cerr << e.what() << endl;
+            return 1;
+        }
+    }
+    else if (q > 0) {
+        try {
+            CountMinSketch sketch(k, n, q, y, z, a, x);
+            for (int j = 0; j < num_args; j++) {
+                sketch.addSequenceFrequencies(
+                        KmerCounter::ReadSequence(argv[j + first_arg], filter));
+            }
+            prf = sketch.toProfile();
+            cout << "Count-Min sketch of " << sketch.getDepth() << " x " 
+                 << sketch.getWidth() << " counters (" 
+                 << sketch.getMemory() / 1048576.0 << " MB): " 
+                 << sketch.getNumKmers() << " kmers counted. Each frequency "
+                 << "exceeds the real one by at most " 
+                 << sketch.getErrorBound() << " with probability " 
+                 << sketch.getConfidence() << endl;
+        }
+        catch (exception& e) {
+            cerr << e.what() << endl;
+            return 1;
+        }
+    }
+    else if (g > 0) {
+        try {
+            SpaceSaving counters(k, n, g, a, x);
+            for (int j = 0; j < num_args; j++) {
+                counters.addSequenceFrequencies(
+                        KmerCounter::ReadSequence(argv[j + first_arg], filter));
+            }
+            prf = counters.toProfile();
+            cout << "Space-Saving with " << counters.getNumCounters() 
+                 << " counters (" << counters.getMemory() / 1048576.0 
+                 << " MB): " << counters.getNumKmers() << " kmers counted. "
+                 << "Each frequency exceeds the real one by at most " 
+                 << counters.getErrorBound() << ", and the first " 
+                 << counters.getNumGuaranteed() << " kmers are the most "
+                 << "frequent ones" << endl;
+        }
+        catch (exception& e) {
+            cerr << e.what() << endl;
+            return 1;
+        }
+    }
+    else if (h != "") {
+        try {
+            SampledKmerCounter counter(k, n, h, a, x);
+            for (int j = 0; j < num_args; j++) {
+                counter.addSequenceFrequencies(
+                        KmerCounter::ReadSequence(argv[j + first_arg], filter));
+            }
+            prf = counter.toProfile();
+            prf.zip();
+            prf.sort();
+            cout << "Sampling " << counter.getSampling() << ": " 
+                 << counter.getSize() << " different kmers sampled from "
+                 << counter.getNumKmers() << " kmers" << endl;
+        }
+        catch (exception& e) {
+            cerr << e.what() << endl;
+            return 1;
+        }
+    }
+    else if (a || x || l != "" || filter.isEnabled() ||
+            !LearnSortedProfile(k, n, argv + first_arg, num_args, prf, w, 
+            partitioned)) {
+        // Loop to calculate the kmer frecuencies of the input genome files 
+        // using a KmerCounter object
+        KmerCounter kc(k, n, a, x, w);
+        KmerCounter aux (k, n, a, x, w);
+        try {
+            kc.setSeed(l);
+            aux.setSeed(l);
+            aux.setPartitioned(partitioned);
+        }
+        catch (exception& e) {
+            cerr << e.what() << endl;
+            return 1;
+        }
+        for (int j = 0; j < num_args; j++) {
+            if (filter.isEnabled())
+                aux.calculateSequenceFrequencies(
+                        KmerCounter::ReadSequence(argv[j + first_arg], filter));
+            else
+                aux.calculateFrequencies(argv[j + first_arg]);
+            kc += aux;
+        }
+
+        // Obtain a Profile object from the KmerCounter object
+        prf = kc.toProfile();
+
+        // Zip the Profile object
+        prf.zip();
+
+        // Sort the Profile object
+        prf.sort();
+    }
     prf.setProfileId(p);
     
-    // Zip the Profile object
-    prf.zip();
-    
-    // Sort the Profile object
-    prf.sort();
-    
     // Save the Profile object in the output file
-    prf.save((char*)&o, tb);
+    prf.save(o.c_str(), tb);
+    
+    // Save the sketch of the Profile object
+    if (s > 0) {
+        Sketch sketch(s);
+        sketch.build(prf);
+        Sketch::Save((o + ".skt").c_str(), &sketch, 1);
+    }
     
     return 0;
 }
@@ -0,0 +1,101 @@
+/*
+ * Metodología de la Programación: Kmer5
+ * Curso 2023/2024
+ */
+
+/**
+ * @file NucleotideTable.cpp
+ */
+
+#include <cctype>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "Kmer.h"
+#include "NucleotideTable.h"
+
+using namespace std;
+
+NucleotideTable::NucleotideTable(const std::string& validNucleotides) {
+    string allNucleotides = Kmer::MISSING_NUCLEOTIDE + validNucleotides;
+
+    // The same classification as Kmer::normalize(): first to uppercase,
+    //    then the position of the first occurrence in allNucleotides
+    for (int c = 0; c < 256; c++) {
+        int code = allNucleotides.find(toupper(c));
+        if (code < 0)
+            code = 0;
+        _codes[c] = code;
+        _nucleotides[c] = allNucleotides[code];
+    }
+
+    // The characters of the uppercase blocks that have a code greater
+    //    than 0 (each one appears once, as it is its own uppercase)
+    _numSimdNucleotides = 0;
+    for (size_t code = 1; code < allNucleotides.size(); code++) {
+        unsigned char nucleotide = allNucleotides[code];
+        if (_codes[nucleotide] == code && toupper(nucleotide) == nucleotide) {
+            if (_numSimdNucleotides == MAX_SIMD_NUCLEOTIDES) {
+                _numSimdNucleotides = 0;
+                break;
+            }
+            _simdNucleotides[_numSimdNucleotides] = nucleotide;
+            _simdCodes[_numSimdNucleotides] = code;
+            _numSimdNucleotides++;
+        }
+    }
+}
+
+void NucleotideTable::translate(const char text[], int length,
+        unsigned char codes[]) const {
+    int i = 0;
+#ifdef __SSE2__
+    if (_numSimdNucleotides > 0) {
+        const __m128i beforeA = _mm_set1_epi8('a' - 1);
+        const __m128i afterZ = _mm_set1_epi8('z' + 1);
+        const __m128i toUpper = _mm_set1_epi8('a' - 'A');
+        for (; i + 16 <= length; i += 16) {
+            __m128i block = _mm_loadu_si128((const __m128i*)(text + i));
+
+            // Lowercase letters to uppercase (the bytes greater than 127
+            //    are negative, so they are not changed)
+            __m128i lower = _mm_and_si128(_mm_cmpgt_epi8(block, beforeA),
+                    _mm_cmplt_epi8(block, afterZ));
+            block = _mm_sub_epi8(block, _mm_and_si128(lower, toUpper));
+
+            __m128i result = _mm_setzero_si128();
+            for (int n = 0; n < _numSimdNucleotides; n++) {
+                __m128i found = _mm_cmpeq_epi8(block,
+                        _mm_set1_epi8(_simdNucleotides[n]));
+                result = _mm_or_si128(result, _mm_and_si128(found,
+                        _mm_set1_epi8(_simdCodes[n])));
+            }
+            _mm_storeu_si128((__m128i*)(codes + i), result);
+        }
+    }
+#endif
+    for (; i < length; i++) {
+        codes[i] = _codes[(unsigned char)text[i]];
+    }
+}
+
+int NucleotideTable::FindValid(const unsigned char codes[], int from, 
+        int length) {
+    int i = from;
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= length; i += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i*)(codes + i));
+        int invalid = _mm_movemask_epi8(_mm_cmpeq_epi8(block, zero));
+        if (invalid != 0xFFFF)
+            return i + __builtin_ctz(~invalid);
+    }
+#endif
+    while (i < length && codes[i] == 0) {
+        i++;
+    }
+    
+    return i;
+}
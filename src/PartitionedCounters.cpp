@@ -0,0 +1,72 @@
+/*
+ * Metodología de la Programación: Kmer5
+ * Curso 2023/2024
+ */
+
+/**
+ * @file PartitionedCounters.cpp
+ */
+
+#include "PartitionedCounters.h"
+
+using namespace std;
+
+const int PartitionedCounters::PARTITION_BITS;
+
+const int PartitionedCounters::PARTITION_SIZE;
+
+/**
+ * Total number of increments that the buffers of the partitions can keep
+ * (4 MB of int)
+ */
+static const int BUFFERED_INCREMENTS = 1 << 20;
+
+/**
+ * Minimum number of increments of the buffer of a partition
+ */
+static const int MIN_PARTITION_BUFFER = 256;
+
+PartitionedCounters::PartitionedCounters(CounterTable& counters): 
+        _counters(counters) {
+    _numPartitions = (_counters.getNumCells() - 1) / PARTITION_SIZE + 1;
+    _capacity = BUFFERED_INCREMENTS / _numPartitions;
+    if (_capacity < MIN_PARTITION_BUFFER)
+        _capacity = MIN_PARTITION_BUFFER;
+    _offsets = new int[(long long) _numPartitions * _capacity];
+    _sizes = new int[_numPartitions];
+    for (int p = 0; p < _numPartitions; p++) {
+        _sizes[p] = 0;
+    }
+}
+
+PartitionedCounters::~PartitionedCounters() {
+    delete[] _offsets;
+    delete[] _sizes;
+}
+
+int PartitionedCounters::getNumPartitions() const {
+    return _numPartitions;
+}
+
+void PartitionedCounters::increase(const int cells[], int numCells) {
+    for (int i = 0; i < numCells; i++) {
+        int partition = cells[i] >> PARTITION_BITS;
+        _offsets[(long long) partition * _capacity + _sizes[partition]] =
+                cells[i];
+        if (++_sizes[partition] == _capacity)
+            flush(partition);
+    }
+}
+
+void PartitionedCounters::flush() {
+    for (int p = 0; p < _numPartitions; p++) {
+        flush(p);
+    }
+}
+
+void PartitionedCounters::flush(int partition) {
+    // The counters of a partition are close, so they are not prefetched
+    _counters.increase(_offsets + (long long) partition * _capacity, 
+            _sizes[partition], 0);
+    _sizes[partition] = 0;
+}
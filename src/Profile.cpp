@@ -14,12 +14,39 @@
  */
 
 #include "Profile.h"
+#include "NucleotideTable.h"
+#include <algorithm>
 #include <fstream>
+#include <unordered_set>
 
 using namespace std;
 
 const string Profile::MAGIC_STRING_T="MP-KMER-T-1.0";
 const string Profile::MAGIC_STRING_B="MP-KMER-B-1.0";
+const string Profile::MAGIC_STRING_TP="MP-KMER-T-1.1";
+const string Profile::MAGIC_STRING_BP="MP-KMER-B-1.1";
+
+/**
+ * Merges the repeated kmers of a profile read from a file. The kmers of a
+ * saved profile are unique, so append() and its search of each kmer are only
+ * used when a repeated one is found
+ * @param profile The profile read. Input/Output parameter
+ */
+static void MergeRepeatedKmers(Profile& profile) {
+    unordered_set<string> kmers;
+    kmers.reserve(profile.getSize());
+    for (int i = 0; i < profile.getSize(); i++) {
+        if (!kmers.insert(profile[i].getKmer().toString()).second) {
+            Profile merged;
+            merged.setProfileId(profile.getProfileId());
+            for (int j = 0; j < profile.getSize(); j++) {
+                merged.append(profile[j]);
+            }
+            profile = merged;
+            return;
+        }
+    }
+}
 
 Profile::Profile(): _profileId("unknown"), _size(0),
     _capacity(INITIAL_CAPACITY){
@@ -39,6 +66,7 @@ Profile::Profile(int size) {
 
 Profile::Profile(const Profile& orig) {
     _profileId = orig._profileId;
+    _parameters = orig._parameters;
     _size = orig._size;
     _capacity = orig._capacity;
     _vectorKmerFreq = new KmerFreq[_capacity];
@@ -58,6 +86,7 @@ Profile& Profile::operator=(const Profile& orig) {
     if (this != &orig) {
         deallocate();
         _profileId = orig._profileId;
+        _parameters = orig._parameters;
         _size = orig._size;
         _capacity = orig._capacity;
         _vectorKmerFreq = new KmerFreq[_capacity];
@@ -77,6 +106,14 @@ void Profile::setProfileId(const std::string& id) {
     _profileId = id;
 }
 
+const string& Profile::getParameters() const {
+    return _parameters;
+}
+
+void Profile::setParameters(const std::string& parameters) {
+    _parameters = parameters;
+}
+
 const KmerFreq& Profile::at(int index) const {
     if (index < 0 || index >= _size)
         throw out_of_range(string("const KmerFreq& Profile::at(int index) "
@@ -118,11 +155,34 @@ double Profile::getDistance(const Profile& otherProfile) const {
         distance += abs(i - rank_2);
     }
     
-    distance /= _size*otherProfile._size;
+    distance /= (double)_size*otherProfile._size;
     
     return distance;
 }
 
+double Profile::getDistanceBounded(const Profile& otherProfile, 
+        double cutoff) const {
+    if (otherProfile._size <= 0 || _size <= 0)
+        throw invalid_argument(string("double Profile::getDistanceBounded("
+                "const Profile& otherProfile, double cutoff) const: one of "
+                "the Profiles (or both) is empty"));
+    
+    double denominator = (double)_size*otherProfile._size;
+    double bound = cutoff * denominator;
+    double distance = 0;
+    
+    for (int i = 0; i < _size && distance <= bound; i++) {
+        int rank_2 = otherProfile.findKmer(_vectorKmerFreq[i].getKmer());
+        
+        if (rank_2 == -1)
+            rank_2 = otherProfile._size;
+        
+        distance += abs(i - rank_2);
+    }
+    
+    return distance / denominator;
+}
+
 int Profile::findKmer(const Kmer& kmer, int initialPos, int finalPos) const {
     int pos_kmer = -1;
     int i = initialPos;
@@ -154,18 +214,12 @@ string Profile::toString() const {
 }
 
 void Profile::sort() {
-    for (int i = 0; i < _size; i++) {
-        int pos_max = i;
-        for (int j = i + 1; j < _size; j++) {
-            if (_vectorKmerFreq[j] > _vectorKmerFreq[pos_max]) {
-                pos_max = j;
-            }
-        }
-        
-        KmerFreq temp = _vectorKmerFreq[i];
-        _vectorKmerFreq[i] = _vectorKmerFreq[pos_max];
-        _vectorKmerFreq[pos_max] = temp;
-    }
+    // operator> is a strict total order for the kmers of a Profile, so the
+    //    result is the same as the one of a selection sort
+    std::sort(_vectorKmerFreq, _vectorKmerFreq + _size, 
+            [](const KmerFreq& a, const KmerFreq& b) {
+                return a > b;
+            });
 }
 
 void Profile::save(const char fileName[], char mode) const {
@@ -174,11 +228,17 @@ void Profile::save(const char fileName[], char mode) const {
     
     if (output) {
         if (mode == 't') {
-            output << MAGIC_STRING_T << endl;
+            if (_parameters == "")
+                output << MAGIC_STRING_T << endl;
+            else
+                output << MAGIC_STRING_TP << endl << _parameters << endl;
             output << *this;
         }
         else if (mode == 'b') {
-            output << MAGIC_STRING_B << endl;
+            if (_parameters == "")
+                output << MAGIC_STRING_B << endl;
+            else
+                output << MAGIC_STRING_BP << endl << _parameters << endl;
             output << _profileId << endl;
             output << _size << endl;
             
@@ -224,6 +284,12 @@ void Profile::load(const char fileName[]) {
     string magic_string;
     input >> magic_string;
     input.get();
+    string parameters = "";
+    if (magic_string == MAGIC_STRING_TP || magic_string == MAGIC_STRING_BP) {
+        getline(input, parameters);
+        magic_string = magic_string == MAGIC_STRING_TP ? MAGIC_STRING_T :
+                MAGIC_STRING_B;
+    }
 
     if (magic_string == MAGIC_STRING_T) {
         input >> *this;
@@ -233,15 +299,15 @@ void Profile::load(const char fileName[]) {
         string id;
         int size;
         getline(input,id);
-        _profileId = id;
         input >> size;
-        allocate(size);
-        KmerFreq kf;
+        Profile read(size);
+        read.setProfileId(id);
 
         for (int i = 0; i < size; i++) {
-            kf.read(input);
-            append(kf);
+            read[i].read(input);
         }
+        MergeRepeatedKmers(read);
+        *this = read;
     }
     else {
         input.close();
@@ -249,14 +315,42 @@ void Profile::load(const char fileName[]) {
                 "fileName): an invalid magic string has been found in "
                 "the given file"));
     }
+    // Set after operator>>, which resets the profile
+    _parameters = parameters;
 
     input.close(); 
 }
 
+string Profile::LoadParameters(const char fileName[]) {
+    ifstream input;
+    input.open(fileName);
+    
+    if (!input) {
+        throw ios_base::failure(string("std::string Profile::LoadParameters("
+                "const char fileName[]): the given file cannot be opened\n"));
+    }
+    
+    string magic_string;
+    string parameters;
+    input >> magic_string;
+    input.get();
+    if (magic_string == MAGIC_STRING_TP || magic_string == MAGIC_STRING_BP)
+        getline(input, parameters);
+    else if (magic_string != MAGIC_STRING_T && magic_string != MAGIC_STRING_B) {
+        input.close();
+        throw invalid_argument(string("std::string Profile::LoadParameters("
+                "const char fileName[]): an invalid magic string has been "
+                "found in the given file"));
+    }
+    input.close();
+    
+    return parameters;
+}
+
 void Profile::append(const KmerFreq& kmerFreq) {  
     int pos_kmer = findKmer(kmerFreq.getKmer());
     if (pos_kmer != -1) {
-        int freq = kmerFreq.getFrequency() + 
+        long long freq = kmerFreq.getFrequency() + 
                    _vectorKmerFreq[pos_kmer].getFrequency();
         _vectorKmerFreq[pos_kmer].setFrequency(freq);
     }
@@ -271,11 +365,14 @@ void Profile::append(const KmerFreq& kmerFreq) {
 }
 
 void Profile::normalize(const string& validNucleotides) {
+    // The table of the valid nucleotides is built once for all the kmers
+    NucleotideTable table(validNucleotides);
+    
     // Loop to traverse and normalize each one of the kmers in array
     for (int i = 0; i < _size; i++) {
         // Normalize kmer i
         Kmer aux = _vectorKmerFreq[i].getKmer();
-        aux.normalize(validNucleotides);
+        aux.normalize(table);
         _vectorKmerFreq[i].setKmer(aux);
     }
     
@@ -283,7 +380,7 @@ void Profile::normalize(const string& validNucleotides) {
     while (i < _size) {
         int pos = findKmer(_vectorKmerFreq[i].getKmer(), 0, i - 1);
         if (pos != -1) {
-            int freq = _vectorKmerFreq[i].getFrequency() + 
+            long long freq = _vectorKmerFreq[i].getFrequency() + 
                     _vectorKmerFreq[pos].getFrequency();
             _vectorKmerFreq[pos].setFrequency(freq);
             deletePos(i);
@@ -376,27 +473,28 @@ std::ostream& operator<<(std::ostream& os, const Profile& profile) {
 }
 
 std::istream& operator>>(std::istream& is, Profile& profile) {
-    profile.~Profile();
+    profile = Profile();
     string id;
     int size;
-    is >> id >> size;
+    getline(is >> ws, id);
+    is >> size;
     if (size < 0) {
         throw out_of_range(string("std::istream& operator>>(std::istream& is, "
                 "Profile& profile): the size given must be positive"));
     }
     
-    profile.setProfileId(id);
+    Profile read(size);
+    read.setProfileId(id);
     
     for (int i = 0; i < size; i++) {
-        KmerFreq kf;
         string kmer;
-        int freq;
+        long long freq;
         is >> kmer >> freq;
-        Kmer k(kmer);
-        kf.setKmer(k);
-        kf.setFrequency(freq);
-        profile.append(kf);
+        read[i].setKmer(Kmer(kmer));
+        read[i].setFrequency(freq);
     }
+    MergeRepeatedKmers(read);
+    profile = read;
     
     return is;
 }
\ No newline at end of file
@@ -0,0 +1,374 @@
+/*
+ * Metodología de la Programación: Kmer5
+ * Curso 2023/2024
+ */
+
+/**
+ * @file ProfileDatabase.cpp
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "ProfileDatabase.h"
+
+using namespace std;
+
+const string ProfileDatabase::MAGIC_STRING="MP-KMER-DB-1.1";
+
+/**
+ * Minimum number of bytes of an entry of the offset table: the lengths of
+ * its two strings, k, the number of kmers and the offset
+ */
+static const int ENTRY_MIN_SIZE = 4 * sizeof(int32_t) + sizeof(int64_t);
+
+/**
+ * @brief Writes the bytes of the given integer in binary format
+ * @param output The output stream. Output parameter
+ * @param value The integer to write. Input parameter
+ */
+static void WriteInt32(ostream& output, int32_t value) {
+    output.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+/**
+ * @brief Writes the bytes of the given integer in binary format
+ * @param output The output stream. Output parameter
+ * @param value The integer to write. Input parameter
+ */
+static void WriteInt64(ostream& output, int64_t value) {
+    output.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+/**
+ * @brief Writes the length of the given string (a 32 bits int) and then its
+ * characters
+ * @param output The output stream. Output parameter
+ * @param text The string to write. Input parameter
+ */
+static void WriteString(ostream& output, const string& text) {
+    WriteInt32(output, text.length());
+    output.write(text.data(), text.length());
+}
+
+/**
+ * @brief Reads an integer in binary format
+ * @param input The input stream. Output parameter
+ * @return The integer read
+ */
+static int32_t ReadInt32(istream& input) {
+    int32_t value = 0;
+    input.read(reinterpret_cast<char*>(&value), sizeof(value));
+    return value;
+}
+
+/**
+ * @brief Reads an integer in binary format
+ * @param input The input stream. Output parameter
+ * @return The integer read
+ */
+static int64_t ReadInt64(istream& input) {
+    int64_t value = 0;
+    input.read(reinterpret_cast<char*>(&value), sizeof(value));
+    return value;
+}
+
+/**
+ * @brief Reads a string written with WriteString(). If its length is not
+ * valid, the failbit of the stream is set
+ * @param input The input stream. Output parameter
+ * @param end The position of the end of the stream. Input parameter
+ * @return The string read
+ */
+static string ReadString(istream& input, int64_t end) {
+    int32_t length = ReadInt32(input);
+    if (!input)
+        return string();
+    if (length < 0 || length > end - (int64_t) input.tellg()) {
+        input.setstate(ios::failbit);
+        return string();
+    }
+
+    string text(length, ' ');
+    input.read(&text[0], length);
+    return text;
+}
+
+ProfileDatabase::ProfileDatabase(): _entries(nullptr), _size(0),
+    _capacity(0) {}
+
+ProfileDatabase::~ProfileDatabase() {
+    // A database being written that has not been closed is incomplete
+    if (_output.is_open()) {
+        discard();
+        return;
+    }
+    try {
+        close();
+    }
+    catch (exception& e) {
+        // A destructor cannot throw
+    }
+}
+
+void ProfileDatabase::open(const char fileName[]) {
+    close();
+    _input.open(fileName, ios::in | ios::binary);
+
+    if (!_input) {
+        throw ios_base::failure(string("void ProfileDatabase::open(const "
+                "char fileName[]): the given file cannot be opened\n"));
+    }
+
+    string magic_string;
+    getline(_input, magic_string);
+    if (magic_string != MAGIC_STRING) {
+        _input.close();
+        throw invalid_argument(string("void ProfileDatabase::open(const "
+                "char fileName[]): an invalid magic string has been found in "
+                "the given file"));
+    }
+
+    int size = ReadInt32(_input);
+    int64_t tableOffset = ReadInt64(_input);
+    int64_t payloadOffset = _input.tellg();
+    _input.seekg(0, ios::end);
+    int64_t end = _input.tellg();
+
+    // Each entry of the offset table takes at least ENTRY_MIN_SIZE bytes, 
+    //    so a corrupt size is found before allocating the table
+    if (!_input || size < 0 || tableOffset < payloadOffset || 
+            tableOffset > end || size > (end - tableOffset) / ENTRY_MIN_SIZE) {
+        _input.close();
+        _input.clear();
+        throw ios_base::failure(string("void ProfileDatabase::open(const "
+                "char fileName[]): an error ocurred while reading the "
+                "header\n"));
+    }
+
+    _input.seekg(tableOffset);
+    _entries = new Entry[size];
+    _size = size;
+    _capacity = size;
+    bool valid = true;
+    for (int i = 0; i < _size && valid; i++) {
+        Entry& entry = _entries[i];
+        entry.profileId = ReadString(_input, end);
+        entry.k = ReadInt32(_input);
+        entry.validNucleotides = ReadString(_input, end);
+        entry.numKmers = ReadInt32(_input);
+        entry.offset = ReadInt64(_input);
+
+        // The payload should be between the header and the offset table
+        valid = _input && entry.k > 0 && entry.numKmers >= 0 && 
+                entry.offset >= payloadOffset && entry.offset <= tableOffset &&
+                entry.numKmers <= (tableOffset - entry.offset) / 
+                        (entry.k + (int64_t) sizeof(int64_t));
+    }
+
+    if (!valid) {
+        close();
+        throw ios_base::failure(string("void ProfileDatabase::open(const "
+                "char fileName[]): an error ocurred while reading the "
+                "offset table\n"));
+    }
+}
+
+void ProfileDatabase::create(const char fileName[]) {
+    close();
+    _output.open(fileName, ios::out | ios::binary | ios::trunc);
+
+    if (!_output) {
+        _output.clear();
+        throw ios_base::failure(string("void ProfileDatabase::create(const "
+                "char fileName[]): the given file cannot be opened\n"));
+    }
+    _fileName = fileName;
+
+    // Header with room for the number of profiles and the table position
+    _output << MAGIC_STRING << '\n';
+    WriteInt32(_output, 0);
+    WriteInt64(_output, 0);
+}
+
+void ProfileDatabase::append(const Profile& profile,
+        const std::string& validNucleotides) {
+    if (!_output.is_open()) {
+        throw ios_base::failure(string("void ProfileDatabase::append(const "
+                "Profile& profile, const std::string& validNucleotides): the "
+                "database has not been created\n"));
+    }
+    if (profile.getSize() == 0) {
+        throw invalid_argument(string("void ProfileDatabase::append(const "
+                "Profile& profile, const std::string& validNucleotides): the "
+                "profile ") + profile.getProfileId() + " is empty");
+    }
+    if (profile.getParameters() != "") {
+        throw invalid_argument(string("void ProfileDatabase::append(const "
+                "Profile& profile, const std::string& validNucleotides): the "
+                "profile ") + profile.getProfileId() + " has the parameters " +
+                profile.getParameters() + ", which cannot be stored");
+    }
+    if (_size == _capacity) {
+        _capacity = _capacity == 0 ? 16 : 2 * _capacity;
+        Entry* entries = new Entry[_capacity];
+        for (int i = 0; i < _size; i++) {
+            entries[i] = _entries[i];
+        }
+        delete[] _entries;
+        _entries = entries;
+    }
+
+    Entry& entry = _entries[_size];
+    entry.profileId = profile.getProfileId();
+    entry.k = profile[0].getKmer().getK();
+    entry.validNucleotides = validNucleotides;
+    entry.numKmers = profile.getSize();
+    entry.offset = _output.tellp();
+    _size++;
+
+    for (int j = 0; j < profile.getSize(); j++) {
+        string kmer = profile[j].getKmer().toString();
+        kmer.resize(entry.k, Kmer::MISSING_NUCLEOTIDE);
+        _output.write(kmer.data(), entry.k);
+        WriteInt64(_output, profile[j].getFrequency());
+    }
+}
+
+void ProfileDatabase::close() {
+    bool failed = false;
+    if (_output.is_open()) {
+        // Offset table, and its position and size in the header
+        int64_t tableOffset = _output.tellp();
+        for (int i = 0; i < _size; i++) {
+            WriteString(_output, _entries[i].profileId);
+            WriteInt32(_output, _entries[i].k);
+            WriteString(_output, _entries[i].validNucleotides);
+            WriteInt32(_output, _entries[i].numKmers);
+            WriteInt64(_output, _entries[i].offset);
+        }
+
+        _output.seekp(MAGIC_STRING.length() + 1);
+        WriteInt32(_output, _size);
+        WriteInt64(_output, tableOffset);
+        failed = !_output;
+        _output.close();
+    }
+    _output.clear();
+    _fileName.clear();
+
+    if (_input.is_open())
+        _input.close();
+    _input.clear();
+    delete[] _entries;
+    _entries = nullptr;
+    _size = 0;
+    _capacity = 0;
+
+    if (failed) {
+        throw ios_base::failure(string("void ProfileDatabase::close(): an "
+                "error ocurred while writing in the file\n"));
+    }
+}
+
+void ProfileDatabase::discard() {
+    if (_output.is_open()) {
+        _output.close();
+        remove(_fileName.c_str());
+    }
+    _output.clear();
+    _fileName.clear();
+    close();
+}
+
+int ProfileDatabase::getSize() const {
+    return _size;
+}
+
+const string& ProfileDatabase::getProfileId(int index) const {
+    checkIndex(index);
+    return _entries[index].profileId;
+}
+
+int ProfileDatabase::getK(int index) const {
+    checkIndex(index);
+    return _entries[index].k;
+}
+
+const string& ProfileDatabase::getValidNucleotides(int index) const {
+    checkIndex(index);
+    return _entries[index].validNucleotides;
+}
+
+int ProfileDatabase::getNumKmers(int index) const {
+    checkIndex(index);
+    return _entries[index].numKmers;
+}
+
+Profile ProfileDatabase::getProfile(int index) const {
+    checkIndex(index);
+    if (!_input.is_open()) {
+        throw ios_base::failure(string("Profile ProfileDatabase::getProfile("
+                "int index) const: the database is not open\n"));
+    }
+
+    const Entry& entry = _entries[index];
+    int recordSize = entry.k + sizeof(int64_t);
+    char* payload = new char[(size_t)entry.numKmers * recordSize];
+
+    _input.clear();
+    _input.seekg(entry.offset);
+    _input.read(payload, (streamsize)entry.numKmers * recordSize);
+    if (!_input) {
+        delete[] payload;
+        throw ios_base::failure(string("Profile ProfileDatabase::getProfile("
+                "int index) const: an error ocurred while reading the "
+                "profile\n"));
+    }
+
+    Profile profile(entry.numKmers);
+    profile.setProfileId(entry.profileId);
+    const char* record = payload;
+    for (int i = 0; i < entry.numKmers; i++) {
+        int64_t frequency;
+        memcpy(&frequency, record + entry.k, sizeof(frequency));
+        profile[i].setKmer(Kmer(string(record, entry.k)));
+        profile[i].setFrequency(frequency);
+        record += recordSize;
+    }
+
+    delete[] payload;
+    return profile;
+}
+
+void ProfileDatabase::build(const char fileName[], const string profileFiles[],
+        int numFiles, const std::string& validNucleotides) {
+    // One profile in memory at a time. If a profile cannot be written, the
+    //    database is discarded instead of closed with the previous ones
+    ProfileDatabase database;
+    database.create(fileName);
+    try {
+        for (int i = 0; i < numFiles; i++) {
+            Profile profile;
+            profile.load(profileFiles[i].c_str());
+            if (profile.getSize() == 0) {
+                throw invalid_argument(string("void ProfileDatabase::build("
+                        "...): the profile ") + profileFiles[i] + 
+                        " is empty");
+            }
+            database.append(profile, validNucleotides);
+        }
+    }
+    catch (exception& e) {
+        database.discard();
+        throw;
+    }
+    database.close();
+}
+
+void ProfileDatabase::checkIndex(int index) const {
+    if (index < 0 || index >= _size)
+        throw out_of_range(string("ProfileDatabase: index must be between 0 "
+                "and getSize()-1"));
+}
@@ -0,0 +1,208 @@
+/*
+ * Metodología de la Programación: Kmer5
+ * Curso 2023/2024
+ */
+
+/**
+ * @file RankVector.cpp
+ */
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "RankVector.h"
+#include "Sketch.h"
+
+using namespace std;
+
+RankVector::RankVector(int depth) {
+    if (depth <= 0)
+        throw invalid_argument(string("RankVector::RankVector(int depth): "
+                "depth must be greater than zero"));
+
+    allocate(depth);
+    _size = 0;
+    _profileSize = 0;
+}
+
+RankVector::RankVector(const RankVector& orig) {
+    allocate(orig._depth);
+    _size = orig._size;
+    _profileSize = orig._profileSize;
+    for (int i = 0; i < _size; i++) {
+        _hashes[i] = orig._hashes[i];
+        _ranks[i] = orig._ranks[i];
+    }
+}
+
+RankVector::~RankVector() {
+    deallocate();
+}
+
+RankVector& RankVector::operator=(const RankVector& orig) {
+    if (this != &orig) {
+        deallocate();
+        allocate(orig._depth);
+        _size = orig._size;
+        _profileSize = orig._profileSize;
+        for (int i = 0; i < _size; i++) {
+            _hashes[i] = orig._hashes[i];
+            _ranks[i] = orig._ranks[i];
+        }
+    }
+
+    return *this;
+}
+
+int RankVector::getDepth() const {
+    return _depth;
+}
+
+int RankVector::getSize() const {
+    return _size;
+}
+
+int RankVector::getProfileSize() const {
+    return _profileSize;
+}
+
+bool RankVector::isComplete() const {
+    return _size == _profileSize;
+}
+
+void RankVector::build(const Profile& profile) {
+    _profileSize = profile.getSize();
+    _size = min(_depth, _profileSize);
+
+    int* order = new int[_size];
+    for (int i = 0; i < _size; i++) {
+        _hashes[i] = Sketch::Hash(profile[i].getKmer());
+        order[i] = i;
+    }
+
+    // Sort the ranks by hash value
+    const unsigned long long* hashes = _hashes;
+    std::sort(order, order + _size, [hashes](int a, int b) {
+        return hashes[a] < hashes[b];
+    });
+
+    unsigned long long* sorted = new unsigned long long[_size];
+    for (int i = 0; i < _size; i++) {
+        sorted[i] = _hashes[order[i]];
+        _ranks[i] = order[i];
+    }
+    for (int i = 0; i < _size; i++) {
+        _hashes[i] = sorted[i];
+    }
+
+    delete[] sorted;
+    delete[] order;
+}
+
+double RankVector::getDistance(const RankVector& other) const {
+    if (_depth != other._depth)
+        throw invalid_argument(string("double RankVector::getDistance(const "
+                "RankVector& other) const: the depths are not the same"));
+
+    long long sum = 0;
+    int i = 0, j = 0;
+    while (i < _size && j < other._size) {
+        if (_hashes[i] == other._hashes[j]) {
+            sum += abs(_ranks[i] - other._ranks[j]);
+            i++;
+            j++;
+        }
+        else if (_hashes[i] < other._hashes[j]) {
+            sum += _depth - _ranks[i];
+            i++;
+        }
+        else {
+            sum += _depth - other._ranks[j];
+            j++;
+        }
+    }
+    for (; i < _size; i++) {
+        sum += _depth - _ranks[i];
+    }
+    for (; j < other._size; j++) {
+        sum += _depth - other._ranks[j];
+    }
+
+    return sum / ((double)_depth * _depth);
+}
+
+double RankVector::getProfileDistance(const RankVector& other) const {
+    if (_size == 0 || other._size == 0 || !isComplete() ||
+            !other.isComplete())
+        throw invalid_argument(string("double RankVector::getProfileDistance("
+                "const RankVector& other) const: one of the RankVectors (or "
+                "both) is empty or not complete"));
+
+    long long sum = 0;
+    int i = 0, j = 0;
+    while (i < _size && j < other._size) {
+        if (_hashes[i] == other._hashes[j]) {
+            sum += abs(_ranks[i] - other._ranks[j]);
+            i++;
+            j++;
+        }
+        else if (_hashes[i] < other._hashes[j]) {
+            sum += abs(_ranks[i] - other._size);
+            i++;
+        }
+        else {
+            j++;
+        }
+    }
+    for (; i < _size; i++) {
+        sum += abs(_ranks[i] - other._size);
+    }
+
+    return sum / ((double)_size * other._size);
+}
+
+void RankVector::write(std::ostream& outputStream) const {
+    outputStream.write(reinterpret_cast<const char*>(&_depth), sizeof(_depth));
+    outputStream.write(reinterpret_cast<const char*>(&_size), sizeof(_size));
+    outputStream.write(reinterpret_cast<const char*>(&_profileSize),
+            sizeof(_profileSize));
+    outputStream.write(reinterpret_cast<const char*>(_hashes),
+            _size * sizeof(unsigned long long));
+    outputStream.write(reinterpret_cast<const char*>(_ranks),
+            _size * sizeof(int));
+}
+
+void RankVector::read(std::istream& inputStream) {
+    int depth = 0, size = 0, profileSize = 0;
+    inputStream.read(reinterpret_cast<char*>(&depth), sizeof(depth));
+    inputStream.read(reinterpret_cast<char*>(&size), sizeof(size));
+    inputStream.read(reinterpret_cast<char*>(&profileSize),
+            sizeof(profileSize));
+    if (!inputStream || depth <= 0 || size < 0 || size > depth ||
+            profileSize < size) {
+        inputStream.setstate(ios::failbit);
+        return;
+    }
+
+    deallocate();
+    allocate(depth);
+    _size = size;
+    _profileSize = profileSize;
+    inputStream.read(reinterpret_cast<char*>(_hashes),
+            _size * sizeof(unsigned long long));
+    inputStream.read(reinterpret_cast<char*>(_ranks), _size * sizeof(int));
+}
+
+void RankVector::allocate(int depth) {
+    _depth = depth;
+    _hashes = new unsigned long long[_depth];
+    _ranks = new int[_depth];
+}
+
+void RankVector::deallocate() {
+    delete[] _hashes;
+    delete[] _ranks;
+    _hashes = nullptr;
+    _ranks = nullptr;
+    _size = 0;
+}
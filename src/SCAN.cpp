@@ -0,0 +1,250 @@
+/*
+ * Metodología de la Programación: Kmer5
+ * Curso 2023/2024
+ */
+
+/**
+ * @file SCAN.cpp
+ */
+
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include "KmerCounter.h"
+#include "ProfileDatabase.h"
+#include "SlidingProfile.h"
+
+using namespace std;
+
+/**
+ * Shows help about the use of this program in the given output stream
+ * @param outputStream The output stream where the help will be shown (for example,
+ * cout, cerr, etc)
+ */
+void showEnglishHelp(ostream& outputStream) {
+    outputStream << "ERROR in SCAN parameters" << endl;
+    outputStream << "Run with the following parameters:" << endl;
+    outputStream << "SCAN [-k kValue] [-n nucleotidesSet] [-w windowSize] [-s stride] [-d database.db] <file.dna> [<profile1.prf> <profile2.prf> <profile3.prf> ....]" << endl;
+    outputStream << endl;
+    outputStream << "Parameters:" << endl;
+    outputStream << "-k kValue: number of nucleotides in a kmer (5 by default)" << endl;
+    outputStream << "-n nucletiodesSet: set of possible nucleotides in a kmer (ACGT by default). "
+                 << "Note that the characters should be provided in uppercase" << endl;
+    outputStream << "-w windowSize: number of nucleotides of a window (10000 by default)" << endl;
+    outputStream << "-s stride: number of nucleotides between the beginnings of two consecutive "
+                 << "windows (1000 by default)" << endl;
+    outputStream << "-d database.db: reference database built with BUILDDB. Only the "
+                 << "profiles with the same kValue and nucleotidesSet are used" << endl;
+    outputStream << "<file.dna>: name of the DNA file to scan" << endl;
+    outputStream << "<profile1.prf> [<profile2.prf> <profile3.prf> ....] ....: "
+                 << "names of the Profile models (at least one is mandatory if -d is not given)" << endl;
+    outputStream << endl;
+    outputStream << "This program obtains the identifier of the closest profile to each window "
+                 << "of the input DNA file" << endl;
+    outputStream << endl;
+}
+
+/**
+ * This program scans the DNA of an input file (<file.dna>) with a sliding
+ * window of windowSize nucleotides, which moves stride nucleotides each time,
+ * and prints the identifier of the closest profile to each window among the
+ * set of provided models: <profile1.prf>, <profile2.prf>, ... and the
+ * profiles of a reference database (option -d) learned with the same k and
+ * nucleotides. It can be used to find regions of a genome that look like
+ * another organism (horizontal transfers or contaminations).
+ *
+ * The Profile of a window is not learned again for each window: a
+ * SlidingProfile object removes the kmers that leave the window and adds the
+ * ones that enter it, keeping their ranks and the distances to the
+ * references up to date. Moving the window costs O(stride) updates of the
+ * frequencies, and then the distances only change for the kmers whose rank
+ * has changed. The ranks are the ones of the Profile learned from the
+ * window, so the distances are the ones obtained by CLASSIFY for the DNA of
+ * the window. As in CLASSIFY, the kmers with missing nucleotides are not
+ * removed from the Profile of a window.
+ *
+ * The output is a track with a line for each window: the position of its
+ * first nucleotide, the position after its last nucleotide, the identifier
+ * of the closest profile and the distance to it, separated by tabs. If the
+ * input DNA is shorter than windowSize, a single window with all of it is
+ * used.
+ *
+ * This program assumes that the profile files are already normalized and
+ * sorted by frequency. This is not checked in this program. The profile
+ * files cannot be sampled or spaced (see LEARN -h and -G), since the 
+ * windows have all their contiguous kmers.
+ *
+ * Running sintax:
+ * > SCAN [-k kValue] [-n nucleotidesSet] [-w windowSize] [-s stride] [-d database.db] <file.dna> [<profile1.prf> <profile2.prf> <profile3.prf> ....]
+ *
+ * Running example:
+ * > SCAN -w 50000 -s 25000 ../Genomes/human_chr6_s60000_l500000.dna ../Genomes/human_chr9_s10000_l500000.prf ../Genomes/worm1.prf
+ * 0	50000	homo sapiens	0.0634581
+ * 25000	75000	homo sapiens	0.0610923
+ * ...
+ *
+ * @param argc The number of command line parameters
+ * @param argv The vector of command line parameters (cstrings)
+ * @return 0 If there is no error; a value > 0 if error
+ */
+int main(int argc, char *argv[]) {
+    // Process the main() arguments
+    if (argc < 3) {
+        showEnglishHelp(cerr);
+        return 1;
+    }
+
+    int num_args, first_arg;
+    int k = 5;
+    string n = KmerCounter::DEFAULT_VALID_NUCLEOTIDES;
+    int w = 10000;
+    int s = 1000;
+    string d = "";
+
+    bool sigo = true;
+    int i = 1;
+    while (sigo && i < argc-1) {
+        if (string(argv[i]).at(0) == '-') {
+            if (string(argv[i]) == "-k") {
+                k = stoi(argv[i+1]);
+                i += 2;
+            }
+            else if (string(argv[i]) == "-n") {
+                n = argv[i+1];
+                i += 2;
+            }
+            else if (string(argv[i]) == "-w") {
+                w = stoi(argv[i+1]);
+                i += 2;
+            }
+            else if (string(argv[i]) == "-s") {
+                s = stoi(argv[i+1]);
+                i += 2;
+            }
+            else if (string(argv[i]) == "-d") {
+                d = argv[i+1];
+                i += 2;
+            }
+            else {
+                showEnglishHelp(cerr);
+                return 1;
+            }
+        }
+        else {
+            sigo = false;
+        }
+    }
+
+    num_args = argc - i - 1;
+    first_arg = i + 1;
+
+    if (i >= argc || string(argv[argc-1]).at(0) == '-' ||
+            (num_args == 0 && d == "") || k <= 0 || w < k || s <= 0) {
+        showEnglishHelp(cerr);
+        return 1;
+    }
+
+    // Add the references to the sliding window: first the profile files
+    //    and then the profiles of the database with the same k and
+    //    nucleotides
+    SlidingProfile window(k, n);
+    string* ids = nullptr;
+    int num_refs = 0;
+    try {
+        ProfileDatabase database;
+        int num_db = 0;
+        if (d != "") {
+            database.open(d.c_str());
+            num_db = database.getSize();
+        }
+
+        ids = new string[num_args + num_db];
+        for (int j = 0; j < num_args + num_db; j++) {
+            Profile reference;
+            if (j < num_args) {
+                reference.load(argv[first_arg + j]);
+                // The windows have all the contiguous kmers (see LEARN -h
+                //    and -G)
+                if (reference.getParameters() != "") {
+                    cerr << "The profile " << argv[first_arg + j] << " has "
+                         << "been learned with "
+                         << reference.getParameters() << ", and it cannot be "
+                         << "scanned" << endl;
+                    delete[] ids;
+                    return 1;
+                }
+            }
+            else if (database.getK(j - num_args) == k &&
+                    database.getValidNucleotides(j - num_args) == n)
+                reference = database.getProfile(j - num_args);
+            else
+                continue;
+
+            window.addReference(reference);
+            ids[num_refs] = reference.getProfileId();
+            num_refs++;
+        }
+    }
+    catch (exception& e) {
+        cerr << e.what() << endl;
+        delete[] ids;
+        return 1;
+    }
+
+    if (num_refs == 0) {
+        cerr << "There is not any profile learned with k=" << k
+             << " and nucleotides " << n << endl;
+        delete[] ids;
+        return 1;
+    }
+
+    // Read the input DNA in the same way as KmerCounter::calculateFrequencies()
+    ifstream input(argv[first_arg-1]);
+    if (!input) {
+        cerr << "The DNA file " << argv[first_arg-1] << " cannot be opened"
+             << endl;
+        delete[] ids;
+        return 1;
+    }
+    string dna;
+    input >> dna;
+    input.close();
+
+    int length = dna.length();
+    if (length < k) {
+        cerr << "The DNA file " << argv[first_arg-1] << " has less than k="
+             << k << " nucleotides" << endl;
+        delete[] ids;
+        return 1;
+    }
+
+    // Slide the window: the kmers of a window are the ones that begin in
+    //    the positions [start, start + w - k + 1)
+    int num_kmers = min(w, length) - k + 1;
+    window.addKmers(dna, 0, num_kmers);
+    int start = 0;
+    while (true) {
+        int pos_min = 0;
+        double distance_min = window.getDistance(0);
+        for (int r = 1; r < num_refs; r++) {
+            double distance = window.getDistance(r);
+            if (distance < distance_min) {
+                distance_min = distance;
+                pos_min = r;
+            }
+        }
+        cout << start << '\t' << start + min(w, length) << '\t'
+             << ids[pos_min] << '\t' << distance_min << '\n';
+
+        int next = start + s;
+        if (next + w > length)
+            break;
+
+        window.slide(dna, start, start + num_kmers, next, next + num_kmers);
+        start = next;
+    }
+
+    delete[] ids;
+
+    return 0;
+}
@@ -0,0 +1,169 @@
+/*
+ * Metodología de la Programación: Kmer5
+ * Curso 2023/2024
+ */
+
+/**
+ * @file SampledKmerCounter.cpp
+ */
+
+#include <cctype>
+#include <climits>
+#include <deque>
+#include <fstream>
+#include <stdexcept>
+
+#include "SampledKmerCounter.h"
+
+using namespace std;
+
+const string SampledKmerCounter::FRAC_MIN_HASH = "fracminhash";
+const string SampledKmerCounter::MINIMIZER = "minimizer";
+
+/**
+ * A kmer of the current window of the minimizers: its hash value, its code
+ * and its position in the sequence
+ */
+struct WindowKmer {
+    unsigned long long hash; ///< Hash value of the kmer
+    unsigned long long code; ///< Code of the kmer
+    long long position; ///< Position of the kmer in the sequence
+};
+
+SampledKmerCounter::SampledKmerCounter(int k,
+        const std::string& validNucleotides, const std::string& sampling,
+        bool canonical, bool onlyValidKmers): _coder(k, validNucleotides,
+        canonical, onlyValidKmers) {
+    size_t separator = sampling.find('=');
+    string name = sampling.substr(0, separator);
+    string digits = separator == string::npos ? "" :
+            sampling.substr(separator + 1);
+    bool valid = (name == FRAC_MIN_HASH || name == MINIMIZER) &&
+            !digits.empty() && digits.size() <= 18;
+    for (size_t i = 0; i < digits.size() && valid; i++) {
+        valid = isdigit((unsigned char) digits[i]);
+    }
+    long long value = valid ? stoll(digits) : 0;
+    if (value <= 0 || (name == MINIMIZER && value > INT_MAX))
+        throw std::invalid_argument(string("SampledKmerCounter::"
+                "SampledKmerCounter(int k, const std::string& "
+                "validNucleotides, const std::string& sampling, bool "
+                "canonical, bool onlyValidKmers): invalid sampling ") +
+                sampling);
+
+    _sampling = name + "=" + to_string(value);
+    _minimizers = name == MINIMIZER;
+    _threshold = _minimizers ? ULLONG_MAX : ULLONG_MAX / value;
+    _window = _minimizers ? value : 1;
+    _numKmers = 0;
+}
+
+int SampledKmerCounter::getK() const {
+    return _coder.getK();
+}
+
+const std::string& SampledKmerCounter::getSampling() const {
+    return _sampling;
+}
+
+long long SampledKmerCounter::getNumKmers() const {
+    return _numKmers;
+}
+
+int SampledKmerCounter::getSize() const {
+    return _frequencies.size();
+}
+
+void SampledKmerCounter::calculateFrequencies(const char* fileName) {
+    ifstream input;
+    input.open(fileName);
+    
+    if (!input)
+        throw ios_base::failure(string("void "
+                "SampledKmerCounter::calculateFrequencies(const char* "
+                "fileName): the given file cannot be opened\n"));
+
+    string sequence;
+    input >> sequence;
+    input.close();
+    _frequencies.clear();
+    _numKmers = 0;
+    addSequenceFrequencies(sequence);
+}
+
+void SampledKmerCounter::addSequenceFrequencies(const std::string& sequence) {
+    if (!_minimizers) {
+        _coder.forEachCode(sequence.data(), sequence.length(),
+                [this](unsigned long long code, int count) {
+                    _numKmers += count;
+                    if (Hash(code) <= _threshold)
+                        increase(code, count);
+                });
+        return;
+    }
+
+    // The window is a deque of increasing hash values, whose front is the
+    //    last kmer with the smallest hash value of the window
+    deque<WindowKmer> window;
+    long long position = 0;
+    long long selected = -1; // Position of the last selected kmer
+    unsigned long long selectedHash = 0;
+    _coder.forEachCode(sequence.data(), sequence.length(),
+            [&](unsigned long long code, int count) {
+                _numKmers += count;
+                WindowKmer kmer = {Hash(code), code, 0};
+                for (int c = 0; c < count; c++) {
+                    while (!window.empty() && window.back().hash >= kmer.hash) {
+                        window.pop_back();
+                    }
+                    kmer.position = position;
+                    window.push_back(kmer);
+                    if (window.front().position <= position - _window)
+                        window.pop_front();
+                    position++;
+
+                    // A new kmer is selected when the previous one leaves
+                    //    the window or a smaller one enters it
+                    if (position >= _window && (selected < position - _window ||
+                            window.front().hash < selectedHash)) {
+                        selected = window.front().position;
+                        selectedHash = window.front().hash;
+                        increase(window.front().code, 1);
+                    }
+                }
+            });
+
+    // A sequence shorter than a window has a single minimizer
+    if (position > 0 && position < _window)
+        increase(window.front().code, 1);
+}
+
+Profile SampledKmerCounter::toProfile() const {
+    Profile profile(_frequencies.size());
+    int pos = 0;
+    for (unordered_map<unsigned long long, long long>::const_iterator it =
+            _frequencies.begin(); it != _frequencies.end(); ++it) {
+        profile.at(pos).setKmer(Kmer(_coder.decode(it->first)));
+        profile.at(pos).setFrequency(it->second);
+        pos++;
+    }
+    profile.setParameters(_sampling);
+
+    return profile;
+}
+
+unsigned long long SampledKmerCounter::Hash(unsigned long long code) {
+    // The output function of splitmix64, with its increment so the code 0
+    //    is not always sampled
+    code += 0x9e3779b97f4a7c15ULL;
+    code ^= code >> 30;
+    code *= 0xbf58476d1ce4e5b9ULL;
+    code ^= code >> 27;
+    code *= 0x94d049bb133111ebULL;
+    code ^= code >> 31;
+    return code;
+}
+
+void SampledKmerCounter::increase(unsigned long long code, long long value) {
+    _frequencies[code] += value;
+}
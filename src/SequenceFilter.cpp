@@ -0,0 +1,200 @@
+/*
+ * Metodología de la Programación: Kmer5
+ * Curso 2023/2024
+ */
+
+/**
+ * @file SequenceFilter.cpp
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "Kmer.h"
+#include "SequenceFilter.h"
+
+using namespace std;
+
+const int SequenceFilter::DUST_WINDOW;
+const int SequenceFilter::DEFAULT_DUST_LEVEL;
+const int SequenceFilter::PHRED_OFFSET;
+const int SequenceFilter::MAX_QUALITY;
+
+/**
+ * Number of different triplets of the nucleotides A, C, G and T
+ */
+static const int NUM_TRIPLETS = 64;
+
+/**
+ * Code of the characters that are not a nucleotide of a triplet, and of the
+ * slots of a window without a triplet
+ */
+static const unsigned char NO_TRIPLET = 0xff;
+
+/**
+ * The code of each character in the triplets of the low complexity filter:
+ * 0, 1, 2 and 3 for A, C, G and T (or U), in uppercase or lowercase, and
+ * NO_TRIPLET for the other ones
+ */
+struct DustCodes {
+    unsigned char codes[256]; ///< Code of each character
+
+    /**
+     * @brief Constructor of the struct. Fills the table
+     */
+    DustCodes() {
+        const string nucleotides = "ACGT";
+        fill(codes, codes + 256, NO_TRIPLET);
+        for (int code = 0; code < 4; code++) {
+            codes[(unsigned char) nucleotides[code]] = code;
+            codes[(unsigned char) tolower(nucleotides[code])] = code;
+        }
+        codes[(unsigned char) 'U'] = codes[(unsigned char) 'u'] = 3;
+    }
+};
+
+/**
+ * The codes of the characters in the triplets of the low complexity filter
+ */
+static const DustCodes DUST_CODES;
+
+SequenceFilter::SequenceFilter(int minQuality, int dustLevel) {
+    if (minQuality < 0 || minQuality > MAX_QUALITY || dustLevel < 0)
+        throw std::invalid_argument(string("SequenceFilter::SequenceFilter("
+                "int minQuality, int dustLevel): invalid minimum quality ") +
+                to_string(minQuality) + " or DUST level " +
+                to_string(dustLevel));
+    _minQuality = minQuality;
+    _dustLevel = dustLevel;
+}
+
+int SequenceFilter::getMinQuality() const {
+    return _minQuality;
+}
+
+int SequenceFilter::getDustLevel() const {
+    return _dustLevel;
+}
+
+bool SequenceFilter::isEnabled() const {
+    return _minQuality > 0 || _dustLevel > 0;
+}
+
+long long SequenceFilter::filter(char sequence[], long long length,
+        const char qualities[]) const {
+    long long masked = 0;
+    if (_minQuality > 0 && qualities != nullptr)
+        masked += maskQualities(sequence, length, qualities);
+    if (_dustLevel > 0)
+        masked += maskLowComplexity(sequence, length);
+
+    return masked;
+}
+
+long long SequenceFilter::filter(std::string& sequence) const {
+    return filter(&sequence[0], sequence.size());
+}
+
+long long SequenceFilter::maskQualities(char sequence[], long long length,
+        const char qualities[]) const {
+    // The characters of the qualities are compared as signed characters,
+    //    so the ones greater than 127 (not valid) are also masked
+    const signed char limit = PHRED_OFFSET + _minQuality;
+    long long masked = 0;
+    long long i = 0;
+#ifdef __SSE2__
+    // 16 qualities are compared at once, and the nucleotides whose quality
+    //    is smaller than the limit are replaced with a blend
+    const __m128i limits = _mm_set1_epi8(limit);
+    const __m128i missing = _mm_set1_epi8(Kmer::MISSING_NUCLEOTIDE);
+    for (; i + 16 <= length; i += 16) {
+        __m128i low = _mm_cmplt_epi8(_mm_loadu_si128(
+                (const __m128i*) (qualities + i)), limits);
+        int lowMask = _mm_movemask_epi8(low);
+        if (lowMask == 0)
+            continue;
+        __m128i block = _mm_loadu_si128((const __m128i*) (sequence + i));
+        int missingMask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, missing));
+        masked += __builtin_popcount(lowMask & ~missingMask);
+        block = _mm_or_si128(_mm_andnot_si128(low, block),
+                _mm_and_si128(low, missing));
+        _mm_storeu_si128((__m128i*) (sequence + i), block);
+    }
+#endif
+    for (; i < length; i++) {
+        if ((signed char) qualities[i] < limit &&
+                sequence[i] != Kmer::MISSING_NUCLEOTIDE) {
+            sequence[i] = Kmer::MISSING_NUCLEOTIDE;
+            masked++;
+        }
+    }
+
+    return masked;
+}
+
+long long SequenceFilter::maskLowComplexity(char sequence[],
+        long long length) const {
+    // The window has the triplets that end at its last numTriplets
+    //    positions, in a circular buffer. Each triplet of the window adds
+    //    to the score the number of previous occurrences in the window, so
+    //    the score is the sum of c * (c - 1) / 2 of all the triplets
+    const int numTriplets = DUST_WINDOW - 2;
+    unsigned char window[DUST_WINDOW - 2];
+    int counts[NUM_TRIPLETS] = {0};
+    fill(window, window + numTriplets, NO_TRIPLET);
+    long long maxScore = (long long) _dustLevel * (numTriplets - 1);
+    long long score = 0;
+    int triplet = 0;
+    int run = 0; // Number of consecutive nucleotides of a triplet
+    int slot = 0;
+    long long masked = 0;
+    long long unmasked = 0; // First position not masked yet
+
+    // The nucleotides are read before a window that contains them is
+    //    masked, so the triplets are the ones of the original sequence
+    for (long long i = 0; i < length; i++) {
+        unsigned char code = DUST_CODES.codes[(unsigned char) sequence[i]];
+        if (code == NO_TRIPLET)
+            run = 0;
+        else {
+            triplet = ((triplet << 2) | code) & (NUM_TRIPLETS - 1);
+            run++;
+        }
+        if (window[slot] != NO_TRIPLET) {
+            counts[window[slot]]--;
+            score -= counts[window[slot]];
+        }
+        window[slot] = run >= 3 ? triplet : NO_TRIPLET;
+        if (run >= 3) {
+            score += counts[triplet];
+            counts[triplet]++;
+        }
+        slot = slot + 1 == numTriplets ? 0 : slot + 1;
+
+        if (score > maxScore && i >= DUST_WINDOW - 1) {
+            for (long long p = max(unmasked, i - DUST_WINDOW + 1); p <= i;
+                    p++) {
+                masked += sequence[p] != Kmer::MISSING_NUCLEOTIDE;
+                sequence[p] = Kmer::MISSING_NUCLEOTIDE;
+            }
+            unmasked = i + 1;
+        }
+    }
+
+    // A sequence shorter than a window (for example, a short read) is a
+    //    single window with its own number of triplets
+    if (length < DUST_WINDOW && length >= 4 &&
+            score > (long long) _dustLevel * (length - 3)) {
+        for (long long p = 0; p < length; p++) {
+            masked += sequence[p] != Kmer::MISSING_NUCLEOTIDE;
+            sequence[p] = Kmer::MISSING_NUCLEOTIDE;
+        }
+    }
+
+    return masked;
+}
@@ -0,0 +1,238 @@
+/*
+ * Metodología de la Programación: Kmer5
+ * Curso 2023/2024
+ */
+
+/**
+ * @file Sketch.cpp
+ */
+
+#include <algorithm>
+#include <fstream>
+
+#include "Sketch.h"
+
+using namespace std;
+
+const string Sketch::MAGIC_STRING="MP-KMER-SKETCH-1.0";
+
+Sketch::Sketch(int size) {
+    if (size <= 0)
+        throw invalid_argument(string("Sketch::Sketch(int size): "
+                "size must be greater than zero"));
+
+    _profileId = "unknown";
+    _size = 0;
+    _capacity = size;
+    _hashes = new unsigned long long[_capacity];
+}
+
+Sketch::Sketch(const Sketch& orig) {
+    _profileId = orig._profileId;
+    _size = orig._size;
+    _capacity = orig._capacity;
+    _hashes = new unsigned long long[_capacity];
+    for (int i = 0; i < _size; i++) {
+        _hashes[i] = orig._hashes[i];
+    }
+}
+
+Sketch::~Sketch() {
+    delete[] _hashes;
+    _hashes = nullptr;
+    _size = 0;
+}
+
+Sketch& Sketch::operator=(const Sketch& orig) {
+    if (this != &orig) {
+        delete[] _hashes;
+        _profileId = orig._profileId;
+        _size = orig._size;
+        _capacity = orig._capacity;
+        _hashes = new unsigned long long[_capacity];
+        for (int i = 0; i < _size; i++) {
+            _hashes[i] = orig._hashes[i];
+        }
+    }
+
+    return *this;
+}
+
+const string& Sketch::getProfileId() const {
+    return _profileId;
+}
+
+int Sketch::getCapacity() const {
+    return _capacity;
+}
+
+int Sketch::getSize() const {
+    return _size;
+}
+
+unsigned long long Sketch::at(int index) const {
+    if (index < 0 || index >= _size)
+        throw out_of_range(string("unsigned long long Sketch::at(int index) "
+                "const: index must be between 0 and _size"));
+
+    return _hashes[index];
+}
+
+void Sketch::build(const Profile& profile) {
+    _profileId = profile.getProfileId();
+
+    unsigned long long* all = new unsigned long long[profile.getSize()];
+    int n = 0;
+    for (int i = 0; i < profile.getSize(); i++) {
+        const Kmer& kmer = profile[i].getKmer();
+        if (kmer.toString().find(Kmer::MISSING_NUCLEOTIDE) == string::npos) {
+            all[n] = Hash(kmer);
+            n++;
+        }
+    }
+
+    // Keep the _capacity smallest distinct hash values
+    std::sort(all, all + n);
+    _size = 0;
+    for (int i = 0; i < n && _size < _capacity; i++) {
+        if (_size == 0 || all[i] != _hashes[_size - 1]) {
+            _hashes[_size] = all[i];
+            _size++;
+        }
+    }
+
+    delete[] all;
+}
+
+double Sketch::getJaccard(const Sketch& other) const {
+    int s = min(_capacity, other._capacity);
+    int i = 0, j = 0, taken = 0, common = 0;
+
+    // Merge of the two sorted lists without branches in the loop body:
+    // both positions advance when the values are equal
+    while (i < _size && j < other._size && taken < s) {
+        unsigned long long a = _hashes[i];
+        unsigned long long b = other._hashes[j];
+        common += (a == b);
+        i += (a <= b);
+        j += (b <= a);
+        taken++;
+    }
+
+    // The rest of the union comes from only one of the sketches
+    taken += min(s - taken, (_size - i) + (other._size - j));
+
+    return taken == 0 ? 0.0 : (double)common / taken;
+}
+
+void Sketch::write(std::ostream& outputStream) const {
+    outputStream << _profileId << '\n';
+    outputStream.write(reinterpret_cast<const char*>(&_capacity),
+            sizeof(_capacity));
+    outputStream.write(reinterpret_cast<const char*>(&_size), sizeof(_size));
+    outputStream.write(reinterpret_cast<const char*>(_hashes),
+            _size * sizeof(unsigned long long));
+}
+
+void Sketch::read(std::istream& inputStream) {
+    string id;
+    int capacity = 0, size = 0;
+    getline(inputStream, id);
+    inputStream.read(reinterpret_cast<char*>(&capacity), sizeof(capacity));
+    inputStream.read(reinterpret_cast<char*>(&size), sizeof(size));
+    if (!inputStream || capacity <= 0 || size < 0 || size > capacity) {
+        inputStream.setstate(ios::failbit);
+        return;
+    }
+
+    *this = Sketch(capacity);
+    _profileId = id;
+    inputStream.read(reinterpret_cast<char*>(_hashes),
+            size * sizeof(unsigned long long));
+    _size = size;
+}
+
+void Sketch::Save(const char fileName[], const Sketch sketches[],
+        int numSketches) {
+    ofstream output;
+    output.open(fileName, ios::out | ios::binary);
+
+    if (!output) {
+        throw ios_base::failure(string("void Sketch::Save(...): "
+                "the given file cannot be opened\n"));
+    }
+
+    output << MAGIC_STRING << '\n';
+    output.write(reinterpret_cast<const char*>(&numSketches),
+            sizeof(numSketches));
+    for (int i = 0; i < numSketches; i++) {
+        sketches[i].write(output);
+    }
+
+    if (!output) {
+        output.close();
+        throw ios_base::failure(string("void Sketch::Save(...): an error "
+                "ocurred while writing in the file\n"));
+    }
+
+    output.close();
+}
+
+Sketch* Sketch::Load(const char fileName[], int& numSketches) {
+    ifstream input;
+    input.open(fileName, ios::in | ios::binary);
+
+    if (!input) {
+        throw ios_base::failure(string("Sketch* Sketch::Load(...): "
+                "the given file cannot be opened\n"));
+    }
+
+    string magic_string;
+    getline(input, magic_string);
+    if (magic_string != MAGIC_STRING) {
+        input.close();
+        throw invalid_argument(string("Sketch* Sketch::Load(...): an invalid "
+                "magic string has been found in the given file"));
+    }
+
+    numSketches = 0;
+    input.read(reinterpret_cast<char*>(&numSketches), sizeof(numSketches));
+    if (!input || numSketches < 0) {
+        input.close();
+        throw ios_base::failure(string("Sketch* Sketch::Load(...): an error "
+                "ocurred while reading the file\n"));
+    }
+
+    Sketch* sketches = new Sketch[numSketches];
+    for (int i = 0; i < numSketches; i++) {
+        sketches[i].read(input);
+    }
+
+    if (!input) {
+        delete[] sketches;
+        input.close();
+        throw ios_base::failure(string("Sketch* Sketch::Load(...): an error "
+                "ocurred while reading the file\n"));
+    }
+
+    input.close();
+    return sketches;
+}
+
+unsigned long long Sketch::Hash(const Kmer& kmer) {
+    // FNV-1a over the nucleotides followed by the splitmix64 finalizer, so
+    // that the low and high bits are well mixed
+    unsigned long long h = 14695981039346656037ULL;
+    string text = kmer.toString();
+    for (size_t i = 0; i < text.length(); i++) {
+        h ^= (unsigned char)text[i];
+        h *= 1099511628211ULL;
+    }
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+
+    return h;
+}
@@ -0,0 +1,451 @@
+/*
+ * Metodología de la Programación: Kmer5
+ * Curso 2023/2024
+ */
+
+/**
+ * @file SlidingProfile.cpp
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cstdlib>
+
+#include "SlidingProfile.h"
+
+using namespace std;
+
+/**
+ * Initial number of frequencies in the array of the ends of the buckets
+ */
+static const int INITIAL_MAX_FREQUENCY = 16;
+
+SlidingProfile::SlidingProfile(int k, const std::string& validNucleotides) {
+    if (k <= 0)
+        throw invalid_argument(string("SlidingProfile::SlidingProfile(int k, "
+                "const std::string& validNucleotides): k must be greater "
+                "than zero"));
+
+    // The codes of the kmers are in alphabetical order, as the kmers with
+    //    the same frequency in Profile::sort()
+    _k = k;
+    _allNucleotides = Kmer::MISSING_NUCLEOTIDE + validNucleotides;
+    std::sort(_allNucleotides.begin(), _allNucleotides.end());
+
+    long long numCodes = 1;
+    for (int i = 0; i < _k; i++) {
+        if (i == _k - 1)
+            _highPower = numCodes;
+        numCodes *= _allNucleotides.size();
+        if (numCodes > INT_MAX)
+            throw invalid_argument(string("SlidingProfile::SlidingProfile("
+                    "int k, const std::string& validNucleotides): the table "
+                    "of kmers is too large"));
+    }
+    _numCodes = numCodes;
+
+    int missing = _allNucleotides.find(Kmer::MISSING_NUCLEOTIDE);
+    for (int c = 0; c < 256; c++) {
+        _values[c] = missing;
+    }
+    for (size_t i = 0; i < _allNucleotides.size(); i++) {
+        unsigned char nucleotide = _allNucleotides[i];
+        if ((int)i == missing)
+            continue;
+        _values[toupper(nucleotide)] = i;
+        _values[tolower(nucleotide)] = i;
+    }
+
+    _numReferences = 0;
+    _maxFrequency = INITIAL_MAX_FREQUENCY;
+    allocate();
+}
+
+SlidingProfile::SlidingProfile(const SlidingProfile& orig) {
+    copy(orig);
+}
+
+SlidingProfile::~SlidingProfile() {
+    deallocate();
+}
+
+SlidingProfile& SlidingProfile::operator=(const SlidingProfile& orig) {
+    if (this != &orig) {
+        deallocate();
+        copy(orig);
+    }
+
+    return *this;
+}
+
+int SlidingProfile::getK() const {
+    return _k;
+}
+
+int SlidingProfile::getSize() const {
+    return _size;
+}
+
+int SlidingProfile::getNumReferences() const {
+    return _numReferences;
+}
+
+void SlidingProfile::addReference(const Profile& reference) {
+    if (reference.getSize() == 0)
+        throw invalid_argument(string("void SlidingProfile::addReference("
+                "const Profile& reference): the reference is empty"));
+
+    // Add a column to the table of ranks, with the rank of the kmers that
+    //    are not in the reference (its size)
+    int n = _numReferences;
+    int size = reference.getSize();
+    int* ranks = new int[(long long)_numCodes * (n + 1)];
+    long long* sums = new long long[n + 1];
+    int* referenceSizes = new int[n + 1];
+    for (long long code = 0; code < _numCodes; code++) {
+        for (int r = 0; r < n; r++) {
+            ranks[code * (n + 1) + r] = _ranks[code * n + r];
+        }
+        ranks[code * (n + 1) + n] = size;
+    }
+    for (int r = 0; r < n; r++) {
+        sums[r] = _sums[r];
+        referenceSizes[r] = _referenceSizes[r];
+    }
+    referenceSizes[n] = size;
+
+    // The rank of a kmer is the position of its first occurrence, as in
+    //    Profile::findKmer(). Kmers that cannot be in a window are skipped
+    for (int i = 0; i < size; i++) {
+        const Kmer& kmer = reference[i].getKmer();
+        if (kmer.size() != _k)
+            continue;
+
+        long long code = 0;
+        bool valid = true;
+        for (int j = 0; j < _k && valid; j++) {
+            size_t value = _allNucleotides.find(kmer.at(j));
+            valid = value != string::npos;
+            code = code * _allNucleotides.size() + value;
+        }
+        if (valid && ranks[code * (n + 1) + n] == size)
+            ranks[code * (n + 1) + n] = i;
+    }
+
+    sums[n] = 0;
+    for (int position = 0; position < _size; position++) {
+        sums[n] += abs(position - ranks[(long long)_order[position] *
+                (n + 1) + n]);
+    }
+
+    delete[] _ranks;
+    delete[] _sums;
+    delete[] _referenceSizes;
+    _ranks = ranks;
+    _sums = sums;
+    _referenceSizes = referenceSizes;
+    _numReferences = n + 1;
+}
+
+void SlidingProfile::addKmers(const std::string& sequence, int first,
+        int last) {
+    updateKmers(sequence, first, last, true);
+    sortBuckets();
+}
+
+void SlidingProfile::removeKmers(const std::string& sequence, int first,
+        int last) {
+    updateKmers(sequence, first, last, false);
+    sortBuckets();
+}
+
+void SlidingProfile::slide(const std::string& sequence, int first, int last,
+        int nextFirst, int nextLast) {
+    // The kmers in both ranges do not change
+    if (nextFirst < last && first < nextLast) {
+        updateKmers(sequence, first, min(nextFirst, last), false);
+        updateKmers(sequence, max(nextLast, first), last, false);
+        updateKmers(sequence, nextFirst, min(first, nextLast), true);
+        updateKmers(sequence, max(last, nextFirst), nextLast, true);
+    }
+    else {
+        updateKmers(sequence, first, last, false);
+        updateKmers(sequence, nextFirst, nextLast, true);
+    }
+    sortBuckets();
+}
+
+double SlidingProfile::getDistance(int reference) const {
+    if (reference < 0 || reference >= _numReferences)
+        throw out_of_range(string("double SlidingProfile::getDistance(int "
+                "reference) const: invalid position ") +
+                to_string(reference));
+    if (_size == 0)
+        throw invalid_argument(string("double SlidingProfile::getDistance("
+                "int reference) const: the window is empty"));
+
+    return _sums[reference] /
+            ((double)_size * _referenceSizes[reference]);
+}
+
+Profile SlidingProfile::toProfile() const {
+    Profile profile(_size);
+    int base = _allNucleotides.size();
+    string text(_k, Kmer::MISSING_NUCLEOTIDE);
+
+    for (int position = 0; position < _size; position++) {
+        int code = _order[position];
+        for (int j = _k - 1; j >= 0; j--) {
+            text[j] = _allNucleotides[code % base];
+            code /= base;
+        }
+        profile.at(position).setKmer(Kmer(text));
+        profile.at(position).setFrequency(_frequencies[_order[position]]);
+    }
+
+    return profile;
+}
+
+void SlidingProfile::allocate() {
+    _frequencies = new int[_numCodes]();
+    _positions = new int[_numCodes];
+    _order = new int[_numCodes];
+    _touched = new bool[_numCodes]();
+    _touchedKmers = new int[_numCodes];
+    for (int code = 0; code < _numCodes; code++) {
+        _positions[code] = -1;
+    }
+    _size = 0;
+    _numTouched = 0;
+    _ends = new int[_maxFrequency + 1]();
+    _sortedEnds = new int[_maxFrequency + 1]();
+    _changed = new bool[_maxFrequency + 1]();
+    _ranks = new int[(long long)_numCodes * _numReferences];
+    _sums = new long long[_numReferences]();
+    _referenceSizes = new int[_numReferences];
+}
+
+void SlidingProfile::deallocate() {
+    delete[] _frequencies;
+    delete[] _positions;
+    delete[] _order;
+    delete[] _touched;
+    delete[] _touchedKmers;
+    delete[] _ends;
+    delete[] _sortedEnds;
+    delete[] _changed;
+    delete[] _ranks;
+    delete[] _sums;
+    delete[] _referenceSizes;
+    _frequencies = nullptr;
+    _positions = nullptr;
+    _order = nullptr;
+    _touched = nullptr;
+    _touchedKmers = nullptr;
+    _ends = nullptr;
+    _sortedEnds = nullptr;
+    _changed = nullptr;
+    _ranks = nullptr;
+    _sums = nullptr;
+    _referenceSizes = nullptr;
+    _size = 0;
+}
+
+void SlidingProfile::copy(const SlidingProfile& orig) {
+    _k = orig._k;
+    _allNucleotides = orig._allNucleotides;
+    _numCodes = orig._numCodes;
+    _highPower = orig._highPower;
+    _maxFrequency = orig._maxFrequency;
+    _numReferences = orig._numReferences;
+    for (int c = 0; c < 256; c++) {
+        _values[c] = orig._values[c];
+    }
+
+    // The buckets of orig are always sorted, so no kmer is touched
+    allocate();
+    _size = orig._size;
+    for (int code = 0; code < _numCodes; code++) {
+        _frequencies[code] = orig._frequencies[code];
+        _positions[code] = orig._positions[code];
+        _order[code] = orig._order[code];
+    }
+    for (int f = 0; f <= _maxFrequency; f++) {
+        _ends[f] = orig._ends[f];
+        _sortedEnds[f] = orig._sortedEnds[f];
+    }
+    for (long long i = 0; i < (long long)_numCodes * _numReferences; i++) {
+        _ranks[i] = orig._ranks[i];
+    }
+    for (int r = 0; r < _numReferences; r++) {
+        _sums[r] = orig._sums[r];
+        _referenceSizes[r] = orig._referenceSizes[r];
+    }
+}
+
+int SlidingProfile::getCode(const std::string& sequence, int first) const {
+    int base = _allNucleotides.size();
+    int code = 0;
+    for (int i = first; i < first + _k; i++) {
+        code = code * base + _values[(unsigned char)sequence[i]];
+    }
+
+    return code;
+}
+
+void SlidingProfile::updateKmers(const std::string& sequence, int first,
+        int last, bool add) {
+    if (first >= last)
+        return;
+
+    int base = _allNucleotides.size();
+    int code = getCode(sequence, first);
+    for (int i = first; i < last; i++) {
+        if (i > first)
+            code = (code % _highPower) * base +
+                    _values[(unsigned char)sequence[i + _k - 1]];
+        if (add)
+            increase(code);
+        else
+            decrease(code);
+    }
+}
+
+void SlidingProfile::increase(int code) {
+    int frequency = _frequencies[code];
+    if (frequency + 1 > _maxFrequency) {
+        int* ends = new int[2 * _maxFrequency + 1]();
+        int* sortedEnds = new int[2 * _maxFrequency + 1]();
+        bool* changed = new bool[2 * _maxFrequency + 1]();
+        for (int f = 0; f <= _maxFrequency; f++) {
+            ends[f] = _ends[f];
+            sortedEnds[f] = _sortedEnds[f];
+            changed[f] = _changed[f];
+        }
+        delete[] _ends;
+        delete[] _sortedEnds;
+        delete[] _changed;
+        _ends = ends;
+        _sortedEnds = sortedEnds;
+        _changed = changed;
+        _maxFrequency *= 2;
+    }
+
+    touch(code);
+    if (frequency == 0)
+        _size++;
+    _ends[frequency + 1]++;
+    _frequencies[code]++;
+    _changed[frequency] = true;
+    _changed[frequency + 1] = true;
+}
+
+void SlidingProfile::decrease(int code) {
+    int frequency = _frequencies[code];
+
+    touch(code);
+    if (frequency == 1)
+        _size--;
+    _ends[frequency]--;
+    _frequencies[code]--;
+    _changed[frequency] = true;
+    _changed[frequency - 1] = true;
+}
+
+void SlidingProfile::touch(int code) {
+    if (!_touched[code]) {
+        _touched[code] = true;
+        _touchedKmers[_numTouched] = code;
+        _numTouched++;
+    }
+}
+
+void SlidingProfile::setRank(int code, int position) {
+    int old = _positions[code];
+    const int* ranks = _ranks + (long long)code * _numReferences;
+    for (int r = 0; r < _numReferences; r++) {
+        if (old >= 0)
+            _sums[r] -= abs(old - ranks[r]);
+        if (position >= 0)
+            _sums[r] += abs(position - ranks[r]);
+    }
+
+    _positions[code] = position;
+    if (position >= 0)
+        _order[position] = code;
+}
+
+void SlidingProfile::sortBuckets() {
+    // The kmers whose frequency has changed, sorted by frequency and then
+    //    alphabetically, so the new kmers of each bucket are consecutive
+    int* touched = _touchedKmers;
+    const int* frequencies = _frequencies;
+    std::sort(touched, touched + _numTouched, [frequencies](int a, int b) {
+        return frequencies[a] < frequencies[b] ||
+                (frequencies[a] == frequencies[b] && a < b);
+    });
+
+    // The kmers that leave the window
+    int next = 0;
+    while (next < _numTouched && _frequencies[touched[next]] == 0) {
+        setRank(touched[next], -1);
+        next++;
+    }
+
+    // Each bucket that has changed is the merge of the kmers that were
+    //    already in it, which are still sorted, and its new kmers. The
+    //    buckets are merged in an auxiliary array, since the new position
+    //    of a bucket can overlap the previous one of another bucket
+    int* merged = new int[_size];
+    int numMerged = 0;
+    for (int f = 1; f <= _maxFrequency; f++) {
+        if (!_changed[f])
+            continue;
+        int first = f < _maxFrequency ? _sortedEnds[f + 1] : 0;
+        int last = _sortedEnds[f];
+        while (first < last || (next < _numTouched &&
+                _frequencies[touched[next]] == f)) {
+            if (first < last && _touched[_order[first]])
+                first++;
+            else if (first < last && (next == _numTouched ||
+                    _frequencies[touched[next]] != f ||
+                    _order[first] < touched[next])) {
+                merged[numMerged] = _order[first];
+                numMerged++;
+                first++;
+            }
+            else {
+                merged[numMerged] = touched[next];
+                numMerged++;
+                next++;
+            }
+        }
+    }
+
+    // Only the kmers whose rank has changed update the sums
+    numMerged = 0;
+    for (int f = 1; f <= _maxFrequency; f++) {
+        if (!_changed[f])
+            continue;
+        int first = f < _maxFrequency ? _ends[f + 1] : 0;
+        for (int position = first; position < _ends[f]; position++) {
+            int code = merged[numMerged];
+            numMerged++;
+            if (_positions[code] != position)
+                setRank(code, position);
+            else
+                _order[position] = code;
+        }
+    }
+    delete[] merged;
+
+    for (int i = 0; i < _numTouched; i++) {
+        _touched[touched[i]] = false;
+    }
+    _numTouched = 0;
+    for (int f = 0; f <= _maxFrequency; f++) {
+        _sortedEnds[f] = _ends[f];
+        _changed[f] = false;
+    }
+}
@@ -0,0 +1,173 @@
+/*
+ * Metodología de la Programación: Kmer5
+ * Curso 2023/2024
+ */
+
+/**
+ * @file SpaceSaving.cpp
+ */
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "SpaceSaving.h"
+
+using namespace std;
+
+/**
+ * Estimated number of bytes of the entry of a kmer in the hash table of
+ * the positions: its key, its value and the pointers of its node and its
+ * bucket
+ */
+static const int POSITION_ENTRY_BYTES = sizeof(unsigned long long) +
+        sizeof(int) + 2 * sizeof(void*);
+
+SpaceSaving::SpaceSaving(int k, const std::string& validNucleotides,
+        int numCounters, bool canonical, bool onlyValidKmers):
+        _coder(k, validNucleotides, canonical, onlyValidKmers) {
+    if (numCounters <= 0)
+        throw std::invalid_argument(string("SpaceSaving::SpaceSaving(int k, "
+                "const std::string& validNucleotides, int numCounters, bool "
+                "canonical, bool onlyValidKmers): invalid number of "
+                "counters ") + to_string(numCounters));
+
+    _numCounters = numCounters;
+    _numKmers = 0;
+    _heap.reserve(numCounters);
+    _positions.reserve(numCounters);
+}
+
+int SpaceSaving::getK() const {
+    return _coder.getK();
+}
+
+int SpaceSaving::getNumCounters() const {
+    return _numCounters;
+}
+
+long long SpaceSaving::getNumKmers() const {
+    return _numKmers;
+}
+
+long long SpaceSaving::getErrorBound() const {
+    return (int) _heap.size() == _numCounters ? _heap[0].count : 0;
+}
+
+int SpaceSaving::getNumGuaranteed() const {
+    vector<string> kmers;
+    vector<int> order = sortCounters(kmers);
+    int numGuaranteed = 0;
+    long long guaranteed = 0; // Smallest guaranteed frequency of the first g
+    for (int g = 1; g <= (int) order.size(); g++) {
+        const Counter& counter = _heap[order[g - 1]];
+        guaranteed = g == 1 ? counter.count - counter.error :
+                min(guaranteed, counter.count - counter.error);
+        long long next = g < (int) order.size() ? _heap[order[g]].count :
+                getErrorBound();
+        if (guaranteed >= next)
+            numGuaranteed = g;
+    }
+
+    return numGuaranteed;
+}
+
+long long SpaceSaving::getMemory() const {
+    return (long long) _numCounters * (sizeof(Counter) +
+            POSITION_ENTRY_BYTES);
+}
+
+void SpaceSaving::addSequenceFrequencies(const std::string& sequence) {
+    _coder.forEachCode(sequence.data(), sequence.length(),
+            [this](unsigned long long code, int count) {
+                increase(code, count);
+            });
+}
+
+Profile SpaceSaving::toProfile() const {
+    vector<string> kmers;
+    vector<int> order = sortCounters(kmers);
+    Profile profile(order.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        profile.at(i).setKmer(Kmer(kmers[order[i]]));
+        profile.at(i).setFrequency(_heap[order[i]].count);
+    }
+
+    return profile;
+}
+
+void SpaceSaving::increase(unsigned long long code, long long value) {
+    _numKmers += value;
+    unordered_map<unsigned long long, int>::iterator position =
+            _positions.find(code);
+    if (position != _positions.end()) {
+        _heap[position->second].count += value;
+        siftDown(position->second);
+    }
+    else if ((int) _heap.size() < _numCounters) {
+        Counter counter = {code, value, 0};
+        _heap.push_back(counter);
+        _positions[code] = _heap.size() - 1;
+        siftUp(_heap.size() - 1);
+    }
+    else {
+        // The kmer takes the counter with the smallest estimation, which is
+        //    the maximum error of its new estimation
+        Counter& smallest = _heap[0];
+        _positions.erase(smallest.code);
+        smallest.code = code;
+        smallest.error = smallest.count;
+        smallest.count += value;
+        _positions[code] = 0;
+        siftDown(0);
+    }
+}
+
+void SpaceSaving::siftDown(int pos) {
+    int size = _heap.size();
+    int start = pos;
+    Counter counter = _heap[pos];
+    while (2 * pos + 1 < size) {
+        int child = 2 * pos + 1;
+        if (child + 1 < size && _heap[child + 1].count < _heap[child].count)
+            child++;
+        if (_heap[child].count >= counter.count)
+            break;
+        _heap[pos] = _heap[child];
+        _positions[_heap[pos].code] = pos;
+        pos = child;
+    }
+    if (pos != start) {
+        _heap[pos] = counter;
+        _positions[counter.code] = pos;
+    }
+}
+
+void SpaceSaving::siftUp(int pos) {
+    int start = pos;
+    Counter counter = _heap[pos];
+    while (pos > 0 && _heap[(pos - 1) / 2].count > counter.count) {
+        _heap[pos] = _heap[(pos - 1) / 2];
+        _positions[_heap[pos].code] = pos;
+        pos = (pos - 1) / 2;
+    }
+    if (pos != start) {
+        _heap[pos] = counter;
+        _positions[counter.code] = pos;
+    }
+}
+
+std::vector<int> SpaceSaving::sortCounters(
+        std::vector<std::string>& kmers) const {
+    kmers.resize(_heap.size());
+    vector<int> order(_heap.size());
+    for (size_t i = 0; i < _heap.size(); i++) {
+        kmers[i] = _coder.decode(_heap[i].code);
+        order[i] = i;
+    }
+    sort(order.begin(), order.end(), [&](int a, int b) {
+        return _heap[a].count > _heap[b].count ||
+                (_heap[a].count == _heap[b].count && kmers[a] < kmers[b]);
+    });
+
+    return order;
+}
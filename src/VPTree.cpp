@@ -0,0 +1,254 @@
+/*
+ * Metodología de la Programación: Kmer5
+ * Curso 2023/2024
+ */
+
+/**
+ * @file VPTree.cpp
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+#include "VPTree.h"
+
+using namespace std;
+
+const string VPTree::MAGIC_STRING="MP-KMER-VPT-1.1";
+
+/**
+ * Minimum number of bytes of a node of a tree in a file: its item, threshold
+ * and middle, and the depth, size and profile size of its RankVector
+ */
+static const int NODE_MIN_SIZE = 5 * sizeof(int) + sizeof(double);
+
+VPTree::VPTree(): _vectors(nullptr), _items(nullptr), _thresholds(nullptr),
+    _middles(nullptr), _size(0) {}
+
+VPTree::~VPTree() {
+    deallocate();
+}
+
+int VPTree::getSize() const {
+    return _size;
+}
+
+int VPTree::getDepth() const {
+    return _size > 0 ? _vectors[0].getDepth() : 0;
+}
+
+void VPTree::build(const RankVector vectors[], int numVectors) {
+    deallocate();
+    allocate(numVectors);
+    for (int i = 0; i < _size; i++) {
+        _vectors[i] = vectors[i];
+        _items[i] = i;
+    }
+
+    double* distances = new double[_size];
+    build(0, _size, distances);
+    delete[] distances;
+}
+
+void VPTree::build(int lo, int hi, double distances[]) {
+    if (hi - lo <= 0)
+        return;
+
+    // The element in the middle of the range is taken as vantage point
+    swap(_items[lo], _items[lo + (hi - lo) / 2]);
+    int vantage = _items[lo];
+    int others = hi - lo - 1;
+    if (others == 0) {
+        _thresholds[lo] = 0;
+        _middles[lo] = hi;
+        return;
+    }
+
+    for (int i = lo + 1; i < hi; i++) {
+        distances[_items[i]] = _vectors[vantage].getDistance(
+                _vectors[_items[i]]);
+    }
+
+    // The closest half of the references goes to the inner part
+    int middle = lo + 1 + (others + 1) / 2;
+    nth_element(_items + lo + 1, _items + middle - 1, _items + hi,
+            [distances](int a, int b) {
+                return distances[a] < distances[b];
+            });
+    _thresholds[lo] = distances[_items[middle - 1]];
+    _middles[lo] = middle;
+
+    build(lo + 1, middle, distances);
+    build(middle, hi, distances);
+}
+
+int VPTree::search(const RankVector& query, int k, int neighbours[],
+        double distances[], int& numEvaluations, double epsilon) const {
+    priority_queue<pair<double, int> > heap;
+    numEvaluations = 0;
+    if (k > 0)
+        search(0, _size, query, k, epsilon, heap, numEvaluations);
+
+    int found = heap.size();
+    for (int i = found - 1; i >= 0; i--) {
+        distances[i] = heap.top().first;
+        neighbours[i] = heap.top().second;
+        heap.pop();
+    }
+
+    return found;
+}
+
+void VPTree::search(int lo, int hi, const RankVector& query, int k,
+        double epsilon, priority_queue<pair<double, int> >& heap,
+        int& numEvaluations) const {
+    if (hi - lo <= 0)
+        return;
+
+    int vantage = _items[lo];
+    double distance = query.getDistance(_vectors[vantage]);
+    numEvaluations++;
+
+    if ((int)heap.size() < k)
+        heap.push(make_pair(distance, vantage));
+    else if (distance < heap.top().first) {
+        heap.pop();
+        heap.push(make_pair(distance, vantage));
+    }
+
+    double threshold = _thresholds[lo];
+    int middle = _middles[lo];
+
+    // Radius of the search: distance to the k-th closest reference so far
+    double tau = (int)heap.size() < k ? HUGE_VAL :
+            heap.top().first / (1 + epsilon);
+
+    if (distance <= threshold) {
+        if (distance - tau <= threshold)
+            search(lo + 1, middle, query, k, epsilon, heap, numEvaluations);
+        tau = (int)heap.size() < k ? HUGE_VAL :
+                heap.top().first / (1 + epsilon);
+        if (distance + tau >= threshold)
+            search(middle, hi, query, k, epsilon, heap, numEvaluations);
+    }
+    else {
+        if (distance + tau >= threshold)
+            search(middle, hi, query, k, epsilon, heap, numEvaluations);
+        tau = (int)heap.size() < k ? HUGE_VAL :
+                heap.top().first / (1 + epsilon);
+        if (distance - tau <= threshold)
+            search(lo + 1, middle, query, k, epsilon, heap, numEvaluations);
+    }
+}
+
+void VPTree::save(const char fileName[]) const {
+    ofstream output;
+    output.open(fileName, ios::out | ios::binary);
+
+    if (!output) {
+        throw ios_base::failure(string("void VPTree::save(const char "
+                "fileName[]) const: the given file cannot be opened\n"));
+    }
+
+    output << MAGIC_STRING << '\n';
+    output.write(reinterpret_cast<const char*>(&_size), sizeof(_size));
+    output.write(reinterpret_cast<const char*>(_items), _size * sizeof(int));
+    output.write(reinterpret_cast<const char*>(_thresholds),
+            _size * sizeof(double));
+    output.write(reinterpret_cast<const char*>(_middles), _size * sizeof(int));
+    for (int i = 0; i < _size; i++) {
+        _vectors[i].write(output);
+    }
+
+    if (!output) {
+        output.close();
+        throw ios_base::failure(string("void VPTree::save(const char "
+                "fileName[]) const: an error ocurred while writing in the "
+                "file\n"));
+    }
+
+    output.close();
+}
+
+void VPTree::load(const char fileName[]) {
+    ifstream input;
+    input.open(fileName, ios::in | ios::binary);
+
+    if (!input) {
+        throw ios_base::failure(string("void VPTree::load(const char "
+                "fileName[]): the given file cannot be opened\n"));
+    }
+
+    string magic_string;
+    getline(input, magic_string);
+    if (magic_string != MAGIC_STRING) {
+        input.close();
+        throw invalid_argument(string("void VPTree::load(const char "
+                "fileName[]): an invalid magic string has been found in the "
+                "given file"));
+    }
+
+    // Each node has at least its item, threshold, middle and the header of
+    //    its RankVector, so a size larger than the file is not allocated
+    int size = 0;
+    input.read(reinterpret_cast<char*>(&size), sizeof(size));
+    streamoff begin = input.tellg();
+    input.seekg(0, ios::end);
+    streamoff end = input.tellg();
+    input.seekg(begin);
+    if (!input || size < 0 || size > (end - begin) / NODE_MIN_SIZE) {
+        input.close();
+        throw ios_base::failure(string("void VPTree::load(const char "
+                "fileName[]): an error ocurred while reading the file\n"));
+    }
+
+    deallocate();
+    allocate(size);
+    input.read(reinterpret_cast<char*>(_items), _size * sizeof(int));
+    input.read(reinterpret_cast<char*>(_thresholds), _size * sizeof(double));
+    input.read(reinterpret_cast<char*>(_middles), _size * sizeof(int));
+    for (int i = 0; i < _size; i++) {
+        _vectors[i].read(input);
+    }
+
+    if (!input) {
+        deallocate();
+        input.close();
+        throw ios_base::failure(string("void VPTree::load(const char "
+                "fileName[]): an error ocurred while reading the file\n"));
+    }
+    input.close();
+
+    // The items and middles are used as positions by search(), and all the
+    //    vectors are compared with a query of the same depth
+    for (int i = 0; i < _size; i++) {
+        if (_items[i] < 0 || _items[i] >= _size || _middles[i] <= i ||
+                _middles[i] > _size ||
+                _vectors[i].getDepth() != _vectors[0].getDepth()) {
+            deallocate();
+            throw ios_base::failure(string("void VPTree::load(const char "
+                    "fileName[]): the given file has an invalid tree\n"));
+        }
+    }
+}
+
+void VPTree::allocate(int size) {
+    _size = size;
+    _vectors = new RankVector[_size];
+    _items = new int[_size];
+    _thresholds = new double[_size];
+    _middles = new int[_size];
+}
+
+void VPTree::deallocate() {
+    delete[] _vectors;
+    delete[] _items;
+    delete[] _thresholds;
+    delete[] _middles;
+    _vectors = nullptr;
+    _items = nullptr;
+    _thresholds = nullptr;
+    _middles = nullptr;
+    _size = 0;
+}
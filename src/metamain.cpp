@@ -2,5 +2,17 @@
     #include "LEARN.cpp"
 #elif CLASSIFY
     #include "CLASSIFY.cpp"
+#elif BUILDDB
+    #include "BUILDDB.cpp"
+#elif DISTMATRIX
+    #include "DISTMATRIX.cpp"
+#elif CLASSIFYREADS
+    #include "CLASSIFYREADS.cpp"
+#elif SCAN
+    #include "SCAN.cpp"
+#elif BENCHCOUNT
+    #include "BENCHCOUNT.cpp"
+#elif BENCHSAMPLE
+    #include "BENCHSAMPLE.cpp"
 #endif
 